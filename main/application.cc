@@ -1,5 +1,6 @@
 #include "application.h"
 #include "board.h"
+#include "board_caps.h"
 #include "display.h"
 #include "system_info.h"
 #include "ml307_ssl_transport.h"
@@ -8,14 +9,53 @@
 #include "websocket_protocol.h"
 #include "font_awesome_symbols.h"
 #include "iot/thing_manager.h"
+#include "iot/iot_executor.h"
 #include "assets/lang_config.h"
+#include "settings.h"
+#include "settings_schema.h"
+#include "packet_pool.h"
+#include "pcm_simd.h"
+#include "latency_tracker.h"
+#include "boot_profiler.h"
+#include "heap_guard.h"
+#include "heap_telemetry.h"
+#include "memory_budget.h"
+#include "cpu_load_monitor.h"
+#include "network_quality.h"
+#include "net_rx_tuning.h"
+#include "sched_profile.h"
+#include "session_memory.h"
+#include "task_telemetry.h"
+#include "flight_recorder.h"
+#include "event_log.h"
+#include "sound_index.h"
+#include "sound_mixer.h"
+#include "cpu_governor.h"
+#include "config_blobs.h"
+#include "command_shortcuts.h"
+#include "button.h"
+#include "telemetry_registry.h"
+#include "long_task_detector.h"
+#include "asset_pack.h"
+#include "http_worker.h"
+#include "sound_cache.h"
+#include "audio_loopback_test.h"
+#include "capture_health.h"
+#include "message_tokens.h"
+#if CONFIG_USE_WAKE_WORD_DETECT || CONFIG_USE_AUDIO_PROCESSOR
+#include "audio_frontend.h"
+#endif
 
+#include <algorithm>
 #include <cstring>
 #include <esp_log.h>
 #include <cJSON.h>
 #include <driver/gpio.h>
 #include <arpa/inet.h>
 #include <esp_app_desc.h>
+#include <esp_timer.h>
+#include <esp_attr.h>
+#include <sys/time.h>
 
 #define TAG "Application"
 
@@ -36,7 +76,17 @@ static const char* const STATE_STRINGS[] = {
 
 Application::Application() {
     event_group_ = xEventGroupCreate();
+    audio_event_group_ = xEventGroupCreate();
+    main_task_queue_ = xQueueCreate(32, sizeof(TaskRef));
+    button_event_queue_ = xQueueCreate(8, sizeof(ButtonEvent));
     background_task_ = new BackgroundTask(4096 * 8);
+    // 编解码的核与优先级按调度档案走（balanced 档等于原布局：
+    // 编码核 0、解码核 1——AFE 偏好核 1，但放音时 AFE 基本空闲）
+    const auto& sched = sched_profile::Current();
+    encode_task_ = new AudioPipelineTask("opus_encode", 4096 * 8,
+        sched.encode_priority, sched_profile::Core(sched.encode_core), 10);
+    decode_task_ = new AudioPipelineTask("opus_decode", 4096 * 4,
+        sched.decode_priority, sched_profile::Core(sched.decode_core), 30);
 
     esp_timer_create_args_t clock_timer_args = {
         .callback = [](void* arg) {
@@ -49,9 +99,25 @@ Application::Application() {
         .skip_unhandled_events = true
     };
     esp_timer_create(&clock_timer_args, &clock_timer_handle_);
+
+    esp_timer_create_args_t audio_clock_args = {
+        .callback = [](void* arg) {
+            Application* app = (Application*)arg;
+            app->OnAudioClock();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "audio_clock",
+        .skip_unhandled_events = true
+    };
+    esp_timer_create(&audio_clock_args, &audio_clock_handle_);
 }
 
 Application::~Application() {
+    if (audio_clock_handle_ != nullptr) {
+        esp_timer_stop(audio_clock_handle_);
+        esp_timer_delete(audio_clock_handle_);
+    }
     if (clock_timer_handle_ != nullptr) {
         esp_timer_stop(clock_timer_handle_);
         esp_timer_delete(clock_timer_handle_);
@@ -59,149 +125,181 @@ Application::~Application() {
     if (background_task_ != nullptr) {
         delete background_task_;
     }
+    if (encode_task_ != nullptr) {
+        delete encode_task_;
+    }
+    if (decode_task_ != nullptr) {
+        delete decode_task_;
+    }
+    if (main_task_queue_ != nullptr) {
+        vQueueDelete(main_task_queue_);
+    }
+    if (button_event_queue_ != nullptr) {
+        vQueueDelete(button_event_queue_);
+    }
     vEventGroupDelete(event_group_);
+    vEventGroupDelete(audio_event_group_);
+}
+
+void Application::StartVersionCheckTask() {
+    // 排到共享 HTTP 工作任务上：栈只在请求真正进行时存在，失败重试
+    // 的 60 秒间隔里没有任务抱着 8KB 栈睡觉，到点由时钟定时器重新
+    // 排队；后续别的 HTTP 作业也共用这一个栈
+    HttpWorker::GetInstance().Submit([this]() {
+        CheckNewVersion();
+    });
 }
 
 void Application::CheckNewVersion() {
     auto& board = Board::GetInstance();
     auto display = board.GetDisplay();
     // Check if there is a new firmware version available
-    ota_.SetPostData(board.GetJson());
+    std::string post_data = board.GetJson();
+    const auto& crash_dump = flight_recorder::GetCrashDump();
+    if (!crash_dump.empty()) {
+        // 崩溃现场搭每次开机都会发的版本检查便车上报，不依赖音频通道；
+        // POST 体以 '}' 结尾，在闭括号前插入字段
+        post_data.insert(post_data.size() - 1, ",\"flight_recorder\":" + crash_dump);
+    }
+    ota_.SetPostData(std::move(post_data));
 
     const int MAX_RETRY = 10;
-    int retry_count = 0;
-
-    while (true) {
-        if (!ota_.CheckVersion()) {
-            retry_count++;
-            if (retry_count >= MAX_RETRY) {
-                ESP_LOGE(TAG, "Too many retries, exit version check");
-                return;
-            }
-            ESP_LOGW(TAG, "Check new version failed, retry in %d seconds (%d/%d)", 60, retry_count, MAX_RETRY);
-            vTaskDelay(pdMS_TO_TICKS(60000));
-            continue;
-        }
-        retry_count = 0;
-
-        if (ota_.HasNewVersion()) {
-            Alert(Lang::Strings::OTA_UPGRADE, Lang::Strings::UPGRADING, "happy", Lang::Sounds::P3_UPGRADE);
-            // Wait for the chat state to be idle
-            do {
-                vTaskDelay(pdMS_TO_TICKS(3000));
-            } while (GetDeviceState() != kDeviceStateIdle);
-
-            // Use main task to do the upgrade, not cancelable
-            Schedule([this, display]() {
-                SetDeviceState(kDeviceStateUpgrading);
-                
-                display->SetIcon(FONT_AWESOME_DOWNLOAD);
-                std::string message = std::string(Lang::Strings::NEW_VERSION) + ota_.GetFirmwareVersion();
-                display->SetChatMessage("system", message.c_str());
-
-                auto& board = Board::GetInstance();
-                board.SetPowerSaveMode(false);
-#if CONFIG_USE_WAKE_WORD_DETECT
-                wake_word_detect_.StopDetection();
-#endif
-                // 预先关闭音频输出，避免升级过程有音频操作
-                auto codec = board.GetAudioCodec();
-                codec->EnableInput(false);
-                codec->EnableOutput(false);
-                {
-                    std::lock_guard<std::mutex> lock(mutex_);
-                    audio_decode_queue_.clear();
-                }
-                background_task_->WaitForCompletion();
-                delete background_task_;
-                background_task_ = nullptr;
-                vTaskDelay(pdMS_TO_TICKS(1000));
-
-                ota_.StartUpgrade([display](int progress, size_t speed) {
-                    char buffer[64];
-                    snprintf(buffer, sizeof(buffer), "%d%% %zuKB/s", progress, speed / 1024);
-                    display->SetChatMessage("system", buffer);
-                });
-
-                // If upgrade success, the device will reboot and never reach here
-                display->SetStatus(Lang::Strings::UPGRADE_FAILED);
-                ESP_LOGI(TAG, "Firmware upgrade failed...");
-                vTaskDelay(pdMS_TO_TICKS(3000));
-                Reboot();
-            });
-
+    if (!ota_.CheckVersion()) {
+        if (++version_check_retry_count_ >= MAX_RETRY) {
+            ESP_LOGE(TAG, "Too many retries, exit version check");
             return;
         }
+        ESP_LOGW(TAG, "Check new version failed, retry in %d seconds (%d/%d)",
+            60, version_check_retry_count_, MAX_RETRY);
+        version_check_ticks_ = 60;
+        return;
+    }
+    version_check_retry_count_ = 0;
+    // POST 已经送达服务器，崩溃现场不再重复上报
+    flight_recorder::DiscardCrashDump();
+
+    if (ota_.HasNewVersion()) {
+        // 后台无感升级：空闲时低优先级预取到备用分区，唤醒词/按键一来立
+        // 刻让路，下完在下一个自然空闲点切分区重启，设备全程照常可用
+        ESP_LOGI(TAG, "New version %s available, prefetching in background",
+            ota_.GetFirmwareVersion().c_str());
+        ota_.StartPrefetch(
+            [this]() { return CanEnterSleepMode(); },
+            [this]() { pending_ota_activation_ = true; });
+    }
 
-        // No new version, mark the current version as valid
-        ota_.MarkCurrentVersionValid();
-        std::string message = std::string(Lang::Strings::VERSION) + ota_.GetCurrentVersion();
-        display->ShowNotification(message.c_str());
-    
-        if (ota_.HasActivationCode()) {
-            // Activation code is valid
-            SetDeviceState(kDeviceStateActivating);
-            ShowActivationCode();
-
-            // Check again in 60 seconds or until the device is idle
-            for (int i = 0; i < 60; ++i) {
-                if (device_state_ == kDeviceStateIdle) {
-                    break;
-                }
-                vTaskDelay(pdMS_TO_TICKS(1000));
-            }
-            continue;
-        }
+    // 当前版本继续跑，照常标记有效避免回滚
+    ota_.MarkCurrentVersionValid();
+    std::string message = std::string(Lang::Strings::VERSION) + ota_.GetCurrentVersion();
+    display->ShowNotification(message.c_str());
+
+    if (ota_.HasActivationCode()) {
+        // 服务器要求激活，旧缓存作废：下次开机不能再拿它直进待机
+        Settings settings("ota", true);
+        settings.EraseKey("check_cache");
+        SetDeviceState(kDeviceStateActivating);
+        // 激活确认之前每 60 秒再查一次（倒计时由播报完成回调拉起），
+        // 间隔期间同样不占任务
+        ShowActivationCode();
+        return;
+    }
+
+    // 检查通过且无需激活：结果落缓存，下次开机走快路径直进待机
+    config_blobs::VersionCheckCache cache = {};
+    cache.activated = 1;
+    strncpy(cache.firmware_version, ota_.GetCurrentVersion().c_str(),
+        sizeof(cache.firmware_version) - 1);
+    cache.checked_at = (int64_t)time(NULL);
+    {
+        Settings settings("ota", true);
+        settings.SetBlob("check_cache", config_blobs::VersionCheckCache::kVersion,
+            &cache, sizeof(cache));
+    }
 
+    // 缓存直进待机的开机场景下这里是后台复核，设备可能已经在对话，
+    // 别把它拽回待机
+    if (device_state_ == kDeviceStateStarting || device_state_ == kDeviceStateActivating) {
         SetDeviceState(kDeviceStateIdle);
         display->SetChatMessage("system", "");
         PlaySound(Lang::Sounds::P3_SUCCESS);
-        // Exit the loop if upgrade or idle
-        break;
     }
 }
 
+// 读上次版本检查的缓存，命中返回 true（开机可以先进待机，检查转后台）。
+// 时钟还没同步时顺手把墙钟恢复到上次检查的时刻：日志不再从 1970 起跳，
+// TTL 比较也有了参照，服务器时间到了会再校正
+bool Application::LoadVersionCheckCache() {
+    config_blobs::VersionCheckCache cache = {};
+    Settings settings("ota", false);
+    if (!settings.GetBlob("check_cache", config_blobs::VersionCheckCache::kVersion,
+            &cache, sizeof(cache))) {
+        return false;
+    }
+    if (!cache.activated) {
+        return false;
+    }
+    // OTA 过后第一次开机照旧同步检查：新固件的激活态要重新确认
+    auto app_desc = esp_app_get_description();
+    if (strncmp(cache.firmware_version, app_desc->version,
+            sizeof(cache.firmware_version)) != 0) {
+        return false;
+    }
+    int64_t now = time(NULL);
+    if (now < 1600000000 && cache.checked_at > 1600000000) {
+        struct timeval tv = {
+            .tv_sec = (time_t)cache.checked_at,
+            .tv_usec = 0,
+        };
+        settimeofday(&tv, NULL);
+        now = cache.checked_at;
+    }
+    // TTL 7 天：正常设备每次开机的后台复核都会把 checked_at 推新，
+    // 过期说明长期没碰到服务器，回退同步检查
+    if (now - cache.checked_at > 7 * 24 * 3600) {
+        return false;
+    }
+    return true;
+}
+
 void Application::ShowActivationCode() {
     auto& message = ota_.GetActivationMessage();
     auto& code = ota_.GetActivationCode();
 
-    struct digit_sound {
-        char digit;
-        const std::string_view& sound;
-    };
-    static const std::array<digit_sound, 10> digit_sounds{{
-        digit_sound{'0', Lang::Sounds::P3_0},
-        digit_sound{'1', Lang::Sounds::P3_1}, 
-        digit_sound{'2', Lang::Sounds::P3_2},
-        digit_sound{'3', Lang::Sounds::P3_3},
-        digit_sound{'4', Lang::Sounds::P3_4},
-        digit_sound{'5', Lang::Sounds::P3_5},
-        digit_sound{'6', Lang::Sounds::P3_6},
-        digit_sound{'7', Lang::Sounds::P3_7},
-        digit_sound{'8', Lang::Sounds::P3_8},
-        digit_sound{'9', Lang::Sounds::P3_9}
+    // 按数字直接下标取音效，省掉每位数字一次线性查找
+    static const std::array<const std::string_view*, 10> digit_sounds{{
+        &Lang::Sounds::P3_0, &Lang::Sounds::P3_1, &Lang::Sounds::P3_2,
+        &Lang::Sounds::P3_3, &Lang::Sounds::P3_4, &Lang::Sounds::P3_5,
+        &Lang::Sounds::P3_6, &Lang::Sounds::P3_7, &Lang::Sounds::P3_8,
+        &Lang::Sounds::P3_9
     }};
 
-    // This sentence uses 9KB of SRAM, so we need to wait for it to finish
-    Alert(Lang::Strings::ACTIVATION, message.c_str(), "happy", Lang::Sounds::P3_ACTIVATION);
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    background_task_->WaitForCompletion();
+    Alert(Lang::Strings::ACTIVATION, message.c_str(), "happy", "");
 
+    // 提示语和整串数字一次性排队无缝连播：切片都是 memory-mapped
+    // flash 的零拷贝视图，不再 sleep 一秒、不再排空解码队列——以前
+    // 这条流程每台新设备要白等 15 秒以上。60 秒的激活复查倒计时挪到
+    // 播完才起，节奏和旧的阻塞版本一致
+    std::vector<std::string_view> sequence;
+    sequence.reserve(code.size() + 1);
+    sequence.push_back(Lang::Sounds::P3_ACTIVATION);
     for (const auto& digit : code) {
-        auto it = std::find_if(digit_sounds.begin(), digit_sounds.end(),
-            [digit](const digit_sound& ds) { return ds.digit == digit; });
-        if (it != digit_sounds.end()) {
-            PlaySound(it->sound);
+        if (digit >= '0' && digit <= '9') {
+            sequence.push_back(*digit_sounds[digit - '0']);
         }
     }
+    PlaySoundSequence(sequence, [this]() {
+        Schedule([this]() { version_check_ticks_ = 60; });
+    });
 }
 
 void Application::Alert(const char* status, const char* message, const char* emotion, const std::string_view& sound) {
     ESP_LOGW(TAG, "Alert %s: %s [%s]", status, message, emotion);
     auto display = Board::GetInstance().GetDisplay();
+    display->BeginUpdate();
     display->SetStatus(status);
     display->SetEmotion(emotion);
     display->SetChatMessage("system", message);
+    display->CommitUpdate();
     if (!sound.empty()) {
         PlaySound(sound);
     }
@@ -210,30 +308,50 @@ void Application::Alert(const char* status, const char* message, const char* emo
 void Application::DismissAlert() {
     if (device_state_ == kDeviceStateIdle) {
         auto display = Board::GetInstance().GetDisplay();
+        display->BeginUpdate();
         display->SetStatus(Lang::Strings::STANDBY);
         display->SetEmotion("neutral");
         display->SetChatMessage("system", "");
+        display->CommitUpdate();
     }
 }
 
 void Application::PlaySound(const std::string_view& sound) {
+    // 资产分区有覆盖时换成分区里的映射切片；外置资产固件里嵌入视图
+    // 长度为 0，没刷资产包时没东西可放，直接返回
+    auto resolved = AssetPack::GetInstance().ResolveSound(sound);
+    if (resolved.empty()) {
+        ESP_LOGW(TAG, "Sound asset unavailable (assets partition not flashed?)");
+        return;
+    }
     auto codec = Board::GetInstance().GetAudioCodec();
     codec->EnableOutput(true);
-    SetDecodeSampleRate(16000);
-    const char* data = sound.data();
-    size_t size = sound.size();
-    for (const char* p = data; p < data + size; ) {
-        auto p3 = (BinaryProtocol3*)p;
-        p += sizeof(BinaryProtocol3);
-
-        auto payload_size = ntohs(p3->payload_size);
-        std::vector<uint8_t> opus;
-        opus.resize(payload_size);
-        memcpy(opus.data(), p3->payload, payload_size);
-        p += payload_size;
+    // 空闲态放提示音也把时钟提上去，排空后在输出路径清掉
+    CpuGovernor::GetInstance().SetPipelineActive(true);
+    // 嵌入数据和分区数据都是常驻的 memory-mapped flash，UI 声道里只放切片，不做拷贝；
+    // 包边界由 SoundIndex 首次播放时解析一次，之后不再重走 BinaryProtocol3 帧头。
+    // UI 声道自带解码器和重采样，不再动会话解码采样率，也不占抖动缓冲
+    SoundMixer::GetInstance().QueuePackets(SoundIndex::GetInstance().Get(resolved));
+}
 
-        std::lock_guard<std::mutex> lock(mutex_);
-        audio_decode_queue_.emplace_back(std::move(opus));
+void Application::PlaySoundSequence(const std::vector<std::string_view>& sounds,
+                                    std::function<void()> on_complete) {
+    auto codec = Board::GetInstance().GetAudioCodec();
+    codec->EnableOutput(true);
+    CpuGovernor::GetInstance().SetPipelineActive(true);
+    // 整串切片一次排进 UI 声道：段与段之间没有等待，也就没有缝
+    for (const auto& sound : sounds) {
+        auto resolved = AssetPack::GetInstance().ResolveSound(sound);
+        if (resolved.empty()) {
+            ESP_LOGW(TAG, "Sound asset unavailable (assets partition not flashed?)");
+            continue;
+        }
+        SoundMixer::GetInstance().QueuePackets(SoundIndex::GetInstance().Get(resolved));
+    }
+    if (on_complete) {
+        // 最后一帧被取走（或被打断冲掉）时触发；什么都没排进去时
+        // 立刻触发，调用方不用关心资产在不在
+        SoundMixer::GetInstance().NotifyWhenDrained(std::move(on_complete));
     }
 }
 
@@ -251,14 +369,15 @@ void Application::ToggleChatState() {
     if (device_state_ == kDeviceStateIdle) {
         Schedule([this]() {
             SetDeviceState(kDeviceStateConnecting);
-            if (!protocol_->OpenAudioChannel()) {
+            if (!OpenAudioChannelWithFailover()) {
                 return;
             }
 
             keep_listening_ = true;
+            listening_mode_ = kListeningModeAutoStop;
             protocol_->SendStartListening(kListeningModeAutoStop);
             SetDeviceState(kDeviceStateListening);
-        });
+        }, "toggle_chat");
     } else if (device_state_ == kDeviceStateSpeaking) {
         Schedule([this]() {
             AbortSpeaking(kAbortReasonNone);
@@ -286,16 +405,18 @@ void Application::StartListening() {
         Schedule([this]() {
             if (!protocol_->IsAudioChannelOpened()) {
                 SetDeviceState(kDeviceStateConnecting);
-                if (!protocol_->OpenAudioChannel()) {
+                if (!OpenAudioChannelWithFailover()) {
                     return;
                 }
             }
+            listening_mode_ = kListeningModeManualStop;
             protocol_->SendStartListening(kListeningModeManualStop);
             SetDeviceState(kDeviceStateListening);
         });
     } else if (device_state_ == kDeviceStateSpeaking) {
         Schedule([this]() {
             AbortSpeaking(kAbortReasonNone);
+            listening_mode_ = kListeningModeManualStop;
             protocol_->SendStartListening(kListeningModeManualStop);
             SetDeviceState(kDeviceStateListening);
         });
@@ -311,142 +432,270 @@ void Application::StopListening() {
     });
 }
 
-void Application::Start() {
-    auto& board = Board::GetInstance();
-    SetDeviceState(kDeviceStateStarting);
-
-    /* Setup the display */
-    auto display = board.GetDisplay();
-
-    /* Setup the audio codec */
-    auto codec = board.GetAudioCodec();
-    opus_decode_sample_rate_ = codec->output_sample_rate();
-    opus_decoder_ = std::make_unique<OpusDecoderWrapper>(opus_decode_sample_rate_, 1);
-    opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
-    // For ML307 boards, we use complexity 5 to save bandwidth
-    // For other boards, we use complexity 3 to save CPU
-    if (board.GetBoardType() == "ml307") {
-        ESP_LOGI(TAG, "ML307 board detected, setting opus encoder complexity to 5");
-        opus_encoder_->SetComplexity(5);
+// 传输层在运行时装配：主传输的服务端不可达时换上备用传输重建，
+// 所有协议回调在这里统一接线，保证两条路径行为一致
+void Application::InitializeProtocol(bool use_fallback) {
+#ifdef CONFIG_CONNECTION_TYPE_WEBSOCKET
+    if (use_fallback) {
+        protocol_ = std::make_unique<MqttProtocol>();
     } else {
-        ESP_LOGI(TAG, "WiFi board detected, setting opus encoder complexity to 3");
-        opus_encoder_->SetComplexity(3);
-    }
-
-    if (codec->input_sample_rate() != 16000) {
-        input_resampler_.Configure(codec->input_sample_rate(), 16000);
-        reference_resampler_.Configure(codec->input_sample_rate(), 16000);
+        protocol_ = std::make_unique<WebsocketProtocol>();
     }
-    codec->OnInputReady([this, codec]() {
-        BaseType_t higher_priority_task_woken = pdFALSE;
-        xEventGroupSetBitsFromISR(event_group_, AUDIO_INPUT_READY_EVENT, &higher_priority_task_woken);
-        return higher_priority_task_woken == pdTRUE;
-    });
-    codec->OnOutputReady([this]() {
-        BaseType_t higher_priority_task_woken = pdFALSE;
-        xEventGroupSetBitsFromISR(event_group_, AUDIO_OUTPUT_READY_EVENT, &higher_priority_task_woken);
-        return higher_priority_task_woken == pdTRUE;
-    });
-    codec->Start();
-
-    /* Start the main loop */
-    xTaskCreate([](void* arg) {
-        Application* app = (Application*)arg;
-        app->MainLoop();
-        vTaskDelete(NULL);
-    }, "main_loop", 4096 * 2, this, 3, nullptr);
-
-    /* Wait for the network to be ready */
-    board.StartNetwork();
-
-    // Initialize the protocol
-    display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
-#ifdef CONFIG_CONNECTION_TYPE_WEBSOCKET
-    protocol_ = std::make_unique<WebsocketProtocol>();
 #else
+    (void)use_fallback;
     protocol_ = std::make_unique<MqttProtocol>();
 #endif
     protocol_->OnNetworkError([this](const std::string& message) {
+        event_log::Record(event_log::kNetworkError);
         SetDeviceState(kDeviceStateIdle);
         Alert(Lang::Strings::ERROR, message.c_str(), "sad", Lang::Sounds::P3_EXCLAMATION);
     });
-    protocol_->OnIncomingAudio([this](std::vector<uint8_t>&& data) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    protocol_->OnIncomingAudio([this](std::vector<uint8_t>&& data, uint32_t stream_ms) {
         if (device_state_ == kDeviceStateSpeaking) {
-            audio_decode_queue_.emplace_back(std::move(data));
+            jitter_buffer_.Push(std::move(data), stream_ms);
         }
     });
-    protocol_->OnAudioChannelOpened([this, codec, &board]() {
+    // 同屋多台设备的公告（门铃、告警）：服务器给每帧戳统一的起播
+    // 时刻，各设备按对过表的系统时钟到点出声，相差不过一两帧。
+    // 走 UI 声道的共享低码率解码器，不碰会话解码器和抖动缓冲，
+    // 对话中来广播就压低 TTS 叠上去
+    protocol_->OnBroadcastAudio([this](std::vector<uint8_t>&& opus, int64_t playout_ms) {
+        auto codec = Board::GetInstance().GetAudioCodec();
+        codec->EnableOutput(true);
+        CpuGovernor::GetInstance().SetPipelineActive(true);
+        SoundMixer::GetInstance().QueueBroadcast(std::move(opus), playout_ms);
+    });
+    protocol_->OnAudioChannelOpened([this]() {
+        event_log::Record(event_log::kChannelOpen);
+        auto& board = Board::GetInstance();
         board.SetPowerSaveMode(false);
-        if (protocol_->server_sample_rate() != codec->output_sample_rate()) {
-            ESP_LOGW(TAG, "Server sample rate %d does not match device output sample rate %d, resampling may cause distortion",
-                protocol_->server_sample_rate(), codec->output_sample_rate());
+        // 传输库的收包任务这时候才建出来，统一抬到推荐优先级
+        net_rx_tuning::Apply();
+        // Opus 原生输出率的板子解码器直接按输出率出样本，异率下行
+        // 不经过重采样，不存在失真问题，不用告警
+        if constexpr (!board_caps::kOutputRateOpusNative) {
+            auto codec = board.GetAudioCodec();
+            if (protocol_->server_sample_rate() != codec->output_sample_rate()) {
+                ESP_LOGW(TAG, "Server sample rate %d does not match device output sample rate %d, resampling may cause distortion",
+                    protocol_->server_sample_rate(), codec->output_sample_rate());
+            }
         }
         SetDecodeSampleRate(protocol_->server_sample_rate());
+        ApplyEncoderProfile(protocol_->encoder_profile());
         auto& thing_manager = iot::ThingManager::GetInstance();
         protocol_->SendIotDescriptors(thing_manager.GetDescriptorsJson());
+        // 服务器确认了二进制状态通道时，数值 thing 从 JSON 路径摘出来
+        // 走 0x05 帧；字符串属性的 thing 和老服务器照旧 JSON
+        bool iot_binary = protocol_->SupportsBinaryIotStates();
         std::string states;
-        if (thing_manager.GetStatesJson(states, false)) {
+        if (thing_manager.GetStatesJson(states, false, iot_binary)) {
             protocol_->SendIotStates(states);
         }
+        if (iot_binary) {
+            std::string payload;
+            if (thing_manager.GetStatesBinary(payload, false)) {
+                protocol_->SendIotStatesBinary(payload);
+            }
+        }
     });
-    protocol_->OnAudioChannelClosed([this, &board]() {
-        board.SetPowerSaveMode(true);
+    protocol_->OnAudioChannelClosed([this]() {
+        event_log::Record(event_log::kChannelClose);
+        // 结算本次会话的内存高水位画像
+        SessionMemory::GetInstance().OnSessionEnd();
+        Board::GetInstance().SetPowerSaveMode(true);
         Schedule([this]() {
             auto display = Board::GetInstance().GetDisplay();
             display->SetChatMessage("system", "");
             SetDeviceState(kDeviceStateIdle);
         });
     });
-    protocol_->OnIncomingJson([this, display](const cJSON* root) {
+    // 高频消息的免建树路径：tts/stt/llm 的字段在协议层扫出来直接
+    // 分发，省掉每条几十个节点的 cJSON 树。语义必须和下面的完整
+    // 解析分支保持一致——没把握的消息返回 false 走回退
+    protocol_->OnIncomingFastJson([this](const FastMessage& msg) -> bool {
+        using namespace message_tokens;
+        switch (ParseType(msg.type.c_str())) {
+        case kTypeTts:
+            switch (ParseState(msg.state.c_str())) {
+            case kStateStart:
+                ResetCaptionTimeline();
+                Schedule([this]() {
+                    aborted_ = false;
+                    if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
+                        SetDeviceState(kDeviceStateSpeaking);
+                    }
+                });
+                return true;
+            case kStateStop:
+                FlushCaptions(true);
+                Schedule([this]() {
+                    if (device_state_ == kDeviceStateSpeaking) {
+                        decode_task_->WaitForCompletion();
+                        if (keep_listening_) {
+                            if (pipelined_capture_) {
+                                // 流水线采集已经抢先发过 listen start，
+                                // 上行正在跑，这里只做本地状态收尾
+                                listening_mode_ = kListeningModeAlwaysOn;
+                            } else {
+                                listening_mode_ = kListeningModeAutoStop;
+                                protocol_->SendStartListening(kListeningModeAutoStop);
+                            }
+                            SetDeviceState(kDeviceStateListening);
+                        } else {
+                            SetDeviceState(kDeviceStateIdle);
+                        }
+                    }
+                });
+                return true;
+            case kStateSentenceStart:
+                if (!msg.text.empty()) {
+                    ESP_LOGI(TAG, "<< %s", msg.text.c_str());
+                    QueueCaption(msg.offset_ms, msg.text.c_str());
+                }
+                return true;
+            default:
+                return false;
+            }
+        case kTypeStt:
+            if (!msg.text.empty()) {
+                ESP_LOGI(TAG, ">> %s", msg.text.c_str());
+                UpdateChatMessage("user", msg.text.c_str());
+            }
+            return true;
+        case kTypeLlm:
+            if (!msg.emotion.empty()) {
+                UpdateEmotion(msg.emotion.c_str());
+            }
+            return true;
+        case kTypeIot:
+            // 受限 invoke 模式零分配执行；有拿不准的形态返回 false，
+            // 协议层回退 cJSON 路径重放（一条都不会执行到一半）
+            return msg.raw != nullptr &&
+                   iot::ThingManager::GetInstance().InvokeRaw(msg.raw);
+        default:
+            return false;
+        }
+    });
+    protocol_->OnIncomingJson([this](const cJSON* root) {
         // Parse JSON data
+        using namespace message_tokens;
         auto type = cJSON_GetObjectItem(root, "type");
-        if (strcmp(type->valuestring, "tts") == 0) {
+        switch (ParseType(type->valuestring)) {
+        case kTypeTts: {
             auto state = cJSON_GetObjectItem(root, "state");
-            if (strcmp(state->valuestring, "start") == 0) {
+            switch (ParseState(state->valuestring)) {
+            case kStateStart:
+                ResetCaptionTimeline();
                 Schedule([this]() {
                     aborted_ = false;
                     if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
                         SetDeviceState(kDeviceStateSpeaking);
                     }
                 });
-            } else if (strcmp(state->valuestring, "stop") == 0) {
+                break;
+            case kStateStop:
+                FlushCaptions(true);
                 Schedule([this]() {
                     if (device_state_ == kDeviceStateSpeaking) {
-                        background_task_->WaitForCompletion();
+                        decode_task_->WaitForCompletion();
                         if (keep_listening_) {
-                            protocol_->SendStartListening(kListeningModeAutoStop);
+                            if (pipelined_capture_) {
+                                // 回合流水线已发过 listen start（见
+                                // StartPipelinedCapture），不再重复宣告
+                                listening_mode_ = kListeningModeAlwaysOn;
+                            } else {
+                                listening_mode_ = kListeningModeAutoStop;
+                                protocol_->SendStartListening(kListeningModeAutoStop);
+                            }
                             SetDeviceState(kDeviceStateListening);
                         } else {
                             SetDeviceState(kDeviceStateIdle);
                         }
                     }
                 });
-            } else if (strcmp(state->valuestring, "sentence_start") == 0) {
+                break;
+            case kStateSentenceStart: {
                 auto text = cJSON_GetObjectItem(root, "text");
                 if (text != NULL) {
                     ESP_LOGI(TAG, "<< %s", text->valuestring);
-                    Schedule([this, display, message = std::string(text->valuestring)]() {
-                        display->SetChatMessage("assistant", message.c_str());
-                    });
+                    auto offset = cJSON_GetObjectItem(root, "offset_ms");
+                    QueueCaption(offset != NULL ? offset->valueint : -1, text->valuestring);
                 }
+                break;
+            }
+            default:
+                break;
             }
-        } else if (strcmp(type->valuestring, "stt") == 0) {
+            break;
+        }
+        case kTypeStt: {
             auto text = cJSON_GetObjectItem(root, "text");
             if (text != NULL) {
                 ESP_LOGI(TAG, ">> %s", text->valuestring);
-                Schedule([this, display, message = std::string(text->valuestring)]() {
-                    display->SetChatMessage("user", message.c_str());
-                });
+                UpdateChatMessage("user", text->valuestring);
             }
-        } else if (strcmp(type->valuestring, "llm") == 0) {
+            break;
+        }
+        case kTypeLlm: {
             auto emotion = cJSON_GetObjectItem(root, "emotion");
             if (emotion != NULL) {
-                Schedule([this, display, emotion_str = std::string(emotion->valuestring)]() {
-                    display->SetEmotion(emotion_str.c_str());
-                });
+                UpdateEmotion(emotion->valuestring);
+            }
+            break;
+        }
+        case kTypeEncoderProfile: {
+            // 会话中也允许服务器降档，不用等重连
+            EncoderProfile profile;
+            auto item = cJSON_GetObjectItem(root, "bitrate");
+            if (item != NULL) {
+                profile.bitrate = item->valueint;
+            }
+            item = cJSON_GetObjectItem(root, "complexity");
+            if (item != NULL) {
+                profile.complexity = item->valueint;
+            }
+            item = cJSON_GetObjectItem(root, "vbr");
+            if (item != NULL) {
+                profile.vbr = cJSON_IsTrue(item) ? 1 : 0;
+            }
+            item = cJSON_GetObjectItem(root, "frame_duration");
+            if (item != NULL) {
+                profile.frame_duration = item->valueint;
             }
-        } else if (strcmp(type->valuestring, "iot") == 0) {
+            ApplyEncoderProfile(profile);
+            break;
+        }
+        case kTypeMetrics: {
+            // 服务器拉取设备健康快照，与周期推送共用注册表组装；
+            // 带 "events":true 改为抽干事件环（性能事件时间线），
+            // 带 "trace":true 导出 Perfetto 格式的打点火焰图
+            auto events = cJSON_GetObjectItem(root, "events");
+            bool want_events = events != NULL && cJSON_IsTrue(events);
+            auto trace = cJSON_GetObjectItem(root, "trace");
+            bool want_trace = trace != NULL && cJSON_IsTrue(trace);
+            Schedule([this, want_events, want_trace]() {
+                if (want_trace) {
+                    protocol_->SendMetrics("{\"trace\":" + event_log::DrainPerfettoJson() + "}");
+                } else if (want_events) {
+                    protocol_->SendMetrics("{\"events\":" + event_log::DrainJson() + "}");
+                } else {
+                    protocol_->SendMetrics(TelemetryRegistry::GetInstance().BuildSnapshot());
+                }
+            }, "metrics_pull");
+            break;
+        }
+        case kTypeTelemetry: {
+            // 服务器下发遥测推送节奏：{"type":"telemetry","interval":30}，
+            // interval 秒一批，0 关掉。不下发就保持默认（不推）
+            auto interval = cJSON_GetObjectItem(root, "interval");
+            if (interval != NULL) {
+                telemetry_interval_s_ = interval->valueint > 0 ? interval->valueint : 0;
+                telemetry_ticks_ = 0;
+                ESP_LOGI(TAG, "Telemetry interval set to %d s", telemetry_interval_s_);
+            }
+            break;
+        }
+        case kTypeIot: {
             auto commands = cJSON_GetObjectItem(root, "commands");
             if (commands != NULL) {
                 auto& thing_manager = iot::ThingManager::GetInstance();
@@ -455,9 +704,254 @@ void Application::Start() {
                     thing_manager.Invoke(command);
                 }
             }
+            break;
+        }
+        default:
+            break;
         }
     });
     protocol_->Start();
+}
+
+// 连续开通道失败达到阈值后切到备用传输：MQTT 的接入参数走 OTA
+// 配置下发（Ota::CheckVersion 已落到 mqtt 命名空间），不用重刷固件。
+// MQTT 为主传输时没有备用——WebSocket 的 URL 只在对应编译配置下存在
+bool Application::OpenAudioChannelWithFailover() {
+    TRACE_SCOPE("channel_open");
+    if (protocol_->OpenAudioChannel()) {
+        channel_open_failures_ = 0;
+        return true;
+    }
+#ifdef CONFIG_CONNECTION_TYPE_WEBSOCKET
+    if (!protocol_fallback_ && ++channel_open_failures_ >= 2) {
+        event_log::Record(event_log::kChannelOpenFailed, (uint16_t)channel_open_failures_);
+        Settings settings("mqtt");
+        config_blobs::MqttConfig mqtt_config = {};
+        bool provisioned = settings.GetBlob("config", config_blobs::MqttConfig::kVersion,
+                &mqtt_config, sizeof(mqtt_config))
+            ? mqtt_config.endpoint[0] != '\0'
+            : !settings.GetString("endpoint").empty();
+        if (!provisioned) {
+            ESP_LOGW(TAG, "No MQTT fallback config provisioned, staying on WebSocket");
+            return false;
+        }
+        ESP_LOGW(TAG, "WebSocket endpoint unreachable, failing over to MQTT");
+        protocol_fallback_ = true;
+        channel_open_failures_ = 0;
+        InitializeProtocol(true);
+        // 新传输立刻试一次，失败也留在备用传输上继续按原重试节奏走
+        return protocol_->OpenAudioChannel();
+    }
+#endif
+    return false;
+}
+
+void Application::Start() {
+    // 先判上次是不是崩溃重启、留存 noinit 环里的现场，再开始记录本次
+    flight_recorder::Init();
+    event_log::Init();
+    // 预算账本在任何大件 PSRAM 分配之前立账（显示缓冲可能在板级
+    // 构造里已经来记过，Init 自身幂等）
+    memory_budget::Init();
+
+    // 设置 schema 迁移在所有消费方读配置之前跑一遍：改名搬值、
+    // 缺失键落默认、表外键告警（见 settings_schema.h）
+    settings_schema::Migrate();
+
+    // 外置语言资产分区（有的话）在任何提示音之前映射好
+    AssetPack::GetInstance().Init();
+
+    // DFS 调速器最先起：启动期持满频锁，之后跟着设备状态走
+    CpuGovernor::GetInstance().Init();
+
+    // 各计数面挂进遥测注册表：服务器拉取和周期推送共用同一份快照
+    auto& telemetry = TelemetryRegistry::GetInstance();
+    telemetry.Register("heap", []() { return HeapTelemetry::GetInstance().BuildJson(); });
+    telemetry.Register("psram_budget", []() { return memory_budget::BuildJson(); });
+    telemetry.Register("capture", []() { return CaptureHealth::GetInstance().BuildJson(); });
+    telemetry.Register("session_mem", []() { return SessionMemory::GetInstance().BuildJson(); });
+    telemetry.Register("cpu", []() { return CpuLoadMonitor::GetInstance().BuildJson(); });
+    telemetry.Register("network", []() { return NetworkQuality::GetInstance().BuildJson(); });
+    telemetry.Register("tasks", []() { return TaskTelemetry::GetInstance().BuildJson(); });
+    telemetry.Register("power", []() { return CpuGovernor::GetInstance().BuildJson(); });
+    telemetry.Register("long_tasks", []() { return LongTaskDetector::GetInstance().BuildJson(); });
+    telemetry.Register("iot", []() { return iot::IotExecutor::GetInstance().BuildJson(); });
+    telemetry.Register("loopback", []() { return AudioLoopbackTest::GetInstance().BuildJson(); });
+    telemetry.Register("opus", []() { return OpusProfiler::GetInstance().BuildJson(); });
+    telemetry.Register("settings", []() { return settings_schema::BuildJson(); });
+    telemetry.Register("nvs", []() { return SettingsStore::GetInstance().BuildWearJson(); });
+#if CONFIG_USE_WAKE_WORD_DETECT || CONFIG_USE_AUDIO_PROCESSOR
+    telemetry.Register("afe", []() { return AudioFrontend::GetInstance().BuildJson(); });
+#endif
+    telemetry.Register("encoder", [this]() {
+        std::lock_guard<std::mutex> lock(opus_encoder_mutex_);
+        return std::string("{\"target\":") + std::to_string(opus_complexity_) +
+            ",\"active\":" + std::to_string(opus_complexity_active_) +
+            ",\"ema_us\":" + std::to_string((long long)encode_ema_us_) +
+            ",\"budget_us\":" + std::to_string(opus_frame_duration_ * 1000) +
+            ",\"ups\":" + std::to_string(tuner_ups_) +
+            ",\"downs\":" + std::to_string(tuner_downs_) + "}";
+    });
+    telemetry.Register("state", [this]() {
+        uint32_t count = transition_count_;
+        return std::string("{\"state\":\"") + STATE_STRINGS[GetDeviceState()] +
+            "\",\"transitions\":" + std::to_string(count) +
+            ",\"invalid\":" + std::to_string(invalid_transitions_) +
+            ",\"avg_ms\":" + std::to_string(count > 0 ? transition_total_us_ / count / 1000 : 0) +
+            ",\"worst_ms\":" + std::to_string(transition_worst_us_ / 1000) +
+            ",\"worst_edge\":\"" + STATE_STRINGS[transition_worst_from_] + "->" +
+            STATE_STRINGS[transition_worst_to_] + "\"}";
+    });
+    telemetry.Register("jitter", [this]() {
+        auto jitter = jitter_buffer_.GetStats();
+        return "{\"depth\":" + std::to_string(jitter.depth) +
+            ",\"target\":" + std::to_string(jitter.target_depth) +
+            ",\"underruns\":" + std::to_string(jitter.underruns) +
+            ",\"late_drops\":" + std::to_string(jitter.late_drops) +
+            ",\"pause_events\":" + std::to_string(jitter.pause_events) +
+            ",\"abort_flushed\":" + std::to_string(jitter.abort_flushed) +
+            ",\"concealed\":" + std::to_string(concealed_frames_) +
+            ",\"concealed_fallback\":" + std::to_string(concealed_fallback_) +
+            ",\"decoder_resets\":" + std::to_string(decoder_resets_) + "}";
+    });
+
+    auto& board = Board::GetInstance();
+    SetDeviceState(kDeviceStateStarting);
+
+    /* Setup the display */
+    boot_profiler::Begin("display");
+    auto display = board.GetDisplay();
+    boot_profiler::End("display");
+
+    /* Setup the audio codec */
+    boot_profiler::Begin("audio_codec");
+    auto codec = board.GetAudioCodec();
+    opus_decode_sample_rate_ = codec->output_sample_rate();
+    opus_decoders_[opus_decode_sample_rate_] = std::make_unique<ProfiledOpusDecoder>(opus_decode_sample_rate_, 1);
+    opus_decoder_ = opus_decoders_[opus_decode_sample_rate_].get();
+    if (opus_decode_sample_rate_ != 16000) {
+        // PlaySound 固定用 16000，提前建好，避免第一声提示音被建解码器卡住
+        opus_decoders_[16000] = std::make_unique<ProfiledOpusDecoder>(16000, 1);
+    }
+    opus_encoder_ = std::make_unique<ProfiledOpusEncoder>(16000, 1, OPUS_FRAME_DURATION_MS);
+    // 播放前至少缓 2 帧，最多允许积压 1.2 秒
+    jitter_buffer_.Configure(OPUS_FRAME_DURATION_MS, 2, 1200 / OPUS_FRAME_DURATION_MS);
+    // 抖动缓冲的上界也进账本（深度上限 × 典型包长）：数额不大，
+    // 但 psram_budget 面板要能对上启动序列承诺过的每一笔
+    memory_budget::Claim("jitter_buffer",
+        (1200 / OPUS_FRAME_DURATION_MS) * 512);
+    // TTS 比实时快，深度越过高水位先请服务器暂停推流，
+    // 长回复不再把几百包攒在 SRAM 里等着被打断扔掉
+    jitter_buffer_.OnBackpressure([this](bool paused) {
+        Schedule([this, paused]() {
+            if (protocol_ != nullptr && protocol_->IsAudioChannelOpened()) {
+                protocol_->SendAudioFlowControl(paused);
+            }
+        });
+    });
+    // 复杂度起点从板级能力矩阵拿（board_caps.h），不再运行期比
+    // GetBoardType() 字符串——蜂窝板和 WiFi 板如今同档，复杂度闭环
+    // 会在编码耗时逼近帧预算时自动降档（见 NoteEncodeTime），空闲
+    // 设备白拿更好的音质，忙的设备不靠保守的静态值保命
+    opus_complexity_ = board_caps::kDefaultOpusComplexity;
+    ESP_LOGI(TAG, "Setting opus encoder complexity to %d%s", opus_complexity_,
+        board_caps::kHasCellular ? " (cellular board)" : "");
+    opus_complexity_active_ = opus_complexity_;
+    opus_encoder_->SetComplexity(opus_complexity_active_);
+
+    // 采样率在编译期已知：16k 板连 Configure 都不编进来
+    if constexpr (board_caps::kNeedsInputResample) {
+        input_resampler_.Configure(kBoardInputSampleRate, 16000);
+        reference_resampler_.Configure(kBoardInputSampleRate, 16000);
+    }
+    // 热路径上的临时 PCM 缓冲全部从池里取，避免每 30ms 帧都走 heap_caps_malloc
+    size_t frame_samples = std::max(codec->input_sample_rate(), codec->output_sample_rate())
+        / 1000 * OPUS_FRAME_DURATION_MS * codec->input_channels();
+    audio_buffer_pool_.Initialize(8, frame_samples);
+    // 堆遥测的子系统 gauge：出问题时至少能分清是谁在涨
+    HeapTelemetry::GetInstance().RegisterGauge("audio_buffer_pool",
+        [this]() { return audio_buffer_pool_.BytesAllocated(); });
+    HeapTelemetry::GetInstance().RegisterGauge("packet_pool",
+        []() { return PacketPool::GetInstance().BytesPooled(); });
+    // 储备归零本身就是碎片化告警信号
+    HeapTelemetry::GetInstance().RegisterGauge("heap_reserve",
+        []() { return HeapGuard::GetInstance().ReserveBytes(); });
+    codec->OnInputReady([this, codec]() {
+        BaseType_t higher_priority_task_woken = pdFALSE;
+        xEventGroupSetBitsFromISR(audio_event_group_, AUDIO_INPUT_READY_EVENT, &higher_priority_task_woken);
+        return higher_priority_task_woken == pdTRUE;
+    });
+    codec->OnOutputReady([this]() {
+        BaseType_t higher_priority_task_woken = pdFALSE;
+        // 说话态绕开主循环，DMA 就绪直接唤醒直驱播放任务；
+        // 非直驱的输出节拍由音频时钟按帧边界驱动（见 OnAudioClock），
+        // 不再跟着 DMA 缓冲粒度的 on_sent 走
+        if (playback_direct_drive_ && playback_task_handle_ != nullptr) {
+            vTaskNotifyGiveFromISR(playback_task_handle_, &higher_priority_task_woken);
+        }
+        return higher_priority_task_woken == pdTRUE;
+    });
+    codec->Start();
+    // 音频时钟起拍：逐拍自排程的一次性定时器，相位锁在帧边界上
+    audio_clock_next_us_ = esp_timer_get_time() + OPUS_FRAME_DURATION_MS * 1000;
+    esp_timer_start_once(audio_clock_handle_, OPUS_FRAME_DURATION_MS * 1000);
+    boot_profiler::End("audio_codec");
+
+    /* Start the main loop */
+    TaskHandle_t main_loop_handle = nullptr;
+    xTaskCreate([](void* arg) {
+        Application* app = (Application*)arg;
+        app->MainLoop();
+        vTaskDelete(NULL);
+    }, "main_loop", 4096 * 2, this, sched_profile::Current().main_loop_priority,
+        &main_loop_handle);
+    TaskTelemetry::GetInstance().RegisterTask("main_loop", main_loop_handle, 4096 * 2);
+    TaskTelemetry::GetInstance().RegisterQueue("main_task", [this]() {
+        return (size_t)uxQueueMessagesWaiting(main_task_queue_);
+    }, 32);
+
+    // 音频泵：输入/输出就绪单独伺候，优先级与播放任务同档，
+    // 一堆排队闭包不再把 DMA 半满事件压在主循环后面
+    TaskHandle_t audio_pump_handle = nullptr;
+    xTaskCreate([](void* arg) {
+        Application* app = (Application*)arg;
+        app->AudioPumpLoop();
+        vTaskDelete(NULL);
+    }, "audio_pump", 4096 * 2, this, sched_profile::Current().playback_priority,
+        &audio_pump_handle);
+    TaskTelemetry::GetInstance().RegisterTask("audio_pump", audio_pump_handle, 4096 * 2);
+
+    // 说话态直驱播放任务：优先级压过主循环，解码不被状态杂务插队
+    xTaskCreate([](void* arg) {
+        Application* app = (Application*)arg;
+        app->PlaybackLoop();
+        vTaskDelete(NULL);
+    }, "playback", 4096 * 4, this, sched_profile::Current().playback_priority,
+        &playback_task_handle_);
+    TaskTelemetry::GetInstance().RegisterTask("playback", playback_task_handle_, 4096 * 4);
+
+    // 注网/DHCP 往往要等好几秒，和唤醒模型加载互不依赖，并行跑：
+    // 网络在后台连，这边先把 AFE+WakeNet 建起来
+    xTaskCreate([](void* arg) {
+        Application* app = (Application*)arg;
+        boot_profiler::Begin("network");
+        Board::GetInstance().StartNetwork();
+        boot_profiler::End("network");
+        xEventGroupSetBits(app->event_group_, NETWORK_READY_EVENT);
+        vTaskDelete(NULL);
+    }, "boot_network", 4096 * 2, this, 2, nullptr);
+
+    // 共享 AFE（检测 + 通话共用一个实例）连同唤醒模型在后台任务里建，
+    // 见下方 afe_init 任务；这里不再同步创建，省出启动关键路径
+
+    /* Wait for the network to be ready */
+    xEventGroupWaitBits(event_group_, NETWORK_READY_EVENT, pdTRUE, pdTRUE, portMAX_DELAY);
+
+    // Initialize the protocol
+    boot_profiler::Begin("protocol");
+    display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
+    InitializeProtocol(false);
+    boot_profiler::End("protocol");
 
     // Check for new firmware version or get the MQTT broker address
     ota_.SetCheckVersionUrl(CONFIG_OTA_VERSION_URL);
@@ -467,27 +961,148 @@ void Application::Start() {
     auto app_desc = esp_app_get_description();
     ota_.SetHeader("User-Agent", std::string(BOARD_NAME "/") + app_desc->version);
 
-    xTaskCreate([](void* arg) {
-        Application* app = (Application*)arg;
-        app->CheckNewVersion();
-        vTaskDelete(NULL);
-    }, "check_new_version", 4096 * 2, this, 2, nullptr);
+    // 已激活设备的开机快路径：上次检查的缓存没过期就直接进待机，
+    // 唤醒词一就绪就能用；版本检查照常拉起，但降级成后台复核，
+    // 启动不再吊在 HTTP 往返上（弱网下那是 60 秒一次的重试）。
+    // 固件刚升级或缓存过期则照旧同步等检查结果
+    if (LoadVersionCheckCache()) {
+        ESP_LOGI(TAG, "Version check cache hit, entering idle before revalidation");
+        SetDeviceState(kDeviceStateIdle);
+    }
+    StartVersionCheckTask();
+
+    // 常用 UI 音效预解码：放批量车道，不占启动关键路径
+    background_task_->Schedule([]() {
+        SoundCache::GetInstance().Prewarm();
+    }, BackgroundTask::kLaneBulk, "sound_prewarm");
 
 #if CONFIG_USE_AUDIO_PROCESSOR
-    audio_processor_.Initialize(codec->input_channels(), codec->input_reference());
-    audio_processor_.OnOutput([this](std::vector<int16_t>&& data) {
-        background_task_->Schedule([this, data = std::move(data)]() mutable {
-            opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
-                Schedule([this, opus = std::move(opus)]() {
-                    protocol_->SendAudio(opus);
+    audio_processor_.OnOutput([this](const int16_t* data, size_t samples) {
+        // 非聆听态不上行，但也不白丢：滚进预滚环。进聆听态的迁移
+        // 有实打实的耗时（等播放尾巴、解码器复位、建链），用户压着
+        // 提示音开口的话头落在这段里，之后从环里补发。
+        // 回合流水线开闸后，说话态也照常上行（下一句压着播报尾巴传）
+        if (device_state_ != kDeviceStateListening &&
+            !(device_state_ == kDeviceStateSpeaking && pipelined_capture_)) {
+            std::lock_guard<std::mutex> lock(preroll_mutex_);
+            if (preroll_ring_.empty()) {
+                preroll_ring_.resize(16 * LISTEN_PREROLL_MS);  // 16 采样/ms @16kHz
+            }
+            for (size_t i = 0; i < samples; i++) {
+                preroll_ring_[preroll_head_] = data[i];
+                preroll_head_ = (preroll_head_ + 1) % preroll_ring_.size();
+            }
+            preroll_size_ = std::min(preroll_size_ + samples, preroll_ring_.size());
+            return;
+        }
+        // 预滚补发：第一个实时帧之前，把提示音时刻以来暂存的采样按
+        // 原顺序先喂编码器（编码器内部按帧长重切），和实时帧在同一
+        // 个任务上串行，顺序天然正确
+        if (preroll_pending_) {
+            std::vector<int16_t> preroll;
+            {
+                std::lock_guard<std::mutex> lock(preroll_mutex_);
+                preroll_pending_ = false;
+                // 环里最新的采样截止到现在，只补发提示音之后的部分
+                size_t keep = (size_t)((esp_timer_get_time() - preroll_cutoff_us_) * 16 / 1000);
+                if (keep > preroll_size_) {
+                    keep = preroll_size_;
+                }
+                if (keep > 0) {
+                    preroll.resize(keep);
+                    size_t start = (preroll_head_ + preroll_ring_.size() - keep) % preroll_ring_.size();
+                    for (size_t i = 0; i < keep; i++) {
+                        preroll[i] = preroll_ring_[(start + i) % preroll_ring_.size()];
+                    }
+                }
+                preroll_size_ = 0;
+            }
+            if (!preroll.empty()) {
+                std::lock_guard<std::mutex> lock(opus_encoder_mutex_);
+                opus_encoder_->Encode(std::move(preroll), [this](std::vector<uint8_t>&& opus) {
+                    QueueUplinkPacket(esp_timer_get_time(), std::move(opus));
                 });
-            });
+            }
+        }
+#if CONFIG_USE_WAKE_WORD_DETECT
+        // 不为静音付编码和流量：VAD 停声后补一段 hangover 再整帧抑制，
+        // 服务器端点检测在 hangover 里已经能收尾
+        if (voice_detected_) {
+            silence_frames_ = 0;
+            segment_spoken_ = true;
+            segment_end_sent_ = false;
+        } else if (++silence_frames_ == SEGMENT_END_SILENCE_FRAMES &&
+                   listening_mode_ == kListeningModeManualStop &&
+                   segment_spoken_ && !segment_end_sent_) {
+            // 手动模式的设备端点检测：用户说完但还按着键，静音拖尾
+            // 到阈值就给服务器发段尾标记，ASR 不用再等自己的静音
+            // 超时（典型 500-800ms）。采集和上行继续，用户接着说话
+            // 会开启新的一段
+            segment_end_sent_ = true;
+            event_log::Record(event_log::kSegmentEnd);
+            Schedule([this]() {
+                if (device_state_ == kDeviceStateListening) {
+                    protocol_->SendListenSegmentEnd();
+                }
+            }, "segment_end");
+        } else if (silence_frames_ > SILENCE_HANGOVER_FRAMES) {
+            if (++suppressed_frames_ % 500 == 0) {
+                ESP_LOGI(TAG, "Uplink silence suppression: %lu frames skipped", suppressed_frames_);
+            }
+            return;
+        }
+#endif
+        // 融合管线：编码就在 AFE fetch 任务上做，借用指针直接喂进
+        // 编码器，省掉一跳任务切换和一次中间拷贝。AFE 内部有几十帧
+        // 的环缓冲，编码的几毫秒不会憋住 feed；与档位切换的互斥靠
+        // opus_encoder_mutex_
+        LATENCY_TIMESTAMP(capture_us);
+        LATENCY_TIMESTAMP(encode_start_us);
+        std::lock_guard<std::mutex> lock(opus_encoder_mutex_);
+        int64_t tuner_start_us = esp_timer_get_time();
+        opus_encoder_->Encode(std::vector<int16_t>(data, data + samples),
+            [this, capture_us, encode_start_us](std::vector<uint8_t>&& opus) {
+            LATENCY_RECORD(kStageEncode, encode_start_us);
+            LATENCY_RECORD(kStageCapture, capture_us);
+            LATENCY_TIMESTAMP(send_start_us);
+            QueueUplinkPacket(send_start_us, std::move(opus));
+        });
+        NoteEncodeTime(esp_timer_get_time() - tuner_start_us);
+    });
+
+    audio_processor_.OnVadStateChange([this](bool speaking) {
+        Schedule([this, speaking]() {
+            // AEC 消掉 TTS 回声后仍检测到人声：用户在插话。
+            // 有无回采参考是编译期事实，没有的板子整个分支折叠掉
+            if constexpr (board_caps::kHasAecReference) {
+                if (device_state_ != kDeviceStateSpeaking) {
+                    return;
+                }
+                if (protocol_ && protocol_->turn_pipeline_supported()) {
+                    // 回合流水线：不本地打断，开口即开始上行下一句，
+                    // 播报尾巴继续放，切不切回合由服务器判定——误触
+                    //（咳嗽、旁人说话）不会把播报拦腰掐断
+                    if (speaking && !pipelined_capture_) {
+                        StartPipelinedCapture();
+                    } else if (speaking) {
+                        // 同一轮播报里停顿后又开口：上行通道还开着，
+                        // 只需把静音抑制重新掰回"在说话"
+                        voice_detected_ = true;
+                        silence_frames_ = 0;
+                    } else if (pipelined_capture_) {
+                        // 话说完了：交还静音抑制，尾音 hangover 后不再白传
+                        voice_detected_ = false;
+                    }
+                } else if (speaking) {
+                    // 老服务器没有流水线语义，保持本地立即打断
+                    AbortSpeaking(kAbortReasonNone);
+                }
+            }
         });
     });
 #endif
 
 #if CONFIG_USE_WAKE_WORD_DETECT
-    wake_word_detect_.Initialize(codec->input_channels(), codec->input_reference());
     wake_word_detect_.OnVadStateChange([this](bool speaking) {
         Schedule([this, speaking]() {
             if (device_state_ == kDeviceStateListening) {
@@ -498,26 +1113,34 @@ void Application::Start() {
                 }
                 auto led = Board::GetInstance().GetLed();
                 led->OnStateChanged();
+            } else if (speaking && device_state_ == kDeviceStateIdle &&
+                       protocol_ && !protocol_->IsAudioChannelOpened()) {
+                // 空闲时开口大概率接着就是唤醒词：先把连接/TLS/hello 做掉
+                channel_pre_warmed_ = protocol_->OpenAudioChannel();
+                pre_warm_ticks_ = 0;
             }
         });
     });
 
     wake_word_detect_.OnWakeWordDetected([this](const std::string& wake_word) {
         Schedule([this, &wake_word]() {
+            // 唤醒→建链→首包 的整段耗时在火焰图上连成一条
+            TRACE_SCOPE("wake_handler");
             if (device_state_ == kDeviceStateIdle) {
                 SetDeviceState(kDeviceStateConnecting);
-                wake_word_detect_.EncodeWakeWordData();
+                // 先截下窗口快照，检测重启后的新音频不混进这一批
+                auto wake_word_data = wake_word_detect_.TakeWakeWordData();
 
-                if (!protocol_->OpenAudioChannel()) {
+                // 预热过的通道直接用，省掉整个连接握手
+                if (!protocol_->IsAudioChannelOpened() && !OpenAudioChannelWithFailover()) {
                     wake_word_detect_.StartDetection();
                     return;
                 }
-                
-                std::vector<uint8_t> opus;
-                // Encode and send the wake word data to the server
-                while (wake_word_detect_.GetWakeWordOpus(opus)) {
-                    protocol_->SendAudio(opus);
-                }
+                channel_pre_warmed_ = false;
+
+                // 整批交给协议层：支持批帧的服务器收两三个大帧，
+                // 否则逐包兜底
+                protocol_->SendWakeWordAudio(std::move(wake_word_data));
                 // Set the chat state to wake word detected
                 protocol_->SendWakeWordDetected(wake_word);
                 ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
@@ -531,28 +1154,212 @@ void Application::Start() {
 
             // Resume detection
             wake_word_detect_.StartDetection();
-        });
+        }, "wake_word");
     });
-    wake_word_detect_.StartDetection();
-#endif
 
-    SetDeviceState(kDeviceStateIdle);
+    // 说话态的设备端命令词："停止"本地命中直接打断，不再等服务器
+    // 从转录里识别出来再绕一圈回指令。命令词网络只在说话态开闸，
+    // 回调在 fetch 任务上，打断收回主循环做
+    AudioFrontend::GetInstance().OnCommandDetected([this](const std::string& command) {
+        if (command.find("停") == std::string::npos &&
+            command.find("stop") == std::string::npos) {
+            // 目前只接了打断；模型里带的其他命令词（音量等）先记日志
+            ESP_LOGI(TAG, "Unhandled command word: %s", command.c_str());
+            return;
+        }
+        Schedule([this]() {
+            if (device_state_ == kDeviceStateSpeaking) {
+                AbortSpeaking(kAbortReasonNone);
+            }
+        });
+    });
+
+    // 聆听态的短语直通：MultiNet 命中 command_shortcuts 表里的短语
+    // （音量调节等）直接在设备端执行，省掉 ASR→LLM→iot 指令一整圈；
+    // 表外话音照旧上行走服务器。回调在 fetch 任务上，Invoke 收回
+    // 主循环做——iot 命令本来就在主循环里执行
+    AudioFrontend::GetInstance().OnShortcutDetected([this](int command_id) {
+        Schedule([this, command_id]() {
+            if (device_state_ != kDeviceStateListening) {
+                return;
+            }
+            if (!command_shortcuts::Dispatch(command_id)) {
+                ESP_LOGW(TAG, "Unknown shortcut command id: %d", command_id);
+            }
+        }, "shortcut");
+    });
+
+#endif
+
+#if CONFIG_USE_WAKE_WORD_DETECT || CONFIG_USE_AUDIO_PROCESSOR
+    // 共享前端（含唤醒模型，从 flash 分区读一秒多）不挡就绪：回调都已
+    // 挂好，设备先到空闲（按键立刻可用），AFE 由低优先级任务后台建，
+    // 建好再开检测。建好之前 Feed 直接丢帧，不会碰 AFE
+    xTaskCreate([](void* arg) {
+        Application* app = (Application*)arg;
+        boot_profiler::Begin("afe_init");
+        int64_t start_us = esp_timer_get_time();
+#if CONFIG_USE_AUDIO_PROCESSOR
+        app->audio_processor_.Initialize(kBoardInputChannels, board_caps::kHasAecReference);
+#endif
+#if CONFIG_USE_WAKE_WORD_DETECT
+        app->wake_word_detect_.Initialize(kBoardInputChannels, board_caps::kHasAecReference);
+#endif
+        boot_profiler::End("afe_init");
+        ESP_LOGI(TAG, "Audio frontend ready in %lld ms",
+            (esp_timer_get_time() - start_us) / 1000);
+#if CONFIG_USE_WAKE_WORD_DETECT
+        app->wake_word_detect_.StartDetection();
+#endif
+#if CONFIG_USE_AUDIO_PROCESSOR
+        // 预热常开：空闲/播报期间 AFE 内部环始终是满的，进听音状态
+        // 第一个 chunk 就有处理好的帧，提示音后的第一个字不再被削
+        app->audio_processor_.PreArm(true);
+#endif
+        vTaskDelete(NULL);
+    }, "afe_init", 4096 * 2, this, 1, nullptr);
+#endif
+
+    // 采集健康面板是所有板子共有的硬件面，不走板级 InitializeIot，
+    // 在这里统一挂上（写了 board.cmake 清单的板子把 capture_meter
+    // 列进 BOARD_THINGS 才会编入）
+    if (auto* capture_meter = iot::CreateThing("CaptureMeter")) {
+        iot::ThingManager::GetInstance().AddThing(capture_meter);
+    }
+
+    SetDeviceState(kDeviceStateIdle);
+    // 启动的大件分配都过去了，趁堆还干净抓下雨天储备
+    HeapGuard::GetInstance().PreallocateReserve();
     esp_timer_start_periodic(clock_timer_handle_, 1000000);
+    boot_profiler::Report();
 }
 
 void Application::OnClockTimer() {
     clock_ticks_++;
 
+    // 版本检查重试/激活复查倒计时到点，重新拉起短命检查任务
+    if (version_check_ticks_ > 0 && --version_check_ticks_ == 0) {
+        StartVersionCheckTask();
+    }
+
+    // 链路质量换档：降低编码复杂度省带宽，抬高抖动缓冲下限抗丢包；
+    // 迟滞在监测侧做，这里只跟随档位变化
+    if (clock_ticks_ % 5 == 0) {
+        int level = NetworkQuality::GetInstance().level();
+        if (level != network_quality_level_) {
+            network_quality_level_ = level;
+            Schedule([this, level]() {
+                static const int kComplexityByLevel[] = { 3, 2, 1 };
+                static const size_t kJitterFloorByLevel[] = { 2, 4, 6 };
+                ESP_LOGI(TAG, "Adapting to link quality level %d", level);
+                EncoderProfile profile;
+                profile.complexity = kComplexityByLevel[level];
+                ApplyEncoderProfile(profile);
+                jitter_buffer_.RaiseFloor(kJitterFloorByLevel[level]);
+            });
+        }
+    }
+
+    // 预取好的固件挑真正空闲的时刻切换，说话/聊天中绝不打断
+    if (pending_ota_activation_ && CanEnterSleepMode()) {
+        pending_ota_activation_ = false;
+        Schedule([this]() {
+            if (!CanEnterSleepMode()) {
+                pending_ota_activation_ = true;
+                return;
+            }
+            SetDeviceState(kDeviceStateUpgrading);
+            auto display = Board::GetInstance().GetDisplay();
+            std::string message = std::string(Lang::Strings::NEW_VERSION) + ota_.GetFirmwareVersion();
+            display->SetChatMessage("system", message.c_str());
+            if (!ota_.ActivatePrefetchedFirmware()) {
+                // 镜像校验没过，回到空闲，等下次版本检查重新预取
+                SetDeviceState(kDeviceStateIdle);
+            }
+        });
+    }
+
+    // 遥测批推送：到点组一份注册表快照发出去。计数独立于
+    // clock_ticks_（那个随状态切换清零），通道没开这个周期就跳过
+    if (telemetry_interval_s_ > 0 && ++telemetry_ticks_ >= telemetry_interval_s_) {
+        telemetry_ticks_ = 0;
+        Schedule([this]() {
+            if (protocol_ != nullptr && protocol_->IsAudioChannelOpened()) {
+                protocol_->SendTelemetry(TelemetryRegistry::GetInstance().BuildSnapshot());
+            }
+        });
+    }
+
+    // 预热的通道没等来唤醒词就放掉，别占着服务器
+    if (channel_pre_warmed_ && ++pre_warm_ticks_ > 10) {
+        channel_pre_warmed_ = false;
+        Schedule([this]() {
+            if (device_state_ == kDeviceStateIdle && protocol_ && protocol_->IsAudioChannelOpened()) {
+                protocol_->CloseAudioChannel();
+            }
+        });
+    }
+
+    // 阻塞属性（电量计这类 I2C 读数）的后台采样：批量车道低优先级
+    // 刷新缓存，GetStatesJson 在通道建立路径上只读缓存不碰总线
+    if (clock_ticks_ % 5 == 0 && iot::ThingManager::GetInstance().has_blocking_things()) {
+        ScheduleBulk([]() {
+            iot::ThingManager::GetInstance().SampleBlockingProperties();
+        }, "iot_sample");
+    }
+
+    // 攒下的 NVS commit 只在待机态落盘：flash commit 会挂起 cache
+    // 几十毫秒，绝不让它落在对话当中。批量车道低优先级执行，
+    // 执行时再验一次状态——调度到执行之间用户可能已经开口
+    if (device_state_ == kDeviceStateIdle &&
+        SettingsStore::GetInstance().HasPendingCommits()) {
+        ScheduleBulk([this]() {
+            if (device_state_ == kDeviceStateIdle) {
+                SettingsStore::GetInstance().CommitPending();
+            }
+        }, "nvs_commit");
+    }
+
     // Print the debug info every 10 seconds
     if (clock_ticks_ % 10 == 0) {
-        // SystemInfo::PrintRealTimeStats(pdMS_TO_TICKS(1000));
+        HeapTelemetry::GetInstance().Sample();
+        // 碎片化哨兵：每次采样跟着查告警，空闲窗口顺带做整理
+        HeapGuard::GetInstance().Maintain(CanEnterSleepMode());
+        SessionMemory::GetInstance().Sample();
+        CpuLoadMonitor::GetInstance().Sample();
+        TaskTelemetry::GetInstance().Sample();
         int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
         int min_free_sram = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
-        ESP_LOGI(TAG, "Free internal: %u minimal internal: %u", free_sram, min_free_sram);
+        ESP_LOGI(TAG, "Free internal: %u minimal internal: %u schedule fallbacks: %lu",
+            free_sram, min_free_sram, task_slots_.heap_fallbacks());
+        auto residency = CpuGovernor::GetInstance().GetResidency();
+        ESP_LOGI(TAG, "CPU residency: full %lld ms scaled %lld ms transitions %lu",
+            residency.full_ms, residency.scaled_ms, residency.transitions);
+        flight_recorder::RecordSnapshot(free_sram,
+            heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),
+            (uint16_t)std::min<uint32_t>(TaskTelemetry::GetInstance().MinFreeStackBytes(), UINT16_MAX));
+
+        if (device_state_ == kDeviceStateSpeaking) {
+            auto stats = jitter_buffer_.GetStats();
+            ESP_LOGI(TAG, "Jitter buffer: depth %zu target %zu underruns %lu drops %lu",
+                stats.depth, stats.target_depth, stats.underruns, stats.late_drops);
+            flight_recorder::RecordAudio(stats.underruns, stats.late_drops);
+            // 统计值是累计的，事件环里只记本周期的增量
+            static uint32_t last_underruns = 0, last_drops = 0;
+            if (stats.underruns > last_underruns) {
+                event_log::Record(event_log::kJitterUnderrun, 0, stats.underruns - last_underruns);
+            }
+            if (stats.late_drops > last_drops) {
+                event_log::Record(event_log::kUplinkDrop, 0, stats.late_drops - last_drops);
+            }
+            last_underruns = stats.underruns;
+            last_drops = stats.late_drops;
+        }
+        LATENCY_REPORT();
 
         // If we have synchronized server time, set the status to clock "HH:MM" if the device is idle
         if (ota_.HasServerTime()) {
-            if (device_state_ == kDeviceStateIdle) {
+            if (device_state_ == kDeviceStateIdle && !ambient_clock_) {
                 Schedule([this]() {
                     // Set status to clock "HH:MM"
                     time_t now = time(NULL);
@@ -563,58 +1370,166 @@ void Application::OnClockTimer() {
             }
         }
     }
-}
 
-void Application::Schedule(std::function<void()> callback) {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        main_tasks_.push_back(std::move(callback));
+    // 持续空闲约三分钟后切常亮表盘：LVGL 整个停掉，之后每分钟只剩
+    // 一次字模直贴，调速器可以一直待在最低档。clock_ticks_ 随状态
+    // 切换清零，正好当空闲秒数用
+    if (device_state_ == kDeviceStateIdle && !ambient_clock_ &&
+            clock_ticks_ >= 180 && ota_.HasServerTime()) {
+        ambient_clock_ = true;
+        Schedule([]() {
+            Board::GetInstance().GetDisplay()->SetAmbientClock(true);
+        });
     }
-    xEventGroupSetBits(event_group_, SCHEDULE_EVENT);
 }
 
 // The Main Loop controls the chat state and websocket connection
 // If other tasks need to access the websocket or chat state,
 // they should use Schedule to call this function
+bool IRAM_ATTR Application::PostButtonEventFromISR(Button* button, bool pressed, int64_t timestamp_us) {
+    ButtonEvent event = { button, timestamp_us, pressed };
+    BaseType_t task_woken = pdFALSE;
+    if (xQueueSendFromISR(button_event_queue_, &event, &task_woken) != pdTRUE) {
+        return false;
+    }
+    BaseType_t unblocked = pdFALSE;
+    xEventGroupSetBitsFromISR(event_group_, BUTTON_EVENT, &unblocked);
+    if (task_woken == pdTRUE || unblocked == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+    return true;
+}
+
 void Application::MainLoop() {
     while (true) {
         auto bits = xEventGroupWaitBits(event_group_,
-            SCHEDULE_EVENT | AUDIO_INPUT_READY_EVENT | AUDIO_OUTPUT_READY_EVENT,
+            SCHEDULE_EVENT | BUTTON_EVENT,
+            pdTRUE, pdFALSE, portMAX_DELAY);
+
+        // 按键最先处理：PTT 按下到开始采集的延迟直接决定吞不吞字
+        if (bits & BUTTON_EVENT) {
+            ButtonEvent event;
+            while (xQueueReceive(button_event_queue_, &event, 0) == pdTRUE) {
+                event.button->DispatchFastEvent(event.pressed, event.timestamp_us);
+            }
+        }
+        if (bits & SCHEDULE_EVENT) {
+            TaskRef task;
+            while (xQueueReceive(main_task_queue_, &task, 0) == pdTRUE) {
+                int64_t start_us = esp_timer_get_time();
+                task.Run();
+                // 音频搬运已拆去独立泵任务，但慢闭包仍会拖住按键
+                // 和后续调度，超预算的按调度点记账
+                LongTaskDetector::GetInstance().Record(task.tag, esp_timer_get_time() - start_us);
+            }
+        }
+    }
+}
+
+// 音频泵：只伺候 DMA 就绪事件。输入侧的编码调度自己持
+// opus_encoder_mutex_；输出侧经闸门与 SetDeviceState 的解码器
+// 复位互斥（见 output_pump_gate_ 的注释）
+void Application::AudioPumpLoop() {
+    while (true) {
+        auto bits = xEventGroupWaitBits(audio_event_group_,
+            AUDIO_INPUT_READY_EVENT | AUDIO_OUTPUT_READY_EVENT,
             pdTRUE, pdFALSE, portMAX_DELAY);
 
         if (bits & AUDIO_INPUT_READY_EVENT) {
             InputAudio();
         }
         if (bits & AUDIO_OUTPUT_READY_EVENT) {
-            OutputAudio();
-        }
-        if (bits & SCHEDULE_EVENT) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            std::list<std::function<void()>> tasks = std::move(main_tasks_);
-            lock.unlock();
-            for (auto& task : tasks) {
-                task();
+            std::lock_guard<std::mutex> lock(output_mutex_);
+            if (output_pump_gate_) {
+                OutputAudio();
             }
         }
     }
 }
 
 void Application::ResetDecoder() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    // 只在 SetDeviceState 里调用，彼时解码队列已经排空（WaitForCompletion）、
+    // 直驱播放任务已退出热循环、音频泵的输出侧已关闸，
+    // 没有并发的解码路径，不需要锁；jitter buffer 自带内部锁
     opus_decoder_->ResetState();
-    audio_decode_queue_.clear();
+    jitter_buffer_.Clear();
+    window_frames_drained_ = 0;
+    last_pcm_.clear();
+    conceal_run_ = 0;
+    decode_fail_run_ = 0;
+    // 队列已清空，别让半截提示音把满频锁一直吊着
+    CpuGovernor::GetInstance().SetPipelineActive(false);
     last_output_time_ = std::chrono::steady_clock::now();
 }
 
+// 音频时钟：非直驱输出的节拍源。on_sent 按 DMA 缓冲粒度触发，和
+// 60ms 帧时序混叠，队列深度会系统性振荡；这里按帧边界整拍唤醒音频
+// 泵。esp_timer 的晶振和 I2S 的采样时钟各漂各的，每拍按写入游标的
+// 提前量（tx_tail - now）相对一帧目标的偏差微调下一拍周期——锁相
+// 而不追相，单拍最多修 ±2ms，漂移慢慢收敛而节拍不会跳出帧边界
+void Application::OnAudioClock() {
+    constexpr int64_t kFrameUs = OPUS_FRAME_DURATION_MS * 1000;
+    if (!playback_direct_drive_) {
+        xEventGroupSetBits(audio_event_group_, AUDIO_OUTPUT_READY_EVENT);
+    }
+    int64_t now = esp_timer_get_time();
+    int64_t period = kFrameUs;
+    int64_t lead = Board::GetInstance().GetAudioCodec()->output_tail_us() - now;
+    if (lead > 0) {
+        // 有存量在放才校正：提前量高于一帧说明供快于耗，拉长下一拍，
+        // 反之缩短。没货（静音/刚起播）时按整帧盲走
+        int64_t error = lead - kFrameUs;
+        if (error > 2000) {
+            error = 2000;
+        } else if (error < -2000) {
+            error = -2000;
+        }
+        period += error;
+    }
+    audio_clock_next_us_ += period;
+    int64_t delay = audio_clock_next_us_ - now;
+    if (delay < 1000) {
+        // 本拍被高优先级活挤晚了太多，不补发积压的拍，直接重定相位
+        audio_clock_next_us_ = now + period;
+        delay = period;
+    }
+    esp_timer_start_once(audio_clock_handle_, delay);
+}
+
 void Application::OutputAudio() {
     auto now = std::chrono::steady_clock::now();
     auto codec = Board::GetInstance().GetAudioCodec();
     const int max_silence_seconds = 10;
 
-    std::unique_lock<std::mutex> lock(mutex_);
-    if (audio_decode_queue_.empty()) {
-        // Disable the output if there is no audio data for a long time
+    // 说话态由直驱播放任务整链处理，音频泵不再逐帧搬运
+    if (playback_direct_drive_) {
+        return;
+    }
+
+    if (device_state_ == kDeviceStateListening) {
+        jitter_buffer_.Clear();
+        // 聆听态不放提示音（没 AEC 的板子会录进上行），排队中的
+        // 直接冲掉——和旧的串行路径丢弃语义一致，回调照常触发
+        SoundMixer::GetInstance().Clear();
+        return;
+    }
+
+    JitterBuffer::AudioFrame frame;
+    if (!jitter_buffer_.Pop(frame)) {
+        // 会话无输出时 UI 声道单独出帧，节拍仍由音频时钟驱动
+        if (SoundMixer::GetInstance().IsActive()) {
+            std::vector<int16_t> pcm;
+            size_t samples = (size_t)codec->output_sample_rate() / 1000 * OPUS_FRAME_DURATION_MS;
+            if (SoundMixer::GetInstance().RenderFrame(pcm, samples, codec->output_sample_rate())) {
+                last_output_time_ = now;
+                codec->OutputData(pcm);
+                return;
+            }
+        }
+        // 预缓冲或欠载时不输出；空闲太久就关掉输出
         if (device_state_ == kDeviceStateIdle) {
+            // 提示音放完了，管线信号清掉，DFS 可以降档
+            CpuGovernor::GetInstance().SetPipelineActive(false);
             auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - last_output_time_).count();
             if (duration > max_silence_seconds) {
                 codec->EnableOutput(false);
@@ -623,36 +1538,245 @@ void Application::OutputAudio() {
         return;
     }
 
-    if (device_state_ == kDeviceStateListening) {
-        audio_decode_queue_.clear();
-        return;
+    last_output_time_ = now;
+    CreditAudioWindow(frame);
+
+    decode_task_->Schedule([this, frame = std::move(frame)]() mutable {
+        DecodeAndOutput(std::move(frame));
+    });
+}
+
+// 说话态直驱：DMA 就绪通知直接落在本任务，出队→解码→写 codec
+// 一条链做完，不再走 主循环事件→解码队列 的调度往返（每 60ms 帧
+// 省下几次上下文切换）。OutputData 在 DMA 满时阻塞，天然起到解码
+// 提前量的作用——缓冲里有货就一直往前解，欠载余量比逐事件驱动大
+// 得多。退出握手见 SetDeviceState
+void Application::PlaybackLoop() {
+    auto codec = Board::GetInstance().GetAudioCodec();
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        std::lock_guard<std::mutex> lock(playback_mutex_);
+        while (playback_direct_drive_) {
+            // 先把前瞻环补到目标深度再写 DMA：写 DMA 会在满时阻塞，
+            // 存货在那之前备好，单帧解码尖峰由存货顶住
+            while ((int)ready_pcm_.size() < decode_ahead_depth_) {
+                JitterBuffer::AudioFrame frame;
+                if (!jitter_buffer_.Pop(frame)) {
+                    break;
+                }
+                last_output_time_ = std::chrono::steady_clock::now();
+                CreditAudioWindow(frame);
+                auto pcm = DecodeFrame(std::move(frame));
+                if (pcm.valid()) {
+                    ready_pcm_.push_back(std::move(pcm));
+                }
+            }
+            if (ready_pcm_.empty()) {
+                // 预缓冲或欠载，等下一次 DMA 就绪通知
+                break;
+            }
+            auto pcm = std::move(ready_pcm_.front());
+            ready_pcm_.pop_front();
+            // 说话中来的提示音（如命令词确认）压低 TTS 叠上去
+            SoundMixer::GetInstance().MixInto(*pcm, codec->output_sample_rate());
+            codec->OutputData(*pcm);
+        }
     }
+}
 
-    last_output_time_ = now;
-    auto opus = std::move(audio_decode_queue_.front());
-    audio_decode_queue_.pop_front();
-    lock.unlock();
+void Application::DecodeAndOutput(JitterBuffer::AudioFrame&& frame) {
+    auto pcm = DecodeFrame(std::move(frame));
+    if (pcm.valid()) {
+        auto codec = Board::GetInstance().GetAudioCodec();
+        SoundMixer::GetInstance().MixInto(*pcm, codec->output_sample_rate());
+        codec->OutputData(*pcm);
+    }
+}
 
-    background_task_->Schedule([this, codec, opus = std::move(opus)]() mutable {
-        if (aborted_) {
-            return;
+AudioBufferPool::Handle Application::DecodeFrame(JitterBuffer::AudioFrame&& frame) {
+    if (aborted_) {
+        return {};
+    }
+
+    // 空帧是传输层的丢包标记，走隐藏路径而不是解码
+    if (frame.size() == 0) {
+        return ConcealFrame();
+    }
+
+    // flash 切片在这里才落成单包 vector，避免整段提示音的 SRAM 峰值
+    //（UI 音效已分流到 SoundMixer，预解码缓存的命中也挪到了那边）
+    std::vector<uint8_t> opus = frame.owned.empty()
+        ? std::vector<uint8_t>(frame.data(), frame.data() + frame.size())
+        : std::move(frame.owned);
+    auto pcm = audio_buffer_pool_.Acquire();
+    // 深度自适应要靠真实耗时，不用打点宏的时间戳（关统计时它是 0）
+    int64_t decode_start_us = esp_timer_get_time();
+    bool decoded = opus_decoder_->Decode(std::move(opus), *pcm);
+    int64_t decode_us = esp_timer_get_time() - decode_start_us;
+    LATENCY_RECORD(kStageDecode, decode_start_us);
+    // 用完的包缓冲还给接收路径复用
+    PacketPool::GetInstance().Release(std::move(opus));
+    if (!decoded) {
+        // 连续失败不是零星坏包而是流级损坏（服务端装帧 bug、批帧
+        // 错位）：解码器内部状态已不可信，继续逐包硬啃只会把嘶哑
+        // 拖到挂断。重置解码器、清掉抖动缓冲里同一段坏流，从下一
+        // 个干净包重新垫底
+        if (++decode_fail_run_ >= 3) {
+            ESP_LOGW(TAG, "Corrupt stream: %d consecutive decode failures, resetting decoder",
+                decode_fail_run_);
+            event_log::Record(event_log::kCorruptStream, (uint16_t)decode_fail_run_);
+            opus_decoder_->ResetState();
+            jitter_buffer_.Clear();
+            last_pcm_.clear();
+            conceal_run_ = 0;
+            decoder_resets_++;
+            decode_fail_run_ = 0;
         }
+        return {};
+    }
 
-        std::vector<int16_t> pcm;
-        if (!opus_decoder_->Decode(std::move(opus), pcm)) {
-            return;
+    // 好帧到手：更新隐藏素材，清掉连续隐藏计数和失败计数
+    conceal_run_ = 0;
+    decode_fail_run_ = 0;
+    last_pcm_.assign(pcm->begin(), pcm->end());
+
+    // 解码耗时的 EWMA 均值/偏差（1/8 步长），前瞻深度按抖动走：
+    // 稳定语音 2 帧兜底，音乐类 TTS 抖起来每满半帧预算加一帧，
+    // 封顶 4 帧（多一帧就是多 60ms 额外缓冲延迟，不白给）
+    decode_time_mean_us_ += (decode_us - decode_time_mean_us_) / 8;
+    int64_t dev = decode_us - decode_time_mean_us_;
+    decode_time_dev_us_ += ((dev < 0 ? -dev : dev) - decode_time_dev_us_) / 8;
+    int depth = 2 + (int)(decode_time_dev_us_ / (OPUS_FRAME_DURATION_MS * 1000 / 2));
+    decode_ahead_depth_ = depth > 4 ? 4 : depth;
+
+    if (frame.recv_time_us != 0) {
+        // 本地提示音（flash 切片）没有到达时间，只统计网络下行。
+        // 前瞻解码后这里量到的是 到达→解码就绪，写 DMA 由环的存货垫付
+        LATENCY_RECORD(kStageOutput, frame.recv_time_us);
+    }
+
+    // Resample if the sample rate is different.
+    // Opus 原生输出率的板子解码即终态，这一级整段折叠，逐帧零检查
+    if constexpr (!board_caps::kOutputRateOpusNative) {
+        auto codec = Board::GetInstance().GetAudioCodec();
+        if (opus_decode_sample_rate_ != codec->output_sample_rate()) {
+            auto resampled = audio_buffer_pool_.Acquire();
+            resampled->resize(output_resampler_.GetOutputSamples(pcm->size()));
+            output_resampler_.Process(pcm->data(), pcm->size(), resampled->data());
+            return resampled;
         }
+    }
+    return pcm;
+}
+
+// 丢包隐藏：先让解码器自己做 PLC（空载荷解码，libopus 对丢包输入
+// 按前一帧状态合成过渡音），解码器不接受空载荷时退化成上一个好帧
+// 的衰减重放。连续隐藏超过 3 帧就放弃——那是断流不是零星丢包，
+// 静音比拖长的合成音好听，抖动缓冲会重新垫底
+AudioBufferPool::Handle Application::ConcealFrame() {
+    if (conceal_run_ >= 3 || last_pcm_.empty()) {
+        return {};
+    }
+    conceal_run_++;
+    auto pcm = audio_buffer_pool_.Acquire();
+    if (opus_decoder_->Decode(std::vector<uint8_t>(), *pcm)) {
+        concealed_frames_++;
+    } else {
+        // 每连丢一帧幅度再减半，三帧内淡到听不见
+        pcm->resize(last_pcm_.size());
+        for (size_t i = 0; i < last_pcm_.size(); i++) {
+            (*pcm)[i] = last_pcm_[i] >> conceal_run_;
+        }
+        concealed_fallback_++;
+    }
 
-        // Resample if the sample rate is different
+    // 隐藏帧同样要跟着输出采样率走
+    if constexpr (!board_caps::kOutputRateOpusNative) {
+        auto codec = Board::GetInstance().GetAudioCodec();
         if (opus_decode_sample_rate_ != codec->output_sample_rate()) {
-            int target_size = output_resampler_.GetOutputSamples(pcm.size());
-            std::vector<int16_t> resampled(target_size);
-            output_resampler_.Process(pcm.data(), pcm.size(), resampled.data());
-            pcm = std::move(resampled);
+            auto resampled = audio_buffer_pool_.Acquire();
+            resampled->resize(output_resampler_.GetOutputSamples(pcm->size()));
+            output_resampler_.Process(pcm->data(), pcm->size(), resampled->data());
+            return resampled;
         }
-        
-        codec->OutputData(pcm);
-    });
+    }
+    return pcm;
+}
+
+void Application::CreditAudioWindow(const JitterBuffer::AudioFrame& frame) {
+    // 每放掉半个窗口的网络帧就把额度还给服务器，推流始终贴着
+    // 播放速度走，打断时队里最多压着一个窗口（本地提示音不占窗口）。
+    // 协议访问统一回主循环做，直驱任务不直接碰 websocket
+    if (frame.recv_time_us == 0) {
+        return;
+    }
+    // 字幕时间线推进：带流时间戳的帧（0x03）按戳校准，服务器跳过
+    // 静音段也不漂；裸包按帧长累加。这里在解码出队点计数，比扬声器
+    // 实际出声早一个前瞻环（≤4 帧），对字幕是可接受的提前量
+    uint32_t pos = frame.stream_ms != 0 ? frame.stream_ms
+        : tts_position_ms_.load(std::memory_order_relaxed) + OPUS_FRAME_DURATION_MS;
+    tts_position_ms_.store(pos, std::memory_order_relaxed);
+    if (has_pending_captions_.load(std::memory_order_acquire)) {
+        // 到点的字幕直接上屏；display 的更新路径本身异步且线程安全
+        while (true) {
+            std::string text;
+            {
+                std::lock_guard<std::mutex> lock(caption_mutex_);
+                if (pending_captions_.empty() || pending_captions_.front().first > pos) {
+                    has_pending_captions_.store(!pending_captions_.empty(),
+                        std::memory_order_release);
+                    break;
+                }
+                text = std::move(pending_captions_.front().second);
+                pending_captions_.pop_front();
+            }
+            AppendChatMessage("assistant", text.c_str());
+        }
+    }
+    const int kWindowUpdateFrames = (1200 / OPUS_FRAME_DURATION_MS) / 2;
+    if (++window_frames_drained_ >= kWindowUpdateFrames) {
+        int frames = window_frames_drained_;
+        window_frames_drained_ = 0;
+        Schedule([this, frames]() {
+            if (protocol_ != nullptr && protocol_->IsAudioChannelOpened()) {
+                protocol_->SendAudioWindowUpdate(frames);
+            }
+        });
+    }
+}
+
+// 字幕时间线：sentence_start 带 offset_ms（相对本轮 TTS 音频起点）时
+// 不立刻上屏，等播放位置追到再显示，弱网下字幕不再超前语音几秒；
+// 不带字段的服务器保持老行为（即到即显）
+void Application::QueueCaption(int offset_ms, const char* text) {
+    if (offset_ms < 0 ||
+        (uint32_t)offset_ms <= tts_position_ms_.load(std::memory_order_relaxed)) {
+        AppendChatMessage("assistant", text);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(caption_mutex_);
+    pending_captions_.emplace_back((uint32_t)offset_ms, std::string(text));
+    has_pending_captions_.store(true, std::memory_order_release);
+}
+
+void Application::ResetCaptionTimeline() {
+    tts_position_ms_.store(0, std::memory_order_relaxed);
+    FlushCaptions(false);
+}
+
+void Application::FlushCaptions(bool display) {
+    std::deque<std::pair<uint32_t, std::string>> leftover;
+    {
+        std::lock_guard<std::mutex> lock(caption_mutex_);
+        leftover.swap(pending_captions_);
+        has_pending_captions_.store(false, std::memory_order_release);
+    }
+    // TTS 正常收尾把余下的句子补齐上屏；打断则直接丢弃
+    if (display) {
+        for (auto& caption : leftover) {
+            AppendChatMessage("assistant", caption.second.c_str());
+        }
+    }
 }
 
 void Application::InputAudio() {
@@ -662,75 +1786,242 @@ void Application::InputAudio() {
         return;
     }
 
-    if (codec->input_sample_rate() != 16000) {
-        if (codec->input_channels() == 2) {
-            auto mic_channel = std::vector<int16_t>(data.size() / 2);
-            auto reference_channel = std::vector<int16_t>(data.size() / 2);
-            for (size_t i = 0, j = 0; i < mic_channel.size(); ++i, j += 2) {
-                mic_channel[i] = data[j];
-                reference_channel[i] = data[j + 1];
-            }
-            auto resampled_mic = std::vector<int16_t>(input_resampler_.GetOutputSamples(mic_channel.size()));
-            auto resampled_reference = std::vector<int16_t>(reference_resampler_.GetOutputSamples(reference_channel.size()));
-            input_resampler_.Process(mic_channel.data(), mic_channel.size(), resampled_mic.data());
-            reference_resampler_.Process(reference_channel.data(), reference_channel.size(), resampled_reference.data());
-            data.resize(resampled_mic.size() + resampled_reference.size());
-            for (size_t i = 0, j = 0; i < resampled_mic.size(); ++i, j += 2) {
-                data[j] = resampled_mic[i];
-                data[j + 1] = resampled_reference[i];
-            }
+    // 环回自检期间输入整帧转给测试采集，不喂 AFE（啁啾不会误触发唤醒）
+    if (AudioLoopbackTest::GetInstance().CaptureInput(data)) {
+        return;
+    }
+
+    // 采集健康度量在重采样前做：看的是 ADC 原始幅度和真实的通道排布
+    CaptureHealth::GetInstance().Analyze(data.data(), data.size(), kBoardInputChannels);
+
+    // 采样率和通道数是板级编译期常量（config.h），这里 if constexpr
+    // 按板特化：16kHz 板（如 esp-box-lite）整段折叠，二进制里没有
+    // 重采样代码，逐帧路径也不再跑这两个恒假分支
+    if constexpr (kBoardInputSampleRate != 16000) {
+        if constexpr (kBoardInputChannels == 2) {
+            auto mic_channel = audio_buffer_pool_.Acquire();
+            auto reference_channel = audio_buffer_pool_.Acquire();
+            mic_channel->resize(data.size() / 2);
+            reference_channel->resize(data.size() / 2);
+            pcm_simd::Deinterleave2(data.data(), mic_channel->size(),
+                mic_channel->data(), reference_channel->data());
+            auto resampled_mic = audio_buffer_pool_.Acquire();
+            auto resampled_reference = audio_buffer_pool_.Acquire();
+            resampled_mic->resize(input_resampler_.GetOutputSamples(mic_channel->size()));
+            resampled_reference->resize(reference_resampler_.GetOutputSamples(reference_channel->size()));
+            input_resampler_.Process(mic_channel->data(), mic_channel->size(), resampled_mic->data());
+            reference_resampler_.Process(reference_channel->data(), reference_channel->size(), resampled_reference->data());
+            data.resize(resampled_mic->size() + resampled_reference->size());
+            pcm_simd::Interleave2(resampled_mic->data(), resampled_reference->data(),
+                resampled_mic->size(), data.data());
         } else {
-            auto resampled = std::vector<int16_t>(input_resampler_.GetOutputSamples(data.size()));
-            input_resampler_.Process(data.data(), data.size(), resampled.data());
-            data = std::move(resampled);
+            auto resampled = audio_buffer_pool_.Acquire();
+            resampled->resize(input_resampler_.GetOutputSamples(data.size()));
+            input_resampler_.Process(data.data(), data.size(), resampled->data());
+            // swap 让池回收 data 原来的容量，避免两边都重新分配
+            data.swap(*resampled);
         }
     }
 
-#if CONFIG_USE_WAKE_WORD_DETECT
-    if (wake_word_detect_.IsDetectionRunning()) {
-        wake_word_detect_.Feed(data);
+#if CONFIG_USE_WAKE_WORD_DETECT || CONFIG_USE_AUDIO_PROCESSOR
+    // 检测和通话共用一个 AFE，喂一次就够（barge-in 时两边同时消费）
+    auto& frontend = AudioFrontend::GetInstance();
+    if (frontend.IsRunning()) {
+        frontend.Feed(data);
     }
 #endif
-#if CONFIG_USE_AUDIO_PROCESSOR
-    if (audio_processor_.IsRunning()) {
-        audio_processor_.Input(data);
-    }
-#else
+#if !CONFIG_USE_AUDIO_PROCESSOR
     if (device_state_ == kDeviceStateListening) {
-        background_task_->Schedule([this, data = std::move(data)]() mutable {
-            opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
-                Schedule([this, opus = std::move(opus)]() {
-                    protocol_->SendAudio(opus);
-                });
+        LATENCY_TIMESTAMP(capture_us);
+        encode_task_->Schedule([this, capture_us, data = std::move(data)]() mutable {
+            LATENCY_TIMESTAMP(encode_start_us);
+            std::lock_guard<std::mutex> lock(opus_encoder_mutex_);
+            int64_t tuner_start_us = esp_timer_get_time();
+            opus_encoder_->Encode(std::move(data),
+                [this, capture_us, encode_start_us](std::vector<uint8_t>&& opus) {
+                LATENCY_RECORD(kStageEncode, encode_start_us);
+                LATENCY_RECORD(kStageCapture, capture_us);
+                LATENCY_TIMESTAMP(send_start_us);
+                QueueUplinkPacket(send_start_us, std::move(opus));
             });
+            NoteEncodeTime(esp_timer_get_time() - tuner_start_us);
         });
     }
 #endif
 }
 
+void Application::QueueUplinkPacket(int64_t send_start_us, std::vector<uint8_t>&& opus) {
+    bool need_flush = false;
+    {
+        std::lock_guard<std::mutex> lock(uplink_mutex_);
+        pending_uplink_.push_back({ send_start_us, std::move(opus) });
+        if (!uplink_flush_scheduled_) {
+            uplink_flush_scheduled_ = true;
+            need_flush = true;
+        }
+    }
+    // 同一批后续的包搭已排队闭包的便车，不再逐包调度
+    if (need_flush) {
+        Schedule([this]() { FlushUplink(); }, "uplink_flush");
+    }
+}
+
+void Application::FlushUplink() {
+    TRACE_SCOPE("uplink_flush");
+    {
+        std::lock_guard<std::mutex> lock(uplink_mutex_);
+        uplink_batch_.swap(pending_uplink_);
+        uplink_flush_scheduled_ = false;
+    }
+    for (auto& packet : uplink_batch_) {
+        protocol_->SendAudio(packet.opus);
+        LATENCY_RECORD(kStageSend, packet.send_start_us);
+        // 发完的包壳回池，喂给下行收包路径复用，
+        // 双工对话稳态下上下行都不再碰堆
+        PacketPool::GetInstance().Release(std::move(packet.opus));
+    }
+    uplink_batch_.clear();
+}
+
+// 回合流水线的上行开闸：barge-in VAD 在说话态判出人声时调用（主循环）。
+// 话头在 VAD 判定之前就开始了，从预滚环往回补一段再接实时帧；给服务器
+// 发 listen start 宣告新一句开始，TTS 下行不动——服务器认定是真插话
+// 会自己收掉这轮回复（tts stop/abort 下行照旧走老路径）
+void Application::StartPipelinedCapture() {
+    constexpr int kOnsetLeadMs = 300;  // VAD 判定延迟 + 起音，预滚回补量
+    {
+        std::lock_guard<std::mutex> lock(preroll_mutex_);
+        preroll_cutoff_us_ = esp_timer_get_time() - (int64_t)kOnsetLeadMs * 1000;
+        preroll_pending_ = true;
+    }
+    // 静音抑制从"在说话"起步，VAD 停声后由 hangover 自然收尾
+    voice_detected_ = true;
+    silence_frames_ = 0;
+    pipelined_capture_ = true;
+    protocol_->SendStartListening(kListeningModeAlwaysOn);
+    ESP_LOGI(TAG, "Turn pipeline: uplink started while reply tail plays");
+}
+
 void Application::AbortSpeaking(AbortReason reason) {
     ESP_LOGI(TAG, "Abort speaking");
     aborted_ = true;
+    // 打断即撤销：还在排队的解码闭包是过期 TTS，不等它们执行完；
+    // 已被工人取走的那批靠 DecodeFrame 首行的 aborted_ 检查早退
+    decode_task_->CancelPending();
+    background_task_->FlushLane(BackgroundTask::kLaneAudio);
+    // 没播到的音频对应的字幕也不该出现
+    FlushCaptions(false);
     protocol_->SendAbortSpeaking(reason);
 }
 
+// 合法状态迁移表（按 from 索引的 to 位掩码）。状态机的边都来自
+// 真实流程：启动→配网/激活/升级/待机，对话在 待机/连接/听/说 之间
+// 转，FatalError 只进不出（出路是重启）。表外的迁移是调用方逻辑
+// 错误：响亮告警并计数进遥测，但放行——量产设备上卡死比状态
+// 走样更糟
+static const uint16_t kAllowedTransitions[] = {
+    /* Unknown */        0xffff,
+    /* Starting */       (1 << kDeviceStateWifiConfiguring) | (1 << kDeviceStateActivating) |
+                         (1 << kDeviceStateUpgrading) | (1 << kDeviceStateIdle) |
+                         (1 << kDeviceStateFatalError),
+    /* WifiConfiguring */ (1 << kDeviceStateStarting) | (1 << kDeviceStateIdle) |
+                         (1 << kDeviceStateFatalError),
+    /* Idle */           (1 << kDeviceStateConnecting) | (1 << kDeviceStateListening) |
+                         (1 << kDeviceStateSpeaking) | (1 << kDeviceStateUpgrading) |
+                         (1 << kDeviceStateActivating) | (1 << kDeviceStateFatalError),
+    /* Connecting */     (1 << kDeviceStateIdle) | (1 << kDeviceStateListening) |
+                         (1 << kDeviceStateSpeaking) | (1 << kDeviceStateFatalError),
+    /* Listening */      (1 << kDeviceStateIdle) | (1 << kDeviceStateConnecting) |
+                         (1 << kDeviceStateSpeaking) | (1 << kDeviceStateFatalError),
+    /* Speaking */       (1 << kDeviceStateIdle) | (1 << kDeviceStateListening) |
+                         (1 << kDeviceStateFatalError),
+    /* Upgrading */      (1 << kDeviceStateIdle) | (1 << kDeviceStateFatalError),
+    /* Activating */     (1 << kDeviceStateIdle) | (1 << kDeviceStateUpgrading) |
+                         (1 << kDeviceStateFatalError),
+    /* FatalError */     0,
+};
+
 void Application::SetDeviceState(DeviceState state) {
-    if (device_state_ == state) {
+    DeviceState previous_state = device_state_.load(std::memory_order_acquire);
+    if (previous_state == state) {
         return;
     }
-    
+    int64_t transition_start_us = esp_timer_get_time();
+    if ((kAllowedTransitions[previous_state] & (1 << state)) == 0) {
+        ESP_LOGE(TAG, "Invalid state transition %s -> %s",
+            STATE_STRINGS[previous_state], STATE_STRINGS[state]);
+        invalid_transitions_++;
+    }
+
     clock_ticks_ = 0;
-    auto previous_state = device_state_;
-    device_state_ = state;
-    ESP_LOGI(TAG, "STATE: %s", STATE_STRINGS[device_state_]);
-    // The state is changed, wait for all background tasks to finish
-    background_task_->WaitForCompletion();
+    // release 配对读侧的 acquire：其他任务看到新状态时，之前的
+    // 写入（如 playback_direct_drive_）一定已可见
+    device_state_.store(state, std::memory_order_release);
+    ESP_LOGI(TAG, "STATE: %s", STATE_STRINGS[state]);
+    flight_recorder::RecordState(previous_state, state);
+    event_log::Record(event_log::kStateTransition, previous_state, state);
+    // 空闲态放掉满频锁让 DFS 降档；其余状态（听/说/连接/升级）都
+    // 在干活，保持满频
+    CpuGovernor::GetInstance().SetStateActive(
+        state != kDeviceStateIdle && state != kDeviceStateUnknown);
+    // 离开说话态先关直驱，再拿一次互斥确认播放任务已退出热循环，
+    // 之后解码器状态才可以安全复位
+    // 流水线采集随说话态一起收束；说→听这条边是流水线的正常交接，
+    // 上行已经连续，下面进聆听态时不再重新武装预滚回补
+    bool pipelined_handoff = false;
+    if (previous_state == kDeviceStateSpeaking) {
+        pipelined_handoff = pipelined_capture_ && state == kDeviceStateListening;
+        pipelined_capture_ = false;
+#if CONFIG_USE_WAKE_WORD_DETECT || CONFIG_USE_AUDIO_PROCESSOR
+        AudioFrontend::GetInstance().EnableCommandWords(false);
+#endif
+        playback_direct_drive_ = false;
+        // 打断后前瞻环里的存货是上一句的尾巴，直接扔掉
+        std::lock_guard<std::mutex> lock(playback_mutex_);
+        ready_pcm_.clear();
+    }
+#if CONFIG_USE_WAKE_WORD_DETECT
+    if (previous_state == kDeviceStateListening) {
+        AudioFrontend::GetInstance().EnableShortcuts(false);
+    }
+#endif
+    // 只有涉及编解码器复位的边才需要排空任务队列（Reset 的前置契约：
+    // 没有并发的编解码闭包在飞）。其余迁移（如 听→待机、连接失败回
+    // 待机）不再吊在后台队列上——这一步在追踪里是隐藏的几百毫秒档
+    if (previous_state == kDeviceStateSpeaking ||
+        state == kDeviceStateListening || state == kDeviceStateSpeaking) {
+        // 先关音频泵的出向闸门并确认它不在 OutputAudio 里，排空后的
+        // 解码队列才不会被泵再塞进旧帧
+        output_pump_gate_ = false;
+        { std::lock_guard<std::mutex> lock(output_mutex_); }
+        // 带截止期的排空：后台队列堆深（慢显示/IoT 闭包积压）时状态
+        // 切换不再无限冻住，超期后可放弃的音频闭包被原地撤销
+        constexpr int kDrainDeadlineMs = 300;
+        if (!background_task_->WaitForCompletion(kDrainDeadlineMs)) {
+            auto stats = background_task_->GetQueueStats();
+            ESP_LOGW(TAG, "State drain missed %d ms deadline (%u queued, %u in flight, oldest %lld ms)",
+                kDrainDeadlineMs, (unsigned)stats.queued, (unsigned)stats.inflight,
+                (long long)(stats.oldest_wait_us / 1000));
+        }
+        encode_task_->WaitForCompletion();
+        decode_task_->WaitForCompletion();
+    }
 
     auto& board = Board::GetInstance();
     auto codec = board.GetAudioCodec();
     auto display = board.GetDisplay();
     auto led = board.GetLed();
     led->OnStateChanged();
+    // 空闲态只有表盘分钟跳变，LVGL 刷新降档；进对话恢复满帧率
+    display->SetRenderIdle(state == kDeviceStateIdle);
+    // 离开空闲就退常亮表盘：恢复 LVGL 并整屏补帧
+    if (state != kDeviceStateIdle && ambient_clock_) {
+        ambient_clock_ = false;
+        display->SetAmbientClock(false);
+    }
+    // 一次迁移连改状态/表情/消息，攒成一条事务消息，消费端一次
+    // 持锁应用、合并成一次重绘
+    display->BeginUpdate();
     switch (state) {
         case kDeviceStateUnknown:
         case kDeviceStateIdle:
@@ -741,6 +2032,8 @@ void Application::SetDeviceState(DeviceState state) {
 #endif
             break;
         case kDeviceStateConnecting:
+            // 会话内存记账从这里开始拍基线
+            SessionMemory::GetInstance().OnSessionStart();
             display->SetStatus(Lang::Strings::CONNECTING);
             display->SetEmotion("neutral");
             display->SetChatMessage("system", "");
@@ -748,57 +2041,281 @@ void Application::SetDeviceState(DeviceState state) {
         case kDeviceStateListening:
             display->SetStatus(Lang::Strings::LISTENING);
             display->SetEmotion("neutral");
+            if (!pipelined_handoff) {
+                // 预滚对齐：本次迁移的起点就是提示音/状态翻转时刻，
+                // 进聆听态的第一个实时帧前把这之后暂存的音频补发上行
+                std::lock_guard<std::mutex> lock(preroll_mutex_);
+                preroll_cutoff_us_ = transition_start_us;
+                preroll_pending_ = true;
+            }
             ResetDecoder();
-            opus_encoder_->ResetState();
+            {
+                // 音频泵可能正并发调度编码闭包（闭包内持同一把锁），
+                // 复位与编码帧互斥即可，先后顺序无所谓
+                std::lock_guard<std::mutex> lock(opus_encoder_mutex_);
+                opus_encoder_->ResetState();
+            }
+            // 新一轮对话先放行 hangover 帧，等 VAD 跟上再抑制静音
+            silence_frames_ = 0;
+            segment_spoken_ = false;
+            segment_end_sent_ = false;
 #if CONFIG_USE_AUDIO_PROCESSOR
             audio_processor_.Start();
+#endif
+#if CONFIG_USE_WAKE_WORD_DETECT
+            // 聆听态开短语直通，音量这类小命令不等服务器
+            AudioFrontend::GetInstance().EnableShortcuts(true);
 #endif
             UpdateIotStates();
-            if (previous_state == kDeviceStateSpeaking) {
-                // FIXME: Wait for the speaker to empty the buffer
-                vTaskDelay(pdMS_TO_TICKS(120));
+            if constexpr (!board_caps::kHasAecReference) {
+                // 没有 AEC 的板子等扬声器缓冲放完，避免把 TTS 尾巴录进上行。
+                // 按写入游标精确等剩余的尾巴，不再整付 120ms 的固定税
+                if (previous_state == kDeviceStateSpeaking) {
+                    codec->WaitForOutputDrained();
+                }
             }
             break;
         case kDeviceStateSpeaking:
             display->SetStatus(Lang::Strings::SPEAKING);
             ResetDecoder();
             codec->EnableOutput(true);
+            // 直驱开闸，先踢一脚，不用等第一个 DMA 中断
+            playback_direct_drive_ = true;
+            xTaskNotifyGive(playback_task_handle_);
 #if CONFIG_USE_AUDIO_PROCESSOR
-            audio_processor_.Stop();
+            if constexpr (board_caps::kHasAecReference) {
+                // barge-in：有回采参考就让 AFE 带着 AEC 继续跑，
+                // VAD 在 TTS 之上听到人声即可打断，不用等唤醒词
+                audio_processor_.Start();
+#if CONFIG_USE_WAKE_WORD_DETECT
+                // 在 barge-in 之上再开命令词网络，"停止"即时生效
+                AudioFrontend::GetInstance().EnableCommandWords(true);
+#endif
+            } else {
+                audio_processor_.Stop();
+            }
 #endif
             break;
         default:
             // Do nothing
             break;
     }
+    display->CommitUpdate();
+    // 迁移收尾，重新放行音频泵的输出侧（没关过也无妨）
+    output_pump_gate_ = true;
+
+    // 迁移耗时记账：均值看常态，最差边定位具体是哪条迁移在拖
+    int64_t elapsed_us = esp_timer_get_time() - transition_start_us;
+    transition_count_++;
+    transition_total_us_ += elapsed_us;
+    if (elapsed_us > transition_worst_us_) {
+        transition_worst_us_ = elapsed_us;
+        transition_worst_from_ = previous_state;
+        transition_worst_to_ = state;
+    }
 }
 
 void Application::SetDecodeSampleRate(int sample_rate) {
+    if constexpr (board_caps::kOutputRateOpusNative) {
+        // 输出率是 Opus 原生档：解码器直接按输出率出样本，服务器
+        // 无论宣告什么下行率都不需要后级重采样（Opus 解码率无关，
+        // 异率流由解码器内部换算）。重采样级在本构型下已编译剔除
+        if (sample_rate != AUDIO_OUTPUT_SAMPLE_RATE) {
+            ESP_LOGI(TAG, "Decoding %d Hz stream natively at %d Hz output rate",
+                sample_rate, AUDIO_OUTPUT_SAMPLE_RATE);
+        }
+        sample_rate = AUDIO_OUTPUT_SAMPLE_RATE;
+    }
     if (opus_decode_sample_rate_ == sample_rate) {
         return;
     }
 
     opus_decode_sample_rate_ = sample_rate;
-    opus_decoder_.reset();
-    opus_decoder_ = std::make_unique<OpusDecoderWrapper>(opus_decode_sample_rate_, 1);
+    auto it = opus_decoders_.find(sample_rate);
+    if (it == opus_decoders_.end()) {
+        // 第一次遇到的采样率建一次，之后一直复用
+        it = opus_decoders_.emplace(sample_rate,
+            std::make_unique<ProfiledOpusDecoder>(sample_rate, 1)).first;
+    }
+    opus_decoder_ = it->second.get();
+    opus_decoder_->ResetState();
+    // 采样率变了，旧素材不能再当隐藏用
+    last_pcm_.clear();
+    conceal_run_ = 0;
 
-    auto codec = Board::GetInstance().GetAudioCodec();
-    if (opus_decode_sample_rate_ != codec->output_sample_rate()) {
-        ESP_LOGI(TAG, "Resampling audio from %d to %d", opus_decode_sample_rate_, codec->output_sample_rate());
-        output_resampler_.Configure(opus_decode_sample_rate_, codec->output_sample_rate());
+    if constexpr (!board_caps::kOutputRateOpusNative) {
+        auto codec = Board::GetInstance().GetAudioCodec();
+        if (opus_decode_sample_rate_ != codec->output_sample_rate()) {
+            ESP_LOGI(TAG, "Resampling audio from %d to %d", opus_decode_sample_rate_, codec->output_sample_rate());
+            output_resampler_.Configure(opus_decode_sample_rate_, codec->output_sample_rate());
+        }
+    }
+}
+
+void Application::ApplyEncoderProfile(const EncoderProfile& profile) {
+    // 编码现在融合在 AFE fetch 任务上做，档位切换与编码帧之间
+    // 用 opus_encoder_mutex_ 互斥（以前靠都排在编码工作线程上串行）
+    std::lock_guard<std::mutex> lock(opus_encoder_mutex_);
+    if (profile.frame_duration > 0 && profile.frame_duration != opus_frame_duration_) {
+        ESP_LOGI(TAG, "Rebuilding opus encoder: frame duration %d -> %d ms",
+            opus_frame_duration_, profile.frame_duration);
+        opus_frame_duration_ = profile.frame_duration;
+        opus_encoder_ = std::make_unique<ProfiledOpusEncoder>(16000, 1, opus_frame_duration_);
+        opus_encoder_->SetComplexity(opus_complexity_active_);
+    }
+    if (profile.complexity >= 0 && profile.complexity != opus_complexity_) {
+        ESP_LOGI(TAG, "Setting opus encoder complexity to %d", profile.complexity);
+        // 显式档位（服务器/链路质量）立即生效，同时成为闭环的新上限
+        opus_complexity_ = profile.complexity;
+        opus_complexity_active_ = profile.complexity;
+        opus_encoder_->SetComplexity(opus_complexity_active_);
+        tuner_frames_ = 0;
+        tuner_calm_windows_ = 0;
+    }
+    if (profile.bitrate > 0 || profile.vbr >= 0) {
+        // 编码器封装层没有开出码率/VBR 控制，目前只能用复杂度档位换带宽
+        ESP_LOGW(TAG, "Bitrate/VBR control not exposed by encoder wrapper, ignored");
+    }
+}
+
+void Application::StepComplexityLocked(int value, const char* reason) {
+    if (value > opus_complexity_active_) {
+        tuner_ups_++;
+    } else {
+        tuner_downs_++;
+    }
+    ESP_LOGI(TAG, "Opus complexity %d -> %d (%s, encode ema %lld us / budget %d us)",
+        opus_complexity_active_, value, reason,
+        encode_ema_us_, opus_frame_duration_ * 1000);
+    opus_complexity_active_ = value;
+    opus_encoder_->SetComplexity(value);
+}
+
+// 复杂度闭环：空闲的 c3 和跑着 LVGL 动画 + AEC 的 s3 余量差好几倍，
+// 静态档位要么浪费音质要么临界。每帧编码耗时进 EMA，跟帧预算
+//（帧长）比：单帧逼近预算立即降档（赶在过载掉帧之前），持续低于
+// 1/4 预算攒够三个窗口再升，上限是显式设定的目标档。调用方持有
+// opus_encoder_mutex_
+void Application::NoteEncodeTime(int64_t us) {
+    const int64_t budget_us = (int64_t)opus_frame_duration_ * 1000;
+    encode_ema_us_ += (us - encode_ema_us_) / 16;
+    if (us * 10 > budget_us * 9 && opus_complexity_active_ > 1) {
+        StepComplexityLocked(opus_complexity_active_ - 1, "frame near budget");
+        tuner_frames_ = 0;
+        tuner_calm_windows_ = 0;
+        return;
+    }
+    // 每 100 帧（几秒）评估一次趋势
+    if (++tuner_frames_ < 100) {
+        return;
+    }
+    tuner_frames_ = 0;
+    if (encode_ema_us_ * 2 > budget_us) {
+        if (opus_complexity_active_ > 1) {
+            StepComplexityLocked(opus_complexity_active_ - 1, "sustained load");
+        }
+        tuner_calm_windows_ = 0;
+    } else if (encode_ema_us_ * 4 < budget_us) {
+        if (++tuner_calm_windows_ >= 3 && opus_complexity_active_ < opus_complexity_) {
+            StepComplexityLocked(opus_complexity_active_ + 1, "sustained headroom");
+            tuner_calm_windows_ = 0;
+        }
+    } else {
+        tuner_calm_windows_ = 0;
+    }
+}
+
+void Application::UpdateChatMessage(const char* role, const char* message) {
+    std::lock_guard<std::mutex> lock(ui_mutex_);
+    pending_chat_role_ = role;
+    pending_chat_message_ = message;
+    pending_chat_append_ = false;
+    has_pending_chat_ = true;
+    if (!ui_flush_scheduled_) {
+        ui_flush_scheduled_ = true;
+        Schedule([this]() { FlushUiUpdates(); }, "ui_flush");
+    }
+}
+
+void Application::AppendChatMessage(const char* role, const char* message) {
+    std::lock_guard<std::mutex> lock(ui_mutex_);
+    if (has_pending_chat_) {
+        // 同一批里攒下的句子合成一次更新，保留先到的那条的语义
+        pending_chat_message_ += "\n";
+        pending_chat_message_ += message;
+    } else {
+        pending_chat_role_ = role;
+        pending_chat_message_ = message;
+        pending_chat_append_ = true;
+    }
+    has_pending_chat_ = true;
+    if (!ui_flush_scheduled_) {
+        ui_flush_scheduled_ = true;
+        Schedule([this]() { FlushUiUpdates(); }, "ui_flush");
+    }
+}
+
+void Application::UpdateEmotion(const char* emotion) {
+    std::lock_guard<std::mutex> lock(ui_mutex_);
+    pending_emotion_ = emotion;
+    has_pending_emotion_ = true;
+    if (!ui_flush_scheduled_) {
+        ui_flush_scheduled_ = true;
+        Schedule([this]() { FlushUiUpdates(); }, "ui_flush");
+    }
+}
+
+void Application::FlushUiUpdates() {
+    // 一个 flush 闭包清掉积压的所有字段：快速流式时 20 条 JSON 也只落一次屏
+    psram_pmr::string chat_role{psram_pmr::cold()};
+    psram_pmr::string chat_message{psram_pmr::cold()};
+    psram_pmr::string emotion{psram_pmr::cold()};
+    bool has_chat, has_emotion, chat_append;
+    {
+        std::lock_guard<std::mutex> lock(ui_mutex_);
+        chat_role = std::move(pending_chat_role_);
+        chat_message = std::move(pending_chat_message_);
+        emotion = std::move(pending_emotion_);
+        has_chat = has_pending_chat_;
+        has_emotion = has_pending_emotion_;
+        chat_append = pending_chat_append_;
+        has_pending_chat_ = has_pending_emotion_ = false;
+        pending_chat_append_ = false;
+        ui_flush_scheduled_ = false;
+    }
+
+    auto display = Board::GetInstance().GetDisplay();
+    if (has_chat) {
+        if (chat_append) {
+            display->AppendChatMessage(chat_role.c_str(), chat_message.c_str());
+        } else {
+            display->SetChatMessage(chat_role.c_str(), chat_message.c_str());
+        }
+    }
+    if (has_emotion) {
+        display->SetEmotion(emotion.c_str());
     }
 }
 
 void Application::UpdateIotStates() {
     auto& thing_manager = iot::ThingManager::GetInstance();
+    bool iot_binary = protocol_->SupportsBinaryIotStates();
     std::string states;
-    if (thing_manager.GetStatesJson(states, true)) {
+    if (thing_manager.GetStatesJson(states, true, iot_binary)) {
         protocol_->SendIotStates(states);
     }
+    if (iot_binary) {
+        std::string payload;
+        if (thing_manager.GetStatesBinary(payload, true)) {
+            protocol_->SendIotStatesBinary(payload);
+        }
+    }
 }
 
 void Application::Reboot() {
     ESP_LOGI(TAG, "Rebooting...");
+    // 欠着的 NVS commit 先清账，重启不丢设置
+    SettingsStore::GetInstance().FlushAll();
     esp_restart();
 }
 
@@ -4,19 +4,32 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
 #include <freertos/task.h>
+#include <freertos/queue.h>
 #include <esp_timer.h>
 
 #include <string>
+#include <atomic>
 #include <mutex>
+#include <deque>
 #include <list>
+#include <map>
+#include <vector>
 
 #include <opus_encoder.h>
 #include <opus_decoder.h>
-#include <opus_resampler.h>
+
+#include "opus_profiler.h"
+
+#include "fast_resampler.h"
 
 #include "protocol.h"
 #include "ota.h"
 #include "background_task.h"
+#include "task_slot.h"
+#include "audio_buffer_pool.h"
+#include "audio_pipeline_task.h"
+#include "jitter_buffer.h"
+#include "psram_pmr.h"
 
 #if CONFIG_USE_WAKE_WORD_DETECT
 #include "wake_word_detect.h"
@@ -28,6 +41,8 @@
 #define SCHEDULE_EVENT (1 << 0)
 #define AUDIO_INPUT_READY_EVENT (1 << 1)
 #define AUDIO_OUTPUT_READY_EVENT (1 << 2)
+#define NETWORK_READY_EVENT (1 << 3)
+#define BUTTON_EVENT (1 << 4)
 
 enum DeviceState {
     kDeviceStateUnknown,
@@ -44,6 +59,20 @@ enum DeviceState {
 
 #define OPUS_FRAME_DURATION_MS 60
 
+// VAD 报静音后再继续上行多少帧（hangover），之后整帧抑制
+#define SILENCE_HANGOVER_FRAMES 16
+
+// 手动模式下说过话之后连续静音多少帧算一段结束（60ms 帧 ≈ 600ms），
+// 发 segment_end 让服务器提前 finalize ASR，采集本身不停
+#define SEGMENT_END_SILENCE_FRAMES 10
+
+// 聆听预滚上限：非聆听态也把处理后的音频滚动保留这么多毫秒，进
+// 聆听态后从提示音时刻起补发——用户压着提示音开口的话头不再被
+// 状态迁移（等播放尾巴、建链）的耗时削掉
+#define LISTEN_PREROLL_MS 500
+
+class Button;
+
 class Application {
 public:
     static Application& GetInstance() {
@@ -55,9 +84,24 @@ public:
     Application& operator=(const Application&) = delete;
 
     void Start();
-    DeviceState GetDeviceState() const { return device_state_; }
+    DeviceState GetDeviceState() const { return device_state_.load(std::memory_order_acquire); }
     bool IsVoiceDetected() const { return voice_detected_; }
-    void Schedule(std::function<void()> callback);
+    // 小捕获就地放进预分配槽位环，免去每次调度的堆分配；
+    // 多生产者单消费者，队列满时等待而不是丢任务。
+    // tag 必须是常驻字面量，闭包执行超预算时长任务探测按它记账
+    template <typename F>
+    void Schedule(F&& callback, const char* tag = nullptr) {
+        TaskRef task = task_slots_.Acquire(std::forward<F>(callback));
+        task.tag = tag;
+        xQueueSend(main_task_queue_, &task, portMAX_DELAY);
+        xEventGroupSetBits(event_group_, SCHEDULE_EVENT);
+    }
+    // 后台批量车道（预热、自检这类几百毫秒起步的慢活），满时背压
+    template <typename F>
+    void ScheduleBulk(F&& callback, const char* tag = nullptr) {
+        background_task_->Schedule(std::forward<F>(callback),
+            BackgroundTask::kLaneBulk, tag);
+    }
     void SetDeviceState(DeviceState state);
     void Alert(const char* status, const char* message, const char* emotion = "", const std::string_view& sound = "");
     void DismissAlert();
@@ -69,7 +113,14 @@ public:
     void Reboot();
     void WakeWordInvoke(const std::string& wake_word);
     void PlaySound(const std::string_view& sound);
+    // 整串音效一次排进抖动缓冲无缝连播，放完（或被打断冲掉）回调；
+    // 不 sleep、不排空解码队列，激活码播报走这里
+    void PlaySoundSequence(const std::vector<std::string_view>& sounds,
+                           std::function<void()> on_complete = nullptr);
     bool CanEnterSleepMode();
+    // 按键 ISR 直达通道：中断里只入队时间戳事件 + 置 BUTTON_EVENT，
+    // 消抖和回调分发都在主循环做，绕开按键组件整个轮询周期
+    bool PostButtonEventFromISR(Button* button, bool pressed, int64_t timestamp_us);
 
 private:
     Application();
@@ -82,36 +133,218 @@ private:
     AudioProcessor audio_processor_;
 #endif
     Ota ota_;
-    std::mutex mutex_;
-    std::list<std::function<void()>> main_tasks_;
+    QueueHandle_t main_task_queue_ = nullptr;
+    // 按键 ISR 事件帧，按值穿过队列
+    struct ButtonEvent {
+        Button* button;
+        int64_t timestamp_us;
+        bool pressed;
+    };
+    QueueHandle_t button_event_queue_ = nullptr;
+    // 主循环调度闭包的内联槽位环，放不下的才落堆
+    TaskSlotRing task_slots_{32};
     std::unique_ptr<Protocol> protocol_;
     EventGroupHandle_t event_group_ = nullptr;
+    // 音频就绪事件独立成组：一堆排队闭包冲进主循环时不再顺带
+    // 压住音频搬运，反之亦然（单事件组是个护航点）
+    EventGroupHandle_t audio_event_group_ = nullptr;
     esp_timer_handle_t clock_timer_handle_ = nullptr;
-    volatile DeviceState device_state_ = kDeviceStateUnknown;
+    // 音频时钟：逐拍自排程的一次性定时器，给非直驱输出一个锁相在
+    // 帧边界上的节拍（见 OnAudioClock）
+    esp_timer_handle_t audio_clock_handle_ = nullptr;
+    int64_t audio_clock_next_us_ = 0;
+    // 音频路径上随处要读，原子快照，绝不为了看状态去抢锁。
+    // 解码器状态不设锁：任一时刻只有解码工作线程或直驱播放任务碰它，
+    // SetDeviceState 换状态前先排空解码队列并停掉直驱热循环，
+    // ResetDecoder 靠这个时序保证独占
+    std::atomic<DeviceState> device_state_{kDeviceStateUnknown};
+    // 状态迁移记账（都只在主循环的 SetDeviceState 里写）
+    uint32_t transition_count_ = 0;
+    uint32_t invalid_transitions_ = 0;
+    int64_t transition_total_us_ = 0;
+    int64_t transition_worst_us_ = 0;
+    DeviceState transition_worst_from_ = kDeviceStateUnknown;
+    DeviceState transition_worst_to_ = kDeviceStateUnknown;
     bool keep_listening_ = false;
-    bool aborted_ = false;
+    // 解码工作线程要读，原子化，打断立即生效
+    std::atomic<bool> aborted_{false};
     bool voice_detected_ = false;
+    // 静音抑制状态：连续静音帧数与被抑制的帧计数
+    int silence_frames_ = 0;
+    uint32_t suppressed_frames_ = 0;
+    // 设备端点检测：当前聆听模式、本段是否说过话、段尾是否已上报。
+    // 只对手动模式生效——自动模式服务器自己收尾
+    ListeningMode listening_mode_ = kListeningModeAutoStop;
+    bool segment_spoken_ = false;
+    bool segment_end_sent_ = false;
+    // 聆听预滚环：16kHz 单声道定长环（LISTEN_PREROLL_MS），AFE fetch
+    // 任务写、同一任务在进聆听态后的第一帧补发，锁只和状态迁移竞争
+    std::vector<int16_t> preroll_ring_;
+    size_t preroll_head_ = 0;
+    size_t preroll_size_ = 0;
+    std::mutex preroll_mutex_;
+    // 提示音/迁移起点时刻：比它旧的暂存音频不补发
+    int64_t preroll_cutoff_us_ = 0;
+    bool preroll_pending_ = false;
+    // 回合流水线（AEC 板 + 服务器确认 turn_pipeline）：播报中 VAD
+    // 判出人声后不本地打断，直接开始上行下一句，切不切回合由服务器
+    // 定。主循环写、AFE fetch 任务读，与 voice_detected_ 同一纪律
+    bool pipelined_capture_ = false;
     int clock_ticks_ = 0;
+    // 上次已应用的链路质量档位（NetworkQuality::Level）
+    int network_quality_level_ = 0;
+    // 传输层失效切换：连续开通道失败计数，切到备用传输后置位
+    int channel_open_failures_ = 0;
+    bool protocol_fallback_ = false;
+    // 空闲时听到人声就提前建通道，唤醒词确认后直接开始推流
+    bool channel_pre_warmed_ = false;
+    int pre_warm_ticks_ = 0;
+    // 新固件已预取到备用分区，等下一个空闲点切换
+    volatile bool pending_ota_activation_ = false;
+    // 版本检查重试状态：失败/激活等待时只记一个倒计时，
+    // 到点再起短命任务，间隔期间不占任务栈
+    int version_check_retry_count_ = 0;
+    int version_check_ticks_ = 0;
+    // 遥测批推送节奏（秒），服务器下发 telemetry/interval 才开；
+    // 计数独立于 clock_ticks_，那个随状态切换清零
+    int telemetry_interval_s_ = 0;
+    int telemetry_ticks_ = 0;
+    // 常亮表盘已开启：持续空闲够久后进入，任何状态切换退出
+    bool ambient_clock_ = false;
+
+    // 上行包合并派发：编码回调只把包挂进待发批，主循环一个闭包清
+    // 整批。fetch 任务在调度延迟后连续吐多帧时，逐包的 Schedule/
+    // 队列开销摊成一次（编码器本身在组件里，批量 API 加不进去）
+    struct UplinkPacket {
+        int64_t send_start_us;
+        std::vector<uint8_t> opus;
+    };
+    std::mutex uplink_mutex_;
+    std::vector<UplinkPacket> pending_uplink_;
+    std::vector<UplinkPacket> uplink_batch_;
+    bool uplink_flush_scheduled_ = false;
+
+    // UI 更新合并通道：流式字幕每个字段只保留最新值，
+    // 一次主循环调度批量落屏，不再每条 JSON 排一个闭包
+    std::mutex ui_mutex_;
+    // 聊天文本一条几百字节、活到下一条消息为止，攒在 PSRAM 池里，
+    // 不占内部 SRAM
+    psram_pmr::string pending_chat_role_{psram_pmr::cold()};
+    psram_pmr::string pending_chat_message_{psram_pmr::cold()};
+    bool has_pending_chat_ = false;
+    bool pending_chat_append_ = false;
+    psram_pmr::string pending_emotion_{psram_pmr::cold()};
+    // 字幕时间线：播放位置（ms，相对本轮 TTS 起点）和挂起的
+    // (offset_ms, 文本) 队列，服务器按序下发
+    std::atomic<uint32_t> tts_position_ms_{0};
+    std::atomic<bool> has_pending_captions_{false};
+    std::mutex caption_mutex_;
+    std::deque<std::pair<uint32_t, std::string>> pending_captions_;
+    bool has_pending_emotion_ = false;
+    bool ui_flush_scheduled_ = false;
 
     // Audio encode / decode
+    AudioBufferPool audio_buffer_pool_;
     BackgroundTask* background_task_ = nullptr;
+    AudioPipelineTask* encode_task_ = nullptr;
+    AudioPipelineTask* decode_task_ = nullptr;
     std::chrono::steady_clock::time_point last_output_time_;
-    std::list<std::vector<uint8_t>> audio_decode_queue_;
+    JitterBuffer jitter_buffer_;
+    // 说话态直驱：播放任务独占 出队→解码→写 codec 全链，DMA 中断
+    // 直接通知它，不再经 主循环事件→解码队列 的调度往返。
+    // 互斥锁只用作退出握手：关直驱后拿一次锁即确认任务已退出热循环
+    TaskHandle_t playback_task_handle_ = nullptr;
+    std::atomic<bool> playback_direct_drive_{false};
+    std::mutex playback_mutex_;
+    // 音频泵的出向闸门：SetDeviceState 复位解码器前先关闸并拿一次
+    // output_mutex_ 确认泵不在 OutputAudio 里，排空后的解码队列才
+    // 不会被泵塞回旧帧（与直驱的退出握手同一个套路）
+    std::atomic<bool> output_pump_gate_{true};
+    std::mutex output_mutex_;
+    // 解码前瞻环：播放任务先把 2-4 帧解成 PCM 备着再写 DMA，单帧
+    // 解码超 60ms 预算（音乐类 TTS 的复杂度尖峰）时用存货顶上，
+    // 不会立刻欠载。深度按解码耗时抖动的 EWMA 自适应。
+    // 只在播放任务上、持 playback_mutex_ 时访问
+    std::deque<AudioBufferPool::Handle> ready_pcm_;
+    int decode_ahead_depth_ = 2;
+    int64_t decode_time_mean_us_ = 0;
+    int64_t decode_time_dev_us_ = 0;
+    // 接收窗口额度：网络帧出队累计到半窗就回一条 window 更新，
+    // 按窗口推流的服务器据此匀速补发（本地提示音不占窗口）
+    int window_frames_drained_ = 0;
+
+    // 带周期计数的包装：每帧 ccount 进直方图，遥测注册表里 "opus"
+    std::unique_ptr<ProfiledOpusEncoder> opus_encoder_;
+    // 编码在 AFE fetch 任务上就地做，与档位切换（重建编码器）互斥
+    std::mutex opus_encoder_mutex_;
+    // 当前生效的编码档位，服务器可以在会话中下调
+    // 显式设定的目标复杂度（板级默认/服务器档位/链路质量档），同时是
+    // 闭环调节的上限；active 是实际生效值，按编码耗时在 [1, 目标] 间走
+    int opus_complexity_ = 3;
+    int opus_complexity_active_ = 3;
+    int opus_frame_duration_ = OPUS_FRAME_DURATION_MS;
+    // 编码耗时闭环的状态：EMA 对比帧预算，逼近预算先降档，持续富余
+    // 攒够安静窗口再升档（见 NoteEncodeTime）
+    int64_t encode_ema_us_ = 0;
+    uint32_t tuner_frames_ = 0;
+    int tuner_calm_windows_ = 0;
+    uint32_t tuner_ups_ = 0;
+    uint32_t tuner_downs_ = 0;
+    // 每个采样率一个常驻解码器，切换只换指针，不再重建
+    std::map<int, std::unique_ptr<ProfiledOpusDecoder>> opus_decoders_;
+    ProfiledOpusDecoder* opus_decoder_ = nullptr;
 
-    std::unique_ptr<OpusEncoderWrapper> opus_encoder_;
-    std::unique_ptr<OpusDecoderWrapper> opus_decoder_;
+    // 丢包隐藏素材：最近一个好帧的 PCM（解码采样率）和连续隐藏
+    // 计数，只在解码路径上访问。计数器给遥测
+    std::vector<int16_t> last_pcm_;
+    int conceal_run_ = 0;
+    uint32_t concealed_frames_ = 0;
+    uint32_t concealed_fallback_ = 0;
+    // 流完整性自愈：连续解码失败计数和累计重置次数（见 DecodeFrame）
+    int decode_fail_run_ = 0;
+    uint32_t decoder_resets_ = 0;
 
     int opus_decode_sample_rate_ = -1;
-    OpusResampler input_resampler_;
-    OpusResampler reference_resampler_;
-    OpusResampler output_resampler_;
+    // 常用采样率对走编译期多相表，罕见的回退 OpusResampler
+    FastResampler input_resampler_;
+    FastResampler reference_resampler_;
+    FastResampler output_resampler_;
 
     void MainLoop();
+    void AudioPumpLoop();
+    void QueueUplinkPacket(int64_t send_start_us, std::vector<uint8_t>&& opus);
+    void FlushUplink();
+    void InitializeProtocol(bool use_fallback);
+    bool OpenAudioChannelWithFailover();
     void InputAudio();
+    void OnAudioClock();
     void OutputAudio();
+    void PlaybackLoop();
+    void DecodeAndOutput(JitterBuffer::AudioFrame&& frame);
+    AudioBufferPool::Handle DecodeFrame(JitterBuffer::AudioFrame&& frame);
+    AudioBufferPool::Handle ConcealFrame();
+    void CreditAudioWindow(const JitterBuffer::AudioFrame& frame);
+    // 字幕时间线（见 application.cc QueueCaption 的说明）
+    void QueueCaption(int offset_ms, const char* text);
+    void ResetCaptionTimeline();
+    void FlushCaptions(bool display);
     void ResetDecoder();
+    // 回合流水线的上行开闸：补发话头预滚并给服务器发 listen start，
+    // 只在说话态由 barge-in VAD 触发
+    void StartPipelinedCapture();
     void SetDecodeSampleRate(int sample_rate);
+    void ApplyEncoderProfile(const EncoderProfile& profile);
+    // 每帧编码完在持 opus_encoder_mutex_ 的上下文里调用，驱动复杂度闭环
+    void NoteEncodeTime(int64_t us);
+    void StepComplexityLocked(int value, const char* reason);
+    void UpdateChatMessage(const char* role, const char* message);
+    // 同一条回复的后续句子走追加：显示端只处理新增文本段
+    void AppendChatMessage(const char* role, const char* message);
+    void UpdateEmotion(const char* emotion);
+    void FlushUiUpdates();
     void CheckNewVersion();
+    void StartVersionCheckTask();
+    bool LoadVersionCheckCache();
     void ShowActivationCode();
     void OnClockTimer();
 };
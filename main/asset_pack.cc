@@ -0,0 +1,116 @@
+#include "asset_pack.h"
+#include "assets/lang_config.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <cstring>
+
+#define TAG "AssetPack"
+
+namespace {
+
+struct PackHeader {
+    char magic[4];
+    uint32_t entry_count;
+    char lang[8];
+};
+
+struct PackEntry {
+    char name[32];
+    uint32_t offset;
+    uint32_t size;
+};
+
+}  // namespace
+
+const esp_partition_t* AssetPack::ActiveSlot() {
+    Settings settings("assets");
+    std::string label = settings.GetString("active", "assets_a");
+    auto partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label.c_str());
+    if (partition == nullptr) {
+        // 老分区表：没有 A/B 槽，退回单个 "assets" 分区
+        partition = esp_partition_find_first(
+            ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "assets");
+    }
+    return partition;
+}
+
+const esp_partition_t* AssetPack::InactiveSlot() {
+    Settings settings("assets");
+    std::string active = settings.GetString("active", "assets_a");
+    const char* other = active == "assets_b" ? "assets_a" : "assets_b";
+    return esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, other);
+}
+
+bool AssetPack::Init() {
+    auto partition = ActiveSlot();
+    if (partition == nullptr) {
+        ESP_LOGI(TAG, "No assets partition, using embedded assets");
+        return false;
+    }
+
+    const void* base = nullptr;
+    auto err = esp_partition_mmap(partition, 0, partition->size,
+                                  ESP_PARTITION_MMAP_DATA, &base, &mmap_handle_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mmap assets partition: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    auto header = static_cast<const PackHeader*>(base);
+    if (memcmp(header->magic, "XZA1", sizeof(header->magic)) != 0) {
+        ESP_LOGW(TAG, "Assets partition not flashed or invalid, using embedded assets");
+        esp_partition_munmap(mmap_handle_);
+        return false;
+    }
+    if (strncmp(header->lang, Lang::CODE, sizeof(header->lang)) != 0) {
+        ESP_LOGW(TAG, "Asset pack language '%.8s' does not match firmware '%s', using embedded assets",
+                 header->lang, Lang::CODE);
+        esp_partition_munmap(mmap_handle_);
+        return false;
+    }
+    // 条目表本身要放得进分区，每个条目的数据也不能越界
+    size_t table_end = sizeof(PackHeader) + header->entry_count * sizeof(PackEntry);
+    if (header->entry_count > 1024 || table_end > partition->size) {
+        ESP_LOGW(TAG, "Asset pack entry table out of bounds, using embedded assets");
+        esp_partition_munmap(mmap_handle_);
+        return false;
+    }
+
+    auto entries = reinterpret_cast<const PackEntry*>(header + 1);
+    auto bytes = static_cast<const char*>(base);
+    for (uint32_t i = 0; i < header->entry_count; i++) {
+        const auto& entry = entries[i];
+        if (entry.offset + entry.size > partition->size || entry.name[0] == '\0') {
+            ESP_LOGW(TAG, "Asset entry %lu out of bounds, skipped", i);
+            continue;
+        }
+        std::string name(entry.name, strnlen(entry.name, sizeof(entry.name)));
+        sounds_[std::move(name)] = std::string_view(bytes + entry.offset, entry.size);
+    }
+
+    loaded_ = true;
+    ESP_LOGI(TAG, "Asset pack '%s' mapped from %s: %u sounds, %lu KB partition",
+             Lang::CODE, partition->label, (unsigned)sounds_.size(),
+             (unsigned long)(partition->size / 1024));
+    return true;
+}
+
+std::string_view AssetPack::ResolveSound(const std::string_view& sound) const {
+    if (!loaded_) {
+        return sound;
+    }
+    // 资产表只有二十来项，线性反查足够；数据指针天然唯一
+    for (size_t i = 0; i < Lang::Sounds::kAllCount; i++) {
+        if (Lang::Sounds::kAll[i].data.data() == sound.data()) {
+            auto it = sounds_.find(std::string_view(Lang::Sounds::kAll[i].name));
+            if (it != sounds_.end()) {
+                return it->second;
+            }
+            break;
+        }
+    }
+    return sound;
+}
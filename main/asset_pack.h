@@ -0,0 +1,54 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <esp_partition.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+
+// 外置语言资产分区（"assets"）的只读访问。分区启动时整块 memory-map，
+// 音效以 flash 映射切片对外——和嵌入资产一样零拷贝，但 OTA 不再背着
+// 几百 KB 的 p3 音效，语言包可以独立于固件刷写。
+// 包格式（小端，scripts/build_asset_pack.py 生成）：
+//   头部  { char magic[4] = "XZA1"; uint32 entry_count; char lang[8]; }
+//   条目  { char name[32]; uint32 offset; uint32 size; } * entry_count
+//   数据  紧随其后，offset 相对分区起始
+// 没有分区、没刷包或校验失败时保持未加载，一切回退到嵌入资产。
+// 分区表里有 assets_a/assets_b 时按 A/B 双槽运行：激活槽的标签记在
+// NVS（assets/active），OTA 把新包悄悄下进备用槽，激活固件时和启动
+// 分区同一步翻转；只有单个 "assets" 分区的老表保持原样
+class AssetPack {
+public:
+    static AssetPack& GetInstance() {
+        static AssetPack instance;
+        return instance;
+    }
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    // 启动时调用一次；返回 false 表示继续用嵌入资产
+    bool Init();
+    bool loaded() const { return loaded_; }
+
+    // 当前激活的资产分区：A/B 槽按 NVS 标签选，找不到退回单槽
+    // "assets"，都没有返回 nullptr
+    static const esp_partition_t* ActiveSlot();
+    // 备用资产槽（OTA 往这里写新包）；单槽分区表返回 nullptr——
+    // 在线覆写正在 mmap 的分区会让资产凭空变掉，不支持
+    static const esp_partition_t* InactiveSlot();
+
+    // 嵌入音效 → 分区覆盖：按 Lang::Sounds 资产表把数据指针反查成
+    // 名字再查包；没有覆盖时原样返回。外置资产固件里嵌入视图长度
+    // 为 0，调用方见到空结果就跳过播放
+    std::string_view ResolveSound(const std::string_view& sound) const;
+
+private:
+    AssetPack() = default;
+
+    bool loaded_ = false;
+    esp_partition_mmap_handle_t mmap_handle_ = 0;
+    std::map<std::string, std::string_view, std::less<>> sounds_;
+};
+
+#endif // ASSET_PACK_H
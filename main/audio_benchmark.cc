@@ -0,0 +1,252 @@
+#include "audio_benchmark.h"
+#include "pcm_simd.h"
+
+#include <esp_cpu.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+#include <aes/esp_aes.h>
+
+#include <opus_encoder.h>
+#include <opus_resampler.h>
+
+#include "fast_resampler.h"
+#include "sched_profile.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#if CONFIG_USE_AUDIO_PROCESSOR
+#include "audio_processor.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+#define TAG "AudioBench"
+
+namespace audio_benchmark {
+
+// 每个负载跑 10 秒等效的音频量，足够摊平缓存冷启动
+static constexpr int kSecondsPerRun = 10;
+static constexpr int kFrameDurationMs = 60;
+
+// 1kHz 正弦，-6dBFS，比全零或白噪声更接近真实语音的编码开销
+static void FillSine(int16_t* data, size_t samples, int sample_rate) {
+    for (size_t i = 0; i < samples; i++) {
+        data[i] = (int16_t)(16384.0 * sin(2.0 * M_PI * 1000.0 * i / sample_rate));
+    }
+}
+
+static void Report(const char* name, const char* params, int frames,
+                   int64_t total_us, uint64_t total_cycles) {
+    printf("BENCH,%s,%s,frames=%d,total_us=%lld,us_per_frame=%.1f,cycles_per_frame=%llu\n",
+           name, params, frames, (long long)total_us,
+           frames > 0 ? (double)total_us / frames : 0.0,
+           frames > 0 ? (unsigned long long)(total_cycles / frames) : 0ULL);
+}
+
+static void BenchOpusEncode() {
+    const int frame_samples = 16000 / 1000 * kFrameDurationMs;
+    const int frames = kSecondsPerRun * 1000 / kFrameDurationMs;
+    std::vector<int16_t> base(frame_samples);
+    FillSine(base.data(), base.size(), 16000);
+
+    for (int complexity = 0; complexity <= 10; complexity++) {
+        auto encoder = std::make_unique<OpusEncoderWrapper>(16000, 1, kFrameDurationMs);
+        encoder->SetComplexity(complexity);
+
+        int64_t total_us = 0;
+        uint64_t total_cycles = 0;
+        size_t total_bytes = 0;
+        for (int i = 0; i < frames; i++) {
+            std::vector<int16_t> pcm(base);
+            int64_t t0 = esp_timer_get_time();
+            uint32_t c0 = esp_cpu_get_cycle_count();
+            encoder->Encode(std::move(pcm), [&total_bytes](std::vector<uint8_t>&& opus) {
+                total_bytes += opus.size();
+            });
+            total_cycles += (uint32_t)(esp_cpu_get_cycle_count() - c0);
+            total_us += esp_timer_get_time() - t0;
+        }
+        char params[48];
+        snprintf(params, sizeof(params), "complexity=%d,bytes=%u", complexity, (unsigned)total_bytes);
+        Report("opus_encode", params, frames, total_us, total_cycles);
+    }
+}
+
+static void BenchResampler() {
+    static const int kRatePairs[][2] = {
+        {24000, 16000}, {48000, 16000}, {16000, 24000}, {16000, 48000},
+    };
+    for (auto& pair : kRatePairs) {
+        OpusResampler resampler;
+        resampler.Configure(pair[0], pair[1]);
+
+        const int in_samples = pair[0] / 1000 * kFrameDurationMs;
+        const int frames = kSecondsPerRun * 1000 / kFrameDurationMs;
+        std::vector<int16_t> input(in_samples);
+        std::vector<int16_t> output(resampler.GetOutputSamples(in_samples));
+        FillSine(input.data(), input.size(), pair[0]);
+
+        int64_t total_us = 0;
+        uint64_t total_cycles = 0;
+        for (int i = 0; i < frames; i++) {
+            int64_t t0 = esp_timer_get_time();
+            uint32_t c0 = esp_cpu_get_cycle_count();
+            resampler.Process(input.data(), input.size(), output.data());
+            total_cycles += (uint32_t)(esp_cpu_get_cycle_count() - c0);
+            total_us += esp_timer_get_time() - t0;
+        }
+        char params[32];
+        snprintf(params, sizeof(params), "rate=%d_%d", pair[0], pair[1]);
+        Report("resampler", params, frames, total_us, total_cycles);
+    }
+}
+
+// 同样的采样率对跑表驱动多相内核，和上面的 silk 内核对照
+static void BenchFastResampler() {
+    static const int kRatePairs[][2] = {
+        {24000, 16000}, {48000, 16000}, {16000, 24000}, {16000, 48000},
+    };
+    for (auto& pair : kRatePairs) {
+        FastResampler resampler;
+        resampler.Configure(pair[0], pair[1]);
+
+        const int in_samples = pair[0] / 1000 * kFrameDurationMs;
+        const int frames = kSecondsPerRun * 1000 / kFrameDurationMs;
+        std::vector<int16_t> input(in_samples);
+        std::vector<int16_t> output(resampler.GetOutputSamples(in_samples));
+        FillSine(input.data(), input.size(), pair[0]);
+
+        int64_t total_us = 0;
+        uint64_t total_cycles = 0;
+        for (int i = 0; i < frames; i++) {
+            int64_t t0 = esp_timer_get_time();
+            uint32_t c0 = esp_cpu_get_cycle_count();
+            resampler.Process(input.data(), input.size(), output.data());
+            total_cycles += (uint32_t)(esp_cpu_get_cycle_count() - c0);
+            total_us += esp_timer_get_time() - t0;
+        }
+        char params[32];
+        snprintf(params, sizeof(params), "rate=%d_%d", pair[0], pair[1]);
+        Report("fast_resampler", params, frames, total_us, total_cycles);
+    }
+}
+
+static void BenchDeinterleave() {
+    const int frame_samples = 16000 / 1000 * kFrameDurationMs;
+    const int frames = kSecondsPerRun * 1000 / kFrameDurationMs;
+    std::vector<int16_t> interleaved(frame_samples * 2);
+    std::vector<int16_t> left(frame_samples);
+    std::vector<int16_t> right(frame_samples);
+    FillSine(interleaved.data(), interleaved.size(), 16000);
+
+    int64_t total_us = 0;
+    uint64_t total_cycles = 0;
+    for (int i = 0; i < frames; i++) {
+        int64_t t0 = esp_timer_get_time();
+        uint32_t c0 = esp_cpu_get_cycle_count();
+        pcm_simd::Deinterleave2(interleaved.data(), frame_samples, left.data(), right.data());
+        total_cycles += (uint32_t)(esp_cpu_get_cycle_count() - c0);
+        total_us += esp_timer_get_time() - t0;
+    }
+    char params[32];
+    snprintf(params, sizeof(params), "samples=%d", frame_samples);
+    Report("deinterleave2", params, frames, total_us, total_cycles);
+}
+
+static void BenchAesCtr() {
+    // 对齐 MqttProtocol 的报文加密：AES-128-CTR，16 字节 nonce，
+    // 负载取 60ms 帧典型的 Opus 包长
+    static constexpr size_t kPayloadSize = 120;
+    static constexpr int kPackets = 5000;
+
+    esp_aes_context ctx;
+    esp_aes_init(&ctx);
+    uint8_t key[16];
+    memset(key, 0x5A, sizeof(key));
+    esp_aes_setkey(&ctx, key, 128);
+
+    uint8_t payload[kPayloadSize];
+    uint8_t encrypted[kPayloadSize];
+    memset(payload, 0x33, sizeof(payload));
+
+    int64_t total_us = 0;
+    uint64_t total_cycles = 0;
+    for (int i = 0; i < kPackets; i++) {
+        uint8_t nonce[16] = {};
+        uint8_t stream_block[16] = {};
+        size_t nc_off = 0;
+        memcpy(nonce + 12, &i, sizeof(i));
+        int64_t t0 = esp_timer_get_time();
+        uint32_t c0 = esp_cpu_get_cycle_count();
+        esp_aes_crypt_ctr(&ctx, kPayloadSize, &nc_off, nonce, stream_block, payload, encrypted);
+        total_cycles += (uint32_t)(esp_cpu_get_cycle_count() - c0);
+        total_us += esp_timer_get_time() - t0;
+    }
+    esp_aes_free(&ctx);
+
+    char params[32];
+    snprintf(params, sizeof(params), "payload=%u", (unsigned)kPayloadSize);
+    Report("aes_ctr", params, kPackets, total_us, total_cycles);
+}
+
+#if CONFIG_USE_AUDIO_PROCESSOR
+static void BenchAfe() {
+    // 吞吐口径：全速喂 N 秒音频，等 fetch 端出完，总墙钟时间
+    // 对比音频时长得到实时倍率（>1 才有余量）
+    static AudioProcessor processor;
+    static volatile int fetched_frames = 0;
+    processor.Initialize(1, false);
+    processor.OnOutput([](const int16_t* data, size_t samples) {
+        fetched_frames = fetched_frames + 1;
+    });
+    processor.Start();
+
+    const int frame_samples = 16000 / 1000 * kFrameDurationMs;
+    const int frames = kSecondsPerRun * 1000 / kFrameDurationMs;
+    std::vector<int16_t> frame(frame_samples);
+    FillSine(frame.data(), frame.size(), 16000);
+
+    int64_t t0 = esp_timer_get_time();
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    uint64_t total_cycles = 0;
+    for (int i = 0; i < frames; i++) {
+        processor.Input(frame);
+        total_cycles += (uint32_t)(esp_cpu_get_cycle_count() - c0);
+        c0 = esp_cpu_get_cycle_count();
+    }
+    // 给 fetch 管线排空留时间
+    int last = -1;
+    while (fetched_frames != last) {
+        last = fetched_frames;
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    int64_t total_us = esp_timer_get_time() - t0;
+    processor.Stop();
+
+    char params[48];
+    snprintf(params, sizeof(params), "audio_s=%d,fetched=%d", kSecondsPerRun, (int)fetched_frames);
+    Report("afe_feed_fetch", params, frames, total_us, total_cycles);
+}
+#endif
+
+void Run() {
+    printf("BENCH_BEGIN,version=1,target=%s,frame_ms=%d\n", CONFIG_IDF_TARGET, kFrameDurationMs);
+    BenchDeinterleave();
+    BenchAesCtr();
+    BenchResampler();
+    BenchFastResampler();
+    BenchOpusEncode();
+#if CONFIG_USE_AUDIO_PROCESSOR
+    BenchAfe();
+#endif
+    sched_profile::RunStressBenchmark();
+    printf("BENCH_END\n");
+    ESP_LOGI(TAG, "Benchmark finished");
+}
+
+}  // namespace audio_benchmark
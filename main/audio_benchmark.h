@@ -0,0 +1,16 @@
+#ifndef AUDIO_BENCHMARK_H
+#define AUDIO_BENCHMARK_H
+
+// 设备端音频 DSP 基准测试（CONFIG_AUDIO_BENCHMARK 固件入口）。
+// 跑一组标准负载：Opus 编码按复杂度扫描、重采样各速率对、
+// 声道拆分、UDP 报文 AES-CTR、AFE feed/fetch 吞吐，结果按
+// "BENCH,<名字>,<参数>,frames=...,total_us=...,us_per_frame=...,
+// cycles_per_frame=..." 逐行打印，CI 解析后用来卡音频 CPU 预算。
+namespace audio_benchmark {
+
+// 跑完所有负载后返回；不会启动正常应用
+void Run();
+
+}  // namespace audio_benchmark
+
+#endif // AUDIO_BENCHMARK_H
@@ -0,0 +1,53 @@
+#include "audio_buffer_pool.h"
+
+#include <esp_log.h>
+
+#define TAG "AudioBufferPool"
+
+AudioBufferPool::~AudioBufferPool() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto buffer : free_list_) {
+        delete buffer;
+    }
+    free_list_.clear();
+}
+
+void AudioBufferPool::Initialize(size_t slots, size_t frame_samples) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_samples_ = frame_samples;
+    free_list_.reserve(slots);
+    for (size_t i = 0; i < slots; ++i) {
+        auto buffer = new std::vector<int16_t>();
+        buffer->reserve(frame_samples_);
+        free_list_.push_back(buffer);
+    }
+    total_slots_ = slots;
+    ESP_LOGI(TAG, "Initialized %zu slots of %zu samples", slots, frame_samples);
+}
+
+AudioBufferPool::Handle AudioBufferPool::Acquire() {
+    std::vector<int16_t>* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_list_.empty()) {
+            buffer = free_list_.back();
+            free_list_.pop_back();
+        }
+    }
+    if (buffer == nullptr) {
+        // 槽位耗尽时扩池而不是阻塞音频路径
+        buffer = new std::vector<int16_t>();
+        buffer->reserve(frame_samples_);
+        total_slots_++;
+        ESP_LOGW(TAG, "Pool exhausted, growing by one slot");
+    }
+    buffer->clear();
+    return Handle(this, buffer);
+}
+
+void AudioBufferPool::Release(std::vector<int16_t>* buffer) {
+    // Keep the capacity, drop the contents
+    buffer->clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_list_.push_back(buffer);
+}
@@ -0,0 +1,82 @@
+#ifndef AUDIO_BUFFER_POOL_H
+#define AUDIO_BUFFER_POOL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// 音频热路径的固定槽位缓冲池
+// Fixed-slot pool of reusable PCM buffers for the 30ms audio hot path.
+// Buffers keep their capacity when they go back to the pool, so the
+// steady state does no heap allocation at all and internal SRAM stops
+// fragmenting on long sessions.
+class AudioBufferPool {
+public:
+    // RAII handle: the buffer returns to the pool when the handle dies.
+    // Move-only, so it can be captured into scheduled lambdas.
+    class Handle {
+    public:
+        Handle() = default;
+        Handle(AudioBufferPool* pool, std::vector<int16_t>* buffer)
+            : pool_(pool), buffer_(buffer) {}
+        Handle(Handle&& other) : pool_(other.pool_), buffer_(other.buffer_) {
+            other.pool_ = nullptr;
+            other.buffer_ = nullptr;
+        }
+        Handle& operator=(Handle&& other) {
+            if (this != &other) {
+                Reset();
+                pool_ = other.pool_;
+                buffer_ = other.buffer_;
+                other.pool_ = nullptr;
+                other.buffer_ = nullptr;
+            }
+            return *this;
+        }
+        ~Handle() {
+            Reset();
+        }
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+
+        std::vector<int16_t>& operator*() const { return *buffer_; }
+        std::vector<int16_t>* operator->() const { return buffer_; }
+        bool valid() const { return buffer_ != nullptr; }
+
+    private:
+        void Reset() {
+            if (pool_ != nullptr && buffer_ != nullptr) {
+                pool_->Release(buffer_);
+            }
+            pool_ = nullptr;
+            buffer_ = nullptr;
+        }
+
+        AudioBufferPool* pool_ = nullptr;
+        std::vector<int16_t>* buffer_ = nullptr;
+    };
+
+    AudioBufferPool() = default;
+    ~AudioBufferPool();
+
+    // slots 是同时在外的缓冲数量，frame_samples 按 30ms 帧 * 通道数预留容量
+    void Initialize(size_t slots, size_t frame_samples);
+    // Returns an empty buffer with frame_samples capacity reserved.
+    // If all slots are out, a new slot is allocated instead of blocking
+    // the audio path; it joins the pool when released.
+    Handle Acquire();
+    // 池子总共占用的字节数（含借出的槽位），供堆遥测上报
+    size_t BytesAllocated() const { return total_slots_ * frame_samples_ * sizeof(int16_t); }
+
+private:
+    friend class Handle;
+    void Release(std::vector<int16_t>* buffer);
+
+    std::mutex mutex_;
+    std::vector<std::vector<int16_t>*> free_list_;
+    size_t frame_samples_ = 0;
+    size_t total_slots_ = 0;
+};
+
+#endif // AUDIO_BUFFER_POOL_H
@@ -1,13 +1,27 @@
 #include "audio_codec.h"
+#include "audio_iram.h"
 #include "board.h"
+#include "board_caps.h"
+#include "intr_affinity.h"
+#include "latency_tracker.h"
+#include "pcm_simd.h"
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <cmath>
 #include <cstring>
 #include <driver/i2s_common.h>
 
 #define TAG "AudioCodec"
 
+// 淡变步长：每 64 采样走一步，0 到满增益 32 步
+static constexpr int16_t kFadeStepQ14 = 512;
+
+// 开声瞬态斜坡的步长：每 64 采样走一步，4 步到满增益，
+// 24kHz 下约 10ms——够压住 DAC 换路的阶跃，又短到听不出淡入
+static constexpr int16_t kRampStepQ14 = 4096;
+
 AudioCodec::AudioCodec() {
 }
 
@@ -22,20 +36,140 @@ void AudioCodec::OnOutputReady(std::function<bool()> callback) {
     on_output_ready_ = callback;
 }
 
-void AudioCodec::OutputData(std::vector<int16_t>& data) {
+AUDIO_IRAM_ATTR void AudioCodec::OutputData(std::vector<int16_t>& data) {
+    if (ramp_gain_q14_ != (1 << 14)) {
+        ApplyEnableRamp(data);
+    }
+    if (software_volume_) {
+        ApplySoftwareGain(data);
+    }
+    if constexpr (board_caps::kHasOutputProfile) {
+        // 板级声学整形放在音量之后：限幅器看到的就是实际送出的电平，
+        // EQ 提升叠加大音量也压得住
+        output_shaper_.Process(data.data(), data.size(), output_channels_);
+    }
     Write(data.data(), data.size());
+    // 推进写入游标：Write 返回时数据已进 DMA 链，从"当前播放位置"
+    //（上个游标和现在的较大者——欠载后 DMA 填静音，游标回到现在）
+    // 再加这批采样的时长，就是它放完的时刻
+    int64_t now = esp_timer_get_time();
+    int64_t tail = tx_tail_us_.load(std::memory_order_relaxed);
+    if (tail < now) {
+        tail = now;
+    }
+    tail += (int64_t)(data.size() / output_channels_) * 1000000 / output_sample_rate_;
+    tx_tail_us_.store(tail, std::memory_order_relaxed);
+}
+
+void AudioCodec::WaitForOutputDrained() {
+    // 按写入游标睡到最后一个采样放完，再留一个 DMA 描述符的余量
+    // 盖住游标模型和描述符边界的误差。上限钳在整条链的时长上，
+    // 模型漂了也不会比老的固定延时等得更久
+    int64_t margin_us = (int64_t)AUDIO_CODEC_DMA_FRAME_NUM * 1000000 / output_sample_rate_;
+    int64_t chain_us = (int64_t)AUDIO_CODEC_DMA_DESC_NUM * margin_us;
+    int64_t remain_us = tx_tail_us_.load(std::memory_order_relaxed) - esp_timer_get_time();
+    if (remain_us <= 0) {
+        return;
+    }
+    remain_us += margin_us;
+    if (remain_us > chain_us + margin_us) {
+        remain_us = chain_us + margin_us;
+    }
+    vTaskDelay(pdMS_TO_TICKS((remain_us + 999) / 1000));
+}
+
+AUDIO_IRAM_ATTR void AudioCodec::ApplySoftwareGain(std::vector<int16_t>& data) {
+    // 音量曲线与原 NoAudioCodec::Write 一致（平方律），换算成 Q14
+    int16_t target = (int16_t)(pow(double(output_volume_) / 100.0, 2) * (1 << 14));
+    int16_t gain = current_gain_q14_;
+
+    size_t offset = 0;
+    size_t samples = data.size();
+    while (offset < samples && gain != target) {
+        // 每 64 个采样走一步淡变：24kHz 下 0 -> 满增益约 85ms，足够压住爆音
+        size_t chunk = samples - offset < 64 ? samples - offset : 64;
+        if (gain != (1 << 14)) {
+            pcm_simd::ApplyGainQ14(data.data() + offset, chunk, gain);
+        }
+        if (gain < target) {
+            gain = gain + kFadeStepQ14 > target ? target : gain + kFadeStepQ14;
+        } else {
+            gain = gain - kFadeStepQ14 < target ? target : gain - kFadeStepQ14;
+        }
+        offset += chunk;
+    }
+    current_gain_q14_ = gain;
+
+    // 余下部分增益恒定，一次向量化调用处理完；满增益直接跳过
+    if (offset < samples && gain != (1 << 14)) {
+        pcm_simd::ApplyGainQ14(data.data() + offset, samples - offset, gain);
+    }
+}
+
+AUDIO_IRAM_ATTR void AudioCodec::ApplyEnableRamp(std::vector<int16_t>& data) {
+    size_t samples = data.size();
+    size_t offset = 0;
+
+    if (ramp_wait_zero_cross_) {
+        // 从任意相位硬开声对 DAC 就是一次阶跃。先把数据静音到第一
+        // 个过零点，让换路落在波形自然为零的时刻，斜坡从那里起步。
+        // 语音/音乐每半个周期就过零，基本都在本帧内命中；整帧都不
+        // 过零（纯直流）就静音整帧继续等
+        size_t cross = samples;
+        int16_t prev = samples > 0 ? data[0] : 0;
+        for (size_t i = 0; i < samples; i += output_channels_) {
+            int16_t v = data[i];
+            if (v == 0 || (v < 0) != (prev < 0)) {
+                cross = i;
+                break;
+            }
+            prev = v;
+        }
+        if (cross > 0) {
+            memset(data.data(), 0, cross * sizeof(int16_t));
+        }
+        if (cross == samples) {
+            return;
+        }
+        ramp_wait_zero_cross_ = false;
+        offset = cross;
+    }
+
+    // 短斜坡：64 采样一步，每步仍是一次向量化内核调用
+    int16_t gain = ramp_gain_q14_;
+    while (offset < samples && gain != (1 << 14)) {
+        size_t chunk = samples - offset < 64 ? samples - offset : 64;
+        pcm_simd::ApplyGainQ14(data.data() + offset, chunk, gain);
+        gain = (int32_t)gain + kRampStepQ14 >= (1 << 14) ? (1 << 14) : gain + kRampStepQ14;
+        offset += chunk;
+    }
+    ramp_gain_q14_ = gain;
 }
 
-bool AudioCodec::InputData(std::vector<int16_t>& data) {
-    int duration = 30;
+AUDIO_IRAM_ATTR bool AudioCodec::InputData(std::vector<int16_t>& data) {
+    // 读取粒度由板级配置决定（10/20/30ms），AFE 的喂入环形缓冲会按
+    // get_feed_chunksize 重新切块，这里只影响唤醒频率和输入延迟
+    int duration = AUDIO_INPUT_FRAME_DURATION_MS;
+    // 自愈：驱动收包环刚溢出过说明读取被持续挤占，临时把单次读取
+    // 加倍——同样的数据量一半的服务频率，调度晚一拍也追得回来。
+    // 块大小对上层透明（AFE/编码器都按自己的 chunk 重切），
+    // 安静 30 秒后回到默认粒度
+    if (esp_timer_get_time() < input_boost_until_us_.load(std::memory_order_relaxed)) {
+        duration *= 2;
+    }
     int input_frame_size = input_sample_rate_ / 1000 * duration * input_channels_;
 
     data.resize(input_frame_size);
     int samples = Read(data.data(), data.size());
-    if (samples > 0) {
-        return true;
+    if (samples <= 0) {
+        return false;
     }
-    return false;
+    if (samples < input_frame_size) {
+        // 不足额的读取以前带着垃圾尾巴原样上送，现在裁掉并计数
+        rx_partial_reads_.fetch_add(1, std::memory_order_relaxed);
+        data.resize(samples);
+    }
+    return true;
 }
 
 IRAM_ATTR bool AudioCodec::on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
@@ -48,12 +182,36 @@ IRAM_ATTR bool AudioCodec::on_sent(i2s_chan_handle_t handle, i2s_event_data_t *e
 
 IRAM_ATTR bool AudioCodec::on_recv(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
     auto audio_codec = (AudioCodec*)user_ctx;
+#if CONFIG_AUDIO_LATENCY_STATS
+    // 收包完成中断的到达间隔：中断归核（AUDIO_INTR_CORE）后看 p95/max
+    // 是否还随整屏刷新抖动，这是输入抖动最直接的量具
+    int64_t now = esp_timer_get_time();
+    if (audio_codec->last_rx_isr_us_ != 0) {
+        LatencyTracker::GetInstance().Record(
+            LatencyTracker::kStageRxIsrGap, now - audio_codec->last_rx_isr_us_);
+    }
+    audio_codec->last_rx_isr_us_ = now;
+#endif
     if (audio_codec->input_enabled_ && audio_codec->on_input_ready_) {
         return audio_codec->on_input_ready_();
     }
     return false;
 }
 
+IRAM_ATTR bool AudioCodec::on_recv_ovf(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
+    // 收包环溢出 = 采集数据被驱动丢弃。以前完全不可见（Read 只是
+    // 拿到更旧的数据），现在计数给遥测，并触发 30 秒的大块读取自愈
+    auto audio_codec = (AudioCodec*)user_ctx;
+    audio_codec->rx_overruns_.fetch_add(1, std::memory_order_relaxed);
+    audio_codec->input_boost_until_us_.store(
+        esp_timer_get_time() + 30 * 1000000LL, std::memory_order_relaxed);
+    return false;
+}
+
+void AudioCodec::RunChannelInit(const std::function<void()>& fn) {
+    intr_affinity::RunOn(AUDIO_INTR_CORE, "i2s_init", fn);
+}
+
 void AudioCodec::Start() {
     Settings settings("audio", false);
     output_volume_ = settings.GetInt("output_volume", output_volume_);
@@ -61,6 +219,7 @@ void AudioCodec::Start() {
     // 注册音频数据回调
     i2s_event_callbacks_t rx_callbacks = {};
     rx_callbacks.on_recv = on_recv;
+    rx_callbacks.on_recv_q_ovf = on_recv_ovf;
     i2s_channel_register_event_callback(rx_handle_, &rx_callbacks, this);
 
     i2s_event_callbacks_t tx_callbacks = {};
@@ -70,6 +229,10 @@ void AudioCodec::Start() {
     ESP_ERROR_CHECK(i2s_channel_enable(tx_handle_));
     ESP_ERROR_CHECK(i2s_channel_enable(rx_handle_));
 
+    BringUp();
+}
+
+void AudioCodec::BringUp() {
     EnableInput(true);
     EnableOutput(true);
 }
@@ -95,5 +258,16 @@ void AudioCodec::EnableOutput(bool enable) {
         return;
     }
     output_enabled_ = enable;
+    if (enable) {
+        // 重新开声的瞬态统一在这里防：静音等过零 + 10ms 短斜坡，
+        // 硬件音量的 codec 一并生效（老的 85ms 软件音量淡入由它
+        // 取代，软件音量保持在目标值不再清零）
+        ramp_gain_q14_ = 0;
+        ramp_wait_zero_cross_ = true;
+        if constexpr (board_caps::kHasOutputProfile) {
+            // 上次会话的滤波器记忆和限幅增益不跨会话
+            output_shaper_.Reset();
+        }
+    }
     ESP_LOGI(TAG, "Set output enable to %s", enable ? "true" : "false");
 }
@@ -5,11 +5,39 @@
 #include <freertos/event_groups.h>
 #include <driver/i2s_std.h>
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <functional>
 
 #include "board.h"
+#include "config.h"
+#include "output_shaper.h"
+
+// I2S DMA 调优项，板级 config.h 可以覆盖：延迟敏感的部署把帧长调到
+// 10ms 并加大描述符数换调度余量，CPU 紧张的部署保持 30ms 少唤醒几次。
+// 默认值与历史行为一致（6 x 240 帧描述符、30ms 读取粒度）。
+#ifndef AUDIO_CODEC_DMA_DESC_NUM
+#define AUDIO_CODEC_DMA_DESC_NUM 6
+#endif
+#ifndef AUDIO_CODEC_DMA_FRAME_NUM
+#define AUDIO_CODEC_DMA_FRAME_NUM 240
+#endif
+#ifndef AUDIO_INPUT_FRAME_DURATION_MS
+#define AUDIO_INPUT_FRAME_DURATION_MS 30
+#endif
+
+#if AUDIO_INPUT_FRAME_DURATION_MS != 10 && AUDIO_INPUT_FRAME_DURATION_MS != 20 && AUDIO_INPUT_FRAME_DURATION_MS != 30
+#error "AUDIO_INPUT_FRAME_DURATION_MS must be 10, 20 or 30"
+#endif
+
+// 采样率/参考通道在板级 config.h 里就是编译期常量，逐帧热路径
+// 用它们做 if constexpr 特化：16kHz 板完全不链接重采样分支
+#ifndef AUDIO_INPUT_REFERENCE
+#define AUDIO_INPUT_REFERENCE false
+#endif
+inline constexpr int kBoardInputSampleRate = AUDIO_INPUT_SAMPLE_RATE;
+inline constexpr int kBoardInputChannels = AUDIO_INPUT_REFERENCE ? 2 : 1;
 
 class AudioCodec {
 public:
@@ -19,9 +47,17 @@ public:
     virtual void SetOutputVolume(int volume);
     virtual void EnableInput(bool enable);
     virtual void EnableOutput(bool enable);
+    // 休眠路径：整颗 codec 关断（bias/PLL 都停），下次 Enable 走全量
+    // 重配。对话内的高频开关走 EnableInput/EnableOutput，支持的驱动
+    // 在那里只做轻量静音。默认空实现
+    virtual void PowerDown() {}
 
     void Start();
     void OutputData(std::vector<int16_t>& data);
+    // 等已提交的输出采样全部离开 DMA 链再返回。说话→聆听的切换用它
+    // 取代固定 120ms 延时：按写入游标算出还剩多少没放完，通常只有
+    // 一两个描述符的尾巴（几十毫秒以内）
+    void WaitForOutputDrained();
     bool InputData(std::vector<int16_t>& data);
     void OnOutputReady(std::function<bool()> callback);
     void OnInputReady(std::function<bool()> callback);
@@ -33,13 +69,33 @@ public:
     inline int input_channels() const { return input_channels_; }
     inline int output_channels() const { return output_channels_; }
     inline int output_volume() const { return output_volume_; }
+    // 采集完整性计数：驱动收包环溢出（丢数据）和不足额的 Read。
+    // 以前两者都无声无息，现在挂在遥测 capture 面板上
+    inline uint32_t input_overruns() const { return rx_overruns_.load(std::memory_order_relaxed); }
+    inline uint32_t input_partial_reads() const { return rx_partial_reads_.load(std::memory_order_relaxed); }
+    // 写入游标快照：最后一个已提交采样的预计播完时刻（微秒），
+    // 音频时钟拿它对 DMA 消费位置做相位校正
+    inline int64_t output_tail_us() const { return tx_tail_us_.load(std::memory_order_relaxed); }
 
 private:
     std::function<bool()> on_input_ready_;
     std::function<bool()> on_output_ready_;
-    
+
+    // 软件音量路径：按 Q14 增益缩放，开播时从 0 淡入防爆音
+    void ApplySoftwareGain(std::vector<int16_t>& data);
+
+    // EnableOutput 后的瞬态处理：先静音到第一个过零点，再用约 10ms
+    // 的短斜坡拉满，对所有 codec 子类生效（硬件音量的板子原来完全
+    // 没有防爆音）
+    void ApplyEnableRamp(std::vector<int16_t>& data);
+
+    // 板级声学档案（EQ + 限幅，见 output_shaper.h）；没有档案的板子
+    // 是空壳，调用点被 if constexpr 折叠
+    OutputShaper output_shaper_;
+
     IRAM_ATTR static bool on_recv(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
     IRAM_ATTR static bool on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
+    IRAM_ATTR static bool on_recv_ovf(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
 
 protected:
     i2s_chan_handle_t tx_handle_ = nullptr;
@@ -54,6 +110,33 @@ protected:
     int input_channels_ = 1;
     int output_channels_ = 1;
     int output_volume_ = 70;
+    // 没有硬件音量的板子（NoAudioCodec 系列）置位，音量在 OutputData
+    // 里用向量化内核做，而不是 Write 里的标量循环
+    bool software_volume_ = false;
+    int16_t current_gain_q14_ = 0;
+    // 开声瞬态斜坡的当前增益和过零等待标志（见 ApplyEnableRamp）
+    int16_t ramp_gain_q14_ = 1 << 14;
+    bool ramp_wait_zero_cross_ = false;
+    // 写入游标：最后一个已提交采样的预计播完时刻（esp_timer 微秒）。
+    // 播放任务写、主循环读，原子即可
+    std::atomic<int64_t> tx_tail_us_{0};
+    // 采集完整性：溢出/不足额计数（ISR 和读取路径写），以及溢出后
+    // 临时放大单次读取的截止时刻（见 InputData）
+    std::atomic<uint32_t> rx_overruns_{0};
+    std::atomic<uint32_t> rx_partial_reads_{0};
+    std::atomic<int64_t> input_boost_until_us_{0};
+    // 上一次收包完成中断的时刻，只在 ISR 里读写（rx_isr_gap 直方图用）
+    int64_t last_rx_isr_us_ = 0;
+
+    // Start 里的首次拉起：默认顺序开输入再开输出。双芯片板（收发
+    // 各一颗，bring-up 互不依赖）可以重写成并行，让两颗芯片驱动里
+    // 的稳定延时互相遮蔽——音频就绪卡着唤醒词可用，在启动关键路径上
+    virtual void BringUp();
+
+    // 在 AUDIO_INTR_CORE 上同步跑 I2S 通道创建：esp_intr_alloc 把中断
+    // 分配在调用核上，所有子类的通道安装都从这里过，收发完成 ISR
+    // 就不再跟 WiFi/LCD 挤在板级构造函数所在的核（见 intr_affinity.h）
+    static void RunChannelInit(const std::function<void()>& fn);
 
     virtual int Read(int16_t* dest, int samples) = 0;
     virtual int Write(const int16_t* data, int samples) = 0;
@@ -1,8 +1,15 @@
 #include "box_audio_codec.h"
+#include "audio_iram.h"
+#include "settings.h"
 
 #include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
 #include <driver/i2c.h>
 #include <driver/i2s_tdm.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
 static const char TAG[] = "BoxAudioCodec";
 
@@ -15,7 +22,8 @@ BoxAudioCodec::BoxAudioCodec(void* i2c_master_handle, int input_sample_rate, int
     input_sample_rate_ = input_sample_rate;
     output_sample_rate_ = output_sample_rate;
 
-    CreateDuplexChannels(mclk, bclk, ws, dout, din);
+    // 通道创建在 AUDIO_INTR_CORE 上跑，I2S 完成中断随之归核
+    RunChannelInit([&]() { CreateDuplexChannels(mclk, bclk, ws, dout, din); });
 
     // Do initialize of related interface: data_if, ctrl_if and gpio_if
     audio_codec_i2s_cfg_t i2s_cfg = {
@@ -73,6 +81,17 @@ BoxAudioCodec::BoxAudioCodec(void* i2c_master_handle, int input_sample_rate, int
     input_dev_ = esp_codec_dev_new(&dev_cfg);
     assert(input_dev_ != NULL);
 
+    // 配置签名：采样率/地址/参考通道任一变动都会让上次烧进芯片的
+    // 配置失效。软复位时芯片带电、寄存器还在，签名对得上就跳过
+    // 拉起路径上的冗余重编程（增益/音量重写）；掉电复位不算
+    config_sig_ = input_sample_rate_ ^ (output_sample_rate_ << 1) ^
+        ((int32_t)es8311_addr << 16) ^ ((int32_t)es7210_addr << 24) ^
+        (input_reference_ ? (1 << 8) : 0);
+    if (esp_reset_reason() == ESP_RST_SW) {
+        Settings settings("audio", false);
+        warm_config_valid_ = settings.GetInt("box_cfg_sig", 0) == config_sig_;
+    }
+
     ESP_LOGI(TAG, "BoxAudioDevice initialized");
 }
 
@@ -96,8 +115,8 @@ void BoxAudioCodec::CreateDuplexChannels(gpio_num_t mclk, gpio_num_t bclk, gpio_
     i2s_chan_config_t chan_cfg = {
         .id = I2S_NUM_0,
         .role = I2S_ROLE_MASTER,
-        .dma_desc_num = 6,
-        .dma_frame_num = 240,
+        .dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM,
+        .dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM,
         .auto_clear_after_cb = true,
         .auto_clear_before_cb = false,
         .intr_priority = 0,
@@ -178,6 +197,45 @@ void BoxAudioCodec::CreateDuplexChannels(gpio_num_t mclk, gpio_num_t bclk, gpio_
     ESP_LOGI(TAG, "Duplex channels created");
 }
 
+// ES7210（采集）和 ES8311（播放）是两颗独立芯片，各自 open 里的
+// 寄存器编程和稳定延时互不依赖：I2C 事务有总线锁天然串行，但驱动
+// 里的 vTaskDelay 稳定窗口可以互相遮蔽。采集链放到一次性任务里与
+// 播放链并行拉起，串行几十毫秒的 bring-up 只剩较慢的一条
+void BoxAudioCodec::BringUp() {
+    int64_t start_us = esp_timer_get_time();
+    struct BringUpCtx {
+        BoxAudioCodec* codec;
+        SemaphoreHandle_t done;
+    } ctx = { this, xSemaphoreCreateBinary() };
+    bool overlapped = ctx.done != nullptr &&
+        xTaskCreate([](void* arg) {
+            auto* c = (BringUpCtx*)arg;
+            c->codec->EnableInput(true);
+            xSemaphoreGive(c->done);
+            vTaskDelete(NULL);
+        }, "codec_in", 3072, &ctx, 10, nullptr) == pdPASS;
+    if (overlapped) {
+        EnableOutput(true);
+        xSemaphoreTake(ctx.done, portMAX_DELAY);
+    } else {
+        // 任务起不来（内存紧张）退回顺序拉起，只是慢一点
+        EnableInput(true);
+        EnableOutput(true);
+    }
+    if (ctx.done != nullptr) {
+        vSemaphoreDelete(ctx.done);
+    }
+    ESP_LOGI(TAG, "Codec bring-up%s in %lld ms%s",
+        overlapped ? " (overlapped)" : "",
+        (esp_timer_get_time() - start_us) / 1000,
+        warm_config_valid_ ? ", warm config" : "");
+    // 热跳过只覆盖开机后的首次拉起；之后的重开（休眠断电回来）
+    // 芯片状态不保证，走全量编程
+    warm_config_valid_ = false;
+    Settings settings("audio", true);
+    settings.SetInt("box_cfg_sig", config_sig_);
+}
+
 void BoxAudioCodec::SetOutputVolume(int volume) {
     ESP_ERROR_CHECK(esp_codec_dev_set_out_vol(output_dev_, volume));
     AudioCodec::SetOutputVolume(volume);
@@ -199,7 +257,10 @@ void BoxAudioCodec::EnableInput(bool enable) {
             fs.channel_mask |= ESP_CODEC_DEV_MAKE_CHANNEL_MASK(1);
         }
         ESP_ERROR_CHECK(esp_codec_dev_open(input_dev_, &fs));
-        ESP_ERROR_CHECK(esp_codec_dev_set_in_channel_gain(input_dev_, ESP_CODEC_DEV_MAKE_CHANNEL_MASK(0), 40.0));
+        if (!warm_config_valid_) {
+            // 软复位热重启且配置签名没变时芯片里已是这组增益，省掉重写
+            ESP_ERROR_CHECK(esp_codec_dev_set_in_channel_gain(input_dev_, ESP_CODEC_DEV_MAKE_CHANNEL_MASK(0), 40.0));
+        }
     } else {
         ESP_ERROR_CHECK(esp_codec_dev_close(input_dev_));
     }
@@ -220,21 +281,23 @@ void BoxAudioCodec::EnableOutput(bool enable) {
             .mclk_multiple = 0,
         };
         ESP_ERROR_CHECK(esp_codec_dev_open(output_dev_, &fs));
-        ESP_ERROR_CHECK(esp_codec_dev_set_out_vol(output_dev_, output_volume_));
+        if (!warm_config_valid_) {
+            ESP_ERROR_CHECK(esp_codec_dev_set_out_vol(output_dev_, output_volume_));
+        }
     } else {
         ESP_ERROR_CHECK(esp_codec_dev_close(output_dev_));
     }
     AudioCodec::EnableOutput(enable);
 }
 
-int BoxAudioCodec::Read(int16_t* dest, int samples) {
+AUDIO_IRAM_ATTR int BoxAudioCodec::Read(int16_t* dest, int samples) {
     if (input_enabled_) {
         ESP_ERROR_CHECK_WITHOUT_ABORT(esp_codec_dev_read(input_dev_, (void*)dest, samples * sizeof(int16_t)));
     }
     return samples;
 }
 
-int BoxAudioCodec::Write(const int16_t* data, int samples) {
+AUDIO_IRAM_ATTR int BoxAudioCodec::Write(const int16_t* data, int samples) {
     if (output_enabled_) {
         ESP_ERROR_CHECK_WITHOUT_ABORT(esp_codec_dev_write(output_dev_, (void*)data, samples * sizeof(int16_t)));
     }
@@ -18,11 +18,21 @@ private:
     esp_codec_dev_handle_t output_dev_ = nullptr;
     esp_codec_dev_handle_t input_dev_ = nullptr;
 
+    // 热重启跳过冗余重编程：软复位时两颗芯片一直带电，寄存器还是
+    // 上次校验过的配置（配置签名持久在 NVS，配置变了签名对不上）。
+    // 只在首次拉起生效，拉起完即清
+    bool warm_config_valid_ = false;
+    int32_t config_sig_ = 0;
+
     void CreateDuplexChannels(gpio_num_t mclk, gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout, gpio_num_t din);
 
     virtual int Read(int16_t* dest, int samples) override;
     virtual int Write(const int16_t* data, int samples) override;
 
+protected:
+    // ES8311/ES7210 并行拉起（见 .cc）
+    virtual void BringUp() override;
+
 public:
     BoxAudioCodec(void* i2c_master_handle, int input_sample_rate, int output_sample_rate,
         gpio_num_t mclk, gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout, gpio_num_t din,
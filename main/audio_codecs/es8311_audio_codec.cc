@@ -1,4 +1,5 @@
 #include "es8311_audio_codec.h"
+#include "audio_iram.h"
 
 #include <esp_log.h>
 
@@ -13,7 +14,8 @@ Es8311AudioCodec::Es8311AudioCodec(void* i2c_master_handle, i2c_port_t i2c_port,
     input_sample_rate_ = input_sample_rate;
     output_sample_rate_ = output_sample_rate;
     pa_pin_ = pa_pin;
-    CreateDuplexChannels(mclk, bclk, ws, dout, din);
+    // 通道创建在 AUDIO_INTR_CORE 上跑，I2S 完成中断随之归核
+    RunChannelInit([&]() { CreateDuplexChannels(mclk, bclk, ws, dout, din); });
 
     // Do initialize of related interface: data_if, ctrl_if and gpio_if
     audio_codec_i2s_cfg_t i2s_cfg = {
@@ -80,8 +82,8 @@ void Es8311AudioCodec::CreateDuplexChannels(gpio_num_t mclk, gpio_num_t bclk, gp
     i2s_chan_config_t chan_cfg = {
         .id = I2S_NUM_0,
         .role = I2S_ROLE_MASTER,
-        .dma_desc_num = 6,
-        .dma_frame_num = 240,
+        .dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM,
+        .dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM,
         .auto_clear_after_cb = true,
         .auto_clear_before_cb = false,
         .intr_priority = 0,
@@ -135,22 +137,31 @@ void Es8311AudioCodec::SetOutputVolume(int volume) {
     AudioCodec::SetOutputVolume(volume);
 }
 
+// 对话内的开关走静音快路径：首次打开后设备常开（bias/PLL 保温），
+// 之后只动 ADC/DAC 静音位，一两条 I2C 写就完事，不再整走
+// close/open 的寄存器序列——说/听换挡的开销就在这里。完全关断
+// 留给休眠路径的 PowerDown()
 void Es8311AudioCodec::EnableInput(bool enable) {
     if (enable == input_enabled_) {
         return;
     }
     if (enable) {
-        esp_codec_dev_sample_info_t fs = {
-            .bits_per_sample = 16,
-            .channel = 1,
-            .channel_mask = 0,
-            .sample_rate = (uint32_t)input_sample_rate_,
-            .mclk_multiple = 0,
-        };
-        ESP_ERROR_CHECK(esp_codec_dev_open(input_dev_, &fs));
-        ESP_ERROR_CHECK(esp_codec_dev_set_in_gain(input_dev_, 40.0));
+        if (!input_opened_) {
+            esp_codec_dev_sample_info_t fs = {
+                .bits_per_sample = 16,
+                .channel = 1,
+                .channel_mask = 0,
+                .sample_rate = (uint32_t)input_sample_rate_,
+                .mclk_multiple = 0,
+            };
+            ESP_ERROR_CHECK(esp_codec_dev_open(input_dev_, &fs));
+            ESP_ERROR_CHECK(esp_codec_dev_set_in_gain(input_dev_, 40.0));
+            input_opened_ = true;
+        } else {
+            ESP_ERROR_CHECK(esp_codec_dev_set_in_mute(input_dev_, false));
+        }
     } else {
-        ESP_ERROR_CHECK(esp_codec_dev_close(input_dev_));
+        ESP_ERROR_CHECK(esp_codec_dev_set_in_mute(input_dev_, true));
     }
     AudioCodec::EnableInput(enable);
 }
@@ -160,36 +171,61 @@ void Es8311AudioCodec::EnableOutput(bool enable) {
         return;
     }
     if (enable) {
-        // Play 16bit 1 channel
-        esp_codec_dev_sample_info_t fs = {
-            .bits_per_sample = 16,
-            .channel = 1,
-            .channel_mask = 0,
-            .sample_rate = (uint32_t)output_sample_rate_,
-            .mclk_multiple = 0,
-        };
-        ESP_ERROR_CHECK(esp_codec_dev_open(output_dev_, &fs));
-        ESP_ERROR_CHECK(esp_codec_dev_set_out_vol(output_dev_, output_volume_));
+        if (!output_opened_) {
+            // Play 16bit 1 channel
+            esp_codec_dev_sample_info_t fs = {
+                .bits_per_sample = 16,
+                .channel = 1,
+                .channel_mask = 0,
+                .sample_rate = (uint32_t)output_sample_rate_,
+                .mclk_multiple = 0,
+            };
+            ESP_ERROR_CHECK(esp_codec_dev_open(output_dev_, &fs));
+            ESP_ERROR_CHECK(esp_codec_dev_set_out_vol(output_dev_, output_volume_));
+            output_opened_ = true;
+        } else {
+            ESP_ERROR_CHECK(esp_codec_dev_set_out_mute(output_dev_, false));
+        }
         if (pa_pin_ != GPIO_NUM_NC) {
             gpio_set_level(pa_pin_, 1);
         }
     } else {
-        ESP_ERROR_CHECK(esp_codec_dev_close(output_dev_));
+        // PA 先断再静音，避免静音瞬态上喇叭
         if (pa_pin_ != GPIO_NUM_NC) {
             gpio_set_level(pa_pin_, 0);
         }
+        ESP_ERROR_CHECK(esp_codec_dev_set_out_mute(output_dev_, true));
     }
     AudioCodec::EnableOutput(enable);
 }
 
-int Es8311AudioCodec::Read(int16_t* dest, int samples) {
+void Es8311AudioCodec::PowerDown() {
+    EnableInput(false);
+    EnableOutput(false);
+    // 这次 close 要真正断电：临时放开 disable_when_closed，
+    // 下次 Enable 重新 open 走全量配置
+    if (output_opened_) {
+        esp_codec_set_disable_when_closed(output_dev_, true);
+        ESP_ERROR_CHECK(esp_codec_dev_close(output_dev_));
+        esp_codec_set_disable_when_closed(output_dev_, false);
+        output_opened_ = false;
+    }
+    if (input_opened_) {
+        esp_codec_set_disable_when_closed(input_dev_, true);
+        ESP_ERROR_CHECK(esp_codec_dev_close(input_dev_));
+        esp_codec_set_disable_when_closed(input_dev_, false);
+        input_opened_ = false;
+    }
+}
+
+AUDIO_IRAM_ATTR int Es8311AudioCodec::Read(int16_t* dest, int samples) {
     if (input_enabled_) {
         ESP_ERROR_CHECK_WITHOUT_ABORT(esp_codec_dev_read(input_dev_, (void*)dest, samples * sizeof(int16_t)));
     }
     return samples;
 }
 
-int Es8311AudioCodec::Write(const int16_t* data, int samples) {
+AUDIO_IRAM_ATTR int Es8311AudioCodec::Write(const int16_t* data, int samples) {
     if (output_enabled_) {
         ESP_ERROR_CHECK_WITHOUT_ABORT(esp_codec_dev_write(output_dev_, (void*)data, samples * sizeof(int16_t)));
     }
@@ -18,6 +18,9 @@ private:
     esp_codec_dev_handle_t output_dev_ = nullptr;
     esp_codec_dev_handle_t input_dev_ = nullptr;
     gpio_num_t pa_pin_ = GPIO_NUM_NC;
+    // 首次 Enable 后设备保持打开，后续开关走静音快路径
+    bool input_opened_ = false;
+    bool output_opened_ = false;
 
     void CreateDuplexChannels(gpio_num_t mclk, gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout, gpio_num_t din);
 
@@ -33,6 +36,7 @@ public:
     virtual void SetOutputVolume(int volume) override;
     virtual void EnableInput(bool enable) override;
     virtual void EnableOutput(bool enable) override;
+    virtual void PowerDown() override;
 };
 
 #endif // _ES8311_AUDIO_CODEC_H
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "es8388_audio_codec.h"
+#include "audio_iram.h"
 
 #include <esp_log.h>
 
@@ -12,7 +13,9 @@ Es8388AudioCodec::Es8388AudioCodec(void* i2c_master_handle, i2c_port_t i2c_port,
     input_channels_ = 1; // 输入通道数
     input_sample_rate_ = input_sample_rate;
     output_sample_rate_ = output_sample_rate;
-    pa_pin_ = pa_pin;                                                                                                                                                                                     CreateDuplexChannels(mclk, bclk, ws, dout, din);
+    pa_pin_ = pa_pin;
+    // 通道创建在 AUDIO_INTR_CORE 上跑，I2S 完成中断随之归核
+    RunChannelInit([&]() { CreateDuplexChannels(mclk, bclk, ws, dout, din); });
 
     // Do initialize of related interface: data_if, ctrl_if and gpio_if
     audio_codec_i2s_cfg_t i2s_cfg = {
@@ -85,8 +88,8 @@ void Es8388AudioCodec::CreateDuplexChannels(gpio_num_t mclk, gpio_num_t bclk, gp
     i2s_chan_config_t chan_cfg = {
         .id = I2S_NUM_0,
         .role = I2S_ROLE_MASTER,
-        .dma_desc_num = 6,
-        .dma_frame_num = 240,
+        .dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM,
+        .dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM,
         .auto_clear_after_cb = true,
         .auto_clear_before_cb = false,
         .intr_priority = 0,
@@ -136,22 +139,29 @@ void Es8388AudioCodec::SetOutputVolume(int volume) {
     AudioCodec::SetOutputVolume(volume);
 }
 
+// 与 es8311 同一套路：首次打开后设备常开，之后的开关只动静音位，
+// 完全关断留给 PowerDown()（见 es8311_audio_codec.cc 的说明）
 void Es8388AudioCodec::EnableInput(bool enable) {
     if (enable == input_enabled_) {
         return;
     }
     if (enable) {
-        esp_codec_dev_sample_info_t fs = {
-            .bits_per_sample = 16,
-            .channel = 1,
-            .channel_mask = 0,
-            .sample_rate = (uint32_t)input_sample_rate_,
-            .mclk_multiple = 0,
-        };
-        ESP_ERROR_CHECK(esp_codec_dev_open(input_dev_, &fs));
-        ESP_ERROR_CHECK(esp_codec_dev_set_in_gain(input_dev_, 24.0));
+        if (!input_opened_) {
+            esp_codec_dev_sample_info_t fs = {
+                .bits_per_sample = 16,
+                .channel = 1,
+                .channel_mask = 0,
+                .sample_rate = (uint32_t)input_sample_rate_,
+                .mclk_multiple = 0,
+            };
+            ESP_ERROR_CHECK(esp_codec_dev_open(input_dev_, &fs));
+            ESP_ERROR_CHECK(esp_codec_dev_set_in_gain(input_dev_, 24.0));
+            input_opened_ = true;
+        } else {
+            ESP_ERROR_CHECK(esp_codec_dev_set_in_mute(input_dev_, false));
+        }
     } else {
-        ESP_ERROR_CHECK(esp_codec_dev_close(input_dev_));
+        ESP_ERROR_CHECK(esp_codec_dev_set_in_mute(input_dev_, true));
     }
     AudioCodec::EnableInput(enable);
 }
@@ -161,43 +171,64 @@ void Es8388AudioCodec::EnableOutput(bool enable) {
         return;
     }
     if (enable) {
-        esp_codec_dev_sample_info_t fs = {
-            .bits_per_sample = 16,
-            .channel = 1,
-            .channel_mask = 0,
-            .sample_rate = (uint32_t)output_sample_rate_,
-            .mclk_multiple = 0,
-        };
-        ESP_ERROR_CHECK(esp_codec_dev_open(output_dev_, &fs));
-        ESP_ERROR_CHECK(esp_codec_dev_set_out_vol(output_dev_, output_volume_));
-
-        // Set analog output volume to 0dB, default is -45dB
-        uint8_t reg_val = 30; // 0dB
-        uint8_t regs[] = { 46, 47, 48, 49 }; // HP_LVOL, HP_RVOL, SPK_LVOL, SPK_RVOL
-        for (uint8_t reg : regs) {
-            ctrl_if_->write_reg(ctrl_if_, reg, 1, &reg_val, 1);
+        if (!output_opened_) {
+            esp_codec_dev_sample_info_t fs = {
+                .bits_per_sample = 16,
+                .channel = 1,
+                .channel_mask = 0,
+                .sample_rate = (uint32_t)output_sample_rate_,
+                .mclk_multiple = 0,
+            };
+            ESP_ERROR_CHECK(esp_codec_dev_open(output_dev_, &fs));
+            ESP_ERROR_CHECK(esp_codec_dev_set_out_vol(output_dev_, output_volume_));
+
+            // Set analog output volume to 0dB, default is -45dB
+            uint8_t reg_val = 30; // 0dB
+            uint8_t regs[] = { 46, 47, 48, 49 }; // HP_LVOL, HP_RVOL, SPK_LVOL, SPK_RVOL
+            for (uint8_t reg : regs) {
+                ctrl_if_->write_reg(ctrl_if_, reg, 1, &reg_val, 1);
+            }
+            output_opened_ = true;
+        } else {
+            ESP_ERROR_CHECK(esp_codec_dev_set_out_mute(output_dev_, false));
         }
-
         if (pa_pin_ != GPIO_NUM_NC) {
             gpio_set_level(pa_pin_, 1);
         }
     } else {
-        ESP_ERROR_CHECK(esp_codec_dev_close(output_dev_));
         if (pa_pin_ != GPIO_NUM_NC) {
             gpio_set_level(pa_pin_, 0);
         }
+        ESP_ERROR_CHECK(esp_codec_dev_set_out_mute(output_dev_, true));
     }
     AudioCodec::EnableOutput(enable);
 }
 
-int Es8388AudioCodec::Read(int16_t* dest, int samples) {
+void Es8388AudioCodec::PowerDown() {
+    EnableInput(false);
+    EnableOutput(false);
+    if (output_opened_) {
+        esp_codec_set_disable_when_closed(output_dev_, true);
+        ESP_ERROR_CHECK(esp_codec_dev_close(output_dev_));
+        esp_codec_set_disable_when_closed(output_dev_, false);
+        output_opened_ = false;
+    }
+    if (input_opened_) {
+        esp_codec_set_disable_when_closed(input_dev_, true);
+        ESP_ERROR_CHECK(esp_codec_dev_close(input_dev_));
+        esp_codec_set_disable_when_closed(input_dev_, false);
+        input_opened_ = false;
+    }
+}
+
+AUDIO_IRAM_ATTR int Es8388AudioCodec::Read(int16_t* dest, int samples) {
     if (input_enabled_) {
         ESP_ERROR_CHECK_WITHOUT_ABORT(esp_codec_dev_read(input_dev_, (void*)dest, samples * sizeof(int16_t)));
     }
     return samples;
 }
 
-int Es8388AudioCodec::Write(const int16_t* data, int samples) {
+AUDIO_IRAM_ATTR int Es8388AudioCodec::Write(const int16_t* data, int samples) {
     if (output_enabled_) {
         ESP_ERROR_CHECK_WITHOUT_ABORT(esp_codec_dev_write(output_dev_, (void*)data, samples * sizeof(int16_t)));
     }
@@ -12,6 +12,8 @@ private:
     virtual int Read(int16_t* dest, int samples) override;
 
 public:
+    // 没有硬件音量，走基类 OutputData 里的向量化软件增益
+    NoAudioCodec() { software_volume_ = true; }
     virtual ~NoAudioCodec();
 };
 
@@ -0,0 +1,94 @@
+#include "output_shaper.h"
+
+#if AUDIO_OUTPUT_PROFILE
+
+#include <cstring>
+
+#include "audio_iram.h"
+#include "pcm_simd.h"
+
+namespace {
+
+// Q13 双二阶系数：|a1| 最大接近 2，Q13 在 int16 里还留一倍余量
+// 给高增益的 b 系数
+struct BiquadCoeffs {
+    int16_t b0, b1, b2, a1, a2;
+};
+
+constexpr BiquadCoeffs kEqSections[] = AUDIO_OUTPUT_EQ_SECTIONS;
+constexpr size_t kNumSections = sizeof(kEqSections) / sizeof(kEqSections[0]);
+static_assert(kNumSections <= 8, "EQ 节数超出状态数组");
+
+#ifndef AUDIO_OUTPUT_LIMITER_CEILING
+#define AUDIO_OUTPUT_LIMITER_CEILING 29000  // ≈ -1 dBFS
+#endif
+constexpr int32_t kLimiterCeiling = AUDIO_OUTPUT_LIMITER_CEILING;
+// 限幅按 64 采样一块判峰值：24kHz 下约 2.7ms 的检测粒度，
+// 与软件音量的淡变块长一致，增益应用仍是向量化内核
+constexpr size_t kLimiterBlock = 64;
+// 恢复步长：每块 +64/16384，满压到全放约 0.7 秒，听不出抽吸
+constexpr int16_t kLimiterReleaseQ14 = 64;
+
+}  // namespace
+
+void OutputShaper::Reset() {
+    memset(state_, 0, sizeof(state_));
+    limiter_gain_q14_ = 1 << 14;
+}
+
+AUDIO_IRAM_ATTR void OutputShaper::ProcessEq(int16_t* data, size_t samples, int channels) {
+    // 双二阶是逐样本的串行递推（y 依赖 y1/y2），吃不上 SIMD；
+    // 每节每声道一份记忆，级联顺着节的声明序跑
+    for (size_t s = 0; s < kNumSections; ++s) {
+        const BiquadCoeffs& c = kEqSections[s];
+        for (int ch = 0; ch < channels; ++ch) {
+            BiquadState& st = state_[s][ch];
+            int32_t x1 = st.x1, x2 = st.x2, y1 = st.y1, y2 = st.y2;
+            for (size_t i = ch; i < samples; i += channels) {
+                int32_t x = data[i];
+                int32_t y = ((int32_t)c.b0 * x + (int32_t)c.b1 * x1 + (int32_t)c.b2 * x2 -
+                             (int32_t)c.a1 * y1 - (int32_t)c.a2 * y2) >> 13;
+                x2 = x1;
+                x1 = x;
+                y2 = y1;
+                y1 = y;
+                data[i] = y > INT16_MAX ? INT16_MAX : y < INT16_MIN ? INT16_MIN : (int16_t)y;
+            }
+            st.x1 = x1;
+            st.x2 = x2;
+            st.y1 = y1;
+            st.y2 = y2;
+        }
+    }
+}
+
+AUDIO_IRAM_ATTR void OutputShaper::ProcessLimiter(int16_t* data, size_t samples) {
+    // 块峰值限幅：超过天花板的块立即压到线下（瞬时 attack），
+    // 之后每块放一点回来。增益本身用向量化内核应用
+    size_t offset = 0;
+    int16_t gain = limiter_gain_q14_;
+    while (offset < samples) {
+        size_t chunk = samples - offset < kLimiterBlock ? samples - offset : kLimiterBlock;
+        int32_t peak = pcm_simd::PeakAbs(data + offset, chunk);
+        // 本块按当前增益播出去的峰值
+        int32_t out_peak = (peak * gain) >> 14;
+        if (out_peak > kLimiterCeiling) {
+            gain = (int16_t)((kLimiterCeiling << 14) / peak);
+        } else if (gain < (1 << 14)) {
+            gain = (int32_t)gain + kLimiterReleaseQ14 >= (1 << 14)
+                ? (1 << 14) : gain + kLimiterReleaseQ14;
+        }
+        if (gain != (1 << 14)) {
+            pcm_simd::ApplyGainQ14(data + offset, chunk, gain);
+        }
+        offset += chunk;
+    }
+    limiter_gain_q14_ = gain;
+}
+
+AUDIO_IRAM_ATTR void OutputShaper::Process(int16_t* data, size_t samples, int channels) {
+    ProcessEq(data, samples, channels);
+    ProcessLimiter(data, samples);
+}
+
+#endif  // AUDIO_OUTPUT_PROFILE
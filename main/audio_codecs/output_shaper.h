@@ -0,0 +1,56 @@
+#ifndef OUTPUT_SHAPER_H
+#define OUTPUT_SHAPER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "board_caps.h"
+
+// 板级声学整形：实测的定点 EQ + 限幅器，在 OutputData 的末级生效
+// 每个板型的喇叭声学不同（音箱腔体 vs 面包板裸喇叭），以前唯一的
+// 旋钮是软件音量，小喇叭大音量直接削波。板级 config.h 用一次性的
+// 实测数据给出：
+//
+//   #define AUDIO_OUTPUT_PROFILE 1
+//   // Q13 双二阶节 {b0, b1, b2, a1, a2}，级联按序执行
+//   #define AUDIO_OUTPUT_EQ_SECTIONS {{...}, {...}}
+//   // 限幅天花板（线性幅度，29000 ≈ -1 dBFS），可缺省
+//   #define AUDIO_OUTPUT_LIMITER_CEILING 29000
+//
+// 没有档案的板子 AUDIO_OUTPUT_PROFILE 为 0，整级连同状态一起编译
+// 剔除（见 board_caps::kHasOutputProfile 的 if constexpr 折叠）
+#if AUDIO_OUTPUT_PROFILE
+
+class OutputShaper {
+public:
+    // 开声时清状态：上一次会话的滤波器记忆和限幅增益不跨会话
+    void Reset();
+    // 就地处理交织的 int16 PCM（channels 为 1 或 2）
+    void Process(int16_t* data, size_t samples, int channels);
+
+private:
+    struct BiquadState {
+        int32_t x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+    };
+
+    void ProcessEq(int16_t* data, size_t samples, int channels);
+    void ProcessLimiter(int16_t* data, size_t samples);
+
+    // [节][声道] 的滤波器记忆
+    BiquadState state_[8][2];
+    // 限幅增益，Q14：瞬时压下、缓慢恢复
+    int16_t limiter_gain_q14_ = 1 << 14;
+};
+
+#else
+
+// 无档案的板子：空壳，调用点的 if constexpr 分支整段折叠
+class OutputShaper {
+public:
+    void Reset() {}
+    void Process(int16_t*, size_t, int) {}
+};
+
+#endif  // AUDIO_OUTPUT_PROFILE
+
+#endif  // OUTPUT_SHAPER_H
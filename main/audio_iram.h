@@ -0,0 +1,25 @@
+#ifndef AUDIO_IRAM_H
+#define AUDIO_IRAM_H
+
+#include <esp_attr.h>
+#include <sdkconfig.h>
+
+// 音频热路径的 IRAM 放置开关
+// The I2S completion callbacks (AudioCodec::on_recv/on_sent) are always
+// IRAM_ATTR, but everything they wake — the codec driver Read/Write, the
+// AFE feed path with its ring buffer ops, the PCM SIMD kernels and the
+// resampler inner loop — normally runs from flash cache. During flash
+// writes (Settings/NVS commits, OTA) the cache is disabled and those
+// functions stall for milliseconds, which is audible as dropouts.
+//
+// With CONFIG_AUDIO_REALTIME_IRAM the per-frame functions tagged
+// AUDIO_IRAM_ATTR are placed in IRAM so the audio chain keeps running
+// through flash writes. Costs a few KB of IRAM; run
+// scripts/iram_report.py on the linker map to see exactly how much.
+#ifdef CONFIG_AUDIO_REALTIME_IRAM
+#define AUDIO_IRAM_ATTR IRAM_ATTR
+#else
+#define AUDIO_IRAM_ATTR
+#endif
+
+#endif // AUDIO_IRAM_H
@@ -0,0 +1,279 @@
+#include "audio_loopback_test.h"
+#include "application.h"
+#include "board.h"
+#include "audio_codec.h"
+#include "background_task.h"
+#include "json_builder.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#define TAG "LoopbackTest"
+
+namespace {
+
+// 激励参数：400→3400Hz 线性啁啾定位时延（覆盖语音带宽，互相关
+// 峰尖锐），隔 100ms 静音后接 1kHz 纯音测增益和 THD
+constexpr int kChirpMs = 200;
+constexpr int kChirpF0 = 400;
+constexpr int kChirpF1 = 3400;
+constexpr int kGapMs = 100;
+constexpr int kToneMs = 300;
+constexpr int kToneHz = 1000;
+constexpr int16_t kAmplitude = 16384;  // -6dBFS
+// 时延搜索上限；采集窗口 = 激励 + 搜索余量
+constexpr int kMaxLatencyMs = 500;
+
+void FillChirp(int16_t* data, int samples, int sample_rate) {
+    double k = (double)(kChirpF1 - kChirpF0) / (kChirpMs / 1000.0);
+    int fade = sample_rate / 100;  // 10ms 淡入淡出，免得爆音干扰相关
+    for (int i = 0; i < samples; i++) {
+        double t = (double)i / sample_rate;
+        double v = sin(2.0 * M_PI * (kChirpF0 * t + 0.5 * k * t * t));
+        double gain = 1.0;
+        if (i < fade) {
+            gain = (double)i / fade;
+        } else if (i > samples - fade) {
+            gain = (double)(samples - i) / fade;
+        }
+        data[i] = (int16_t)(kAmplitude * gain * v);
+    }
+}
+
+// Goertzel 单点功率（归一化到样本数）
+double GoertzelPower(const int16_t* data, int samples, int sample_rate, int freq) {
+    double w = 2.0 * M_PI * freq / sample_rate;
+    double coeff = 2.0 * cos(w);
+    double s0 = 0, s1 = 0, s2 = 0;
+    for (int i = 0; i < samples; i++) {
+        s0 = data[i] + coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    double power = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+    return power / ((double)samples * samples / 4);
+}
+
+double Rms(const int16_t* data, int samples) {
+    int64_t acc = 0;
+    for (int i = 0; i < samples; i++) {
+        acc += (int32_t)data[i] * data[i];
+    }
+    return sqrt((double)acc / samples);
+}
+
+}  // namespace
+
+bool AudioLoopbackTest::Start() {
+    auto& app = Application::GetInstance();
+    if (app.GetDeviceState() != kDeviceStateIdle) {
+        ESP_LOGW(TAG, "Loopback test only runs from idle state");
+        return false;
+    }
+    bool expected = false;
+    if (!running_.compare_exchange_strong(expected, true)) {
+        return false;
+    }
+    ESP_LOGI(TAG, "Starting audio loopback self-test");
+    app.ScheduleBulk([this]() { Run(); }, "loopback_test");
+    return true;
+}
+
+bool AudioLoopbackTest::CaptureInput(const std::vector<int16_t>& data) {
+    if (!capturing_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capture_.size() < capture_target_) {
+        capture_.insert(capture_.end(), data.begin(), data.end());
+    }
+    return true;
+}
+
+void AudioLoopbackTest::Run() {
+    auto codec = Board::GetInstance().GetAudioCodec();
+    codec->EnableInput(true);
+    codec->EnableOutput(true);
+
+    int out_rate = codec->output_sample_rate();
+    int in_rate = codec->input_sample_rate();
+    int in_channels = codec->input_channels();
+
+    int capture_ms = kChirpMs + kGapMs + kToneMs + kMaxLatencyMs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capture_.clear();
+        capture_target_ = (size_t)(in_rate / 1000 * capture_ms) * in_channels;
+        capture_.reserve(capture_target_);
+    }
+    capturing_.store(true, std::memory_order_release);
+
+    // 激励按输出采样率生成，单声道复制到所有输出通道
+    int chirp_samples = out_rate / 1000 * kChirpMs;
+    int gap_samples = out_rate / 1000 * kGapMs;
+    int tone_samples = out_rate / 1000 * kToneMs;
+    std::vector<int16_t> mono(chirp_samples + gap_samples + tone_samples);
+    FillChirp(mono.data(), chirp_samples, out_rate);
+    for (int i = 0; i < tone_samples; i++) {
+        mono[chirp_samples + gap_samples + i] =
+            (int16_t)(kAmplitude * sin(2.0 * M_PI * kToneHz * i / out_rate));
+    }
+    // 60ms 一块写，OutputData 自己按 DMA 节奏背压
+    int out_channels = codec->output_channels();
+    int chunk = out_rate / 1000 * 60;
+    for (size_t off = 0; off < mono.size(); off += chunk) {
+        size_t n = std::min((size_t)chunk, mono.size() - off);
+        std::vector<int16_t> block(n * out_channels);
+        for (size_t i = 0; i < n; i++) {
+            for (int ch = 0; ch < out_channels; ch++) {
+                block[i * out_channels + ch] = mono[off + i];
+            }
+        }
+        codec->OutputData(block);
+    }
+
+    // 等采集窗口收满，上限 3 秒兜底（输入断了也要能出报告）
+    int64_t deadline = esp_timer_get_time() + 3000000;
+    while (esp_timer_get_time() < deadline) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (capture_.size() >= capture_target_) {
+                break;
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    capturing_.store(false, std::memory_order_release);
+
+    Analyze();
+    running_.store(false, std::memory_order_release);
+}
+
+void AudioLoopbackTest::Analyze() {
+    auto codec = Board::GetInstance().GetAudioCodec();
+    int rate = codec->input_sample_rate();
+    int channels = codec->input_channels();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    runs_++;
+    last_ok_ = false;
+    size_t frames = capture_.size() / channels;
+    if ((int)frames < rate / 1000 * (kChirpMs + kGapMs + kToneMs)) {
+        ESP_LOGE(TAG, "Capture too short: %u frames", (unsigned)frames);
+        return;
+    }
+
+    // 麦克风通道解交织；回采参考（若有）在通道 1
+    std::vector<int16_t> mic(frames);
+    for (size_t i = 0; i < frames; i++) {
+        mic[i] = capture_[i * channels];
+    }
+
+    // 按输入采样率重建啁啾模板（物理信号一致，采样率无关）
+    int tpl_samples = rate / 1000 * kChirpMs;
+    std::vector<int16_t> tpl(tpl_samples);
+    FillChirp(tpl.data(), tpl_samples, rate);
+
+    // 互相关找时延：先 4 倍抽取粗搜，再全采样率在粗峰 ±16 内精搜。
+    // 归一化相关系数太低说明根本没收到激励（喇叭或麦克风坏）
+    int max_lag = std::min((int)frames - tpl_samples, rate / 1000 * kMaxLatencyMs);
+    double tpl_energy = 0;
+    for (int i = 0; i < tpl_samples; i++) {
+        tpl_energy += (double)tpl[i] * tpl[i];
+    }
+    auto score_at = [&](int lag) {
+        int64_t corr = 0;
+        int64_t energy = 0;
+        for (int i = 0; i < tpl_samples; i++) {
+            corr += (int32_t)mic[lag + i] * tpl[i];
+            energy += (int32_t)mic[lag + i] * mic[lag + i];
+        }
+        if (energy == 0) {
+            return 0.0;
+        }
+        return (double)corr / sqrt((double)energy * tpl_energy);
+    };
+    int best_lag = 0;
+    double best_score = -1;
+    for (int lag = 0; lag < max_lag; lag += 4) {
+        int64_t corr = 0;
+        for (int i = 0; i < tpl_samples; i += 4) {
+            corr += (int32_t)mic[lag + i] * tpl[i];
+        }
+        if ((double)corr > best_score) {
+            best_score = (double)corr;
+            best_lag = lag;
+        }
+    }
+    best_score = -1;
+    int coarse = best_lag;
+    for (int lag = std::max(0, coarse - 16); lag < std::min(max_lag, coarse + 16); lag++) {
+        double s = score_at(lag);
+        if (s > best_score) {
+            best_score = s;
+            best_lag = lag;
+        }
+    }
+    if (best_score < 0.2) {
+        ESP_LOGE(TAG, "Chirp not found in capture (score %.2f), check speaker/mic", best_score);
+        last_latency_ms_ = -1;
+        return;
+    }
+    last_latency_ms_ = (float)best_lag * 1000 / rate;
+    last_gain_db_ = (float)(20.0 * log10(
+        Rms(&mic[best_lag], tpl_samples) / Rms(tpl.data(), tpl_samples)));
+
+    // 纯音段：对齐后取中间 200ms 避开起止瞬态，Goertzel 提基波和
+    // 2~4 次谐波估 THD
+    int tone_start = best_lag + rate / 1000 * (kChirpMs + kGapMs + 50);
+    int tone_win = rate / 1000 * 200;
+    if (tone_start + tone_win <= (int)frames) {
+        double p1 = GoertzelPower(&mic[tone_start], tone_win, rate, kToneHz);
+        double ph = GoertzelPower(&mic[tone_start], tone_win, rate, kToneHz * 2)
+                  + GoertzelPower(&mic[tone_start], tone_win, rate, kToneHz * 3)
+                  + GoertzelPower(&mic[tone_start], tone_win, rate, kToneHz * 4);
+        last_thd_pct_ = p1 > 0 ? (float)(sqrt(ph / p1) * 100) : 100.0f;
+    }
+
+    // 回采参考布线检查：参考通道是电气回环，激励期间必须有信号
+    if (codec->input_reference() && channels == 2) {
+        std::vector<int16_t> ref(frames);
+        for (size_t i = 0; i < frames; i++) {
+            ref[i] = capture_[i * channels + 1];
+        }
+        int span = std::min((int)frames, rate / 1000 * (kChirpMs + kGapMs + kToneMs));
+        // -50dBFS 以下视为没接上
+        last_ref_ok_ = Rms(ref.data(), span) > 100.0 ? 1 : 0;
+    } else {
+        last_ref_ok_ = -1;
+    }
+
+    last_ok_ = true;
+    ESP_LOGI(TAG, "Loopback: latency %.1fms gain %.1fdB thd %.1f%% ref %d",
+        last_latency_ms_, last_gain_db_, last_thd_pct_, last_ref_ok_);
+}
+
+std::string AudioLoopbackTest::BuildJson() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    char buffer[256];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddNumber("runs", runs_);
+    json.AddBool("ok", last_ok_);
+    json.AddNumber("latency_ms", (int)last_latency_ms_);
+    json.AddNumber("gain_db", (int)last_gain_db_);
+    // 百分比保一位小数，整数传百分之十
+    json.AddNumber("thd_x10", (int)(last_thd_pct_ * 10));
+    json.AddNumber("ref_ok", last_ref_ok_);
+    json.EndObject();
+    if (json.overflowed()) {
+        return "{}";
+    }
+    return json.str();
+}
@@ -0,0 +1,58 @@
+#ifndef AUDIO_LOOPBACK_TEST_H
+#define AUDIO_LOOPBACK_TEST_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 声学环回自检：扬声器播 啁啾+1kHz 纯音，麦克风收回来，
+// 互相关定位啁啾算整圈时延（DMA 出 + 声学路径 + DMA 入），
+// RMS 比算增益，Goertzel 提 1k 及其谐波估 THD；带回采参考的板子
+// （input_reference()）顺带验证参考通道接没接对。产线和现场升级后
+// 用来确认喇叭/麦克风/回采布线没坏，结果进遥测（"loopback"），
+// 跨固件版本可以审计时延回归。
+//
+// 入口 Start()：空闲态才接受，激励播放和分析都在后台批量车道跑；
+// 采集靠主循环 InputAudio 把原始输入帧转给 CaptureInput（测试期间
+// 不喂 AFE，啁啾也就不会误触发唤醒）
+class AudioLoopbackTest {
+public:
+    static AudioLoopbackTest& GetInstance() {
+        static AudioLoopbackTest instance;
+        return instance;
+    }
+    AudioLoopbackTest(const AudioLoopbackTest&) = delete;
+    AudioLoopbackTest& operator=(const AudioLoopbackTest&) = delete;
+
+    // 发起一次自检；非空闲态或已有一轮在跑返回 false
+    bool Start();
+    // 主循环 InputAudio 开头调用：测试期间收走输入帧返回 true，
+    // 平时一个原子判断就返回 false，不走锁
+    bool CaptureInput(const std::vector<int16_t>& data);
+    // 最近一次结果，遥测用
+    std::string BuildJson();
+
+private:
+    AudioLoopbackTest() = default;
+
+    void Run();
+    void Analyze();
+
+    std::atomic<bool> capturing_{false};
+    std::atomic<bool> running_{false};
+    std::mutex mutex_;
+    std::vector<int16_t> capture_;
+    size_t capture_target_ = 0;
+
+    // 最近一次的结果（mutex_ 保护）
+    uint32_t runs_ = 0;
+    bool last_ok_ = false;
+    float last_latency_ms_ = 0;
+    float last_gain_db_ = 0;
+    float last_thd_pct_ = 0;
+    int last_ref_ok_ = -1;  // -1 = 板子没有回采参考
+};
+
+#endif // AUDIO_LOOPBACK_TEST_H
@@ -0,0 +1,85 @@
+#include "audio_pipeline_task.h"
+#include "task_telemetry.h"
+
+#include <esp_log.h>
+
+#define TAG "AudioPipeline"
+
+AudioPipelineTask::AudioPipelineTask(const char* name, uint32_t stack_size, UBaseType_t priority,
+                                     BaseType_t core_id, size_t max_depth)
+    : max_depth_(max_depth), name_(name) {
+    xTaskCreatePinnedToCore([](void* arg) {
+        AudioPipelineTask* task = (AudioPipelineTask*)arg;
+        task->TaskLoop();
+    }, name, stack_size, this, priority, &task_handle_, core_id);
+    TaskTelemetry::GetInstance().RegisterTask(name, task_handle_, stack_size);
+    TaskTelemetry::GetInstance().RegisterQueue(name, [this]() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return work_items_.size();
+    }, max_depth);
+}
+
+AudioPipelineTask::~AudioPipelineTask() {
+    if (task_handle_ != nullptr) {
+        vTaskDelete(task_handle_);
+    }
+}
+
+bool AudioPipelineTask::Schedule(std::function<void()> work) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (work_items_.size() >= max_depth_) {
+        ESP_LOGW(TAG, "%s queue full (%zu), dropping work item", name_, max_depth_);
+        return false;
+    }
+    active_items_++;
+    work_items_.emplace_back([this, w = std::move(work)]() {
+        w();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_items_--;
+            if (work_items_.empty() && active_items_ == 0) {
+                condition_variable_.notify_all();
+            }
+        }
+    });
+    condition_variable_.notify_all();
+    return true;
+}
+
+size_t AudioPipelineTask::CancelPending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = work_items_.size();
+    if (n == 0) {
+        return 0;
+    }
+    // 被撤销的闭包没机会跑自己的记账尾巴，这里代扣
+    work_items_.clear();
+    active_items_ -= n;
+    ESP_LOGI(TAG, "%s revoked %zu pending items", name_, n);
+    if (active_items_ == 0) {
+        condition_variable_.notify_all();
+    }
+    return n;
+}
+
+void AudioPipelineTask::WaitForCompletion() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_variable_.wait(lock, [this]() {
+        return work_items_.empty() && active_items_ == 0;
+    });
+}
+
+void AudioPipelineTask::TaskLoop() {
+    ESP_LOGI(TAG, "%s started on core %d", name_, xPortGetCoreID());
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_variable_.wait(lock, [this]() { return !work_items_.empty(); });
+
+        std::list<std::function<void()>> items = std::move(work_items_);
+        lock.unlock();
+
+        for (auto& item : items) {
+            item();
+        }
+    }
+}
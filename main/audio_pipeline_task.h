@@ -0,0 +1,44 @@
+#ifndef AUDIO_PIPELINE_TASK_H
+#define AUDIO_PIPELINE_TASK_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <mutex>
+#include <list>
+#include <functional>
+#include <condition_variable>
+#include <atomic>
+
+// 绑核的编解码流水线工作任务
+// A bounded work queue running on a pinned core. One instance drives
+// Opus encode of mic audio and another drives decode of incoming TTS,
+// so the two directions no longer serialize behind the single
+// BackgroundTask worker.
+class AudioPipelineTask {
+public:
+    AudioPipelineTask(const char* name, uint32_t stack_size, UBaseType_t priority,
+                      BaseType_t core_id, size_t max_depth);
+    ~AudioPipelineTask();
+
+    // Returns false (and drops the work) when the queue is full —
+    // stale audio is worth less than bounded latency.
+    bool Schedule(std::function<void()> work);
+    void WaitForCompletion();
+    // 撤销排队未跑的闭包（不执行，直接析构），返回撤销数。打断
+    // TTS 时还没开跑的解码是白活；已经被工人批量取走的那批由
+    // 闭包自查 aborted_ 早退
+    size_t CancelPending();
+
+private:
+    std::mutex mutex_;
+    std::list<std::function<void()>> work_items_;
+    std::condition_variable condition_variable_;
+    TaskHandle_t task_handle_ = nullptr;
+    std::atomic<size_t> active_items_{0};
+    size_t max_depth_;
+    const char* name_;
+
+    void TaskLoop();
+};
+
+#endif // AUDIO_PIPELINE_TASK_H
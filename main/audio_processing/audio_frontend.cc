@@ -0,0 +1,585 @@
+#include "audio_frontend.h"
+#include "audio_iram.h"
+#include "boot_profiler.h"
+#include "memory_budget.h"
+#include "task_telemetry.h"
+#include "settings.h"
+#include "config_blobs.h"
+#include "json_builder.h"
+#include "sched_profile.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <sdkconfig.h>
+#if CONFIG_USE_WAKE_WORD_DETECT
+#include <model_path.h>
+#include <esp_wn_models.h>
+#include <esp_mn_models.h>
+#include <esp_mn_speech_commands.h>
+#include "command_shortcuts.h"
+#endif
+
+#include <cstring>
+#include <sstream>
+
+#include "config.h"
+
+// AFE 内部任务布局，板级 config.h 可覆盖（跟 audio_codec.h 的 DMA
+// 调优宏同一套机制）。默认偏好核 1——核 0 上挤着 LVGL、WiFi 和主循环。
+// fetch 任务（VAD 门控 + 命令词/MultiNet 检测 + 就地 Opus 编码）的
+// 核与优先级由调度档案统一给（AFE_FETCH_TASK_* 的板级覆盖仍然生效，
+// 见 sched_profile.cc），用遥测的 cpu/tasks 面板核验
+#ifndef AFE_PREFERRED_CORE
+#define AFE_PREFERRED_CORE 1
+#endif
+#ifndef AFE_PREFERRED_PRIORITY
+#define AFE_PREFERRED_PRIORITY 1
+#endif
+
+#define DETECTION_ENABLED_EVENT (1 << 0)
+#define COMMUNICATION_ENABLED_EVENT (1 << 1)
+#define PRE_ARMED_EVENT (1 << 2)
+
+// 低功耗守听时语音结束后 WakeNet 再保持多少个 fetch 帧（约 32ms 一帧）
+#define WAKENET_HOLD_FRAMES 100
+
+// 环境底噪 EMA 的时间常数（非语音帧，约 32ms 一帧，1/64 ≈ 2 秒）
+// 和预喂参数：低于 kAmbientPrimeMin 的环境接近静音，NS 本来就没
+// 什么可学的，不值得预喂；漂移超过保存值的四分之一才重写 NVS
+// PSRAM 预算的声明额度（KB），板级 config.h 可按自家模型分区覆盖。
+// WAKE_MODELS 是 esp_srmodel_init 把分区里全部模型复制进 PSRAM 的
+// 合计；AFE 是 create_from_config 的工作区（环形缓冲 + NS/VAD/AEC +
+// 内部 WakeNet 副本），不带 WakeNet 时小一截。实测值事后回填账本
+#ifndef WAKE_MODELS_PSRAM_KB
+#define WAKE_MODELS_PSRAM_KB 800
+#endif
+#ifndef AFE_PSRAM_KB
+#define AFE_PSRAM_KB 480
+#endif
+#ifndef AFE_NO_WAKENET_PSRAM_KB
+#define AFE_NO_WAKENET_PSRAM_KB 320
+#endif
+
+#define AMBIENT_EMA_SHIFT 6
+#define AMBIENT_PRIME_MIN 24
+#define AMBIENT_PRIME_FRAMES 16
+#define AMBIENT_MIN_FRAMES 300
+
+static const char* TAG = "AudioFrontend";
+
+AudioFrontend::AudioFrontend() {
+    event_group_ = xEventGroupCreate();
+}
+
+void AudioFrontend::Initialize(int channels, bool reference) {
+    if (afe_data_ != nullptr) {
+        return;
+    }
+    channels_ = channels;
+    reference_ = reference;
+    int ref_num = reference_ ? 1 : 0;
+
+#if CONFIG_USE_WAKE_WORD_DETECT
+    // 模型会被 esp_srmodel_init 整块复制进 PSRAM，先过预算：批不
+    // 下来就不装，设备退化成按键唤醒而不是分配失败开机回环（2MB
+    // PSRAM 的板子叠上整帧显示缓冲就是这个下场）
+    srmodel_list_t* models = nullptr;
+    if (memory_budget::Claim("wake_models", WAKE_MODELS_PSRAM_KB * 1024)) {
+        // 模型分区扫描和 AFE 创建是启动耗时大户，分开打点
+        boot_profiler::Begin("srmodel_init");
+        size_t free_before = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+        models = esp_srmodel_init("model");
+        // 实测落差回填账本：模型副本到底多大只有这里量得出来
+        size_t model_bytes = free_before - heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+        memory_budget::Settle("wake_models", model_bytes);
+        ESP_LOGI(TAG, "Wake models: %u KB PSRAM", (unsigned)(model_bytes / 1024));
+        boot_profiler::End("srmodel_init");
+    } else {
+        ESP_LOGW(TAG, "PSRAM budget denied wake models, wake word disabled");
+    }
+    char* command_model = nullptr;
+    char* multinet_model = nullptr;
+    for (int i = 0; models != nullptr && i < models->num; i++) {
+        ESP_LOGI(TAG, "Model %d: %s", i, models->model_name[i]);
+        if (strstr(models->model_name[i], ESP_MN_PREFIX) != NULL) {
+            if (multinet_model == nullptr) {
+                // MultiNet 模型给短语直通用（command_shortcuts 表）
+                multinet_model = models->model_name[i];
+            }
+        } else if (strstr(models->model_name[i], ESP_WN_PREFIX) != NULL) {
+            if (wakenet_model_ == nullptr) {
+                // 第一个 WakeNet 模型当主唤醒词，照旧挂进 AFE
+                wakenet_model_ = models->model_name[i];
+                auto words = esp_srmodel_get_wake_words(models, wakenet_model_);
+                // split by ";" to get all wake words
+                std::stringstream ss(words);
+                std::string word;
+                while (std::getline(ss, word, ';')) {
+                    wake_words_.push_back(word);
+                }
+            } else if (command_model == nullptr) {
+                // 第二个 WakeNet 模型当命令词网络（"停止"等），
+                // 独立持有、按状态门控
+                command_model = models->model_name[i];
+            }
+        }
+    }
+#endif
+
+    afe_config_t afe_config = {
+        // 有回采参考的板子开 AEC，播报期间 AFE 可以继续跑（barge-in）
+        .aec_init = reference_,
+        .se_init = true,
+        .vad_init = true,
+        .wakenet_init = wakenet_model_ != nullptr,
+        .voice_communication_init = false,
+        .voice_communication_agc_init = false,
+        .voice_communication_agc_gain = 10,
+        .vad_mode = VAD_MODE_3,
+        .wakenet_model_name = wakenet_model_,
+        .wakenet_model_name_2 = NULL,
+        .wakenet_mode = DET_MODE_90,
+        .afe_mode = SR_MODE_HIGH_PERF,
+        .afe_perferred_core = AFE_PREFERRED_CORE,
+        .afe_perferred_priority = AFE_PREFERRED_PRIORITY,
+        .afe_ringbuf_size = 50,
+        .memory_alloc_mode = AFE_MEMORY_ALLOC_MORE_PSRAM,
+        .afe_linear_gain = 1.0,
+        .agc_mode = AFE_MN_PEAK_AGC_MODE_2,
+        .pcm_config = {
+            .total_ch_num = channels_,
+            .mic_num = channels_ - ref_num,
+            .ref_num = ref_num,
+            .sample_rate = 16000,
+        },
+        .debug_init = false,
+        .debug_hook = {{ AFE_DEBUG_HOOK_MASE_TASK_IN, NULL }, { AFE_DEBUG_HOOK_FETCH_TASK_IN, NULL }},
+        .afe_ns_mode = NS_MODE_SSP,
+        .afe_ns_model_name = NULL,
+        .fixed_first_channel = true,
+    };
+
+    // AFE 是通话链路的必经之路，额度批不下来也得建——但账本会留
+    // denied 条目给遥测亮红，说明这块板子的预算表该改了。模型被
+    // 预算砍掉时 wakenet_init 已经是 false，AFE 自己也会小一截
+    size_t afe_declared = (afe_config.wakenet_init
+        ? AFE_PSRAM_KB : AFE_NO_WAKENET_PSRAM_KB) * 1024;
+    bool afe_granted = memory_budget::Claim("afe", afe_declared);
+    boot_profiler::Begin("afe_create");
+    size_t afe_free_before = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    afe_data_ = esp_afe_sr_v1.create_from_config(&afe_config);
+    if (afe_granted) {
+        memory_budget::Settle("afe",
+            afe_free_before - heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    }
+    boot_profiler::End("afe_create");
+
+#if CONFIG_USE_WAKE_WORD_DETECT
+    if (command_model != nullptr) {
+        command_iface_ = (const esp_wn_iface_t*)esp_wn_handle_from_name(command_model);
+        if (command_iface_ != nullptr) {
+            // 命令词用高阈值档：播报声底下误触发比漏触发难受得多
+            command_model_data_ = command_iface_->create(command_model, DET_MODE_95);
+            command_chunk_.resize(command_iface_->get_samp_chunksize(command_model_data_));
+            auto words = esp_srmodel_get_wake_words(models, command_model);
+            std::stringstream ss(words);
+            std::string word;
+            while (std::getline(ss, word, ';')) {
+                command_words_.push_back(word);
+            }
+            ESP_LOGI(TAG, "Command word model: %s (%s)", command_model, words);
+        }
+    }
+    if (multinet_model != nullptr) {
+        multinet_iface_ = esp_mn_handle_from_name(multinet_model);
+        if (multinet_iface_ != nullptr) {
+            multinet_data_ = multinet_iface_->create(multinet_model, 6000);
+            multinet_chunk_.resize(multinet_iface_->get_samp_chunksize(multinet_data_));
+            // 把默认命令表换成本地直通短语表，ID = 表下标 + 1
+            esp_mn_commands_alloc((esp_mn_iface_t*)multinet_iface_, multinet_data_);
+            esp_mn_commands_clear();
+            size_t shortcut_count = 0;
+            auto shortcuts = command_shortcuts::GetTable(&shortcut_count);
+            for (size_t i = 0; i < shortcut_count; i++) {
+                esp_mn_commands_add(i + 1, (char*)shortcuts[i].phrase);
+            }
+            esp_mn_commands_update();
+            ESP_LOGI(TAG, "Shortcut model: %s (%u phrases)", multinet_model,
+                (unsigned)shortcut_count);
+        }
+    }
+#endif
+    input_buffer_.Initialize(esp_afe_sr_v1.get_feed_chunksize(afe_data_) * channels_, TAG,
+        true /* use_psram */);
+
+    // 真麦克风数据进来之前先用上次的底噪画像预喂 NS（见头文件说明）
+    PrimeNoiseEstimator(esp_afe_sr_v1.get_feed_chunksize(afe_data_));
+
+    TaskHandle_t fetch_handle = nullptr;
+    xTaskCreatePinnedToCore([](void* arg) {
+        auto this_ = (AudioFrontend*)arg;
+        this_->FetchTask();
+        vTaskDelete(NULL);
+    }, "audio_frontend", 4096 * 2, this, sched_profile::Current().afe_priority,
+        &fetch_handle, sched_profile::Core(sched_profile::Current().afe_core));
+    TaskTelemetry::GetInstance().RegisterTask("audio_frontend", fetch_handle, 4096 * 2);
+}
+
+// Feed 会把 PcmRingBuffer 的 Write/PopChunk 内联进来，
+// 放这一个函数等于把环形缓冲操作一起放进 IRAM
+AUDIO_IRAM_ATTR void AudioFrontend::Feed(const std::vector<int16_t>& data) {
+    if (afe_data_ == nullptr) {
+        return;  // 初始化还在后台跑，这段音频只能丢
+    }
+    input_buffer_.Write(data.data(), data.size());
+
+    // feed 直接拿 chunk 指针，常数时间，不再搬移剩余数据
+    int16_t* chunk;
+    while ((chunk = input_buffer_.PopChunk()) != nullptr) {
+        esp_afe_sr_v1.feed(afe_data_, chunk);
+    }
+}
+
+bool AudioFrontend::IsRunning() {
+    // 预热也算在跑：InputAudio 据此继续喂数据
+    return xEventGroupGetBits(event_group_) &
+        (DETECTION_ENABLED_EVENT | COMMUNICATION_ENABLED_EVENT | PRE_ARMED_EVENT);
+}
+
+void AudioFrontend::SetPreArmed(bool enable) {
+    if (enable) {
+        xEventGroupSetBits(event_group_, PRE_ARMED_EVENT);
+    } else {
+        xEventGroupClearBits(event_group_, PRE_ARMED_EVENT);
+    }
+}
+
+void AudioFrontend::EnableDetection(bool enable) {
+    if (enable) {
+        // 不销毁重建，wakenet 直接重新挂上
+        if (afe_data_ != nullptr && wakenet_model_ != nullptr &&
+            !(xEventGroupGetBits(event_group_) & DETECTION_ENABLED_EVENT)) {
+            esp_afe_sr_v1.enable_wakenet(afe_data_);
+        }
+        xEventGroupSetBits(event_group_, DETECTION_ENABLED_EVENT);
+    } else {
+        xEventGroupClearBits(event_group_, DETECTION_ENABLED_EVENT);
+        // 通话还开着时把唤醒网络停了省 CPU；全停时 fetch 任务本来就挂起
+        if (afe_data_ != nullptr && wakenet_model_ != nullptr && IsCommunicationEnabled()) {
+            esp_afe_sr_v1.disable_wakenet(afe_data_);
+        }
+    }
+}
+
+bool AudioFrontend::IsDetectionEnabled() {
+    return xEventGroupGetBits(event_group_) & DETECTION_ENABLED_EVENT;
+}
+
+void AudioFrontend::EnableCommunication(bool enable) {
+    if (enable) {
+        xEventGroupSetBits(event_group_, COMMUNICATION_ENABLED_EVENT);
+    } else {
+        xEventGroupClearBits(event_group_, COMMUNICATION_ENABLED_EVENT);
+        // 会话收尾顺手检查底噪画像要不要落盘：这里是应用任务上下文，
+        // 不在 fetch 任务里写 NVS
+        MaybeSaveAmbientProfile();
+    }
+}
+
+bool AudioFrontend::IsCommunicationEnabled() {
+    return xEventGroupGetBits(event_group_) & COMMUNICATION_ENABLED_EVENT;
+}
+
+void AudioFrontend::SetLowPowerMode(bool enable) {
+    // 只翻标志，真正的挂起/恢复在 FetchTask 的下一帧做
+    low_power_mode_ = enable;
+}
+
+// 开机把存下的环境电平合成为白噪声垫在首批 feed 里：SSP 的噪声谱
+// 估计从环境量级起步，首句的抑制立即到位。白噪声的谱形和真实环境
+// 不一定一致，但比从静音起步收敛快得多；预喂帧在 fetch 侧因为没有
+// 消费方开着会被整帧丢掉，不会漏到上行
+void AudioFrontend::PrimeNoiseEstimator(int feed_chunksize) {
+    config_blobs::AfeAmbientProfile profile = {};
+    Settings settings("afe");
+    if (!settings.GetBlob("ambient", config_blobs::AfeAmbientProfile::kVersion,
+            &profile, sizeof(profile))) {
+        return;
+    }
+    saved_ambient_level_ = profile.ambient_level;
+    ambient_level_ = profile.ambient_level;
+    if (profile.ambient_level < AMBIENT_PRIME_MIN) {
+        return;
+    }
+
+    // 均匀分布 ±2L 的平均绝对幅度恰好是 L；参考通道留零
+    std::vector<int16_t> chunk(feed_chunksize * channels_, 0);
+    int ref_channel = reference_ ? channels_ - 1 : -1;
+    uint32_t seed = 0x2545f491;
+    int32_t amplitude = profile.ambient_level * 2;
+    for (int frame = 0; frame < AMBIENT_PRIME_FRAMES; frame++) {
+        for (int i = 0; i < feed_chunksize; i++) {
+            for (int ch = 0; ch < channels_; ch++) {
+                if (ch == ref_channel) {
+                    continue;
+                }
+                seed = seed * 1664525u + 1013904223u;
+                chunk[i * channels_ + ch] =
+                    (int16_t)((int32_t)(seed >> 16) % (2 * amplitude + 1) - amplitude);
+            }
+        }
+        esp_afe_sr_v1.feed(afe_data_, chunk.data());
+    }
+    ambient_primed_ = true;
+    ESP_LOGI(TAG, "Primed noise estimator with ambient level %u", profile.ambient_level);
+}
+
+AUDIO_IRAM_ATTR void AudioFrontend::UpdateAmbientLevel(const int16_t* data, size_t samples) {
+    if (samples == 0) {
+        return;
+    }
+    // 隔 4 采样取平均绝对幅度，足够稳又便宜
+    int32_t sum = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < samples; i += 4) {
+        int32_t s = data[i];
+        sum += s < 0 ? -s : s;
+        count++;
+    }
+    float level = (float)sum / count;
+    ambient_level_ += (level - ambient_level_) / (1 << AMBIENT_EMA_SHIFT);
+    ambient_frames_++;
+}
+
+void AudioFrontend::MaybeSaveAmbientProfile() {
+    // 估计没坐稳（开机没多久）或者跟存的值差得不多就不磨 NVS
+    if (ambient_frames_ < AMBIENT_MIN_FRAMES) {
+        return;
+    }
+    uint16_t level = (uint16_t)(ambient_level_ + 0.5f);
+    uint16_t threshold = saved_ambient_level_ / 4 > 8 ? saved_ambient_level_ / 4 : 8;
+    int32_t drift = (int32_t)level - (int32_t)saved_ambient_level_;
+    if (drift < 0) {
+        drift = -drift;
+    }
+    if (drift < threshold) {
+        return;
+    }
+    config_blobs::AfeAmbientProfile profile = {};
+    profile.ambient_level = level;
+    Settings settings("afe", true);
+    settings.SetBlob("ambient", config_blobs::AfeAmbientProfile::kVersion,
+        &profile, sizeof(profile));
+    saved_ambient_level_ = level;
+    ESP_LOGI(TAG, "Ambient noise profile saved: level %u", level);
+}
+
+std::string AudioFrontend::BuildJson() {
+    char buffer[128];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddNumber("ambient", (int)(ambient_level_ + 0.5f));
+    json.AddNumber("saved", saved_ambient_level_);
+    json.AddNumber("frames", (int)ambient_frames_);
+    json.AddBool("primed", ambient_primed_);
+    json.EndObject();
+    return json.str();
+}
+
+void AudioFrontend::EnableCommandWords(bool enable) {
+    if (command_model_data_ == nullptr) {
+        return;
+    }
+    if (enable) {
+        // 半截旧音频不跨会话：先清拼块再开闸
+        command_chunk_filled_ = 0;
+    }
+    command_enabled_ = enable;
+}
+
+void AudioFrontend::OnCommandDetected(std::function<void(const std::string&)> callback) {
+    command_detected_callback_ = callback;
+}
+
+void AudioFrontend::EnableShortcuts(bool enable) {
+    if (multinet_data_ == nullptr) {
+        return;
+    }
+    if (enable) {
+        // 半截旧音频不跨会话：先清拼块再开闸
+        multinet_chunk_filled_ = 0;
+    }
+    shortcuts_enabled_ = enable;
+}
+
+void AudioFrontend::OnShortcutDetected(std::function<void(int)> callback) {
+    shortcut_detected_callback_ = callback;
+}
+
+void AudioFrontend::DetectShortcut(const int16_t* data, size_t samples) {
+    // 和命令词一样按 MultiNet 的输入块长拼块，拼满一块算一块
+    while (samples > 0) {
+        size_t space = multinet_chunk_.size() - multinet_chunk_filled_;
+        size_t n = samples < space ? samples : space;
+        memcpy(multinet_chunk_.data() + multinet_chunk_filled_, data, n * sizeof(int16_t));
+        multinet_chunk_filled_ += n;
+        data += n;
+        samples -= n;
+        if (multinet_chunk_filled_ < multinet_chunk_.size()) {
+            return;
+        }
+        multinet_chunk_filled_ = 0;
+        auto state = multinet_iface_->detect(multinet_data_, multinet_chunk_.data());
+        if (state == ESP_MN_STATE_DETECTED) {
+            auto results = multinet_iface_->get_results(multinet_data_);
+            if (results != nullptr && results->num > 0) {
+                int command_id = results->command_id[0];
+                ESP_LOGI(TAG, "Shortcut phrase detected: id %d", command_id);
+                if (shortcut_detected_callback_) {
+                    shortcut_detected_callback_(command_id);
+                }
+            }
+            multinet_iface_->clean(multinet_data_);
+        } else if (state == ESP_MN_STATE_TIMEOUT) {
+            // 超时清窗，下一段语音从头识别
+            multinet_iface_->clean(multinet_data_);
+        }
+    }
+}
+
+void AudioFrontend::DetectCommandWord(const int16_t* data, size_t samples) {
+    // AFE 的 fetch 块和 WakeNet 的输入块不一定等长，拼满一块算一块
+    while (samples > 0) {
+        size_t space = command_chunk_.size() - command_chunk_filled_;
+        size_t n = samples < space ? samples : space;
+        memcpy(command_chunk_.data() + command_chunk_filled_, data, n * sizeof(int16_t));
+        command_chunk_filled_ += n;
+        data += n;
+        samples -= n;
+        if (command_chunk_filled_ < command_chunk_.size()) {
+            return;
+        }
+        command_chunk_filled_ = 0;
+        int state = command_iface_->detect(command_model_data_, command_chunk_.data());
+        if (state > 0 && !command_words_.empty()) {
+            const std::string& word = (size_t)state <= command_words_.size()
+                ? command_words_[state - 1]
+                : command_words_.front();
+            ESP_LOGI(TAG, "Command word detected: %s", word.c_str());
+            if (command_detected_callback_) {
+                command_detected_callback_(word);
+            }
+        }
+    }
+}
+
+void AudioFrontend::OnWakeWordDetected(std::function<void(const std::string&)> callback) {
+    wake_word_detected_callback_ = callback;
+}
+
+void AudioFrontend::OnDetectionAudio(std::function<void(const int16_t*, size_t)> callback) {
+    detection_audio_callback_ = callback;
+}
+
+void AudioFrontend::OnCommunicationOutput(std::function<void(const int16_t*, size_t)> callback) {
+    communication_output_callback_ = callback;
+}
+
+void AudioFrontend::OnVadStateChange(std::function<void(bool)> callback) {
+    vad_state_change_callbacks_.push_back(callback);
+}
+
+void AudioFrontend::FetchTask() {
+    auto fetch_size = esp_afe_sr_v1.get_fetch_chunksize(afe_data_);
+    auto feed_size = esp_afe_sr_v1.get_feed_chunksize(afe_data_);
+    ESP_LOGI(TAG, "Audio frontend task started, feed size: %d fetch size: %d",
+        feed_size, fetch_size);
+
+    while (true) {
+        auto bits = xEventGroupWaitBits(event_group_,
+            DETECTION_ENABLED_EVENT | COMMUNICATION_ENABLED_EVENT | PRE_ARMED_EVENT,
+            pdFALSE, pdFALSE, portMAX_DELAY);
+
+        auto res = esp_afe_sr_v1.fetch(afe_data_);
+        bits = xEventGroupGetBits(event_group_);
+        if (res == nullptr || res->ret_value == ESP_FAIL) {
+            if (res != nullptr &&
+                (bits & (DETECTION_ENABLED_EVENT | COMMUNICATION_ENABLED_EVENT))) {
+                ESP_LOGI(TAG, "Error code: %d", res->ret_value);
+            }
+            continue;
+        }
+
+        // 非语音帧滚动维护环境底噪估计，预热丢帧也算——空闲期正是
+        // 采环境的好时候
+        if (res->vad_state != AFE_VAD_SPEECH) {
+            UpdateAmbientLevel(res->data, res->data_size / sizeof(int16_t));
+        }
+
+        if ((bits & (DETECTION_ENABLED_EVENT | COMMUNICATION_ENABLED_EVENT)) == 0) {
+            // 只有预热位：fetch 照跑把环排空。输出不再整帧丢掉，而是
+            // 递给通话回调垫预滚环——非聆听态上游只暂存不上行，聆听
+            // 开始时从提示音时刻补发（见 Application::OnOutput 一侧）
+            if (communication_output_callback_) {
+                communication_output_callback_(res->data, res->data_size / sizeof(int16_t));
+            }
+            continue;
+        }
+
+        // VAD 状态翻转才回调，检测和通话两边共用同一份状态
+        bool speaking = res->vad_state == AFE_VAD_SPEECH;
+        if (speaking != is_speaking_) {
+            is_speaking_ = speaking;
+            for (auto& callback : vad_state_change_callbacks_) {
+                callback(speaking);
+            }
+        }
+
+        // 低功耗守听占空比：静默坐满 hold 帧后 disable_wakenet 只留
+        // VAD，省下的 CPU 让 PowerSaveTimer 能把主频降下去；VAD 一报
+        // 语音立即重挂。通话期间唤醒网络另有开关逻辑，这里不掺和
+        if ((bits & DETECTION_ENABLED_EVENT) && wakenet_model_ != nullptr &&
+            !(bits & COMMUNICATION_ENABLED_EVENT)) {
+            if (!low_power_mode_ || speaking) {
+                if (wakenet_suspended_) {
+                    esp_afe_sr_v1.enable_wakenet(afe_data_);
+                    wakenet_suspended_ = false;
+                    ESP_LOGI(TAG, "WakeNet resumed by voice activity");
+                }
+                wakenet_hold_frames_ = WAKENET_HOLD_FRAMES;
+            } else if (!wakenet_suspended_ && --wakenet_hold_frames_ <= 0) {
+                esp_afe_sr_v1.disable_wakenet(afe_data_);
+                wakenet_suspended_ = true;
+                ESP_LOGI(TAG, "WakeNet suspended, VAD-only listening");
+            }
+        }
+
+        // 命令词网络的算力预算：外部（说话态）开闸且 VAD 报人声的帧
+        // 才跑第二个网络，静默帧和其他状态一帧算力不花，总负载保持平
+        if (command_enabled_ && speaking) {
+            DetectCommandWord(res->data, res->data_size / sizeof(int16_t));
+        }
+
+        // 短语直通的算力预算：只在聆听态（通话帧）且 VAD 报人声时跑
+        // MultiNet；命中与否都不截上行，只是多一条本地捷径
+        if (shortcuts_enabled_ && speaking && (bits & COMMUNICATION_ENABLED_EVENT)) {
+            DetectShortcut(res->data, res->data_size / sizeof(int16_t));
+        }
+
+        if (bits & DETECTION_ENABLED_EVENT) {
+            if (detection_audio_callback_) {
+                detection_audio_callback_(res->data, res->data_size / sizeof(int16_t));
+            }
+            if (res->wakeup_state == WAKENET_DETECTED && wake_word_detected_callback_) {
+                wake_word_detected_callback_(
+                    wake_words_.empty() ? std::string() : wake_words_[res->wake_word_index - 1]);
+            }
+        }
+
+        if (communication_output_callback_) {
+            // 借用指针直接递出去，不再为每帧拷一个 vector。通话位没开
+            // 时上游照收：非聆听态的帧进预滚环，聆听开始时补发话头
+            communication_output_callback_(res->data, res->data_size / sizeof(int16_t));
+        }
+    }
+}
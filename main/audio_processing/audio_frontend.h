@@ -0,0 +1,153 @@
+#ifndef AUDIO_FRONTEND_H
+#define AUDIO_FRONTEND_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/event_groups.h>
+
+#include <esp_afe_sr_models.h>
+#include <esp_wn_iface.h>
+#include <esp_mn_iface.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "pcm_ring_buffer.h"
+
+// 共享的音频前端：一个 AFE 实例同时伺候唤醒词检测和语音通话。
+// 以前 WakeWordDetect 和 AudioProcessor 各建一个 AFE（esp_afe_sr_v1 /
+// esp_afe_vc_v1），同一路麦克风数据要喂两份、跑两遍前端 DSP，2MB PSRAM
+// 的板子直接放不下。现在只建一个 esp_afe_sr_v1（wakenet + SE + VAD +
+// 有回采参考时 AEC），一个喂入环、一个 fetch 任务，检测和通话按位开关；
+// 通话期间用 disable_wakenet 关掉唤醒网络省 CPU，不销毁重建。
+class AudioFrontend {
+public:
+    static AudioFrontend& GetInstance() {
+        static AudioFrontend instance;
+        return instance;
+    }
+    AudioFrontend(const AudioFrontend&) = delete;
+    AudioFrontend& operator=(const AudioFrontend&) = delete;
+
+    // 幂等：第一次调用创建 AFE（含模型分区扫描，约一秒），之后直接返回
+    void Initialize(int channels, bool reference);
+    void Feed(const std::vector<int16_t>& data);
+    // 任一消费方开着就返回 true，InputAudio 以此决定是否喂数据
+    bool IsRunning();
+
+    void EnableDetection(bool enable);
+    bool IsDetectionEnabled();
+    void EnableCommunication(bool enable);
+    bool IsCommunicationEnabled();
+
+    // 预热模式：两个消费方都关着时 AFE 也继续喂和 fetch，输出直接
+    // 丢掉。内部环（afe_ringbuf_size）始终是满的，EnableCommunication
+    // 之后一个 chunk 周期内就能出第一帧处理好的音频——否则提示音后
+    // 用户开头 100-200ms 的语音要垫环，有被削掉的风险。代价是空闲
+    // 期间前端 DSP 一直在跑
+    void SetPreArmed(bool enable);
+
+    // 电池板低功耗守听（PowerSaveTimer 进出休眠时切换）：真静默时
+    // 停掉 WakeNet 只留 VAD 前级，检到能量立即重挂。VAD 在单个 fetch
+    // 块内就能翻转，而唤醒词本身持续几百毫秒，WakeNet 的滑窗仍然
+    // 来得及吃到整个词
+    void SetLowPowerMode(bool enable);
+
+    // 命令词网络的状态门控：说话态打开，设备端直接识别"停止"类
+    // 命令，不再等服务器转录一圈。模型分区里要有第二个 WakeNet
+    // 模型（命令词模型），没有则这里是空操作
+    void EnableCommandWords(bool enable);
+    bool HasCommandWords() const { return command_model_data_ != nullptr; }
+    // 命令词命中回调，在 fetch 任务上执行，参数是命中的命令词
+    void OnCommandDetected(std::function<void(const std::string& command)> callback);
+
+    // 本地短语直通（MultiNet）的状态门控：聆听态打开，命中
+    // command_shortcuts 表里的短语直接在设备端执行，不等服务器
+    // 转录一圈；表外话音不受影响。模型分区里要有 MultiNet 模型
+    // （mn 前缀），没有则这里是空操作
+    void EnableShortcuts(bool enable);
+    bool HasShortcuts() const { return multinet_data_ != nullptr; }
+    // 短语命中回调，在 fetch 任务上执行，参数是注册时的命令 ID
+    // （command_shortcuts 表下标 + 1）
+    void OnShortcutDetected(std::function<void(int command_id)> callback);
+
+    // 检测命中回调，参数是命中的唤醒词
+    void OnWakeWordDetected(std::function<void(const std::string& wake_word)> callback);
+    // 检测开启期间每个 fetch 帧回调一次，唤醒词滚动缓存用
+    void OnDetectionAudio(std::function<void(const int16_t* data, size_t samples)> callback);
+    // 通话开启期间输出处理后的上行帧。回调拿到的是 AFE fetch 缓冲的
+    // 借用指针，只在回调期间有效：消费方要么就地编码（融合管线），
+    // 要么自己拷走
+    void OnCommunicationOutput(std::function<void(const int16_t* data, size_t samples)> callback);
+    // VAD 状态翻转，可多方订阅
+    void OnVadStateChange(std::function<void(bool speaking)> callback);
+
+    const std::vector<std::string>& wake_words() const { return wake_words_; }
+
+    // 遥测：环境底噪估计与画像落盘状态
+    std::string BuildJson();
+
+private:
+    AudioFrontend();
+
+    esp_afe_sr_data_t* afe_data_ = nullptr;
+    char* wakenet_model_ = nullptr;
+    std::vector<std::string> wake_words_;
+    PcmRingBuffer input_buffer_;
+    EventGroupHandle_t event_group_;
+    int channels_ = 1;
+    bool reference_ = false;
+    bool is_speaking_ = false;
+
+    // 低功耗守听：标志由外部线程翻转，挂起/恢复 WakeNet 的调用
+    // 全部收在 FetchTask 单线程里做，不跟 AFE 抢并发
+    std::atomic<bool> low_power_mode_{false};
+    bool wakenet_suspended_ = false;
+    int wakenet_hold_frames_ = 0;
+
+    // 命令词模型：独立的 esp_wn 句柄跑在 AFE 输出上，不挂进 AFE——
+    // esp_afe 的 enable/disable_wakenet 是全体开关，两个网络分不开；
+    // 自己持句柄才能按状态单独门控，再按 VAD 按帧控算力
+    const esp_wn_iface_t* command_iface_ = nullptr;
+    model_iface_data_t* command_model_data_ = nullptr;
+    std::vector<std::string> command_words_;
+    std::atomic<bool> command_enabled_{false};
+    std::vector<int16_t> command_chunk_;
+    size_t command_chunk_filled_ = 0;
+    std::function<void(const std::string&)> command_detected_callback_;
+
+    // 短语直通模型：MultiNet 跑在 AFE 输出上，短语表在 Initialize
+    // 里按 command_shortcuts::GetTable 注册，只在聆听态按帧喂
+    const esp_mn_iface_t* multinet_iface_ = nullptr;
+    model_iface_data_t* multinet_data_ = nullptr;
+    std::atomic<bool> shortcuts_enabled_{false};
+    std::vector<int16_t> multinet_chunk_;
+    size_t multinet_chunk_filled_ = 0;
+    std::function<void(int)> shortcut_detected_callback_;
+
+    // 环境底噪估计：fetch 任务在非语音帧上维护 EMA（含预热丢帧），
+    // 会话结束时漂移够大才落盘，Initialize 读回后用来预喂 NS 收敛。
+    // esp-sr 不暴露 NS 内部状态，快照/恢复做不了，预喂是能落地的
+    // 最近替代：按存下的电平合成白噪声垫在首批 feed 里，SSP 的初始
+    // 噪声谱从环境量级起步而不是从静音起步
+    float ambient_level_ = 0.0f;
+    uint32_t ambient_frames_ = 0;
+    uint16_t saved_ambient_level_ = 0;
+    bool ambient_primed_ = false;
+
+    std::function<void(const std::string&)> wake_word_detected_callback_;
+    std::function<void(const int16_t*, size_t)> detection_audio_callback_;
+    std::function<void(const int16_t*, size_t)> communication_output_callback_;
+    std::vector<std::function<void(bool)>> vad_state_change_callbacks_;
+
+    void FetchTask();
+    void DetectCommandWord(const int16_t* data, size_t samples);
+    void DetectShortcut(const int16_t* data, size_t samples);
+    void UpdateAmbientLevel(const int16_t* data, size_t samples);
+    void PrimeNoiseEstimator(int feed_chunksize);
+    void MaybeSaveAmbientProfile();
+};
+
+#endif // AUDIO_FRONTEND_H
@@ -1,36 +1,27 @@
 #ifndef AUDIO_PROCESSOR_H
 #define AUDIO_PROCESSOR_H
 
-#include <esp_afe_sr_models.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/task.h>
-#include <freertos/event_groups.h>
-
-#include <string>
 #include <vector>
 #include <functional>
 
+#include "audio_frontend.h"
+
+// 语音通话上行处理，薄封装：AFE 本体在共享的 AudioFrontend 里
+//（和唤醒词检测共用一个实例），这里只转发回调和开关
 class AudioProcessor {
 public:
-    AudioProcessor();
-    ~AudioProcessor();
+    AudioProcessor() = default;
 
     void Initialize(int channels, bool reference);
     void Input(const std::vector<int16_t>& data);
     void Start();
     void Stop();
+    // 预热：Stop 之后 AFE 继续跑但丢输出，下次 Start 一个 chunk 内出帧
+    void PreArm(bool enable);
     bool IsRunning();
-    void OnOutput(std::function<void(std::vector<int16_t>&& data)> callback);
-
-private:
-    EventGroupHandle_t event_group_ = nullptr;
-    esp_afe_sr_data_t* afe_communication_data_ = nullptr;
-    std::vector<int16_t> input_buffer_;
-    std::function<void(std::vector<int16_t>&& data)> output_callback_;
-    int channels_;
-    bool reference_;
-
-    void AudioProcessorTask();
+    void OnOutput(std::function<void(const int16_t* data, size_t samples)> callback);
+    // AEC 之后的 VAD 状态翻转时回调，播报期间用来检测用户插话
+    void OnVadStateChange(std::function<void(bool speaking)> callback);
 };
 
 #endif
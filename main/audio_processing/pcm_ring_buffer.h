@@ -0,0 +1,96 @@
+#ifndef PCM_RING_BUFFER_H
+#define PCM_RING_BUFFER_H
+
+#include <cstdint>
+#include <cstring>
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+
+// 给 AFE feed 路径用的环形 PCM 缓冲
+// Chunk-aligned ring buffer for the AFE feed path. Writes copy the
+// incoming frame once; reads hand out a contiguous chunk pointer with
+// no copy and no shifting, so feeding is O(1) per chunk instead of the
+// O(n) erase-from-front the std::vector path had.
+//
+// The capacity is a power of two when the chunk size allows it and is
+// always a multiple of the chunk size, so a popped chunk never wraps.
+// Single-threaded use only: the pointer returned by PopChunk() stays
+// valid until the next Write() from the same task.
+class PcmRingBuffer {
+public:
+    ~PcmRingBuffer() {
+        if (buffer_ != nullptr) {
+            heap_caps_free(buffer_);
+        }
+    }
+
+    // use_psram 时存储一次性落在 PSRAM，不占内部 SRAM；
+    // AFE feed 本来就是一次拷贝，对 PSRAM 读没有额外代价
+    void Initialize(size_t chunk_size, const char* tag, bool use_psram = false) {
+        tag_ = tag;
+        chunk_size_ = chunk_size;
+        capacity_ = 1;
+        while (capacity_ < chunk_size * 8) {
+            capacity_ <<= 1;
+        }
+        if (capacity_ % chunk_size != 0) {
+            // 非 2 的幂 chunk 时退化为 chunk 对齐容量，读取仍然无拷贝
+            capacity_ = chunk_size * 8;
+        }
+        if (buffer_ != nullptr) {
+            heap_caps_free(buffer_);
+        }
+        buffer_ = (int16_t*)heap_caps_malloc(capacity_ * sizeof(int16_t),
+            use_psram ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL);
+        if (buffer_ == nullptr) {
+            buffer_ = (int16_t*)heap_caps_malloc(capacity_ * sizeof(int16_t), MALLOC_CAP_DEFAULT);
+        }
+        read_pos_ = write_pos_ = size_ = 0;
+    }
+
+    void Write(const int16_t* data, size_t samples) {
+        while (samples > capacity_ - size_) {
+            // 写满了就丢最旧的一个 chunk，音频热路径不能阻塞
+            ESP_LOGW(tag_, "Ring buffer overflow, dropping one chunk");
+            read_pos_ = (read_pos_ + chunk_size_) % capacity_;
+            size_ -= chunk_size_;
+        }
+        size_t first = samples;
+        if (write_pos_ + first > capacity_) {
+            first = capacity_ - write_pos_;
+        }
+        memcpy(&buffer_[write_pos_], data, first * sizeof(int16_t));
+        if (first < samples) {
+            memcpy(&buffer_[0], data + first, (samples - first) * sizeof(int16_t));
+        }
+        write_pos_ = (write_pos_ + samples) % capacity_;
+        size_ += samples;
+    }
+
+    // Returns a contiguous chunk of chunk_size samples, or nullptr if
+    // less than one chunk is buffered.
+    int16_t* PopChunk() {
+        if (size_ < chunk_size_) {
+            return nullptr;
+        }
+        auto chunk = &buffer_[read_pos_];
+        read_pos_ = (read_pos_ + chunk_size_) % capacity_;
+        size_ -= chunk_size_;
+        return chunk;
+    }
+
+    inline size_t size() const { return size_; }
+    inline size_t chunk_size() const { return chunk_size_; }
+
+private:
+    const char* tag_ = "PcmRingBuffer";
+    int16_t* buffer_ = nullptr;
+    size_t capacity_ = 0;
+    size_t chunk_size_ = 0;
+    size_t read_pos_ = 0;
+    size_t write_pos_ = 0;
+    size_t size_ = 0;
+};
+
+#endif // PCM_RING_BUFFER_H
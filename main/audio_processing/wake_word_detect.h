@@ -1,25 +1,23 @@
 #ifndef WAKE_WORD_DETECT_H
 #define WAKE_WORD_DETECT_H
 
-#include <freertos/FreeRTOS.h>
-#include <freertos/task.h>
-#include <freertos/event_groups.h>
-
-#include <esp_afe_sr_models.h>
-#include <esp_nsn_models.h>
-
 #include <list>
+#include <memory>
 #include <string>
 #include <vector>
 #include <functional>
 #include <mutex>
-#include <condition_variable>
 
+#include <opus_encoder.h>
+
+#include "opus_profiler.h"
+#include "audio_frontend.h"
 
+// 唤醒词检测，薄封装：AFE 本体在共享的 AudioFrontend 里（和语音通话
+// 共用一个实例），这里只管唤醒命中后的滚动 Opus 缓存和回调转发
 class WakeWordDetect {
 public:
-    WakeWordDetect();
-    ~WakeWordDetect();
+    WakeWordDetect() = default;
 
     void Initialize(int channels, bool reference);
     void Feed(const std::vector<int16_t>& data);
@@ -28,33 +26,21 @@ public:
     void StartDetection();
     void StopDetection();
     bool IsDetectionRunning();
-    void EncodeWakeWordData();
-    bool GetWakeWordOpus(std::vector<uint8_t>& opus);
+    // 一次取走整个滚动窗口的预编码包。包在检测期间就已压好，上传方
+    // 整批拿走即可，不再有逐包的条件变量握手
+    std::list<std::vector<uint8_t>> TakeWakeWordData();
     const std::string& GetLastDetectedWakeWord() const { return last_detected_wake_word_; }
 
 private:
-    esp_afe_sr_data_t* afe_detection_data_ = nullptr;
-    char* wakenet_model_ = NULL;
-    std::vector<std::string> wake_words_;
-    std::vector<int16_t> input_buffer_;
-    EventGroupHandle_t event_group_;
     std::function<void(const std::string& wake_word)> wake_word_detected_callback_;
-    std::function<void(bool speaking)> vad_state_change_callback_;
-    bool is_speaking_ = false;
-    int channels_;
-    bool reference_;
     std::string last_detected_wake_word_;
 
-    TaskHandle_t wake_word_encode_task_ = nullptr;
-    StaticTask_t wake_word_encode_task_buffer_;
-    StackType_t* wake_word_encode_task_stack_ = nullptr;
-    std::list<std::vector<int16_t>> wake_word_pcm_;
-    std::list<std::vector<uint8_t>> wake_word_opus_;
+    // 检测运行期间就用低复杂度编码器持续压缩，命中时最近 ~2 秒已是 Opus 包
+    std::unique_ptr<ProfiledOpusEncoder> wake_word_encoder_;
+    std::list<std::vector<uint8_t>> wake_word_encoded_;
     std::mutex wake_word_mutex_;
-    std::condition_variable wake_word_cv_;
 
-    void StoreWakeWordData(uint16_t* data, size_t size);
-    void AudioDetectionTask();
+    void StoreWakeWordData(const int16_t* data, size_t samples);
 };
 
 #endif
@@ -1,63 +1,163 @@
 #include "background_task.h"
+#include "task_telemetry.h"
+#include "long_task_detector.h"
 
-#include <esp_log.h>
 #include <esp_task_wdt.h>
+#include <esp_timer.h>
+#include <chrono>
 
 #define TAG "BackgroundTask"
 
+// 遥测注册要求常驻字符串，任务名也直接用它
+static const char* kWorkerNames[] = { "background_0", "background_1" };
+
 BackgroundTask::BackgroundTask(uint32_t stack_size) {
-    xTaskCreate([](void* arg) {
-        BackgroundTask* task = (BackgroundTask*)arg;
-        task->BackgroundTaskLoop();
-    }, "background_task", stack_size, this, 2, &background_task_handle_);
+    for (int i = 0; i < kWorkerCount; i++) {
+        xTaskCreate([](void* arg) {
+            BackgroundTask* task = (BackgroundTask*)arg;
+            task->WorkerLoop();
+        }, kWorkerNames[i], stack_size, this, 2, &worker_handles_[i]);
+        TaskTelemetry::GetInstance().RegisterTask(kWorkerNames[i], worker_handles_[i], stack_size);
+    }
+    TaskTelemetry::GetInstance().RegisterQueue("bg_lanes", [this]() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lane_count_[0] + lane_count_[1] + lane_count_[2];
+    }, kLaneDepth[0] + kLaneDepth[1] + kLaneDepth[2]);
+    // 队列年龄搭深度采样的便车上报：峰值即排队最久的等待毫秒数，
+    // "容量"取状态切换能容忍的排空预算当基准线
+    TaskTelemetry::GetInstance().RegisterQueue("bg_wait_ms", [this]() {
+        return (size_t)(GetQueueStats().oldest_wait_us / 1000);
+    }, 500);
 }
 
 BackgroundTask::~BackgroundTask() {
-    if (background_task_handle_ != nullptr) {
-        vTaskDelete(background_task_handle_);
+    for (int i = 0; i < kWorkerCount; i++) {
+        if (worker_handles_[i] != nullptr) {
+            vTaskDelete(worker_handles_[i]);
+        }
     }
 }
 
-void BackgroundTask::Schedule(std::function<void()> callback) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (active_tasks_ >= 30) {
-        int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
-        if (free_sram < 10000) {
-            ESP_LOGW(TAG, "active_tasks_ == %u, free_sram == %u", active_tasks_.load(), free_sram);
+bool BackgroundTask::WaitForCompletion(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto drained = [this]() {
+        for (int lane = 0; lane < kLaneCount; lane++) {
+            if (lane_count_[lane] > 0) {
+                return false;
+            }
         }
+        return active_tasks_ == 0;
+    };
+    if (timeout_ms < 0) {
+        all_done_.wait(lock, drained);
+        return true;
     }
-    active_tasks_++;
-    main_tasks_.emplace_back([this, cb = std::move(callback)]() {
-        cb();
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            active_tasks_--;
-            if (main_tasks_.empty() && active_tasks_ == 0) {
-                condition_variable_.notify_all();
-            }
+    if (all_done_.wait_for(lock, std::chrono::milliseconds(timeout_ms), drained)) {
+        return true;
+    }
+    // 截止期已到：音频车道里排队未跑的闭包是可放弃的旧活，原地撤销
+    // 省掉执行时间；普通/批量车道的闭包不可弃（显示、IoT 命令），
+    // 继续等——此时剩下的只有在飞的和不可弃的，不再被旧音频垫着
+    size_t revoked = FlushLaneLocked(kLaneAudio);
+    if (revoked > 0) {
+        audio_revoked_ += revoked;
+        ESP_LOGW(TAG, "Drain deadline (%d ms) hit, revoked %u queued audio tasks (total %lu)",
+            timeout_ms, (unsigned)revoked, audio_revoked_);
+    }
+    all_done_.wait(lock, drained);
+    return false;
+}
+
+void BackgroundTask::FlushLane(Lane lane) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FlushLaneLocked(lane);
+}
+
+size_t BackgroundTask::FlushLaneLocked(Lane lane) {
+    size_t n = lane_count_[lane];
+    for (size_t i = 0; i < n; i++) {
+        lane_items_[lane][(lane_head_[lane] + i) % kLaneDepth[lane]].Discard();
+    }
+    lane_head_[lane] = (lane_head_[lane] + n) % kLaneDepth[lane];
+    lane_count_[lane] = 0;
+    if (n > 0) {
+        active_tasks_ -= n;
+        space_available_.notify_all();
+        if (active_tasks_ == 0) {
+            all_done_.notify_all();
         }
-    });
-    condition_variable_.notify_all();
+    }
+    return n;
 }
 
-void BackgroundTask::WaitForCompletion() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    condition_variable_.wait(lock, [this]() {
-        return main_tasks_.empty() && active_tasks_ == 0;
-    });
+BackgroundTask::QueueStats BackgroundTask::GetQueueStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    QueueStats stats;
+    int64_t now_us = esp_timer_get_time();
+    for (int lane = 0; lane < kLaneCount; lane++) {
+        stats.queued += lane_count_[lane];
+        if (lane_count_[lane] > 0) {
+            // 每条车道队头就是本车道排队最久的
+            int64_t wait_us = now_us - lane_items_[lane][lane_head_[lane]].enqueue_us;
+            if (wait_us > stats.oldest_wait_us) {
+                stats.oldest_wait_us = wait_us;
+            }
+        }
+    }
+    stats.inflight = active_tasks_ - stats.queued;
+    return stats;
 }
 
-void BackgroundTask::BackgroundTaskLoop() {
-    ESP_LOGI(TAG, "background_task started");
+void BackgroundTask::WorkerLoop() {
+    ESP_LOGI(TAG, "background worker started (%d workers, %d lanes)", kWorkerCount, kLaneCount);
+    // 订阅任务看门狗：超预算的闭包只是记账，真正卡死的会带着工人名
+    // 触发 TWDT 转储。TWDT 没初始化时 add 失败，静默退回只做计时
+    bool wdt_subscribed = esp_task_wdt_add(nullptr) == ESP_OK;
+    auto has_work = [this]() {
+        for (int lane = 0; lane < kLaneCount; lane++) {
+            if (lane_count_[lane] > 0) {
+                return true;
+            }
+        }
+        return false;
+    };
     while (true) {
         std::unique_lock<std::mutex> lock(mutex_);
-        condition_variable_.wait(lock, [this]() { return !main_tasks_.empty(); });
-        
-        std::list<std::function<void()>> tasks = std::move(main_tasks_);
+        // 等待带超时：空闲挂着的工人也要按时喂狗
+        while (!has_work()) {
+            work_available_.wait_for(lock, std::chrono::seconds(1));
+            if (wdt_subscribed) {
+                esp_task_wdt_reset();
+            }
+        }
+
+        // 总是先清优先级高的车道，批量活永远排在音频后面
+        TaskRef task = {};
+        for (int lane = 0; lane < kLaneCount; lane++) {
+            if (lane_count_[lane] > 0) {
+                task = lane_items_[lane][lane_head_[lane]];
+                lane_head_[lane] = (lane_head_[lane] + 1) % kLaneDepth[lane];
+                lane_count_[lane]--;
+                break;
+            }
+        }
+        space_available_.notify_all();
         lock.unlock();
 
-        for (auto& task : tasks) {
-            task();
+        int64_t start_us = esp_timer_get_time();
+        task.Run();
+        // tag 按值存在 TaskRef 里，Run 归还槽位后仍然可读
+        LongTaskDetector::GetInstance().Record(task.tag, esp_timer_get_time() - start_us);
+        if (wdt_subscribed) {
+            esp_task_wdt_reset();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            active_tasks_--;
+            if (active_tasks_ == 0) {
+                all_done_.notify_all();
+            }
         }
     }
 }
@@ -1,29 +1,113 @@
 #ifndef BACKGROUND_TASK_H
 #define BACKGROUND_TASK_H
 
+#include "task_slot.h"
+
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
 #include <mutex>
-#include <list>
+#include <functional>
 #include <condition_variable>
 #include <atomic>
 
+// 带优先级车道的小型工作池。单线程版本里一个慢的显示/IoT 闭包会把
+// 音频工作压在后面，这里按紧急程度分三条车道，工人总是先清高优先级：
+//   kLaneAudio  — 音频相关工作，队满直接丢新任务（过期音频不如低延迟）
+//   kLaneNormal — 默认车道，队满时 Schedule 阻塞等空位（背压）
+//   kLaneBulk   — 大块慢活（日志上传、预热等），同样背压
+// 双核 S3 上起两个工人并行消费，单核目标退回一个。
+// 闭包经由 TaskSlotRing 就地存进预分配槽位，车道本身是定长环形缓冲，
+// 一次 Schedule 通常零堆分配。
 class BackgroundTask {
 public:
+    enum Lane {
+        kLaneAudio = 0,
+        kLaneNormal,
+        kLaneBulk,
+        kLaneCount,
+    };
+
     BackgroundTask(uint32_t stack_size = 4096 * 2);
     ~BackgroundTask();
 
-    void Schedule(std::function<void()> callback);
-    void WaitForCompletion();
+    // 返回 false 表示按溢出策略丢弃了任务（只有 kLaneAudio 会这样）。
+    // tag 是常驻字面量，超预算的闭包在长任务遥测里按它记账
+    template <typename F>
+    bool Schedule(F&& callback, Lane lane = kLaneNormal, const char* tag = nullptr) {
+        TaskRef task = slot_ring_.Acquire(std::forward<F>(callback));
+        task.tag = tag;
+        task.enqueue_us = esp_timer_get_time();
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (lane_count_[lane] >= kLaneDepth[lane]) {
+            if (lane == kLaneAudio) {
+                // 音频车道满说明已经追不上实时，丢新任务保住延迟
+                if (++audio_drops_ % 100 == 1) {
+                    ESP_LOGW("BackgroundTask", "Audio lane full, dropped %lu tasks so far", audio_drops_);
+                }
+                lock.unlock();
+                task.Discard();
+                return false;
+            }
+            // 普通/批量车道用背压：等出空位再入队，调用方感知到变慢
+            space_available_.wait(lock, [this, lane]() {
+                return lane_count_[lane] < kLaneDepth[lane];
+            });
+        }
+        lane_items_[lane][(lane_head_[lane] + lane_count_[lane]) % kLaneDepth[lane]] = task;
+        lane_count_[lane]++;
+        active_tasks_++;
+        work_available_.notify_one();
+        return true;
+    }
+
+    // 排空队列。timeout_ms < 0 保持老语义无限等；带截止期时，超期
+    // 后撤销还在排队的音频闭包（该车道本来就允许溢出丢弃，打断后的
+    // 过期解码/显示帧执行完也是白跑），然后只等不可弃的活收尾。
+    // 返回 false 表示截止期被击穿（排空最终仍会完成）
+    bool WaitForCompletion(int timeout_ms = -1);
+    // 优先撤销：把一条车道里排队未跑的闭包原地析构，不执行。
+    // 打断（AbortSpeaking）用它立刻清掉过期的音频工作
+    void FlushLane(Lane lane);
+
+    // 队列巡检快照：排队深度、在飞数量和排队最久的等待时长，
+    // 卡顿归因和遥测用
+    struct QueueStats {
+        size_t queued = 0;
+        size_t inflight = 0;
+        int64_t oldest_wait_us = 0;
+    };
+    QueueStats GetQueueStats();
+
+    uint32_t heap_fallbacks() const { return slot_ring_.heap_fallbacks(); }
 
 private:
+    // 每条车道的深度上限：音频要浅（旧帧没价值），批量活最浅（慢）
+    static constexpr size_t kLaneDepth[kLaneCount] = { 16, 32, 8 };
+    static constexpr size_t kMaxLaneDepth = 32;
+#if CONFIG_IDF_TARGET_ESP32S3
+    static constexpr int kWorkerCount = 2;
+#else
+    static constexpr int kWorkerCount = 1;
+#endif
+
     std::mutex mutex_;
-    std::list<std::function<void()>> main_tasks_;
-    std::condition_variable condition_variable_;
-    TaskHandle_t background_task_handle_ = nullptr;
+    TaskRef lane_items_[kLaneCount][kMaxLaneDepth] = {};
+    size_t lane_head_[kLaneCount] = {};
+    size_t lane_count_[kLaneCount] = {};
+    TaskSlotRing slot_ring_{kLaneDepth[0] + kLaneDepth[1] + kLaneDepth[2]};
+    std::condition_variable work_available_;
+    std::condition_variable space_available_;
+    std::condition_variable all_done_;
+    TaskHandle_t worker_handles_[kWorkerCount] = {};
     std::atomic<size_t> active_tasks_{0};
+    uint32_t audio_drops_ = 0;
+    uint32_t audio_revoked_ = 0;
 
-    void BackgroundTaskLoop();
+    void WorkerLoop();
+    // 调用方持锁；返回撤销的任务数
+    size_t FlushLaneLocked(Lane lane);
 };
 
 #endif
@@ -0,0 +1,49 @@
+#ifndef BOARD_CAPS_H
+#define BOARD_CAPS_H
+
+#include "config.h"
+
+// 板级能力矩阵（编译期）
+// Application::Start 里的 GetBoardType() 字符串比较和散落的运行期
+// 能力查询，查的其实都是 config.h 在编译期就定死的事实。这里把
+// 它们收拢成一组 constexpr：if constexpr 分支在不具备该能力的板子
+// 上整段折叠，既省启动工作也省二进制。布线推不出来的能力由板级
+// config.h 声明（BOARD_HAS_CELLULAR），缺省按 WiFi 板
+#ifndef BOARD_HAS_CELLULAR
+#define BOARD_HAS_CELLULAR 0
+#endif
+#ifndef AUDIO_INPUT_REFERENCE
+#define AUDIO_INPUT_REFERENCE false
+#endif
+#ifndef AUDIO_OUTPUT_PROFILE
+#define AUDIO_OUTPUT_PROFILE 0
+#endif
+
+namespace board_caps {
+
+// ML307 蜂窝板：计费流量、更紧的带宽预算
+inline constexpr bool kHasCellular = BOARD_HAS_CELLULAR;
+// 有回采参考通道才有 AEC/barge-in（与 kBoardInputChannels 同源）
+inline constexpr bool kHasAecReference = AUDIO_INPUT_REFERENCE;
+// 采集/播放域与 16k 会话域之间是否需要重采样
+inline constexpr bool kNeedsInputResample = AUDIO_INPUT_SAMPLE_RATE != 16000;
+// 输出率是 Opus 解码器的原生档位（解码本身率无关，可直接按输出率
+// 出样本）时，播放路径的后级重采样整段编译剔除——esp-box 这类
+// 16k 原生的板子省掉播放路径上最大的可选 DSP 级。非原生率
+//（如 44.1k）的板子保持运行期重采样
+inline constexpr bool kOutputRateOpusNative =
+    AUDIO_OUTPUT_SAMPLE_RATE == 8000 || AUDIO_OUTPUT_SAMPLE_RATE == 12000 ||
+    AUDIO_OUTPUT_SAMPLE_RATE == 16000 || AUDIO_OUTPUT_SAMPLE_RATE == 24000 ||
+    AUDIO_OUTPUT_SAMPLE_RATE == 48000;
+// 板级声学档案：config.h 给出实测的 EQ/限幅表（AUDIO_OUTPUT_EQ_SECTIONS
+// 等，见 output_shaper.h）时置 1，OutputData 里的整形级才链接进来
+inline constexpr bool kHasOutputProfile = AUDIO_OUTPUT_PROFILE;
+
+// 编码复杂度起点。蜂窝板和 WiFi 板如今同档：复杂度闭环会在编码
+// 耗时逼近帧预算时自动降档（见 NoteEncodeTime），空闲设备白拿
+// 更好的音质，不再按板型给保守的静态值
+inline constexpr int kDefaultOpusComplexity = 5;
+
+}  // namespace board_caps
+
+#endif  // BOARD_CAPS_H
@@ -0,0 +1,4 @@
+# 本板编译清单（见 main/CMakeLists.txt 的板级清单说明）。
+# 面包板没有底盘/电池/背光，对应 Thing 和驱动不编入固件
+set(BOARD_THINGS speaker lamp capture_meter)
+set(BOARD_COMMON_DRIVERS wifi_board system_reset)
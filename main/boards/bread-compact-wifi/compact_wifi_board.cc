@@ -3,6 +3,7 @@
 #include "display/oled_display.h"
 #include "system_reset.h"
 #include "application.h"
+#include "audio_loopback_test.h"
 #include "button.h"
 #include "config.h"
 #include "iot/thing_manager.h"
@@ -103,6 +104,10 @@ private:
             }
             app.ToggleChatState();
         });
+        // 产线/维修自检入口：空闲态双击跑声学环回，结果进遥测
+        boot_button_.OnDoubleClick([this]() {
+            AudioLoopbackTest::GetInstance().Start();
+        });
         touch_button_.OnPressDown([this]() {
             Application::GetInstance().StartListening();
         });
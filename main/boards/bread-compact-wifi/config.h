@@ -6,6 +6,18 @@
 #define AUDIO_INPUT_SAMPLE_RATE  16000
 #define AUDIO_OUTPUT_SAMPLE_RATE 24000
 
+// 裸喇叭的声学档案（见 output_shaper.h）：150Hz 以下小喇叭根本
+// 发不出来，白吃冲程还带着削波，二阶高通切掉；2.8kHz 给 2.5dB
+// 的清晰度补偿。系数按 24kHz 输出率算的 Q13 双二阶
+#define AUDIO_OUTPUT_PROFILE 1
+#define AUDIO_OUTPUT_EQ_SECTIONS                 \
+    {                                            \
+        {7968, -15935, 7968, -15929, 7749},      \
+        {8806, -9441, 3898, -9441, 4512},        \
+    }
+// 限幅天花板 -1 dBFS：大音量下 EQ 提升不再顶上削波
+#define AUDIO_OUTPUT_LIMITER_CEILING 29000
+
 // 如果使用 Duplex I2S 模式，请注释下面一行
 #define AUDIO_I2S_METHOD_SIMPLEX
 
@@ -49,4 +61,7 @@
 #define DISPLAY_MIRROR_X true
 #define DISPLAY_MIRROR_Y true
 
+// WiFi 板不计流量，OTA 开两条分段连接换下载吞吐（见 ota.cc）
+#define OTA_PARALLEL_CONNECTIONS 2
+
 #endif // _BOARD_CONFIG_H_
@@ -6,11 +6,41 @@
 
 #define TAG "Axp2101"
 
+// 电池状态变化以秒计，慢速刷新足够
+#define TELEMETRY_REFRESH_INTERVAL_MS 5000
+
 Axp2101::Axp2101(i2c_master_bus_handle_t i2c_bus, uint8_t addr) : I2cDevice(i2c_bus, addr) {
+    // 上电先读一次，定时器第一次到点前查询也有有效值
+    RefreshTelemetry();
+
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void* arg) {
+            auto self = static_cast<Axp2101*>(arg);
+            self->RefreshTelemetry();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "axp2101_poll",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &telemetry_timer_));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(telemetry_timer_, TELEMETRY_REFRESH_INTERVAL_MS * 1000));
+}
+
+Axp2101::~Axp2101() {
+    if (telemetry_timer_ != nullptr) {
+        esp_timer_stop(telemetry_timer_);
+        esp_timer_delete(telemetry_timer_);
+    }
+}
+
+void Axp2101::RefreshTelemetry() {
+    status_reg_ = ReadReg(0x01);
+    battery_level_ = ReadReg(0xA4);
 }
 
 int Axp2101::GetBatteryCurrentDirection() {
-    return (ReadReg(0x01) & 0b01100000) >> 5;
+    return (status_reg_ & 0b01100000) >> 5;
 }
 
 bool Axp2101::IsCharging() {
@@ -22,12 +52,11 @@ bool Axp2101::IsDischarging() {
 }
 
 bool Axp2101::IsChargingDone() {
-    uint8_t value = ReadReg(0x01);
-    return (value & 0b00000111) == 0b00000100;
+    return (status_reg_ & 0b00000111) == 0b00000100;
 }
 
 int Axp2101::GetBatteryLevel() {
-    return ReadReg(0xA4);
+    return battery_level_;
 }
 
 void Axp2101::PowerOff() {
@@ -3,9 +3,12 @@
 
 #include "i2c_device.h"
 
+#include <esp_timer.h>
+
 class Axp2101 : public I2cDevice {
 public:
     Axp2101(i2c_master_bus_handle_t i2c_bus, uint8_t addr);
+    ~Axp2101();
     bool IsCharging();
     bool IsDischarging();
     bool IsChargingDone();
@@ -14,6 +17,13 @@ public:
 
 private:
     int GetBatteryCurrentDirection();
+    void RefreshTelemetry();
+
+    // 遥测缓存：后台定时器慢速刷新状态和电量寄存器，所有查询
+    // 直接读 RAM——IoT 状态序列化和显示刷新不再阻塞在 PMIC 总线上
+    esp_timer_handle_t telemetry_timer_ = nullptr;
+    volatile uint8_t status_reg_ = 0;
+    volatile uint8_t battery_level_ = 0;
 };
 
 #endif
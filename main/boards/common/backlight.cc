@@ -1,5 +1,7 @@
 #include "backlight.h"
 #include "settings.h"
+#include "board.h"
+#include "display.h"
 
 #include <esp_log.h>
 #include <driver/ledc.h>
@@ -49,6 +51,12 @@ void Backlight::SetBrightness(uint8_t brightness, bool permanent) {
         settings.SetInt("brightness", brightness);
     }
 
+    // 先把渲染捡回来再做亮度渐变，点亮瞬间就有新帧可看
+    if (render_suspended_ && brightness > 0) {
+        Board::GetInstance().GetDisplay()->SetRenderSuspended(false);
+        render_suspended_ = false;
+    }
+
     target_brightness_ = brightness;
     step_ = (target_brightness_ > brightness_) ? 1 : -1;
 
@@ -70,6 +78,11 @@ void Backlight::OnTransitionTimer() {
 
     if (brightness_ == target_brightness_) {
         esp_timer_stop(transition_timer_);
+        // 渐变到灭屏才停渲染，渐变过程本身还要出帧
+        if (brightness_ == 0 && !render_suspended_) {
+            Board::GetInstance().GetDisplay()->SetRenderSuspended(true);
+            render_suspended_ = true;
+        }
     }
 }
 
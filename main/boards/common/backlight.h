@@ -24,6 +24,9 @@ protected:
     uint8_t brightness_ = 0;
     uint8_t target_brightness_ = 0;
     uint8_t step_ = 1;
+    // 已因灭屏停掉渲染；只在运行期真正停过之后才会去恢复，
+    // 避免开机首次点亮时在板子构造中途回调 Board::GetInstance
+    bool render_suspended_ = false;
 };
 
 
@@ -1,6 +1,7 @@
 #include "board.h"
 #include "system_info.h"
 #include "settings.h"
+#include "boot_profiler.h"
 #include "display/display.h"
 #include "assets/lang_config.h"
 
@@ -12,6 +13,7 @@
 #define TAG "Board"
 
 Board::Board() {
+    boot_profiler::Scope scope("board_ctor");
     Settings settings("board", true);
     uuid_ = settings.GetString("uuid");
     if (uuid_.empty()) {
@@ -98,60 +100,73 @@ std::string Board::GetJson() {
             }
         }
     */
-    std::string json = "{";
-    json += "\"version\":2,";
-    json += "\"language\":\"" + std::string(Lang::CODE) + "\",";
-    json += "\"flash_size\":" + std::to_string(SystemInfo::GetFlashSize()) + ",";
-    json += "\"minimum_free_heap_size\":" + std::to_string(SystemInfo::GetMinimumFreeHeapSize()) + ",";
-    json += "\"mac_address\":\"" + SystemInfo::GetMacAddress() + "\",";
-    json += "\"uuid\":\"" + uuid_ + "\",";
-    json += "\"chip_model_name\":\"" + SystemInfo::GetChipModelName() + "\",";
-    json += "\"chip_info\":{";
-
-    esp_chip_info_t chip_info;
-    esp_chip_info(&chip_info);
-    json += "\"model\":" + std::to_string(chip_info.model) + ",";
-    json += "\"cores\":" + std::to_string(chip_info.cores) + ",";
-    json += "\"revision\":" + std::to_string(chip_info.revision) + ",";
-    json += "\"features\":" + std::to_string(chip_info.features);
-    json += "},";
-
-    json += "\"application\":{";
-    auto app_desc = esp_app_get_description();
-    json += "\"name\":\"" + std::string(app_desc->project_name) + "\",";
-    json += "\"version\":\"" + std::string(app_desc->version) + "\",";
-    json += "\"compile_time\":\"" + std::string(app_desc->date) + "T" + std::string(app_desc->time) + "Z\",";
-    json += "\"idf_version\":\"" + std::string(app_desc->idf_ver) + "\",";
-
-    char sha256_str[65];
-    for (int i = 0; i < 32; i++) {
-        snprintf(sha256_str + i * 2, sizeof(sha256_str) - i * 2, "%02x", app_desc->app_elf_sha256[i]);
-    }
-    json += "\"elf_sha256\":\"" + std::string(sha256_str) + "\"";
-    json += "},";
-
-    json += "\"partition_table\": [";
-    esp_partition_iterator_t it = esp_partition_find(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, NULL);
-    while (it) {
-        const esp_partition_t *partition = esp_partition_get(it);
-        json += "{";
-        json += "\"label\":\"" + std::string(partition->label) + "\",";
-        json += "\"type\":" + std::to_string(partition->type) + ",";
-        json += "\"subtype\":" + std::to_string(partition->subtype) + ",";
-        json += "\"address\":" + std::to_string(partition->address) + ",";
-        json += "\"size\":" + std::to_string(partition->size);
+    // 静态前缀（flash/MAC/芯片/分区表/应用信息）开机后不会变，第一次
+    // 组好缓存起来。OTA 服务器不可达时 CheckNewVersion 每 60 秒重试
+    // 一次，之前每次都重走分区表迭代和整段字符串拼接，白烧 CPU 和堆
+    if (static_json_.empty()) {
+        std::string json = "{";
+        json += "\"version\":2,";
+        json += "\"language\":\"" + std::string(Lang::CODE) + "\",";
+        json += "\"flash_size\":" + std::to_string(SystemInfo::GetFlashSize()) + ",";
+        json += "\"mac_address\":\"" + SystemInfo::GetMacAddress() + "\",";
+        json += "\"uuid\":\"" + uuid_ + "\",";
+        json += "\"chip_model_name\":\"" + SystemInfo::GetChipModelName() + "\",";
+        json += "\"chip_info\":{";
+
+        esp_chip_info_t chip_info;
+        esp_chip_info(&chip_info);
+        json += "\"model\":" + std::to_string(chip_info.model) + ",";
+        json += "\"cores\":" + std::to_string(chip_info.cores) + ",";
+        json += "\"revision\":" + std::to_string(chip_info.revision) + ",";
+        json += "\"features\":" + std::to_string(chip_info.features);
         json += "},";
-        it = esp_partition_next(it);
-    }
-    json.pop_back(); // Remove the last comma
-    json += "],";
 
-    json += "\"ota\":{";
-    auto ota_partition = esp_ota_get_running_partition();
-    json += "\"label\":\"" + std::string(ota_partition->label) + "\"";
-    json += "},";
+        json += "\"application\":{";
+        auto app_desc = esp_app_get_description();
+        json += "\"name\":\"" + std::string(app_desc->project_name) + "\",";
+        json += "\"version\":\"" + std::string(app_desc->version) + "\",";
+        json += "\"compile_time\":\"" + std::string(app_desc->date) + "T" + std::string(app_desc->time) + "Z\",";
+        json += "\"idf_version\":\"" + std::string(app_desc->idf_ver) + "\",";
+
+        char sha256_str[65];
+        for (int i = 0; i < 32; i++) {
+            snprintf(sha256_str + i * 2, sizeof(sha256_str) - i * 2, "%02x", app_desc->app_elf_sha256[i]);
+        }
+        json += "\"elf_sha256\":\"" + std::string(sha256_str) + "\"";
+        json += "},";
+
+        json += "\"partition_table\": [";
+        esp_partition_iterator_t it = esp_partition_find(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, NULL);
+        while (it) {
+            const esp_partition_t *partition = esp_partition_get(it);
+            json += "{";
+            json += "\"label\":\"" + std::string(partition->label) + "\",";
+            json += "\"type\":" + std::to_string(partition->type) + ",";
+            json += "\"subtype\":" + std::to_string(partition->subtype) + ",";
+            json += "\"address\":" + std::to_string(partition->address) + ",";
+            json += "\"size\":" + std::to_string(partition->size);
+            json += "},";
+            it = esp_partition_next(it);
+        }
+        json.pop_back(); // Remove the last comma
+        json += "],";
+
+        json += "\"ota\":{";
+        auto ota_partition = esp_ota_get_running_partition();
+        json += "\"label\":\"" + std::string(ota_partition->label) + "\"";
+        json += "},";
 
-    json += "\"board\":" + GetBoardJson();
+        static_json_ = std::move(json);
+    }
+
+    // 动态字段（堆水位、板级状态里的电量/信号）每次现取，预留容量
+    // 一次拼完
+    std::string board_json = GetBoardJson();
+    std::string json;
+    json.reserve(static_json_.size() + board_json.size() + 64);
+    json += static_json_;
+    json += "\"minimum_free_heap_size\":" + std::to_string(SystemInfo::GetMinimumFreeHeapSize()) + ",";
+    json += "\"board\":" + board_json;
 
     // Close the JSON object
     json += "}";
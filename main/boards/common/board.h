@@ -25,6 +25,9 @@ protected:
 
     // 软件生成的设备唯一标识
     std::string uuid_;
+    // GetJson 的静态前缀缓存（芯片/分区表/应用信息），第一次组好后
+    // OTA 重试循环每次只补动态字段
+    std::string static_json_;
 
 public:
     static Board& GetInstance() {
@@ -0,0 +1,54 @@
+#include "board_init_stages.h"
+#include "boot_profiler.h"
+
+#include <freertos/task.h>
+#include <esp_log.h>
+
+#define TAG "BoardInitStages"
+
+namespace {
+
+struct StageContext {
+    const char* name;
+    std::function<void()> fn;
+    SemaphoreHandle_t done_semaphore;
+};
+
+}  // namespace
+
+BoardInitStages::~BoardInitStages() {
+    Wait();
+    if (done_semaphore_ != nullptr) {
+        vSemaphoreDelete(done_semaphore_);
+    }
+}
+
+void BoardInitStages::Run(const char* name, std::function<void()> fn) {
+    if (done_semaphore_ == nullptr) {
+        done_semaphore_ = xSemaphoreCreateCounting(16, 0);
+    }
+    auto* ctx = new StageContext{ name, std::move(fn), done_semaphore_ };
+    // 外设初始化调 ESP_ERROR_CHECK 链很深，栈给足
+    xTaskCreate([](void* arg) {
+        auto* ctx = static_cast<StageContext*>(arg);
+        boot_profiler::Begin(ctx->name);
+        ctx->fn();
+        boot_profiler::End(ctx->name);
+        xSemaphoreGive(ctx->done_semaphore);
+        delete ctx;
+        vTaskDelete(NULL);
+    }, name, 4096, ctx, 2, nullptr);
+    pending_++;
+}
+
+void BoardInitStages::RunInline(const char* name, std::function<void()> fn) {
+    boot_profiler::Scope scope(name);
+    fn();
+}
+
+void BoardInitStages::Wait() {
+    while (pending_ > 0) {
+        xSemaphoreTake(done_semaphore_, portMAX_DELAY);
+        pending_--;
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef BOARD_INIT_STAGES_H
+#define BOARD_INIT_STAGES_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <functional>
+
+// 板级并行初始化：互不依赖的 bring-up 阶段各自丢到工作任务上跑
+//（不钉核，调度器自己摊到两个核），Wait 汇合后再跑有依赖的阶段。
+// 显示 SPI、编解码器 I2C 配置这类阶段彼此独立却一直串行排队，
+// 并行后构造函数的关键路径只剩最长的那个阶段。每个阶段自动带
+// boot_profiler 打点，Report 里能看到它们的起止交错。
+//
+// 用法：Run 声明可并行的阶段，Wait 等它们全部结束（即声明依赖），
+// 之后依赖前序结果的阶段用 RunInline 在当前任务上跑。
+class BoardInitStages {
+public:
+    ~BoardInitStages();
+
+    // 把一个阶段丢到工作任务上并行跑
+    void Run(const char* name, std::function<void()> fn);
+    // 在当前任务上同步跑一个阶段（仍打点），用于有依赖的收尾步骤
+    void RunInline(const char* name, std::function<void()> fn);
+    // 等所有 Run 出去的阶段结束；可多次调用，形成"并行一批、
+    // 汇合、再并行一批"的分层依赖
+    void Wait();
+
+private:
+    SemaphoreHandle_t done_semaphore_ = nullptr;
+    int pending_ = 0;
+};
+
+#endif // BOARD_INIT_STAGES_H
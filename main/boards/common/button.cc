@@ -1,8 +1,15 @@
 #include "button.h"
+#include "application.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_attr.h>
 
 static const char* TAG = "Button";
+
+// 机械抖动的成簇窗口：第一个边沿立即放行，窗口内的反跳全部丢弃，
+// 所以消抖不增加按下的响应延迟
+#define BUTTON_DEBOUNCE_US 30000
 #if CONFIG_SOC_ADC_SUPPORTED
 Button::Button(const button_adc_config_t& adc_cfg) {
     button_config_t button_config = {
@@ -19,7 +26,8 @@ Button::Button(const button_adc_config_t& adc_cfg) {
 }
 #endif
 
-Button::Button(gpio_num_t gpio_num, bool active_high) : gpio_num_(gpio_num) {
+Button::Button(gpio_num_t gpio_num, bool active_high)
+    : gpio_num_(gpio_num), active_high_(active_high) {
     if (gpio_num == GPIO_NUM_NC) {
         return;
     }
@@ -40,16 +48,76 @@ Button::Button(gpio_num_t gpio_num, bool active_high) : gpio_num_(gpio_num) {
 }
 
 Button::~Button() {
+    if (fast_path_) {
+        gpio_isr_handler_remove(gpio_num_);
+    }
     if (button_handle_ != NULL) {
         iot_button_delete(button_handle_);
     }
 }
 
+void IRAM_ATTR Button::IsrHandler(void* arg) {
+    static_cast<Button*>(arg)->HandleIsr();
+}
+
+void IRAM_ATTR Button::HandleIsr() {
+    // 中断里只读电平、打时间戳、入队；消抖和回调都在主循环做
+    bool pressed = gpio_get_level(gpio_num_) == (active_high_ ? 1 : 0);
+    Application::GetInstance().PostButtonEventFromISR(this, pressed, esp_timer_get_time());
+}
+
+bool Button::EnableFastPath() {
+    if (fast_path_) {
+        return true;
+    }
+    if (gpio_num_ == GPIO_NUM_NC) {
+        return false;
+    }
+    // 中断服务可能已经被别的模块装过了
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "GPIO ISR service unavailable (%d), falling back to polling", err);
+        return false;
+    }
+    gpio_set_intr_type(gpio_num_, GPIO_INTR_ANYEDGE);
+    if (gpio_isr_handler_add(gpio_num_, IsrHandler, this) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to add ISR for GPIO %d, falling back to polling", gpio_num_);
+        return false;
+    }
+    fast_path_ = true;
+    return true;
+}
+
+void Button::DispatchFastEvent(bool pressed, int64_t timestamp_us) {
+    int level = pressed ? 1 : 0;
+    if (level == last_level_) {
+        return;
+    }
+    if (last_level_ >= 0 && timestamp_us - last_edge_us_ < BUTTON_DEBOUNCE_US) {
+        return;
+    }
+    last_level_ = level;
+    last_edge_us_ = timestamp_us;
+    if (pressed) {
+        if (on_press_down_) {
+            on_press_down_();
+        }
+    } else {
+        if (on_press_up_) {
+            on_press_up_();
+        }
+    }
+}
+
 void Button::OnPressDown(std::function<void()> callback) {
+    on_press_down_ = callback;
+    if (EnableFastPath()) {
+        // ISR 直达，不再走组件轮询
+        return;
+    }
     if (button_handle_ == nullptr) {
         return;
     }
-    on_press_down_ = callback;
     iot_button_register_cb(button_handle_, BUTTON_PRESS_DOWN, [](void* handle, void* usr_data) {
         Button* button = static_cast<Button*>(usr_data);
         if (button->on_press_down_) {
@@ -59,10 +127,13 @@ void Button::OnPressDown(std::function<void()> callback) {
 }
 
 void Button::OnPressUp(std::function<void()> callback) {
+    on_press_up_ = callback;
+    if (EnableFastPath()) {
+        return;
+    }
     if (button_handle_ == nullptr) {
         return;
     }
-    on_press_up_ = callback;
     iot_button_register_cb(button_handle_, BUTTON_PRESS_UP, [](void* handle, void* usr_data) {
         Button* button = static_cast<Button*>(usr_data);
         if (button->on_press_up_) {
@@ -13,14 +13,30 @@ public:
     Button(gpio_num_t gpio_num, bool active_high = false);
     ~Button();
 
+    // GPIO 按键的按下/抬起走 ISR 直达通道：边沿中断把带时间戳的
+    // 事件直接塞进主循环的队列，省掉按键组件最多一个轮询周期加
+    // 按键任务到 Schedule 的一跳。ADC 按键仍走组件轮询。
     void OnPressDown(std::function<void()> callback);
     void OnPressUp(std::function<void()> callback);
     void OnLongPress(std::function<void()> callback);
     void OnClick(std::function<void()> callback);
     void OnDoubleClick(std::function<void()> callback);
+
+    // 主循环从按键事件队列里取到本键的事件后调用：软件消抖 + 分发
+    void DispatchFastEvent(bool pressed, int64_t timestamp_us);
+
 private:
-    gpio_num_t gpio_num_;
+    gpio_num_t gpio_num_ = GPIO_NUM_NC;
     button_handle_t button_handle_ = nullptr;
+    bool active_high_ = false;
+    bool fast_path_ = false;
+    // 消抖状态，只在主循环上读写
+    int last_level_ = -1;
+    int64_t last_edge_us_ = 0;
+
+    bool EnableFastPath();
+    void HandleIsr();
+    static void IsrHandler(void* arg);
 
 
     std::function<void()> on_press_down_;
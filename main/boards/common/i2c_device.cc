@@ -1,6 +1,7 @@
 #include "i2c_device.h"
 
 #include <esp_log.h>
+#include <cstring>
 
 #define TAG "I2cDevice"
 
@@ -24,6 +25,41 @@ void I2cDevice::WriteReg(uint8_t reg, uint8_t value) {
     ESP_ERROR_CHECK(i2c_master_transmit(i2c_device_, buffer, 2, 100));
 }
 
+void I2cDevice::WriteRegs(uint8_t reg, const uint8_t* buffer, size_t length) {
+    // 这里的器件突发写都在十几个寄存器以内，栈上拼帧即可，
+    // 更长的序列按块续发（地址随块推进）
+    uint8_t payload[17];
+    while (length > 0) {
+        size_t chunk = length < sizeof(payload) - 1 ? length : sizeof(payload) - 1;
+        payload[0] = reg;
+        memcpy(payload + 1, buffer, chunk);
+        ESP_ERROR_CHECK(i2c_master_transmit(i2c_device_, payload, chunk + 1, 100));
+        reg += chunk;
+        buffer += chunk;
+        length -= chunk;
+    }
+}
+
+void I2cDevice::WriteRegList(const I2cRegWrite* writes, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        uint8_t values[16];
+        size_t run = 1;
+        values[0] = writes[i].value;
+        while (i + run < count && run < sizeof(values) &&
+               writes[i + run].reg == (uint8_t)(writes[i].reg + run)) {
+            values[run] = writes[i + run].value;
+            run++;
+        }
+        if (run == 1) {
+            WriteReg(writes[i].reg, writes[i].value);
+        } else {
+            WriteRegs(writes[i].reg, values, run);
+        }
+        i += run;
+    }
+}
+
 uint8_t I2cDevice::ReadReg(uint8_t reg) {
     uint8_t buffer[1];
     ESP_ERROR_CHECK(i2c_master_transmit_receive(i2c_device_, &reg, 1, buffer, 1, 100));
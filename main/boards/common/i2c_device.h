@@ -3,6 +3,12 @@
 
 #include <driver/i2c_master.h>
 
+// WriteRegList 的一项：一个寄存器写
+struct I2cRegWrite {
+    uint8_t reg;
+    uint8_t value;
+};
+
 class I2cDevice {
 public:
     I2cDevice(i2c_master_bus_handle_t i2c_bus, uint8_t addr);
@@ -11,6 +17,12 @@ protected:
     i2c_master_dev_handle_t i2c_device_;
 
     void WriteReg(uint8_t reg, uint8_t value);
+    // 连续寄存器突发写：利用器件的地址自增，一次事务写完
+    // reg 起的 length 个寄存器，省掉逐寄存器的起止位和地址字节
+    void WriteRegs(uint8_t reg, const uint8_t* buffer, size_t length);
+    // 合并发出一串寄存器写：地址连续的相邻项并成一次突发，
+    // 典型的上电初始化序列从 N 次事务降到几次
+    void WriteRegList(const I2cRegWrite* writes, size_t count);
     uint8_t ReadReg(uint8_t reg);
     void ReadRegs(uint8_t reg, uint8_t* buffer, size_t length);
 };
@@ -1,5 +1,8 @@
 #include "power_save_timer.h"
 #include "application.h"
+#if CONFIG_USE_WAKE_WORD_DETECT
+#include "audio_frontend.h"
+#endif
 
 #include <esp_log.h>
 
@@ -67,6 +70,12 @@ void PowerSaveTimer::PowerSaveCheck() {
                 on_enter_sleep_mode_();
             }
 
+#if CONFIG_USE_WAKE_WORD_DETECT
+            // 守听进占空比模式：静默期只跑 VAD，WakeNet 省下的 CPU
+            // 才能让下面的降频真正见效
+            AudioFrontend::GetInstance().SetLowPowerMode(true);
+#endif
+
             if (cpu_max_freq_ != -1) {
                 esp_pm_config_t pm_config = {
                     .max_freq_mhz = cpu_max_freq_,
@@ -87,10 +96,16 @@ void PowerSaveTimer::WakeUp() {
     if (in_sleep_mode_) {
         in_sleep_mode_ = false;
 
+#if CONFIG_USE_WAKE_WORD_DETECT
+        AudioFrontend::GetInstance().SetLowPowerMode(false);
+#endif
+
         if (cpu_max_freq_ != -1) {
+            // 醒来不再把 min 钉在满频：满频窗口由 CpuGovernor 的
+            // ESP_PM_CPU_FREQ_MAX 锁保证，句间空隙 DFS 照样能降档
             esp_pm_config_t pm_config = {
                 .max_freq_mhz = cpu_max_freq_,
-                .min_freq_mhz = cpu_max_freq_,
+                .min_freq_mhz = 40,
                 .light_sleep_enable = false,
             };
             esp_pm_configure(&pm_config);
@@ -2,9 +2,11 @@
 
 #include "display.h"
 #include "application.h"
+#include "network_quality.h"
 #include "system_info.h"
 #include "font_awesome_symbols.h"
 #include "settings.h"
+#include "config_blobs.h"
 #include "assets/lang_config.h"
 
 #include <freertos/FreeRTOS.h>
@@ -20,15 +22,102 @@
 #include <wifi_station.h>
 #include <wifi_configuration_ap.h>
 #include <ssid_manager.h>
+#include <esp_wifi.h>
+#include <esp_timer.h>
+
+#include <cstdio>
+#include <cstring>
 
 static const char *TAG = "WifiBoard";
 
+// 定向快连缓存：上次成功关联的 AP 信道和 BSSID 落在 wifi 命名空间里，
+// 下次起网直接带着它们发起关联，省掉 2-4 秒的全信道扫描。
+// AP 换了信道或不在了，驱动会报断开，组件的扫描重连兜底。
+static void SaveLastApInfo() {
+    wifi_ap_record_t ap_info;
+    if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
+        return;
+    }
+    // 信道和 BSSID 合成一个 blob 一次写入，BSSID 存原始字节；
+    // 同一个 AP 重复关联时整组值没变，一次 flash 都不碰
+    config_blobs::WifiFastConnect cache = {};
+    cache.channel = ap_info.primary;
+    memcpy(cache.bssid, ap_info.bssid, sizeof(cache.bssid));
+    Settings settings("wifi", true);
+    settings.SetBlob("fast_connect", config_blobs::WifiFastConnect::kVersion, &cache, sizeof(cache));
+}
+
+static void TryFastConnect() {
+    Settings settings("wifi");
+    config_blobs::WifiFastConnect cache = {};
+    if (!settings.GetBlob("fast_connect", config_blobs::WifiFastConnect::kVersion, &cache, sizeof(cache)) ||
+        cache.channel == 0) {
+        return;
+    }
+    auto ssid_list = SsidManager::GetInstance().GetSsidList();
+    if (ssid_list.empty()) {
+        return;
+    }
+
+    auto& item = ssid_list.front();
+    wifi_config_t wifi_config = {};
+    strncpy((char*)wifi_config.sta.ssid, item.ssid.c_str(), sizeof(wifi_config.sta.ssid) - 1);
+    strncpy((char*)wifi_config.sta.password, item.password.c_str(), sizeof(wifi_config.sta.password) - 1);
+    wifi_config.sta.channel = cache.channel;
+    wifi_config.sta.bssid_set = true;
+    memcpy(wifi_config.sta.bssid, cache.bssid, sizeof(cache.bssid));
+    wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+
+    // 驱动可能还没起来（组件异步初始化），失败就放弃，走正常扫描
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    if (err != ESP_OK) {
+        ESP_LOGD(TAG, "Fast connect config not applied: %s", esp_err_to_name(err));
+        return;
+    }
+    err = esp_wifi_connect();
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Fast connect to %s (channel %d, %02x:%02x:%02x:%02x:%02x:%02x)",
+                 item.ssid.c_str(), cache.channel,
+                 cache.bssid[0], cache.bssid[1], cache.bssid[2],
+                 cache.bssid[3], cache.bssid[4], cache.bssid[5]);
+    }
+}
+
+// 链路预警采样：每 5 秒读一次关联 AP 的 RSSI 喂给 NetworkQuality。
+// 读取只是驱动里的一次寄存器快照，不发探测包，没有空口开销。以前
+// RSSI 只在 OTA 检查拼 POST 体时取一次，音频管线要等真丢包才知道
+// 链路在变差；现在信号滑向覆盖边缘就提前换档（见 RecordRssiSample）
+#ifndef WIFI_RSSI_SAMPLE_INTERVAL_MS
+#define WIFI_RSSI_SAMPLE_INTERVAL_MS 5000
+#endif
+
+static void StartLinkMonitor() {
+    static esp_timer_handle_t timer = nullptr;
+    if (timer != nullptr) {
+        return;
+    }
+    esp_timer_create_args_t args = {};
+    args.callback = [](void*) {
+        wifi_ap_record_t ap_info;
+        if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+            NetworkQuality::GetInstance().RecordRssiSample(ap_info.rssi);
+        }
+    };
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "wifi_rssi";
+    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, WIFI_RSSI_SAMPLE_INTERVAL_MS * 1000LL));
+}
+
 WifiBoard::WifiBoard() {
     Settings settings("wifi", true);
     wifi_config_mode_ = settings.GetInt("force_ap") == 1;
     if (wifi_config_mode_) {
         ESP_LOGI(TAG, "force_ap is set to 1, reset to 0");
         settings.SetInt("force_ap", 0);
+        // 配网模式下随时可能被拔电重启，标志复位立即落盘，
+        // 不然下次开机又被拽回配网
+        settings.Flush();
     }
 }
 
@@ -97,9 +186,14 @@ void WifiBoard::StartNetwork() {
         std::string notification = Lang::Strings::CONNECTED_TO;
         notification += ssid;
         display->ShowNotification(notification.c_str(), 30000);
+        // 刷新快连缓存，下次起网定向关联
+        SaveLastApInfo();
     });
     wifi_station.Start();
 
+    // 赶在组件的全信道扫描出结果前，用缓存的信道/BSSID 先试一次定向关联
+    TryFastConnect();
+
     // Try to connect to WiFi, if failed, launch the WiFi configuration AP
     if (!wifi_station.WaitForConnected(60 * 1000)) {
         wifi_station.Stop();
@@ -107,6 +201,9 @@ void WifiBoard::StartNetwork() {
         EnterWifiConfigMode();
         return;
     }
+
+    // 关联成功后持续监测信号，数据进遥测 network 面板并驱动换档
+    StartLinkMonitor();
 }
 
 Http* WifiBoard::CreateHttp() {
@@ -176,6 +273,8 @@ void WifiBoard::ResetWifiConfiguration() {
     {
         Settings settings("wifi", true);
         settings.SetInt("force_ap", 1);
+        // 马上就重启，不等空闲态的批量 commit
+        settings.Flush();
     }
     GetDisplay()->ShowNotification(Lang::Strings::ENTERING_WIFI_CONFIG_MODE);
     vTaskDelay(pdMS_TO_TICKS(1000));
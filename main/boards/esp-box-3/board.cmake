@@ -0,0 +1,5 @@
+# 本板编译清单（见 main/CMakeLists.txt 的板级清单说明）。
+# blaklight.cc 是 Backlight Thing 的源文件（历史拼写），
+# boards/common/backlight.cc 是 PWM 背光驱动，两者都要
+set(BOARD_THINGS speaker blaklight capture_meter)
+set(BOARD_COMMON_DRIVERS wifi_board backlight)
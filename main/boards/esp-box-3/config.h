@@ -37,5 +37,8 @@
 #define DISPLAY_BACKLIGHT_PIN GPIO_NUM_47
 #define DISPLAY_BACKLIGHT_OUTPUT_INVERT false
 
+// 守听叠加通话时核 1（AFE 内部任务偏好核）会被打满而核 0 空转：
+// 把 fetch 任务（命令词/MultiNet 检测 + Opus 编码）钉到核 0 摊开负载
+#define AFE_FETCH_TASK_CORE 0
 
 #endif // _BOARD_CONFIG_H_
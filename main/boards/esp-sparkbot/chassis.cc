@@ -10,7 +10,9 @@
 #include <driver/gpio.h>
 #include <driver/uart.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <cstring>
+#include <functional>
 
 #include "boards/esp-sparkbot/config.h"
 
@@ -21,6 +23,33 @@ namespace iot {
 class Chassis : public Thing {
 private:
     light_mode_t light_mode_ = LIGHT_MODE_ALWAYS_ON;
+    bool dancing_ = false;
+
+    // 舞步在底盘 MCU 上自主执行大约这么久，这边只能按时长收尾
+    static constexpr int kDanceDurationMs = 6000;
+
+    struct DoneTimer {
+        esp_timer_handle_t timer;
+        std::function<void()> done;
+    };
+
+    // 按时长挂一次性定时器调用完成回调：UART 是单向的，底盘不回报
+    // 动作结束，按标称时长报完成已经够增量状态上报用
+    static void ScheduleDone(int delay_ms, std::function<void()> done) {
+        auto* ctx = new DoneTimer{nullptr, std::move(done)};
+        esp_timer_create_args_t args = {};
+        args.callback = [](void* arg) {
+            auto* ctx = static_cast<DoneTimer*>(arg);
+            ctx->done();
+            esp_timer_delete(ctx->timer);
+            delete ctx;
+        };
+        args.arg = ctx;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "chassis_done";
+        ESP_ERROR_CHECK(esp_timer_create(&args, &ctx->timer));
+        ESP_ERROR_CHECK(esp_timer_start_once(ctx->timer, (int64_t)delay_ms * 1000));
+    }
 
     void SendUartMessage(const char * command_str) {
         uint8_t len = strlen(command_str);
@@ -55,6 +84,10 @@ public:
             return (light_mode_ - 2 <= 0) ? 1 : light_mode_ - 2;
         });
 
+        properties_.AddBooleanProperty("dancing", "是否正在跳舞", [this]() -> bool {
+            return dancing_;
+        });
+
         // 定义设备可以被远程执行的指令
         methods_.AddMethod("GoForward", "向前走", ParameterList(), [this](const ParameterList& parameters) {
             SendUartMessage("x0.0 y1.0");
@@ -72,9 +105,17 @@ public:
             SendUartMessage("x1.0 y0.0");
         });
 
-        methods_.AddMethod("Dance", "跳舞", ParameterList(), [this](const ParameterList& parameters) {
+        // 异步方法：发 UART 指令后执行任务立即空出来，几秒的舞步
+        // 不占执行线程。结束时 dancing_ 翻回 false 并调 done，
+        // 增量状态上报由此把"跳完了"带给服务器
+        methods_.AddAsyncMethod("Dance", "跳舞", ParameterList(), [this](const ParameterList& parameters, std::function<void()> done) {
             SendUartMessage("d1");
             light_mode_ = LIGHT_MODE_MAX;
+            dancing_ = true;
+            ScheduleDone(kDanceDurationMs, [this, done = std::move(done)]() {
+                dancing_ = false;
+                done();
+            });
         });
 
         methods_.AddMethod("SwitchLightMode", "打开灯", ParameterList({
@@ -5,6 +5,8 @@
 #include "button.h"
 #include "config.h"
 #include "i2c_device.h"
+#include "board_init_stages.h"
+#include "intr_affinity.h"
 #include "iot/thing_manager.h"
 
 #include <esp_log.h>
@@ -100,7 +102,11 @@ private:
         io_config.trans_queue_depth = 10;
         io_config.lcd_cmd_bits = 8;
         io_config.lcd_param_bits = 8;
-        ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi(SPI3_HOST, &io_config, &panel_io));
+        // SPI 主机的 ISR 分配在首次挂设备的调用核上，按 DISPLAY_INTR_CORE
+        // 归核（默认 -1 = 原地，板级 config.h 可覆盖，见 intr_affinity.h）
+        intr_affinity::RunOn(DISPLAY_INTR_CORE, "lcd_intr", [&]() {
+            ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi(SPI3_HOST, &io_config, &panel_io));
+        });
 
         // 初始化液晶屏驱动芯片ST7789
         ESP_LOGD(TAG, "Install LCD driver");
@@ -135,9 +141,13 @@ private:
 
 public:
     LichuangDevBoard() : boot_button_(BOOT_BUTTON_GPIO) {
-        InitializeI2c();
-        InitializeSpi();
-        InitializeSt7789Display();
+        // SPI 总线和 I2C/PCA9557 互不依赖，并行拉起；显示初始化
+        // 两者都要（复位脚挂在 PCA9557 上），汇合后再跑
+        BoardInitStages stages;
+        stages.Run("board_i2c", [this]() { InitializeI2c(); });
+        stages.Run("board_spi", [this]() { InitializeSpi(); });
+        stages.Wait();
+        stages.RunInline("board_display", [this]() { InitializeSt7789Display(); });
         InitializeButtons();
         InitializeIot();
         GetBacklight()->RestoreBrightness();
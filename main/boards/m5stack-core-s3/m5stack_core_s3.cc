@@ -7,6 +7,7 @@
 #include "i2c_device.h"
 #include "iot/thing_manager.h"
 #include "axp2101.h"
+#include "board_init_stages.h"
 
 #include <esp_log.h>
 #include <driver/i2c_master.h>
@@ -62,13 +63,16 @@ class Aw9523 : public I2cDevice {
 public:
     // Exanpd IO Init
     Aw9523(i2c_master_bus_handle_t i2c_bus, uint8_t addr) : I2cDevice(i2c_bus, addr) {
-        WriteReg(0x02, 0b00000111);  // P0
-        WriteReg(0x03, 0b10001111);  // P1
-        WriteReg(0x04, 0b00011000);  // CONFIG_P0
-        WriteReg(0x05, 0b00001100);  // CONFIG_P1
-        WriteReg(0x11, 0b00010000);  // GCR P0 port is Push-Pull mode.
-        WriteReg(0x12, 0b11111111);  // LEDMODE_P0
-        WriteReg(0x13, 0b11111111);  // LEDMODE_P1
+        static const I2cRegWrite kInitRegs[] = {
+            {0x02, 0b00000111},  // P0
+            {0x03, 0b10001111},  // P1
+            {0x04, 0b00011000},  // CONFIG_P0
+            {0x05, 0b00001100},  // CONFIG_P1
+            {0x11, 0b00010000},  // GCR P0 port is Push-Pull mode.
+            {0x12, 0b11111111},  // LEDMODE_P0
+            {0x13, 0b11111111},  // LEDMODE_P1
+        };
+        WriteRegList(kInitRegs, sizeof(kInitRegs) / sizeof(kInitRegs[0]));
     }
 
     void ResetAw88298() {
@@ -316,12 +320,18 @@ private:
 public:
     M5StackCoreS3Board() {
         InitializePowerSaveTimer();
-        InitializeI2c();
-        InitializeAxp2101();
-        InitializeAw9523();
-        I2cDetect();
-        InitializeSpi();
-        InitializeIli9342Display();
+        // I2C 链（总线、PMIC、IO 扩展）和显示 SPI 总线互不依赖，
+        // 并行拉起；面板初始化要等 Aw9523 的复位脚，汇合后再跑
+        BoardInitStages stages;
+        stages.Run("board_i2c", [this]() {
+            InitializeI2c();
+            InitializeAxp2101();
+            InitializeAw9523();
+            I2cDetect();
+        });
+        stages.Run("board_spi", [this]() { InitializeSpi(); });
+        stages.Wait();
+        stages.RunInline("board_display", [this]() { InitializeIli9342Display(); });
         InitializeIot();
         InitializeFt6336TouchPad();
         GetBacklight()->RestoreBrightness();
@@ -3,6 +3,9 @@
 
 #include <driver/gpio.h>
 
+// 蜂窝板：计费流量，能力矩阵据此收紧带宽侧默认值（见 board_caps.h）
+#define BOARD_HAS_CELLULAR 1
+
 #define AUDIO_INPUT_SAMPLE_RATE  16000
 #define AUDIO_OUTPUT_SAMPLE_RATE 24000
 #define AUDIO_I2S_MIC_GPIO_WS   GPIO_NUM_4
@@ -56,9 +56,15 @@ private:
             ESP_LOGI(TAG, "Enabling sleep mode");
             display_->SetChatMessage("system", "");
             display_->SetEmotion("sleepy");
-            GetBacklight()->SetBrightness(1);
+            // 快照当前帧后面板整个断显示：比只压背光再省一档，
+            // 唤醒时快照整帧回灌，不用等 LVGL 从头重画
+            display_->SnapshotForSleep();
+            GetBacklight()->SetBrightness(0);
+            esp_lcd_panel_disp_on_off(panel_, false);
         });
         power_save_timer_->OnExitSleepMode([this]() {
+            esp_lcd_panel_disp_on_off(panel_, true);
+            display_->RestoreFromSleep();
             display_->SetChatMessage("system", "");
             display_->SetEmotion("neutral");
             GetBacklight()->RestoreBrightness();
@@ -40,8 +40,10 @@ private:
             display->SetChatMessage("system", "");
             display->SetEmotion("sleepy");
             
+            // 休眠走真关断：EnableInput(false) 现在只是静音保温，
+            // bias/PLL 还在耗电，PowerDown 才整颗断掉
             auto codec = GetAudioCodec();
-            codec->EnableInput(false);
+            codec->PowerDown();
         });
         power_save_timer_->OnExitSleepMode([this]() {
             auto codec = GetAudioCodec();
@@ -0,0 +1,68 @@
+#include "boot_profiler.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <cstring>
+#include <mutex>
+
+#define TAG "BootProfiler"
+
+namespace boot_profiler {
+namespace {
+
+struct StageRecord {
+    const char* name;
+    int64_t start_us;
+    int64_t duration_us;
+};
+
+// 启动阶段就十来个，定长表 + 小锁足够；并行阶段各占一行互不干扰
+constexpr size_t kMaxStages = 16;
+StageRecord g_stages[kMaxStages];
+size_t g_stage_count = 0;
+bool g_reported = false;
+std::mutex g_mutex;
+
+}  // namespace
+
+void Begin(const char* stage) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_reported || g_stage_count >= kMaxStages) {
+        return;
+    }
+    g_stages[g_stage_count++] = { stage, esp_timer_get_time(), -1 };
+}
+
+void End(const char* stage) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_reported) {
+        return;
+    }
+    // 从后往前找最近一次同名 Begin，支持并行阶段交错结束
+    for (size_t i = g_stage_count; i > 0; i--) {
+        auto& record = g_stages[i - 1];
+        if (record.duration_us < 0 && strcmp(record.name, stage) == 0) {
+            record.duration_us = esp_timer_get_time() - record.start_us;
+            return;
+        }
+    }
+}
+
+void Report() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_reported) {
+        return;
+    }
+    g_reported = true;
+    int64_t now = esp_timer_get_time();
+    ESP_LOGI(TAG, "Boot stages (total %lld ms since power-on):", now / 1000);
+    for (size_t i = 0; i < g_stage_count; i++) {
+        const auto& record = g_stages[i];
+        ESP_LOGI(TAG, "  %-16s start %6lld ms, took %6lld ms", record.name,
+            record.start_us / 1000,
+            (record.duration_us < 0 ? now - record.start_us : record.duration_us) / 1000);
+    }
+}
+
+}  // namespace boot_profiler
@@ -0,0 +1,21 @@
+#ifndef BOOT_PROFILER_H
+#define BOOT_PROFILER_H
+
+// 启动阶段耗时打点：各初始化阶段记起止时间，设备就绪后一次性汇报，
+// 用来回答"6 秒冷启动都花在哪了"。Report 之后的打点不再记录。
+namespace boot_profiler {
+
+void Begin(const char* stage);
+void End(const char* stage);
+void Report();
+
+// RAII 形式，作用域结束自动 End
+struct Scope {
+    const char* stage;
+    explicit Scope(const char* stage) : stage(stage) { Begin(stage); }
+    ~Scope() { End(stage); }
+};
+
+}  // namespace boot_profiler
+
+#endif // BOOT_PROFILER_H
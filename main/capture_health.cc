@@ -0,0 +1,131 @@
+#include "capture_health.h"
+#include "audio_codec.h"
+#include "audio_iram.h"
+#include "board.h"
+
+#include <cmath>
+
+// 每帧均方的 EMA 时间常数：1/16，60ms 帧下窗口约 1 秒
+#define CAPTURE_EMA_SHIFT 4
+// 峰值每帧衰减 1/16：短瞬态能在面板上留几秒尾迹
+#define CAPTURE_PEAK_DECAY_SHIFT 4
+// 峰值低于此幅度算平直帧（ADC 噪声底以下，正常供电的麦克风给不出）
+#define CAPTURE_FLAT_PEAK 16
+// 连续平直超过 500 帧（约 30 秒）且另一通道有信号 → 疑似断线
+#define CAPTURE_DEAD_FRAMES 500
+
+namespace {
+
+// 均方 → dBFS 的整数近似，只在拉快照的冷路径跑
+int MeanSqToDb(uint64_t mean_sq) {
+    if (mean_sq == 0) {
+        return -96;
+    }
+    // 10*log10(mean_sq / 32768^2)
+    float db = 10.0f * log10f((float)mean_sq) - 90.3f;
+    return db < -96.0f ? -96 : (int)db;
+}
+
+int PeakToDb(int32_t peak) {
+    if (peak <= 0) {
+        return -96;
+    }
+    float db = 20.0f * log10f((float)peak / 32768.0f);
+    return db < -96.0f ? -96 : (int)db;
+}
+
+}  // namespace
+
+AUDIO_IRAM_ATTR void CaptureHealth::Analyze(const int16_t* data, size_t samples,
+                                            int channels) {
+    if (channels < 1 || channels > 2 || samples == 0) {
+        return;
+    }
+    // 单遍扫过交织帧：平方和进 64 位，峰值和削顶顺路数出来。
+    // PIE 的 ACCX 取出口只有 32 位，整帧的平方和装不下，而这段
+    // 标量循环一帧只花几微秒（16ms 一次），不值得再开向量内核
+    uint64_t sum_sq[2] = {0, 0};
+    int32_t frame_peak[2] = {0, 0};
+    uint32_t frame_clips[2] = {0, 0};
+    for (size_t i = 0; i < samples; ++i) {
+        int ch = channels == 2 ? (int)(i & 1) : 0;
+        int32_t v = data[i];
+        sum_sq[ch] += (uint64_t)((int64_t)v * v);
+        int32_t mag = v < 0 ? -v : v;
+        if (mag > frame_peak[ch]) {
+            frame_peak[ch] = mag;
+        }
+        // 录到满摆幅就是削顶：正常语音连 -3dBFS 都很少碰到
+        if (mag >= 32767) {
+            frame_clips[ch]++;
+        }
+    }
+
+    size_t frames = channels == 2 ? samples / 2 : samples;
+    std::lock_guard<std::mutex> lock(mutex_);
+    channels_ = channels;
+    for (int ch = 0; ch < channels; ++ch) {
+        auto& s = state_[ch];
+        uint64_t mean_sq = sum_sq[ch] / frames;
+        s.ema_mean_sq += ((int64_t)mean_sq - (int64_t)s.ema_mean_sq) >> CAPTURE_EMA_SHIFT;
+        s.peak -= s.peak >> CAPTURE_PEAK_DECAY_SHIFT;
+        if (frame_peak[ch] > s.peak) {
+            s.peak = frame_peak[ch];
+        }
+        s.clips += frame_clips[ch];
+        if (frame_peak[ch] < CAPTURE_FLAT_PEAK) {
+            s.flat_streak++;
+        } else {
+            s.flat_streak = 0;
+        }
+    }
+}
+
+CaptureHealth::Snapshot CaptureHealth::GetSnapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Snapshot snap = {};
+    snap.channels = channels_;
+    for (int ch = 0; ch < 2; ++ch) {
+        auto& s = state_[ch];
+        snap.rms_db[ch] = MeanSqToDb(s.ema_mean_sq);
+        snap.peak_db[ch] = PeakToDb(s.peak);
+        snap.clips[ch] = s.clips;
+        snap.flat_streak[ch] = s.flat_streak;
+    }
+    // 断线判据要求另一通道同期有信号：整机静音（夜里、静噪环境）
+    // 不该报警，一路平直一路正常才说明硬件有问题
+    if (channels_ == 2) {
+        for (int ch = 0; ch < 2; ++ch) {
+            int other = ch ^ 1;
+            snap.dead[ch] = snap.flat_streak[ch] > CAPTURE_DEAD_FRAMES &&
+                state_[other].flat_streak == 0;
+        }
+    }
+    return snap;
+}
+
+std::string CaptureHealth::BuildJson() {
+    Snapshot snap = GetSnapshot();
+    std::string json = "{";
+    json += "\"channels\":" + std::to_string(snap.channels);
+    // codec 驱动层的完整性计数：收包环溢出和不足额读取，
+    // 幅度正常但这里涨就是调度挤占而不是增益问题
+    auto codec = Board::GetInstance().GetAudioCodec();
+    json += ",\"overruns\":" + std::to_string(codec->input_overruns());
+    json += ",\"partial_reads\":" + std::to_string(codec->input_partial_reads());
+    json += ",\"ch\":[";
+    for (int ch = 0; ch < snap.channels; ++ch) {
+        if (ch > 0) {
+            json += ",";
+        }
+        json += "{\"rms_db\":" + std::to_string(snap.rms_db[ch]);
+        json += ",\"peak_db\":" + std::to_string(snap.peak_db[ch]);
+        json += ",\"clips\":" + std::to_string(snap.clips[ch]);
+        json += ",\"flat_streak\":" + std::to_string(snap.flat_streak[ch]);
+        json += ",\"dead\":";
+        json += snap.dead[ch] ? "true" : "false";
+        json += "}";
+    }
+    json += "]}";
+    return json;
+}
@@ -0,0 +1,57 @@
+#ifndef CAPTURE_HEALTH_H
+#define CAPTURE_HEALTH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 采集链路健康监视
+// “服务器听不见设备”的工单绝大多数是增益配错或某路麦克风/回采
+// 虚焊，却要把机器寄回来插示波器才能定位。这里在 InputAudio 每帧
+// 顺手量一下原始采集：各通道的滑窗 RMS、衰减峰值、削顶计数和
+// 平直（疑似断线）帧计数，通过遥测 capture 面板和 IoT 的
+// CaptureMeter 属性远程可查，返修变成一次 metrics 拉取
+class CaptureHealth {
+public:
+    static CaptureHealth& GetInstance() {
+        static CaptureHealth instance;
+        return instance;
+    }
+    CaptureHealth(const CaptureHealth&) = delete;
+    CaptureHealth& operator=(const CaptureHealth&) = delete;
+
+    // 每帧调用，data 为重采样前的原始交织帧（看的是 ADC 真实幅度
+    // 和真实的通道排布），channels 取板级编译期常量
+    void Analyze(const int16_t* data, size_t samples, int channels);
+
+    // IoT 属性和遥测共用的快照
+    struct Snapshot {
+        int channels;
+        int rms_db[2];       // 滑窗 RMS，dBFS（负值，-96 = 静音）
+        int peak_db[2];      // 衰减峰值，dBFS
+        uint32_t clips[2];   // 累计削顶采样数
+        uint32_t flat_streak[2];  // 连续平直帧数
+        bool dead[2];        // 平直超时且另一通道有信号 → 疑似断线
+    };
+    Snapshot GetSnapshot();
+
+    // 组完整 JSON 对象，挂 TelemetryRegistry 的 capture 面板
+    std::string BuildJson();
+
+private:
+    CaptureHealth() = default;
+
+    struct ChannelState {
+        uint64_t ema_mean_sq = 0;  // 每帧均方的 EMA（见 kEmaShift）
+        int32_t peak = 0;          // 指数衰减峰值
+        uint32_t clips = 0;
+        uint32_t flat_streak = 0;
+    };
+
+    std::mutex mutex_;
+    int channels_ = 0;
+    ChannelState state_[2];
+};
+
+#endif  // CAPTURE_HEALTH_H
@@ -0,0 +1,81 @@
+#include "command_shortcuts.h"
+#include "board.h"
+#include "audio_codec.h"
+#include "iot/thing_manager.h"
+
+#include <cJSON.h>
+#include <esp_log.h>
+
+#include <cstdio>
+
+#define TAG "CommandShortcuts"
+
+namespace command_shortcuts {
+
+namespace {
+
+std::string SetVolumeCommand(int volume) {
+    if (volume < 0) {
+        volume = 0;
+    }
+    if (volume > 100) {
+        volume = 100;
+    }
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer),
+        "{\"name\":\"Speaker\",\"method\":\"SetVolume\",\"parameters\":{\"volume\":%d}}", volume);
+    return buffer;
+}
+
+int CurrentVolume() {
+    return Board::GetInstance().GetAudioCodec()->output_volume();
+}
+
+std::string VolumeUp() {
+    return SetVolumeCommand(CurrentVolume() + 10);
+}
+
+std::string VolumeDown() {
+    return SetVolumeCommand(CurrentVolume() - 10);
+}
+
+std::string VolumeMax() {
+    return SetVolumeCommand(100);
+}
+
+std::string Mute() {
+    return SetVolumeCommand(0);
+}
+
+// 表顺序即命令 ID（下标 + 1），改动只许追加，别让旧固件的日志
+// 和新表的 ID 对不上
+const Shortcut kTable[] = {
+    {"tiao gao yin liang", VolumeUp},    // 调高音量
+    {"tiao di yin liang", VolumeDown},   // 调低音量
+    {"zui da yin liang", VolumeMax},     // 最大音量
+    {"jing yin", Mute},                  // 静音
+};
+
+}  // namespace
+
+const Shortcut* GetTable(size_t* count) {
+    *count = sizeof(kTable) / sizeof(kTable[0]);
+    return kTable;
+}
+
+bool Dispatch(int command_id) {
+    if (command_id < 1 || (size_t)command_id > sizeof(kTable) / sizeof(kTable[0])) {
+        return false;
+    }
+    std::string json = kTable[command_id - 1].build_command();
+    cJSON* command = cJSON_Parse(json.c_str());
+    if (command == nullptr) {
+        return false;
+    }
+    ESP_LOGI(TAG, "Local shortcut: %s", json.c_str());
+    iot::ThingManager::GetInstance().Invoke(command);
+    cJSON_Delete(command);
+    return true;
+}
+
+}  // namespace command_shortcuts
@@ -0,0 +1,30 @@
+#ifndef COMMAND_SHORTCUTS_H
+#define COMMAND_SHORTCUTS_H
+
+#include <cstddef>
+#include <string>
+
+// 延迟敏感短语的本地直通表。音量调节这类小命令以前要走
+// 音频→服务器 ASR→LLM→iot 命令 下发，一圈好几秒，而
+// iot/things/speaker.cc 执行只要微秒。聆听态由 AudioFrontend 的
+// MultiNet 在设备端匹配这张表，命中直接用现有 iot 命令格式调
+// ThingManager::Invoke；表里没有的话音不受影响，照旧走服务器。
+namespace command_shortcuts {
+
+struct Shortcut {
+    // MultiNet 注册用的拼音串（中文模型按拼音注册短语）
+    const char* phrase;
+    // 命中时构造 iot 命令 JSON（与服务器下发的格式一致）
+    std::string (*build_command)();
+};
+
+// 返回短语表；MultiNet 注册时命令 ID 取表下标 + 1
+const Shortcut* GetTable(size_t* count);
+
+// 按 MultiNet 命令 ID 执行对应的 iot 命令，在主循环上调用。
+// ID 不在表里返回 false
+bool Dispatch(int command_id);
+
+}  // namespace command_shortcuts
+
+#endif // COMMAND_SHORTCUTS_H
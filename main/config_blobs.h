@@ -0,0 +1,52 @@
+#ifndef CONFIG_BLOBS_H
+#define CONFIG_BLOBS_H
+
+#include <cstdint>
+
+// 成组落盘的二进制配置结构，配合 Settings::GetBlob/SetBlob 使用：
+// 一组相关字段一个 blob，一次 NVS 事务读写完，不再逐键各付一次
+// 页写。改动任何字段布局都必须递增对应的 kVersion——版本不匹配的
+// 旧数据按不存在处理，调用方回退到重新获取或逐键读取。
+namespace config_blobs {
+
+// OTA 版本检查下发的 MQTT 接入配置。
+// Ota::CheckVersion 写入，MqttProtocol::StartMqttClient 读取
+struct MqttConfig {
+    static constexpr uint8_t kVersion = 1;
+    char endpoint[128];
+    char client_id[64];
+    char username[64];
+    char password[96];
+    char publish_topic[64];
+};
+
+// 上一次版本检查的结果缓存（application.cc）：已激活且固件版本没变的
+// 设备开机直接进待机，版本检查转入后台复核，不再把启动吊在 HTTP
+// 往返上。checked_at 是当时的墙钟秒，顺带用来在 SNTP/服务器时间
+// 到位前把时钟从 1970 拉回一个像样的值
+struct VersionCheckCache {
+    static constexpr uint8_t kVersion = 1;
+    uint8_t activated;
+    char firmware_version[32];
+    int64_t checked_at;
+};
+
+// WiFi 定向快连缓存：上次成功关联的 AP 信道和 BSSID（wifi_board.cc）。
+// BSSID 直接存原始字节，省掉字符串格式化和解析
+struct WifiFastConnect {
+    static constexpr uint8_t kVersion = 1;
+    uint8_t channel;
+    uint8_t bssid[6];
+};
+
+// AFE 背景噪声画像（audio_frontend.cc）：空闲非语音帧滚动估计的
+// 环境底噪电平。重启后用来给噪声抑制预喂收敛素材，首句的抑制质量
+// 立即到位，不再在用户开头几个字上现学
+struct AfeAmbientProfile {
+    static constexpr uint8_t kVersion = 1;
+    uint16_t ambient_level;  // 非语音帧平均绝对幅度的 EMA
+};
+
+}  // namespace config_blobs
+
+#endif // CONFIG_BLOBS_H
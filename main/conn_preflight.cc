@@ -0,0 +1,171 @@
+#include "conn_preflight.h"
+#include "board.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <lwip/sockets.h>
+#include <lwip/netdb.h>
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#define TAG "ConnPreflight"
+
+// 下一个地址的错峰间隔：第一个地址 250ms 内没握上就并行追加下一个，
+// 坏路由不再独占整个超时窗口
+#define PREFLIGHT_STAGGER_MS 250
+// 负缓存 TTL：这段时间内对同一端点直接判不可达，重试风暴里
+// 不反复付探测成本；路由恢复最多迟 30 秒被发现
+#define PREFLIGHT_NEGATIVE_TTL_US (30 * 1000000LL)
+
+bool ConnPreflight::Probe(const std::string& host, uint16_t port, int timeout_ms) {
+    std::string key = host + ":" + std::to_string(port);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = negative_cache_.find(key);
+        if (it != negative_cache_.end()) {
+            if (esp_timer_get_time() < it->second) {
+                ESP_LOGW(TAG, "%s negative-cached, failing fast", key.c_str());
+                return false;
+            }
+            negative_cache_.erase(it);
+        }
+    }
+
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0
+        || result == nullptr) {
+        ESP_LOGW(TAG, "DNS resolution for %s failed", host.c_str());
+        std::lock_guard<std::mutex> lock(mutex_);
+        negative_cache_[key] = esp_timer_get_time() + PREFLIGHT_NEGATIVE_TTL_US;
+        return false;
+    }
+
+    // Happy Eyeballs 排序：v6 优先、两族交替，单族坏路由不会把
+    // 竞速窗口整个占掉
+    std::vector<struct addrinfo*> v4, v6, order;
+    for (auto* ai = result; ai != nullptr; ai = ai->ai_next) {
+        (ai->ai_family == AF_INET6 ? v6 : v4).push_back(ai);
+    }
+    for (size_t i = 0; i < v4.size() || i < v6.size(); i++) {
+        if (i < v6.size()) order.push_back(v6[i]);
+        if (i < v4.size()) order.push_back(v4[i]);
+    }
+
+    std::vector<int> fds;
+    size_t next = 0;
+    bool connected = false;
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+
+    while (!connected && esp_timer_get_time() < deadline) {
+        // 到错峰点就再拉起一路连接，前面的继续在 select 里赛跑
+        if (next < order.size()) {
+            auto* ai = order[next++];
+            int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd >= 0) {
+                int flags = fcntl(fd, F_GETFL, 0);
+                fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+                int ret = connect(fd, ai->ai_addr, ai->ai_addrlen);
+                if (ret == 0) {
+                    connected = true;
+                    close(fd);
+                } else if (errno == EINPROGRESS) {
+                    fds.push_back(fd);
+                } else {
+                    close(fd);
+                }
+            }
+        }
+        if (connected || (fds.empty() && next >= order.size())) {
+            break;
+        }
+
+        fd_set wset;
+        FD_ZERO(&wset);
+        int max_fd = -1;
+        for (int fd : fds) {
+            FD_SET(fd, &wset);
+            if (fd > max_fd) {
+                max_fd = fd;
+            }
+        }
+        int64_t remain_us = deadline - esp_timer_get_time();
+        int64_t wait_us = next < order.size() ? PREFLIGHT_STAGGER_MS * 1000LL : remain_us;
+        if (wait_us > remain_us) {
+            wait_us = remain_us;
+        }
+        if (wait_us < 0) {
+            wait_us = 0;
+        }
+        struct timeval tv = {
+            .tv_sec = (time_t)(wait_us / 1000000),
+            .tv_usec = (suseconds_t)(wait_us % 1000000),
+        };
+        if (select(max_fd + 1, nullptr, &wset, nullptr, &tv) > 0) {
+            for (auto it = fds.begin(); it != fds.end();) {
+                if (!FD_ISSET(*it, &wset)) {
+                    ++it;
+                    continue;
+                }
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(*it, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err == 0) {
+                    connected = true;
+                    break;
+                }
+                // 这一路被拒/不可达，关掉让剩下的继续赛
+                close(*it);
+                it = fds.erase(it);
+            }
+        }
+    }
+
+    for (int fd : fds) {
+        close(fd);
+    }
+    freeaddrinfo(result);
+
+    if (!connected) {
+        ESP_LOGW(TAG, "No reachable address for %s within %d ms", key.c_str(), timeout_ms);
+        std::lock_guard<std::mutex> lock(mutex_);
+        negative_cache_[key] = esp_timer_get_time() + PREFLIGHT_NEGATIVE_TTL_US;
+    }
+    return connected;
+}
+
+bool ConnPreflight::ProbeUrl(const std::string& url, int timeout_ms) {
+    // ML307 的套接字在模组侧走 AT 通道，lwIP 探测不代表那条路
+    if (Board::GetInstance().GetBoardType() != "wifi") {
+        return true;
+    }
+
+    uint16_t port = 80;
+    std::string rest = url;
+    auto scheme_end = rest.find("://");
+    if (scheme_end != std::string::npos) {
+        std::string scheme = rest.substr(0, scheme_end);
+        if (scheme == "wss" || scheme == "https") {
+            port = 443;
+        }
+        rest = rest.substr(scheme_end + 3);
+    }
+    auto path_start = rest.find('/');
+    if (path_start != std::string::npos) {
+        rest = rest.substr(0, path_start);
+    }
+    auto port_start = rest.find(':');
+    if (port_start != std::string::npos) {
+        port = (uint16_t)atoi(rest.c_str() + port_start + 1);
+        rest = rest.substr(0, port_start);
+    }
+    if (rest.empty()) {
+        return true;
+    }
+    return Probe(rest, port, timeout_ms);
+}
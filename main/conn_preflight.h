@@ -0,0 +1,45 @@
+#ifndef CONN_PREFLIGHT_H
+#define CONN_PREFLIGHT_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+// 连接预检：在把 URL 交给传输组件之前，自己先做一轮 Happy Eyeballs
+// 式的并行连接竞速——getaddrinfo 解出的所有地址（v6 优先、v6/v4 交替）
+// 以 250ms 错峰发起非阻塞 connect，任一握上就算通。传输组件
+// （esp-ml307 的 EspHttp/WebSocket）内部是单地址串行连接，改不了它，
+// 但预检能拿到两样东西：
+//   1. 快失败——全部地址都不通时负缓存该端点，调用方立刻走备用
+//      通道（WebSocket→MQTT 失败切换）或排程重试，不再吃满组件里
+//      一轮 DNS + TCP 超时（弱网下 20 秒起步）；
+//   2. 顺手把域名解析灌进 lwIP 的 DNS 缓存，组件随后的连接不再
+//      重新查询。
+// 只在 lwIP 栈本地的板子（wifi）上有意义；ML307 的套接字在模组侧，
+// 预检直接放行
+class ConnPreflight {
+public:
+    static ConnPreflight& GetInstance() {
+        static ConnPreflight instance;
+        return instance;
+    }
+    ConnPreflight(const ConnPreflight&) = delete;
+    ConnPreflight& operator=(const ConnPreflight&) = delete;
+
+    // 返回 false 表示此刻判定端点不可达（负缓存命中或竞速全败），
+    // 调用方应立即失败而不是发起组件连接
+    bool Probe(const std::string& host, uint16_t port, int timeout_ms = 2000);
+    // 从 URL 里抠出主机和端口再 Probe；ws/http 默认 80，wss/https 443。
+    // 解析不出来或非 wifi 板子一律放行
+    bool ProbeUrl(const std::string& url, int timeout_ms = 2000);
+
+private:
+    ConnPreflight() = default;
+
+    std::mutex mutex_;
+    // host:port → 负缓存过期时刻（esp_timer_get_time 微秒）
+    std::map<std::string, int64_t> negative_cache_;
+};
+
+#endif // CONN_PREFLIGHT_H
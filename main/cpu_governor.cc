@@ -0,0 +1,88 @@
+#include "cpu_governor.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+
+#define TAG "CpuGovernor"
+
+void CpuGovernor::Init() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // min_freq 给到芯片允许的最低档，实际档位由 DFS 在锁释放时选；
+    // light sleep 仍归 PowerSaveTimer 管（那是守听静默期的事），
+    // 这里只做运行中的频率伸缩
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = 40,
+        .light_sleep_enable = false,
+    };
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        // CONFIG_PM_ENABLE 没开：锁是空操作，账还是照记，
+        // metrics 里 scaled_ms 恒为 0 正好暴露这件事
+        ESP_LOGW(TAG, "DFS not available: %s", esp_err_to_name(err));
+    }
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "audio_dsp", &max_freq_lock_));
+    // 启动期满频：模型加载和连网都在关键路径上
+    state_active_ = true;
+    esp_pm_lock_acquire(max_freq_lock_);
+    holding_ = true;
+    transition_us_ = esp_timer_get_time();
+}
+
+void CpuGovernor::SetStateActive(bool active) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_active_ == active) {
+        return;
+    }
+    state_active_ = active;
+    UpdateLocked();
+}
+
+void CpuGovernor::SetPipelineActive(bool active) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pipeline_active_ == active) {
+        return;
+    }
+    pipeline_active_ = active;
+    UpdateLocked();
+}
+
+void CpuGovernor::UpdateLocked() {
+    bool want = state_active_ || pipeline_active_;
+    if (want == holding_ || max_freq_lock_ == nullptr) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    if (holding_) {
+        full_us_ += now - transition_us_;
+        esp_pm_lock_release(max_freq_lock_);
+    } else {
+        scaled_us_ += now - transition_us_;
+        esp_pm_lock_acquire(max_freq_lock_);
+    }
+    holding_ = want;
+    transition_us_ = now;
+    ++transitions_;
+}
+
+CpuGovernor::Residency CpuGovernor::GetResidency() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 进行中的区间也算进去，不然长对话里数字一直不动
+    int64_t full_us = full_us_;
+    int64_t scaled_us = scaled_us_;
+    int64_t elapsed = esp_timer_get_time() - transition_us_;
+    if (holding_) {
+        full_us += elapsed;
+    } else {
+        scaled_us += elapsed;
+    }
+    return Residency{full_us / 1000, scaled_us / 1000, transitions_};
+}
+
+std::string CpuGovernor::BuildJson() {
+    auto r = GetResidency();
+    return "{\"full_ms\":" + std::to_string(r.full_ms) +
+        ",\"scaled_ms\":" + std::to_string(r.scaled_ms) +
+        ",\"transitions\":" + std::to_string(r.transitions) + "}";
+}
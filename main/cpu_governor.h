@@ -0,0 +1,61 @@
+#ifndef CPU_GOVERNOR_H
+#define CPU_GOVERNOR_H
+
+#include <esp_pm.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 按设备状态和管线占用驱动的 CPU 频率调度。
+// SetPowerSaveMode 只在通道开关时二值切换，对话的句间空隙里 CPU
+// 仍然满频空转。这里启用 esp_pm 的 DFS，平时让系统降到低频档，
+// 只在两类信号任一活跃时持 CPU 满频锁：
+//  - 状态信号：聆听/说话等 DSP 活跃态（SetDeviceState 驱动）
+//  - 管线信号：状态之外还有帧要解（本地提示音在放、队列没排空）
+// 锁的驻留时长两边各记一本账，metrics 里能看到电池机型到底有
+// 多少时间真正降了频。
+class CpuGovernor {
+public:
+    static CpuGovernor& GetInstance() {
+        static CpuGovernor instance;
+        return instance;
+    }
+    CpuGovernor(const CpuGovernor&) = delete;
+    CpuGovernor& operator=(const CpuGovernor&) = delete;
+
+    // 启用 DFS 并创建满频锁，启动期先持锁（彼时正在建模型/连网）。
+    // CONFIG_PM_ENABLE 没开时降级为空操作，只留驻留统计
+    void Init();
+    // 状态信号，SetDeviceState 里按新状态置位
+    void SetStateActive(bool active);
+    // 管线信号，PlaySound 置位、播放路径排空队列时清除
+    void SetPipelineActive(bool active);
+    // 驻留统计：{"full_ms":...,"scaled_ms":...,"transitions":...}
+    std::string BuildJson();
+
+    struct Residency {
+        int64_t full_ms;
+        int64_t scaled_ms;
+        uint32_t transitions;
+    };
+    Residency GetResidency();
+
+private:
+    CpuGovernor() = default;
+
+    // 信号变化后重算锁的持有状态并记账，调用方持锁
+    void UpdateLocked();
+
+    std::mutex mutex_;
+    esp_pm_lock_handle_t max_freq_lock_ = nullptr;
+    bool state_active_ = false;
+    bool pipeline_active_ = false;
+    bool holding_ = false;
+    int64_t transition_us_ = 0;
+    int64_t full_us_ = 0;
+    int64_t scaled_us_ = 0;
+    uint32_t transitions_ = 0;
+};
+
+#endif // CPU_GOVERNOR_H
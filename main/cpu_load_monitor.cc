@@ -0,0 +1,98 @@
+#include "cpu_load_monitor.h"
+
+#include <esp_log.h>
+
+#include <cstdio>
+#include <cstring>
+
+#define TAG "CpuLoad"
+
+void CpuLoadMonitor::Sample() {
+    // 定长数组一次取全系统状态，不 malloc 不 vTaskDelay
+    TaskStatus_t status[kMaxTasks + 4];
+    configRUN_TIME_COUNTER_TYPE total_time = 0;
+    UBaseType_t count = uxTaskGetSystemState(status, kMaxTasks + 4, &total_time);
+    if (count == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t total_delta = (uint32_t)(total_time - last_total_time_);
+    uint32_t idle_delta = 0;
+
+    TaskLoad next[kMaxTasks];
+    size_t next_count = 0;
+    for (UBaseType_t i = 0; i < count && next_count < kMaxTasks; i++) {
+        auto& slot = next[next_count];
+        slot.handle = status[i].xHandle;
+        strncpy(slot.name, status[i].pcTaskName, sizeof(slot.name) - 1);
+        slot.name[sizeof(slot.name) - 1] = '\0';
+        slot.counter = status[i].ulRunTimeCounter;
+        slot.load_pct = 0;
+
+        if (has_baseline_ && total_delta > 0) {
+            // 跟上一个快照里的同一个任务做差分，新任务第一轮记 0
+            for (size_t j = 0; j < task_count_; j++) {
+                if (tasks_[j].handle == slot.handle) {
+                    uint32_t task_delta = slot.counter - tasks_[j].counter;
+                    slot.load_pct = (uint8_t)(task_delta * 100ULL /
+                        ((uint64_t)total_delta * CONFIG_FREERTOS_NUMBER_OF_CORES));
+                    break;
+                }
+            }
+        }
+        if (strncmp(slot.name, "IDLE", 4) == 0) {
+            idle_delta += slot.counter;  // 先累计数器，下面按差分算
+            for (size_t j = 0; j < task_count_; j++) {
+                if (tasks_[j].handle == slot.handle) {
+                    idle_delta -= tasks_[j].counter;
+                    break;
+                }
+            }
+        }
+        next_count++;
+    }
+
+    memcpy(tasks_, next, sizeof(TaskLoad) * next_count);
+    task_count_ = next_count;
+
+    if (has_baseline_ && total_delta > 0) {
+        uint32_t idle_pct = (uint32_t)(idle_delta * 100ULL /
+            ((uint64_t)total_delta * CONFIG_FREERTOS_NUMBER_OF_CORES));
+        uint8_t busy = idle_pct >= 100 ? 0 : (uint8_t)(100 - idle_pct);
+        busy_history_[history_head_] = busy;
+        history_head_ = (history_head_ + 1) % kHistoryDepth;
+        if (history_count_ < kHistoryDepth) {
+            history_count_++;
+        }
+    }
+    last_total_time_ = total_time;
+    has_baseline_ = true;
+}
+
+std::string CpuLoadMonitor::BuildJson() {
+    char buffer[96];
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::string json = "{\"tasks\":{";
+    bool first = true;
+    for (size_t i = 0; i < task_count_; i++) {
+        // 没跑起来的任务不占报文
+        if (tasks_[i].load_pct == 0) {
+            continue;
+        }
+        snprintf(buffer, sizeof(buffer), "%s\"%s\":%u",
+            first ? "" : ",", tasks_[i].name, tasks_[i].load_pct);
+        json += buffer;
+        first = false;
+    }
+    json += "},\"busy_history\":{\"interval_s\":10,\"percent\":[";
+    size_t start = (history_head_ + kHistoryDepth - history_count_) % kHistoryDepth;
+    for (size_t i = 0; i < history_count_; i++) {
+        snprintf(buffer, sizeof(buffer), "%s%u",
+            i > 0 ? "," : "", busy_history_[(start + i) % kHistoryDepth]);
+        json += buffer;
+    }
+    json += "]}}";
+    return json;
+}
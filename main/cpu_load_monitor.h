@@ -0,0 +1,53 @@
+#ifndef CPU_LOAD_MONITOR_H
+#define CPU_LOAD_MONITOR_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 增量式 CPU 负载监控。PrintRealTimeStats 靠 malloc + 1 秒阻塞采样，
+// 只能打到串口；这里每个周期只做一次 uxTaskGetSystemState，跟上一次
+// 快照的运行计数器做差分，无阻塞无堆分配，留一段总负载历史，
+// 服务器发 metrics 请求时随堆遥测一起带回去，看音频任务还有多少余量。
+class CpuLoadMonitor {
+public:
+    static CpuLoadMonitor& GetInstance() {
+        static CpuLoadMonitor instance;
+        return instance;
+    }
+    CpuLoadMonitor(const CpuLoadMonitor&) = delete;
+    CpuLoadMonitor& operator=(const CpuLoadMonitor&) = delete;
+
+    // 每 10 秒从时钟定时器调用一次，计算自上次以来的负载
+    void Sample();
+    // 组出 JSON 对象：当前每任务负载 + 总负载历史
+    std::string BuildJson();
+
+private:
+    CpuLoadMonitor() = default;
+
+    // 固件的任务数稳定在 20 个上下，满了就丢尾巴
+    static constexpr size_t kMaxTasks = 24;
+    static constexpr size_t kHistoryDepth = 30;
+
+    struct TaskLoad {
+        TaskHandle_t handle;
+        char name[configMAX_TASK_NAME_LEN];
+        uint32_t counter;
+        uint8_t load_pct;
+    };
+
+    std::mutex mutex_;
+    TaskLoad tasks_[kMaxTasks] = {};
+    size_t task_count_ = 0;
+    configRUN_TIME_COUNTER_TYPE last_total_time_ = 0;
+    bool has_baseline_ = false;
+    uint8_t busy_history_[kHistoryDepth] = {};
+    size_t history_head_ = 0;
+    size_t history_count_ = 0;
+};
+
+#endif // CPU_LOAD_MONITOR_H
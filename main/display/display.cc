@@ -10,11 +10,89 @@
 #include "font_awesome_symbols.h"
 #include "audio_codec.h"
 #include "settings.h"
+#include "telemetry_registry.h"
 #include "assets/lang_config.h"
 
+#include <esp_memory_utils.h>
+#include <esp_heap_caps.h>
+#include <esp_lvgl_port.h>
+
 #define TAG "Display"
 
+// 空闲态的 LVGL 刷新周期（2Hz）；活跃态回到 LV_DEF_REFR_PERIOD
+#define IDLE_REFRESH_PERIOD_MS 500
+
+namespace {
+
+// 异步 UI 队列的消息：text/role 要么是 flash 常量（指针直接入队），
+// 要么是 strdup 的拷贝，由消费端释放
+struct UiMessage {
+    enum Type : uint8_t { kStatus, kEmotion, kChatMessage, kChatAppend, kTransaction };
+    uint8_t type;
+    const char* text;
+    const char* role;
+    bool text_pooled;
+    bool role_pooled;
+};
+
+// 更新事务（BeginUpdate/CommitUpdate 攒出来的一组变更）：整组走
+// 一条队列消息，消费端一次持锁全部应用。text 字段装它的指针
+struct UiTransaction {
+    const char* status;
+    const char* emotion;
+    const char* role;
+    const char* content;
+    bool status_pooled;
+    bool emotion_pooled;
+    bool role_pooled;
+    bool content_pooled;
+    bool has_message;
+};
+
+void FreeTransaction(UiTransaction* txn) {
+    if (txn->status_pooled) free((void*)txn->status);
+    if (txn->emotion_pooled) free((void*)txn->emotion);
+    if (txn->role_pooled) free((void*)txn->role);
+    if (txn->content_pooled) free((void*)txn->content);
+    free(txn);
+}
+
+// Lang::Strings 和代码里的字面量都在 DROM，指针本身就是稳定的
+// 驻留值；运行期字符串复制一份
+const char* InternUiText(const char* text, bool& pooled) {
+    pooled = false;
+    if (text == nullptr) {
+        return "";
+    }
+    if (esp_ptr_in_drom(text)) {
+        return text;
+    }
+    // 运行期文本（聊天消息居多，一条几百字节）的拷贝优先落 PSRAM，
+    // 无 PSRAM 板子回退内部堆；free() 对任意 caps 堆都有效，
+    // 消费端不用区分来源
+    size_t size = strlen(text) + 1;
+    char* copy = (char*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (copy == nullptr) {
+        copy = (char*)malloc(size);
+    }
+    if (copy == nullptr) {
+        return "";
+    }
+    memcpy(copy, text, size);
+    pooled = true;
+    return copy;
+}
+
+}  // namespace
+
 Display::Display() {
+    // 异步 UI 通道：调用方只入队，LVGL 锁和渲染都在这个任务上
+    ui_queue_ = xQueueCreate(8, sizeof(UiMessage));
+    xTaskCreate([](void* arg) {
+        static_cast<Display*>(arg)->UiTaskLoop();
+        vTaskDelete(NULL);
+    }, "display_ui", 3072, this, 2, &ui_task_);
+
     // Notification timer
     esp_timer_create_args_t notification_timer_args = {
         .callback = [](void *arg) {
@@ -54,6 +132,25 @@ Display::Display() {
 }
 
 Display::~Display() {
+    if (ui_task_ != nullptr) {
+        vTaskDelete(ui_task_);
+    }
+    if (ui_queue_ != nullptr) {
+        UiMessage msg;
+        while (xQueueReceive(ui_queue_, &msg, 0) == pdTRUE) {
+            if (msg.type == UiMessage::kTransaction) {
+                FreeTransaction((UiTransaction*)msg.text);
+                continue;
+            }
+            if (msg.text_pooled) {
+                free((void*)msg.text);
+            }
+            if (msg.role_pooled) {
+                free((void*)msg.role);
+            }
+        }
+        vQueueDelete(ui_queue_);
+    }
     if (notification_timer_ != nullptr) {
         esp_timer_stop(notification_timer_);
         esp_timer_delete(notification_timer_);
@@ -77,7 +174,315 @@ Display::~Display() {
     }
 }
 
+void Display::UiTaskLoop() {
+    UiMessage msg;
+    while (xQueueReceive(ui_queue_, &msg, portMAX_DELAY) == pdTRUE) {
+        switch (msg.type) {
+            case UiMessage::kStatus:
+                UpdateStatus(msg.text);
+                break;
+            case UiMessage::kEmotion:
+                UpdateEmotion(msg.text);
+                break;
+            case UiMessage::kChatMessage:
+                UpdateChatMessage(msg.role, msg.text);
+                break;
+            case UiMessage::kChatAppend:
+                UpdateChatAppend(msg.role, msg.text);
+                break;
+            case UiMessage::kTransaction: {
+                auto* txn = (UiTransaction*)msg.text;
+                {
+                    // 一次持锁应用整组变更（Update* 里的再次加锁是
+                    // 递归重入）；锁放开前渲染任务看不到中间态，
+                    // 失效区合并成一次重绘
+                    DisplayLockGuard lock(this);
+                    if (txn->status != nullptr) {
+                        UpdateStatus(txn->status);
+                    }
+                    if (txn->emotion != nullptr) {
+                        UpdateEmotion(txn->emotion);
+                    }
+                    if (txn->has_message) {
+                        UpdateChatMessage(txn->role, txn->content);
+                    }
+                }
+                FreeTransaction(txn);
+                continue;  // 事务自管释放，跳过下面的逐字段 free
+            }
+        }
+        if (msg.text_pooled) {
+            free((void*)msg.text);
+        }
+        if (msg.role_pooled) {
+            free((void*)msg.role);
+        }
+    }
+}
+
+void Display::BeginUpdate() {
+    // 嵌套 Begin 或上次没 Commit 的残留：先丢掉暂存
+    if (txn_status_pooled_) free((void*)txn_status_);
+    if (txn_emotion_pooled_) free((void*)txn_emotion_);
+    if (txn_role_pooled_) free((void*)txn_role_);
+    if (txn_content_pooled_) free((void*)txn_content_);
+    txn_status_ = nullptr;
+    txn_emotion_ = nullptr;
+    txn_role_ = nullptr;
+    txn_content_ = nullptr;
+    txn_status_pooled_ = txn_emotion_pooled_ = txn_role_pooled_ = txn_content_pooled_ = false;
+    txn_has_message_ = false;
+    txn_task_ = xTaskGetCurrentTaskHandle();
+}
+
+void Display::CommitUpdate() {
+    if (txn_task_ != xTaskGetCurrentTaskHandle()) {
+        return;
+    }
+    txn_task_ = nullptr;
+    if (txn_status_ == nullptr && txn_emotion_ == nullptr && !txn_has_message_) {
+        return;  // 这次迁移什么都没改，不白占队列
+    }
+    auto* txn = (UiTransaction*)malloc(sizeof(UiTransaction));
+    if (txn == nullptr) {
+        // 分配不出来就退化成逐条入队（txn_task_ 已清，走普通路径），
+        // 只是多拿几次锁；Set* 内部会另拷一份，暂存的池拷贝这里释放
+        if (txn_status_ != nullptr) SetStatus(txn_status_);
+        if (txn_emotion_ != nullptr) SetEmotion(txn_emotion_);
+        if (txn_has_message_) SetChatMessage(txn_role_, txn_content_);
+        if (txn_status_pooled_) free((void*)txn_status_);
+        if (txn_emotion_pooled_) free((void*)txn_emotion_);
+        if (txn_role_pooled_) free((void*)txn_role_);
+        if (txn_content_pooled_) free((void*)txn_content_);
+        txn_status_pooled_ = txn_emotion_pooled_ = txn_role_pooled_ = txn_content_pooled_ = false;
+    } else {
+        *txn = { txn_status_, txn_emotion_, txn_role_, txn_content_,
+                 txn_status_pooled_, txn_emotion_pooled_, txn_role_pooled_,
+                 txn_content_pooled_, txn_has_message_ };
+        UiMessage msg = { UiMessage::kTransaction, (const char*)txn, nullptr, false, false };
+        if (xQueueSend(ui_queue_, &msg, pdMS_TO_TICKS(10)) != pdTRUE) {
+            ESP_LOGW(TAG, "UI queue full, dropping update transaction");
+            FreeTransaction(txn);
+        }
+        // 所有权已随事务转移（或释放）
+        txn_status_pooled_ = txn_emotion_pooled_ = txn_role_pooled_ = txn_content_pooled_ = false;
+    }
+    txn_status_ = nullptr;
+    txn_emotion_ = nullptr;
+    txn_role_ = nullptr;
+    txn_content_ = nullptr;
+    txn_has_message_ = false;
+}
+
 void Display::SetStatus(const char* status) {
+    if (txn_task_ == xTaskGetCurrentTaskHandle()) {
+        // 事务内后写覆盖前写
+        if (txn_status_pooled_) free((void*)txn_status_);
+        txn_status_ = InternUiText(status, txn_status_pooled_);
+        return;
+    }
+    UiMessage msg = { UiMessage::kStatus, nullptr, nullptr, false, false };
+    msg.text = InternUiText(status, msg.text_pooled);
+    if (xQueueSend(ui_queue_, &msg, pdMS_TO_TICKS(10)) != pdTRUE) {
+        ESP_LOGW(TAG, "UI queue full, dropping status update");
+        if (msg.text_pooled) {
+            free((void*)msg.text);
+        }
+    }
+}
+
+void Display::SetEmotion(const char* emotion) {
+    if (txn_task_ == xTaskGetCurrentTaskHandle()) {
+        if (txn_emotion_pooled_) free((void*)txn_emotion_);
+        txn_emotion_ = InternUiText(emotion, txn_emotion_pooled_);
+        return;
+    }
+    UiMessage msg = { UiMessage::kEmotion, nullptr, nullptr, false, false };
+    msg.text = InternUiText(emotion, msg.text_pooled);
+    if (xQueueSend(ui_queue_, &msg, pdMS_TO_TICKS(10)) != pdTRUE) {
+        ESP_LOGW(TAG, "UI queue full, dropping emotion update");
+        if (msg.text_pooled) {
+            free((void*)msg.text);
+        }
+    }
+}
+
+void Display::SetChatMessage(const char* role, const char* content) {
+    if (txn_task_ == xTaskGetCurrentTaskHandle()) {
+        if (txn_role_pooled_) free((void*)txn_role_);
+        if (txn_content_pooled_) free((void*)txn_content_);
+        txn_content_ = InternUiText(content, txn_content_pooled_);
+        txn_role_ = InternUiText(role, txn_role_pooled_);
+        txn_has_message_ = true;
+        return;
+    }
+    UiMessage msg = { UiMessage::kChatMessage, nullptr, nullptr, false, false };
+    msg.text = InternUiText(content, msg.text_pooled);
+    msg.role = InternUiText(role, msg.role_pooled);
+    if (xQueueSend(ui_queue_, &msg, pdMS_TO_TICKS(10)) != pdTRUE) {
+        ESP_LOGW(TAG, "UI queue full, dropping chat message");
+        if (msg.text_pooled) {
+            free((void*)msg.text);
+        }
+        if (msg.role_pooled) {
+            free((void*)msg.role);
+        }
+    }
+}
+
+void Display::AppendChatMessage(const char* role, const char* content) {
+    UiMessage msg = { UiMessage::kChatAppend, nullptr, nullptr, false, false };
+    msg.text = InternUiText(content, msg.text_pooled);
+    msg.role = InternUiText(role, msg.role_pooled);
+    if (xQueueSend(ui_queue_, &msg, pdMS_TO_TICKS(10)) != pdTRUE) {
+        ESP_LOGW(TAG, "UI queue full, dropping chat append");
+        if (msg.text_pooled) {
+            free((void*)msg.text);
+        }
+        if (msg.role_pooled) {
+            free((void*)msg.role);
+        }
+    }
+}
+
+void Display::SetRenderIdle(bool idle) {
+    // NoDisplay 的板子没有 lvgl_port，display_ 为空直接略过
+    if (display_ == nullptr) {
+        return;
+    }
+    DisplayLockGuard lock(this);
+    auto timer = lv_display_get_refr_timer(display_);
+    if (timer != nullptr) {
+        // lvgl_port 任务按 lv_timer_handler 报的下次唤醒时间睡，
+        // 拉长刷新周期就是真的少醒
+        lv_timer_set_period(timer, idle ? IDLE_REFRESH_PERIOD_MS : LV_DEF_REFR_PERIOD);
+    }
+}
+
+void Display::SetRenderSuspended(bool suspended) {
+    if (display_ == nullptr || suspended == render_suspended_) {
+        return;
+    }
+    render_suspended_ = suspended;
+    if (suspended) {
+        lvgl_port_stop();
+    } else {
+        lvgl_port_resume();
+        // 停渲染期间 UI 队列照常改标签，恢复时整屏补一帧
+        DisplayLockGuard lock(this);
+        lv_obj_invalidate(lv_screen_active());
+    }
+}
+
+void Display::AttachRenderStats() {
+    if (display_ == nullptr) {
+        return;
+    }
+    stats_window_start_us_ = esp_timer_get_time();
+
+    // flush 起止配对出每次送屏的耗时、字节和像素（无效区），
+    // REFR_READY 且本周期真的 flush 过才算一帧
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto self = static_cast<Display*>(lv_event_get_user_data(e));
+        self->flush_start_us_ = esp_timer_get_time();
+    }, LV_EVENT_FLUSH_START, this);
+
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto self = static_cast<Display*>(lv_event_get_user_data(e));
+        self->flush_us_ += esp_timer_get_time() - self->flush_start_us_;
+        self->flush_count_++;
+        self->frame_dirty_ = true;
+        auto area = static_cast<lv_area_t*>(lv_event_get_param(e));
+        if (area != nullptr) {
+            uint64_t pixels = (uint64_t)lv_area_get_width(area) * lv_area_get_height(area);
+            self->flushed_pixels_ += pixels;
+            self->flush_bytes_ += pixels *
+                lv_color_format_get_size(lv_display_get_color_format(self->display_));
+        }
+    }, LV_EVENT_FLUSH_FINISH, this);
+
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto self = static_cast<Display*>(lv_event_get_user_data(e));
+        if (self->frame_dirty_) {
+            self->frame_dirty_ = false;
+            self->frame_count_++;
+        }
+    }, LV_EVENT_REFR_READY, this);
+
+    TelemetryRegistry::GetInstance().Register("display", [this]() {
+        return BuildRenderStatsJson();
+    });
+}
+
+Display::RenderStatsSnapshot Display::TakeRenderStats() {
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed_us = now - stats_window_start_us_;
+    stats_window_start_us_ = now;
+
+    uint32_t frames = frame_count_.exchange(0);
+    uint32_t flushes = flush_count_.exchange(0);
+    uint64_t flush_us = flush_us_.exchange(0);
+    uint64_t bytes = flush_bytes_.exchange(0);
+    uint64_t pixels = flushed_pixels_.exchange(0);
+
+    RenderStatsSnapshot snapshot;
+    if (elapsed_us <= 0) {
+        return snapshot;
+    }
+    snapshot.fps = (float)frames * 1000000.0f / (float)elapsed_us;
+    snapshot.avg_flush_us = flushes > 0 ? (uint32_t)(flush_us / flushes) : 0;
+    snapshot.kb_per_s = (uint32_t)(bytes * 1000000 / (uint64_t)elapsed_us / 1024);
+    // 无效区占比：每帧平均重画了整屏的百分之几，>100 说明一帧里
+    // 同一块区域被刷了多次（overdraw）
+    uint64_t screen_pixels = (uint64_t)width_ * height_;
+    if (frames > 0 && screen_pixels > 0) {
+        snapshot.invalidated_pct = (int)(pixels * 100 / (screen_pixels * frames));
+    }
+    return snapshot;
+}
+
+std::string Display::BuildRenderStatsJson() {
+    auto stats = TakeRenderStats();
+    return "{\"fps\":" + std::to_string((int)(stats.fps + 0.5f)) +
+        ",\"flush_us\":" + std::to_string(stats.avg_flush_us) +
+        ",\"kb_s\":" + std::to_string(stats.kb_per_s) +
+        ",\"invalidated_pct\":" + std::to_string(stats.invalidated_pct) + "}";
+}
+
+void Display::SetPerfOverlay(bool enable) {
+    if (display_ == nullptr) {
+        return;
+    }
+    DisplayLockGuard lock(this);
+    if (enable && perf_label_ == nullptr) {
+        // 叠在系统层上，不进页面布局，也就不扰动被测的重排行为
+        perf_label_ = lv_label_create(lv_layer_sys());
+        lv_obj_align(perf_label_, LV_ALIGN_TOP_LEFT, 2, 2);
+        lv_obj_set_style_text_color(perf_label_, lv_color_white(), 0);
+        lv_obj_set_style_bg_color(perf_label_, lv_color_black(), 0);
+        lv_obj_set_style_bg_opa(perf_label_, LV_OPA_70, 0);
+        lv_label_set_text(perf_label_, "");
+    } else if (!enable && perf_label_ != nullptr) {
+        lv_obj_del(perf_label_);
+        perf_label_ = nullptr;
+    }
+}
+
+void Display::UpdatePerfOverlay() {
+    if (perf_label_ == nullptr) {
+        return;
+    }
+    auto stats = TakeRenderStats();
+    DisplayLockGuard lock(this);
+    if (perf_label_ != nullptr) {
+        lv_label_set_text_fmt(perf_label_, "%d.%dfps %luus %luKB/s %d%%",
+            (int)stats.fps, (int)(stats.fps * 10) % 10,
+            (unsigned long)stats.avg_flush_us, (unsigned long)stats.kb_per_s,
+            stats.invalidated_pct);
+    }
+}
+
+void Display::UpdateStatus(const char* status) {
     DisplayLockGuard lock(this);
     if (status_label_ == nullptr) {
         return;
@@ -108,6 +513,9 @@ void Display::Update() {
     auto& board = Board::GetInstance();
     auto codec = board.GetAudioCodec();
 
+    // 性能面板跟着秒级更新节奏走，开着才有开销
+    UpdatePerfOverlay();
+
     {
         DisplayLockGuard lock(this);
         if (mute_label_ == nullptr) {
@@ -186,7 +594,7 @@ void Display::Update() {
 }
 
 
-void Display::SetEmotion(const char* emotion) {
+void Display::UpdateEmotion(const char* emotion) {
     struct Emotion {
         const char* icon;
         const char* text;
@@ -242,10 +650,29 @@ void Display::SetIcon(const char* icon) {
     lv_label_set_text(emotion_label_, icon);
 }
 
-void Display::SetChatMessage(const char* role, const char* content) {
+void Display::UpdateChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
         return;
     }
+    // 流式文本大多只在尾部增长：旧文本是新文本的前缀时只插入新增段，
+    // 省掉 set_text 的整串释放/复制；相同就什么都不做
+    const char* current = lv_label_get_text(chat_message_label_);
+    size_t current_len = strlen(current);
+    if (current_len > 0 && strncmp(current, content, current_len) == 0) {
+        if (content[current_len] == '\0') {
+            return;
+        }
+        lv_label_ins_text(chat_message_label_, LV_LABEL_POS_LAST, content + current_len);
+        return;
+    }
     lv_label_set_text(chat_message_label_, content);
 }
+
+void Display::UpdateChatAppend(const char* role, const char* content) {
+    DisplayLockGuard lock(this);
+    if (chat_message_label_ == nullptr || content[0] == '\0') {
+        return;
+    }
+    lv_label_ins_text(chat_message_label_, LV_LABEL_POS_LAST, content);
+}
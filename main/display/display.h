@@ -6,6 +6,11 @@
 #include <esp_log.h>
 #include <esp_pm.h>
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include <atomic>
 #include <string>
 
 struct DisplayFonts {
@@ -19,13 +24,51 @@ public:
     Display();
     virtual ~Display();
 
-    virtual void SetStatus(const char* status);
+    // 异步 UI 通道：这三个调用只入队立即返回，LVGL 锁由 display_ui
+    // 任务在消费端拿——状态切换路径不再等渲染。固定状态串
+    //（Lang::Strings 等 flash 常量）入队就是一次指针交换，运行期
+    // 字符串（字幕、提示）复制一份由消费端释放
+    void SetStatus(const char* status);
+    void SetEmotion(const char* emotion);
+    void SetChatMessage(const char* role, const char* content);
+    // 更新事务：状态迁移一次连改状态/表情/消息三样，逐条入队的话
+    // 消费端要拿三次 LVGL 锁、最多触发三次局部重绘。Begin/Commit
+    // 之间当前任务的 SetStatus/SetEmotion/SetChatMessage 攒成一条
+    // 事务消息，display_ui 任务一次持锁全部应用——渲染任务看不到
+    // 中间态，重绘合并成一次。必须在同一任务上配对；其它任务并发
+    // 的 Set* 不受影响，照旧逐条入队
+    void BeginUpdate();
+    void CommitUpdate();
+    // 追加语义：content 接在当前消息尾部而不是整条替换。流式 TTS
+    // 的回复一句句到，整段替换要把已显示的 CJK 段落整个重排，
+    // 追加只处理新增的文本段
+    void AppendChatMessage(const char* role, const char* content);
     virtual void ShowNotification(const char* notification, int duration_ms = 3000);
     virtual void ShowNotification(const std::string &notification, int duration_ms = 3000);
-    virtual void SetEmotion(const char* emotion);
-    virtual void SetChatMessage(const char* role, const char* content);
     virtual void SetIcon(const char* icon);
 
+    // 渲染性能面板开关：屏角叠一行实时数字（FPS/flush 耗时/字节/
+    // 无效区占比），改 UI 布局前后对比用；计数本身始终在积累并通过
+    // 遥测注册表上报（"display"）
+    void SetPerfOverlay(bool enable);
+
+    // 按设备状态节流 LVGL 刷新：空闲态表盘每分钟才变一次，刷新降到
+    // 2Hz，渲染任务别跟核 1 上的唤醒词 AFE 抢缓存；对话/动画恢复默认节奏
+    void SetRenderIdle(bool idle);
+    // 背光灭着没人看，渲染整个停掉；亮屏恢复并立即补一帧
+    void SetRenderSuspended(bool suspended);
+
+    // 休眠要断面板电（GRAM 不保）的板子用：灭屏前把当前帧快照进
+    // PSRAM，亮屏时整帧回灌，一次面板传输就有画面，不等 LVGL 从头
+    // 重画。基类默认空实现，只灭背光的板子不用管
+    virtual void SnapshotForSleep() {}
+    virtual void RestoreFromSleep() {}
+
+    // 常亮表盘模式：LVGL 整个停掉，预渲染的数字字模每分钟直接贴进
+    // 面板的一小块区域——CPU 和总线开销接近于零，调速器可以一直
+    // 待在最低档。退出时恢复 LVGL 并整屏补帧。基类默认空实现
+    virtual void SetAmbientClock(bool enable) {}
+
     inline int width() const { return width_; }
     inline int height() const { return height_; }
 
@@ -48,6 +91,7 @@ protected:
     const char* battery_icon_ = nullptr;
     const char* network_icon_ = nullptr;
     bool muted_ = false;
+    bool render_suspended_ = false;
 
     esp_timer_handle_t notification_timer_ = nullptr;
     esp_timer_handle_t update_timer_ = nullptr;
@@ -57,6 +101,59 @@ protected:
     virtual void Unlock() = 0;
 
     virtual void Update();
+
+    // 真正碰 LVGL 的实现，在 display_ui 任务上执行；子类按原来
+    // override SetXxx 的方式 override 这些
+    virtual void UpdateStatus(const char* status);
+    virtual void UpdateEmotion(const char* emotion);
+    virtual void UpdateChatMessage(const char* role, const char* content);
+    virtual void UpdateChatAppend(const char* role, const char* content);
+
+    QueueHandle_t ui_queue_ = nullptr;
+    TaskHandle_t ui_task_ = nullptr;
+    void UiTaskLoop();
+
+    // 开着的更新事务归属的任务：Set* 在这个任务上调用时改为暂存，
+    // 其它任务读到的句柄对不上，走普通入队路径，天然无竞态
+    TaskHandle_t txn_task_ = nullptr;
+    // 暂存的事务内容（指针语义与 UI 队列消息一致：DROM 常量直存，
+    // 运行期字符串是池拷贝）；status/emotion 为空指针表示没改
+    const char* txn_status_ = nullptr;
+    const char* txn_emotion_ = nullptr;
+    const char* txn_role_ = nullptr;
+    const char* txn_content_ = nullptr;
+    bool txn_status_pooled_ = false;
+    bool txn_emotion_pooled_ = false;
+    bool txn_role_pooled_ = false;
+    bool txn_content_pooled_ = false;
+    bool txn_has_message_ = false;
+
+    // 渲染统计：子类建好 display_ 后调用一次，挂 LVGL 的 flush/refr
+    // 事件并注册遥测 provider。计数在 lvgl 任务上写、遥测侧读，
+    // 原子就够
+    void AttachRenderStats();
+
+private:
+    struct RenderStatsSnapshot {
+        float fps = 0;
+        uint32_t avg_flush_us = 0;
+        uint32_t kb_per_s = 0;
+        int invalidated_pct = 0;
+    };
+    RenderStatsSnapshot TakeRenderStats();
+    std::string BuildRenderStatsJson();
+    void UpdatePerfOverlay();
+
+    std::atomic<uint32_t> flush_count_{0};
+    std::atomic<uint64_t> flush_us_{0};
+    std::atomic<uint64_t> flush_bytes_{0};
+    std::atomic<uint64_t> flushed_pixels_{0};
+    std::atomic<uint32_t> frame_count_{0};
+    // flush 起止配对只在 lvgl 渲染任务上发生，普通变量即可
+    int64_t flush_start_us_ = 0;
+    bool frame_dirty_ = false;
+    int64_t stats_window_start_us_ = 0;
+    lv_obj_t* perf_label_ = nullptr;
 };
 
 
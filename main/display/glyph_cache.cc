@@ -0,0 +1,148 @@
+#include "glyph_cache.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+#include <cstring>
+#include <list>
+#include <unordered_map>
+
+#define TAG "GlyphCache"
+
+namespace glyph_cache {
+namespace {
+
+// 预热字符：ASCII 全量 + 现代汉语最高频的一批字，启动时直接灌进缓存
+const char* kPrewarmText =
+    " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    "[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~"
+    "的一是了我不人在他有这个上们来到时大地为子中你说生国年着就那和"
+    "要她出也得里后自以会家可下而过天去能对小多然于心学么之都好看起"
+    "发当没成只如事把还用第样道想作种开";
+
+struct CacheEntry {
+    std::list<uint32_t>::iterator lru_it;
+    uint8_t* data;
+};
+
+struct CacheData {
+    const lv_font_t* real;
+    lv_font_t proxy;
+    size_t max_entries;
+    std::list<uint32_t> lru;
+    std::unordered_map<uint32_t, CacheEntry> entries;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+};
+
+// LVGL 的位图字体按位连续打包，没有行对齐
+size_t BitmapSize(const lv_font_glyph_dsc_t* dsc) {
+    int bpp;
+    switch (dsc->format) {
+        case LV_FONT_GLYPH_FORMAT_A1: bpp = 1; break;
+        case LV_FONT_GLYPH_FORMAT_A2: bpp = 2; break;
+        case LV_FONT_GLYPH_FORMAT_A4: bpp = 4; break;
+        case LV_FONT_GLYPH_FORMAT_A8: bpp = 8; break;
+        default: return 0;
+    }
+    return ((size_t)dsc->box_w * dsc->box_h * bpp + 7) / 8;
+}
+
+bool ProxyGetGlyphDsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc,
+                      uint32_t letter, uint32_t letter_next) {
+    auto cache = (CacheData*)font->user_data;
+    return cache->real->get_glyph_dsc(cache->real, dsc, letter, letter_next);
+}
+
+const void* ProxyGetGlyphBitmap(lv_font_glyph_dsc_t* g_dsc, lv_draw_buf_t* draw_buf) {
+    auto proxy = g_dsc->resolved_font;
+    auto cache = (CacheData*)proxy->user_data;
+    uint32_t key = g_dsc->gid.index;
+
+    auto it = cache->entries.find(key);
+    if (it != cache->entries.end()) {
+        cache->hits++;
+        // 命中挪到 LRU 队首
+        cache->lru.splice(cache->lru.begin(), cache->lru, it->second.lru_it);
+        return it->second.data;
+    }
+    cache->misses++;
+
+    // 未命中：让原字体取位图，resolved_font 临时换回去再换回来
+    g_dsc->resolved_font = cache->real;
+    const void* bitmap = cache->real->get_glyph_bitmap(g_dsc, draw_buf);
+    g_dsc->resolved_font = proxy;
+    if (bitmap == nullptr) {
+        return nullptr;
+    }
+
+    size_t size = BitmapSize(g_dsc);
+    if (size == 0) {
+        return bitmap;
+    }
+
+    while (cache->entries.size() >= cache->max_entries && !cache->lru.empty()) {
+        uint32_t victim = cache->lru.back();
+        cache->lru.pop_back();
+        auto victim_it = cache->entries.find(victim);
+        heap_caps_free(victim_it->second.data);
+        cache->entries.erase(victim_it);
+    }
+
+    auto data = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (data == nullptr) {
+        // PSRAM 吃紧时直接透传，不影响正确性
+        return bitmap;
+    }
+    memcpy(data, bitmap, size);
+    cache->lru.push_front(key);
+    cache->entries[key] = CacheEntry{cache->lru.begin(), data};
+    return data;
+}
+
+void Prewarm(CacheData* cache) {
+    const uint8_t* p = (const uint8_t*)kPrewarmText;
+    while (*p != 0) {
+        // 手工解 UTF-8，预热串只有 1 字节和 3 字节两种
+        uint32_t unicode;
+        if ((*p & 0x80) == 0) {
+            unicode = p[0];
+            p += 1;
+        } else if ((*p & 0xF0) == 0xE0) {
+            unicode = ((p[0] & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+            p += 3;
+        } else {
+            p++;
+            continue;
+        }
+
+        lv_font_glyph_dsc_t dsc;
+        if (lv_font_get_glyph_dsc(&cache->proxy, &dsc, unicode, 0)) {
+            ProxyGetGlyphBitmap(&dsc, nullptr);
+        }
+    }
+    ESP_LOGI(TAG, "Pre-warmed %zu glyphs into PSRAM", cache->entries.size());
+}
+
+}  // namespace
+
+const lv_font_t* Wrap(const lv_font_t* font, size_t max_entries) {
+    if (font == nullptr || font->get_glyph_bitmap == nullptr ||
+        heap_caps_get_free_size(MALLOC_CAP_SPIRAM) == 0) {
+        return font;
+    }
+
+    auto cache = new CacheData();
+    cache->real = font;
+    cache->max_entries = max_entries;
+    // 整个结构体拷过来，行高、基线、fallback 链都保持不变
+    cache->proxy = *font;
+    cache->proxy.get_glyph_dsc = ProxyGetGlyphDsc;
+    cache->proxy.get_glyph_bitmap = ProxyGetGlyphBitmap;
+    cache->proxy.user_data = cache;
+
+    Prewarm(cache);
+    return &cache->proxy;
+}
+
+}  // namespace glyph_cache
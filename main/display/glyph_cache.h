@@ -0,0 +1,18 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <lvgl.h>
+
+namespace glyph_cache {
+
+// 给位图字体包一层 PSRAM 字形缓存的代理字体
+// Returns a proxy font that serves glyph bitmaps from a PSRAM-backed
+// LRU cache instead of re-reading them from the memory-mapped flash
+// font on every draw. The most frequent hanzi plus ASCII are pre-warmed
+// at wrap time so chat text layout cost is flat from the first frame.
+// Falls back to the original font untouched when PSRAM is unavailable.
+const lv_font_t* Wrap(const lv_font_t* font, size_t max_entries);
+
+}  // namespace glyph_cache
+
+#endif // GLYPH_CACHE_H
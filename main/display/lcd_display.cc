@@ -1,7 +1,17 @@
 #include "lcd_display.h"
-
+#include "boot_profiler.h"
+#include "glyph_cache.h"
+#include "memory_budget.h"
+#include "sched_profile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
 #include <vector>
+#include <string>
+#include <sys/time.h>
 #include <font_awesome_symbols.h>
+#include <esp_heap_caps.h>
 #include <esp_log.h>
 #include <esp_err.h>
 #include <esp_lvgl_port.h>
@@ -13,18 +23,39 @@
 
 LV_FONT_DECLARE(font_awesome_30_4);
 
+// 多行并成一次 draw_bitmap：esp_lcd 在单次传输内部用 DMA 描述符链搬完
+// 整个区域，逐行循环时每行都要付一次事务建立（CS、命令字、队列往返），
+// 40MHz SPI 下小区域刷新约三分之一的时间耗在这上面，开机白屏肉眼可见
+static void FillPanel(esp_lcd_panel_handle_t panel, int width, int height, uint16_t color) {
+    const int chunk_lines = 40;
+    int lines = std::min(chunk_lines, height);
+    uint16_t* buffer = (uint16_t*)heap_caps_malloc((size_t)width * lines * sizeof(uint16_t),
+        MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    if (buffer == nullptr) {
+        // 内部 DMA 堆吃紧就退回逐行，慢但一定能成
+        std::vector<uint16_t> row(width, color);
+        for (int y = 0; y < height; y++) {
+            esp_lcd_panel_draw_bitmap(panel, 0, y, width, y + 1, row.data());
+        }
+        return;
+    }
+    std::fill_n(buffer, (size_t)width * lines, color);
+    for (int y = 0; y < height; y += lines) {
+        int n = std::min(lines, height - y);
+        esp_lcd_panel_draw_bitmap(panel, 0, y, width, y + n, buffer);
+    }
+    heap_caps_free(buffer);
+}
+
 SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel,
                            int width, int height, int offset_x, int offset_y, bool mirror_x, bool mirror_y, bool swap_xy,
-                           DisplayFonts fonts)
+                           DisplayFonts fonts, LcdBufferConfig buffer_config)
     : LcdDisplay(panel_io, panel, fonts) {
     width_ = width;
     height_ = height;
 
     // draw white
-    std::vector<uint16_t> buffer(width_, 0xFFFF);
-    for (int y = 0; y < height_; y++) {
-        esp_lcd_panel_draw_bitmap(panel_, 0, y, width_, y + 1, buffer.data());
-    }
+    FillPanel(panel_, width_, height_, 0xFFFF);
 
     // Set the display to on
     ESP_LOGI(TAG, "Turning display on");
@@ -35,17 +66,36 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
 
     ESP_LOGI(TAG, "Initialize LVGL port");
     lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
-    port_cfg.task_priority = 1;
+    // 渲染任务的优先级/亲和按调度档案走，和音频链的摆放一起定
+    port_cfg.task_priority = sched_profile::Current().lvgl_priority;
+    port_cfg.task_affinity = sched_profile::LvglAffinity(sched_profile::Current().lvgl_core);
     lvgl_port_init(&port_cfg);
 
     ESP_LOGI(TAG, "Adding LCD screen");
+    // 默认双缓冲：LVGL 在一块缓冲上渲染时 DMA 传输另一块，单缓冲时两者串行。
+    // full_frame_psram 把整帧放进 PSRAM 走 direct mode，DMA 按 trans_lines 分段搬运
+    bool full_frame = buffer_config.full_frame_psram;
+    if (full_frame) {
+        // 整帧（双缓冲则两份）先过 PSRAM 预算：批不下来退回行缓冲，
+        // 屏幕照常点亮，只是少了 direct mode 的顺滑——比把预算留给
+        // 唤醒模型的板子开机回环强
+        size_t frame_bytes = (size_t)width_ * height_ * sizeof(uint16_t)
+            * (buffer_config.double_buffer ? 2 : 1);
+        if (!memory_budget::Claim("lvgl_frame", frame_bytes)) {
+            ESP_LOGW(TAG, "PSRAM budget denied full-frame buffer, using line buffers");
+            full_frame = false;
+        }
+    }
+    uint32_t buffer_size = full_frame
+        ? static_cast<uint32_t>(width_ * height_)
+        : static_cast<uint32_t>(width_) * buffer_config.buffer_lines;
     const lvgl_port_display_cfg_t display_cfg = {
         .io_handle = panel_io_,
         .panel_handle = panel_,
         .control_handle = nullptr,
-        .buffer_size = static_cast<uint32_t>(width_ * 10),
-        .double_buffer = false,
-        .trans_size = 0,
+        .buffer_size = buffer_size,
+        .double_buffer = buffer_config.double_buffer,
+        .trans_size = full_frame ? static_cast<uint32_t>(width_) * buffer_config.trans_lines : 0,
         .hres = static_cast<uint32_t>(width_),
         .vres = static_cast<uint32_t>(height_),
         .monochrome = false,
@@ -56,12 +106,12 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         },
         .color_format = LV_COLOR_FORMAT_RGB565,
         .flags = {
-            .buff_dma = 1,
-            .buff_spiram = 0,
+            .buff_dma = full_frame ? 0u : 1u,
+            .buff_spiram = full_frame ? 1u : 0u,
             .sw_rotate = 0,
             .swap_bytes = 1,
             .full_refresh = 0,
-            .direct_mode = 0,
+            .direct_mode = full_frame ? 1u : 0u,
         },
     };
 
@@ -75,6 +125,7 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         lv_display_set_offset(display_, offset_x, offset_y);
     }
 
+    AttachRenderStats();
     SetupUI();
 }
 
@@ -88,17 +139,16 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
     height_ = height;
     
     // draw white
-    std::vector<uint16_t> buffer(width_, 0xFFFF);
-    for (int y = 0; y < height_; y++) {
-        esp_lcd_panel_draw_bitmap(panel_, 0, y, width_, y + 1, buffer.data());
-    }
+    FillPanel(panel_, width_, height_, 0xFFFF);
 
     ESP_LOGI(TAG, "Initialize LVGL library");
     lv_init();
 
     ESP_LOGI(TAG, "Initialize LVGL port");
     lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
-    port_cfg.task_priority = 1;
+    // 渲染任务的优先级/亲和按调度档案走，和音频链的摆放一起定
+    port_cfg.task_priority = sched_profile::Current().lvgl_priority;
+    port_cfg.task_affinity = sched_profile::LvglAffinity(sched_profile::Current().lvgl_core);
     lvgl_port_init(&port_cfg);
 
     ESP_LOGI(TAG, "Adding LCD screen");
@@ -117,7 +167,10 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         .flags = {
             .buff_dma = 1,
             .swap_bytes = 0,
-            .full_refresh = 1,
+            // 关掉 full_refresh，走 direct mode 的脏区刷新：
+            // 流式字幕只改聊天文本和状态栏时，LVGL 只重画并回传这几块区域，
+            // 整屏切换时脏区自然覆盖全屏，等价于原来的整帧刷新
+            .full_refresh = 0,
             .direct_mode = 1,
         },
     };
@@ -139,6 +192,7 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         lv_display_set_offset(display_, offset_x, offset_y);
     }
 
+    AttachRenderStats();
     SetupUI();
 }
 
@@ -166,6 +220,224 @@ LcdDisplay::~LcdDisplay() {
     if (panel_io_ != nullptr) {
         esp_lcd_panel_io_del(panel_io_);
     }
+    if (sleep_snapshot_ != nullptr) {
+        heap_caps_free(sleep_snapshot_);
+    }
+    if (ambient_timer_ != nullptr) {
+        esp_timer_stop(ambient_timer_);
+        esp_timer_delete(ambient_timer_);
+    }
+    if (ambient_glyphs_ != nullptr) {
+        heap_caps_free(ambient_glyphs_);
+    }
+    if (ambient_compose_ != nullptr) {
+        heap_caps_free(ambient_compose_);
+    }
+}
+
+void LcdDisplay::SnapshotForSleep() {
+    if (panel_ == nullptr || width_ <= 0 || height_ <= 0) {
+        return;
+    }
+    size_t size = (size_t)width_ * height_ * sizeof(uint16_t);
+    if (sleep_snapshot_ == nullptr) {
+        sleep_snapshot_ = (uint16_t*)heap_caps_malloc(size,
+            MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (sleep_snapshot_ == nullptr) {
+            ESP_LOGW(TAG, "No PSRAM for sleep snapshot, wake will redraw");
+            return;
+        }
+    }
+    // 从控件树现渲染一帧进快照缓冲（不依赖面板 GRAM，断电也留得住）
+    lv_draw_buf_t draw_buf;
+    lv_draw_buf_init(&draw_buf, width_, height_, LV_COLOR_FORMAT_RGB565,
+        width_ * sizeof(uint16_t), sleep_snapshot_, size);
+    DisplayLockGuard lock(this);
+    if (lv_snapshot_take_to_draw_buf(lv_screen_active(),
+            LV_COLOR_FORMAT_RGB565, &draw_buf) != LV_RESULT_OK) {
+        ESP_LOGW(TAG, "Snapshot render failed, wake will redraw");
+        heap_caps_free(sleep_snapshot_);
+        sleep_snapshot_ = nullptr;
+        return;
+    }
+    // flush 路径的字节序交换在 lvgl_port 里做，回灌直写面板，
+    // 趁现在不赶时间先换好，唤醒那一下就是纯 DMA
+    for (size_t i = 0; i < (size_t)width_ * height_; i++) {
+        sleep_snapshot_[i] = __builtin_bswap16(sleep_snapshot_[i]);
+    }
+}
+
+void LcdDisplay::RestoreFromSleep() {
+    if (sleep_snapshot_ == nullptr) {
+        return;
+    }
+    // 按块回灌，单个事务别顶 SPI 总线 max_transfer_sz 的限制
+    const int chunk_lines = 40;
+    for (int y = 0; y < height_; y += chunk_lines) {
+        int lines = std::min(chunk_lines, height_ - y);
+        esp_lcd_panel_draw_bitmap(panel_, 0, y, width_, y + lines,
+            sleep_snapshot_ + (size_t)y * width_);
+    }
+    heap_caps_free(sleep_snapshot_);
+    sleep_snapshot_ = nullptr;
+}
+
+// 在一块不加载的屏上逐个渲染 0-9 和冒号的字模，快照进 PSRAM 条带
+//（统一格宽、面板字节序）。只在首次进常亮表盘时做一次，之后每分钟
+// 的更新纯粹是 memcpy 拼装 + 一次 draw_bitmap
+bool LcdDisplay::RenderAmbientGlyphs() {
+    if (ambient_glyphs_ != nullptr) {
+        return true;
+    }
+    static const char* kGlyphChars[11] = {
+        "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", ":"
+    };
+    DisplayLockGuard lock(this);
+    lv_obj_t* screen = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(screen, lv_color_black(), 0);
+    lv_obj_t* label = lv_label_create(screen);
+    lv_obj_set_style_text_font(label, fonts_.text_font, 0);
+    lv_obj_set_style_text_color(label, lv_color_white(), 0);
+    lv_obj_set_style_bg_color(label, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(label, LV_OPA_COVER, 0);
+
+    ambient_cell_h_ = lv_font_get_line_height(fonts_.text_font);
+    ambient_cell_w_ = 0;
+    for (int i = 0; i < 11; i++) {
+        lv_label_set_text(label, kGlyphChars[i]);
+        lv_obj_update_layout(label);
+        ambient_glyph_w_[i] = lv_obj_get_width(label);
+        ambient_cell_w_ = std::max(ambient_cell_w_, ambient_glyph_w_[i]);
+    }
+
+    size_t cell_pixels = (size_t)ambient_cell_w_ * ambient_cell_h_;
+    ambient_glyphs_ = (uint16_t*)heap_caps_malloc(11 * cell_pixels * sizeof(uint16_t),
+        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ambient_compose_ = (uint16_t*)heap_caps_malloc(5 * cell_pixels * sizeof(uint16_t),
+        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (ambient_glyphs_ == nullptr || ambient_compose_ == nullptr) {
+        ESP_LOGW(TAG, "No PSRAM for ambient clock glyphs");
+        if (ambient_glyphs_ != nullptr) {
+            heap_caps_free(ambient_glyphs_);
+            ambient_glyphs_ = nullptr;
+        }
+        lv_obj_del(screen);
+        return false;
+    }
+    memset(ambient_glyphs_, 0, 11 * cell_pixels * sizeof(uint16_t));
+
+    bool ok = true;
+    for (int i = 0; i < 11 && ok; i++) {
+        lv_label_set_text(label, kGlyphChars[i]);
+        lv_obj_update_layout(label);
+        lv_draw_buf_t draw_buf;
+        lv_draw_buf_init(&draw_buf, ambient_glyph_w_[i], ambient_cell_h_,
+            LV_COLOR_FORMAT_RGB565, ambient_cell_w_ * sizeof(uint16_t),
+            ambient_glyphs_ + i * cell_pixels, cell_pixels * sizeof(uint16_t));
+        ok = lv_snapshot_take_to_draw_buf(label, LV_COLOR_FORMAT_RGB565,
+            &draw_buf) == LV_RESULT_OK;
+    }
+    lv_obj_del(screen);
+    if (!ok) {
+        ESP_LOGW(TAG, "Ambient glyph render failed");
+        heap_caps_free(ambient_glyphs_);
+        ambient_glyphs_ = nullptr;
+        heap_caps_free(ambient_compose_);
+        ambient_compose_ = nullptr;
+        return false;
+    }
+    // 跟休眠快照同一个道理：flush 路径的字节序交换在 lvgl_port 里，
+    // 直写面板要自己换，趁渲染这一次换好
+    for (size_t i = 0; i < 11 * cell_pixels; i++) {
+        ambient_glyphs_[i] = __builtin_bswap16(ambient_glyphs_[i]);
+    }
+    return true;
+}
+
+void LcdDisplay::BlitAmbientClock() {
+    if (!ambient_active_ || ambient_glyphs_ == nullptr) {
+        return;
+    }
+    time_t now = time(NULL);
+    char text[8];
+    strftime(text, sizeof(text), "%H:%M", localtime(&now));
+    if (strcmp(text, ambient_shown_) == 0) {
+        return;
+    }
+    strcpy(ambient_shown_, text);
+
+    // 固定 5 格宽的区域居中拼装：区域不随比例字宽变化，上一分钟的
+    // 残影被黑底一起盖掉
+    int region_w = 5 * ambient_cell_w_;
+    int text_w = 0;
+    for (int i = 0; text[i] != '\0'; i++) {
+        text_w += ambient_glyph_w_[text[i] == ':' ? 10 : text[i] - '0'];
+    }
+    memset(ambient_compose_, 0, (size_t)region_w * ambient_cell_h_ * sizeof(uint16_t));
+    int x = (region_w - text_w) / 2;
+    size_t cell_pixels = (size_t)ambient_cell_w_ * ambient_cell_h_;
+    for (int i = 0; text[i] != '\0'; i++) {
+        int glyph = text[i] == ':' ? 10 : text[i] - '0';
+        for (int y = 0; y < ambient_cell_h_; y++) {
+            memcpy(ambient_compose_ + (size_t)y * region_w + x,
+                ambient_glyphs_ + glyph * cell_pixels + (size_t)y * ambient_cell_w_,
+                ambient_glyph_w_[glyph] * sizeof(uint16_t));
+        }
+        x += ambient_glyph_w_[glyph];
+    }
+    int px = (width_ - region_w) / 2;
+    int py = (height_ - ambient_cell_h_) / 2;
+    esp_lcd_panel_draw_bitmap(panel_, px, py, px + region_w, py + ambient_cell_h_,
+        ambient_compose_);
+}
+
+void LcdDisplay::ArmAmbientTimer() {
+    // 对齐到下一个整分，留 100ms 余量跨过分钟边界
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    uint64_t us_into_minute = (uint64_t)(tv.tv_sec % 60) * 1000000 + tv.tv_usec;
+    esp_timer_start_once(ambient_timer_, 60000000 - us_into_minute + 100000);
+}
+
+void LcdDisplay::SetAmbientClock(bool enable) {
+    if (enable == ambient_active_ || panel_ == nullptr) {
+        return;
+    }
+    if (enable) {
+        if (!RenderAmbientGlyphs()) {
+            return;  // 没资源就维持普通表盘
+        }
+        if (ambient_timer_ == nullptr) {
+            esp_timer_create_args_t timer_args = {
+                .callback = [](void* arg) {
+                    auto self = (LcdDisplay*)arg;
+                    self->BlitAmbientClock();
+                    if (self->ambient_active_) {
+                        self->ArmAmbientTimer();
+                    }
+                },
+                .arg = this,
+                .dispatch_method = ESP_TIMER_TASK,
+                .name = "ambient_clock",
+                .skip_unhandled_events = true,
+            };
+            ESP_ERROR_CHECK(esp_timer_create(&timer_args, &ambient_timer_));
+        }
+        ambient_active_ = true;
+        SetRenderSuspended(true);
+        // 黑底清屏：表盘以外什么都不留
+        FillPanel(panel_, width_, height_, 0);
+        ambient_shown_[0] = '\0';
+        BlitAmbientClock();
+        ArmAmbientTimer();
+        ESP_LOGI(TAG, "Ambient clock on, cell %dx%d", ambient_cell_w_, ambient_cell_h_);
+    } else {
+        // 先落旗再停表：esp_timer 任务上可能正跑着一次更新，多贴的
+        // 一帧会被接下来的整屏补帧盖掉
+        ambient_active_ = false;
+        esp_timer_stop(ambient_timer_);
+        SetRenderSuspended(false);
+    }
 }
 
 bool LcdDisplay::Lock(int timeout_ms) {
@@ -176,8 +448,48 @@ void LcdDisplay::Unlock() {
     lvgl_port_unlock();
 }
 
+// “预编译主题”：LCD 板的控件样式编译期就定了，这里做成共享的
+// lv_style_t，一次 init 之后挂对象只是存个指针。原来逐 widget 的
+// lv_obj_set_style_* 每条属性都在对象本地样式表里分配条目并触发
+// 一轮样式重算，SetupUI 十几个控件乘几条属性全摊在启动路径上，
+// 跑起来之后每条聊天记录还要再付一次
+static lv_style_t style_flat;        // 无圆角无边框无内边距的容器
+static lv_style_t style_status_bar;  // 状态栏：两侧 2px，列距 0
+static lv_style_t style_chat_entry;  // 聊天 label：居中对齐
+static bool styles_ready = false;
+
+static void EnsureStyles() {
+    if (styles_ready) {
+        return;
+    }
+    styles_ready = true;
+    lv_style_init(&style_flat);
+    lv_style_set_radius(&style_flat, 0);
+    lv_style_set_border_width(&style_flat, 0);
+    lv_style_set_pad_all(&style_flat, 0);
+
+    lv_style_init(&style_status_bar);
+    lv_style_set_pad_column(&style_status_bar, 0);
+    lv_style_set_pad_left(&style_status_bar, 2);
+    lv_style_set_pad_right(&style_status_bar, 2);
+
+    lv_style_init(&style_chat_entry);
+    lv_style_set_text_align(&style_chat_entry, LV_TEXT_ALIGN_CENTER);
+}
+
 void LcdDisplay::SetupUI() {
     DisplayLockGuard lock(this);
+    boot_profiler::Begin("setup_ui");
+    EnsureStyles();
+
+    // 建树期间关掉逐属性的样式刷新：每次 set_style/add_style 本来
+    // 都会触发失效和重算，这里整棵树建完统一报一次，SetupUI 从
+    // 每属性一遍变成单遍
+    lv_obj_enable_style_refresh(false);
+
+    // 文本字体包一层 PSRAM 字形缓存：高频字启动时预热，冷僻字走 LRU，
+    // 首次显示生僻汉字不再卡在 lvgl_port 任务里
+    fonts_.text_font = glyph_cache::Wrap(fonts_.text_font, 512);
 
     auto screen = lv_screen_active();
     lv_obj_set_style_text_font(screen, fonts_.text_font, 0);
@@ -187,15 +499,15 @@ void LcdDisplay::SetupUI() {
     container_ = lv_obj_create(screen);
     lv_obj_set_size(container_, LV_HOR_RES, LV_VER_RES);
     lv_obj_set_flex_flow(container_, LV_FLEX_FLOW_COLUMN);
-    lv_obj_set_style_pad_all(container_, 0, 0);
-    lv_obj_set_style_border_width(container_, 0, 0);
+    lv_obj_add_style(container_, &style_flat, 0);
     lv_obj_set_style_pad_row(container_, 0, 0);
 
     /* Status bar */
     status_bar_ = lv_obj_create(container_);
     lv_obj_set_size(status_bar_, LV_HOR_RES, fonts_.text_font->line_height);
-    lv_obj_set_style_radius(status_bar_, 0, 0);
-    
+    lv_obj_add_style(status_bar_, &style_flat, 0);
+    lv_obj_add_style(status_bar_, &style_status_bar, 0);
+
     /* Content */
     content_ = lv_obj_create(container_);
     lv_obj_set_scrollbar_mode(content_, LV_SCROLLBAR_MODE_OFF);
@@ -210,19 +522,23 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_style_text_font(emotion_label_, &font_awesome_30_4, 0);
     lv_label_set_text(emotion_label_, FONT_AWESOME_AI_CHIP);
 
-    chat_message_label_ = lv_label_create(content_);
-    lv_label_set_text(chat_message_label_, "");
-    lv_obj_set_width(chat_message_label_, LV_HOR_RES * 0.9); // 限制宽度为屏幕宽度的 90%
-    lv_label_set_long_mode(chat_message_label_, LV_LABEL_LONG_WRAP); // 设置为自动换行模式
-    lv_obj_set_style_text_align(chat_message_label_, LV_TEXT_ALIGN_CENTER, 0); // 设置文本居中对齐
+    /* 滚动消息历史：已经定稿的消息各占一个 label，后续更新只碰
+       末尾一条——长对话不再整段重排，CJK 段落的全量 re-layout 是
+       渲染 trace 里最长的一项 */
+    chat_history_ = lv_obj_create(content_);
+    lv_obj_set_width(chat_history_, LV_HOR_RES);
+    lv_obj_set_flex_grow(chat_history_, 1);
+    lv_obj_add_style(chat_history_, &style_flat, 0);
+    lv_obj_set_style_bg_opa(chat_history_, LV_OPA_TRANSP, 0);
+    lv_obj_set_flex_flow(chat_history_, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_flex_align(chat_history_, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+    lv_obj_set_scrollbar_mode(chat_history_, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_set_scroll_dir(chat_history_, LV_DIR_VER);
+
+    chat_message_label_ = NewChatEntry();
 
     /* Status bar */
     lv_obj_set_flex_flow(status_bar_, LV_FLEX_FLOW_ROW);
-    lv_obj_set_style_pad_all(status_bar_, 0, 0);
-    lv_obj_set_style_border_width(status_bar_, 0, 0);
-    lv_obj_set_style_pad_column(status_bar_, 0, 0);
-    lv_obj_set_style_pad_left(status_bar_, 2, 0);
-    lv_obj_set_style_pad_right(status_bar_, 2, 0);
 
     network_label_ = lv_label_create(status_bar_);
     lv_label_set_text(network_label_, "");
@@ -258,55 +574,151 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_style_text_color(low_battery_label, lv_color_white(), 0);
     lv_obj_center(low_battery_label);
     lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
+
+    // 恢复样式刷新并对整棵树做一次性的重算
+    lv_obj_enable_style_refresh(true);
+    lv_obj_report_style_change(NULL);
+    boot_profiler::End("setup_ui");
+
+    PrewarmEmotions();
 }
 
-void LcdDisplay::SetEmotion(const char* emotion) {
-    struct Emotion {
-        const char* icon;
-        const char* text;
-    };
+struct Emotion {
+    const char* icon;
+    const char* text;
+};
+
+static const std::vector<Emotion> emotions = {
+    {"😶", "neutral"},
+    {"🙂", "happy"},
+    {"😆", "laughing"},
+    {"😂", "funny"},
+    {"😔", "sad"},
+    {"😠", "angry"},
+    {"😭", "crying"},
+    {"😍", "loving"},
+    {"😳", "embarrassed"},
+    {"😯", "surprised"},
+    {"😱", "shocked"},
+    {"🤔", "thinking"},
+    {"😉", "winking"},
+    {"😎", "cool"},
+    {"😌", "relaxed"},
+    {"🤤", "delicious"},
+    {"😘", "kissy"},
+    {"😏", "confident"},
+    {"😴", "sleepy"},
+    {"😜", "silly"},
+    {"🙄", "confused"}
+};
+
+void LcdDisplay::PrewarmEmotions() {
+    // 把所有表情字形的描述符在启动时各摸一遍，字体内部的索引、
+    // 行高等懒初始化都在这里做完，第一次换表情不再额外付出
+    for (const auto& emotion : emotions) {
+        const uint8_t* p = (const uint8_t*)emotion.icon;
+        uint32_t unicode = 0;
+        if ((p[0] & 0xF8) == 0xF0) {
+            unicode = ((p[0] & 0x07) << 18) | ((p[1] & 0x3F) << 12) |
+                      ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+        } else if ((p[0] & 0xF0) == 0xE0) {
+            unicode = ((p[0] & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+        }
+        if (unicode != 0) {
+            lv_font_glyph_dsc_t dsc;
+            lv_font_get_glyph_dsc(fonts_.emoji_font, &dsc, unicode, 0);
+        }
+    }
+}
 
-    static const std::vector<Emotion> emotions = {
-        {"😶", "neutral"},
-        {"🙂", "happy"},
-        {"😆", "laughing"},
-        {"😂", "funny"},
-        {"😔", "sad"},
-        {"😠", "angry"},
-        {"😭", "crying"},
-        {"😍", "loving"},
-        {"😳", "embarrassed"},
-        {"😯", "surprised"},
-        {"😱", "shocked"},
-        {"🤔", "thinking"},
-        {"😉", "winking"},
-        {"😎", "cool"},
-        {"😌", "relaxed"},
-        {"🤤", "delicious"},
-        {"😘", "kissy"},
-        {"😏", "confident"},
-        {"😴", "sleepy"},
-        {"😜", "silly"},
-        {"🙄", "confused"}
-    };
-    
+void LcdDisplay::UpdateEmotion(const char* emotion) {
     // 查找匹配的表情
     std::string_view emotion_view(emotion);
     auto it = std::find_if(emotions.begin(), emotions.end(),
         [&emotion_view](const Emotion& e) { return e.text == emotion_view; });
+    const char* icon = it != emotions.end() ? it->icon : "😶";
 
     DisplayLockGuard lock(this);
     if (emotion_label_ == nullptr) {
         return;
     }
 
+    // LLM 几乎每条回复都带 emotion，且多数时候没变：
+    // 相同表情直接返回，不触发布局和脏区重绘
+    if (current_emotion_icon_ == icon) {
+        return;
+    }
+    current_emotion_icon_ = icon;
+
     // 如果找到匹配的表情就显示对应图标，否则显示默认的neutral表情
     lv_obj_set_style_text_font(emotion_label_, fonts_.emoji_font, 0);
-    if (it != emotions.end()) {
-        lv_label_set_text(emotion_label_, it->icon);
-    } else {
-        lv_label_set_text(emotion_label_, "😶");
+    lv_label_set_text(emotion_label_, icon);
+}
+
+// 消息历史的上限：超出就删最早的一条，label 连同文本一起释放
+static constexpr uint32_t kMaxChatHistory = 8;
+
+lv_obj_t* LcdDisplay::NewChatEntry() {
+    while (lv_obj_get_child_count(chat_history_) >= kMaxChatHistory) {
+        lv_obj_del(lv_obj_get_child(chat_history_, 0));
+    }
+    auto label = lv_label_create(chat_history_);
+    lv_label_set_text(label, "");
+    lv_obj_set_width(label, LV_HOR_RES * 0.9); // 限制宽度为屏幕宽度的 90%
+    lv_label_set_long_mode(label, LV_LABEL_LONG_WRAP); // 设置为自动换行模式
+    // 共享样式代替逐 label 的本地条目：长对话滚动时不再每条消息
+    // 都往 LVGL 堆里塞一份居中对齐
+    lv_obj_add_style(label, &style_chat_entry, 0);
+    // 板级代码按老习惯只给 chat_message_label_ 上色（深色主题的板子），
+    // 新的尾巴从上一条把文字颜色抄过来，样式跟着链传下去
+    if (chat_message_label_ != nullptr) {
+        lv_obj_set_style_text_color(label, lv_obj_get_style_text_color(chat_message_label_, 0), 0);
+    }
+    return label;
+}
+
+void LcdDisplay::SetChatMessageLocked(const char* role, const char* content) {
+    if (content == nullptr || content[0] == '\0') {
+        // 空串保持原来的清屏语义：历史一并清掉
+        lv_obj_clean(chat_history_);
+        chat_message_label_ = NewChatEntry();
+        chat_tail_role_.clear();
+        return;
+    }
+    // 尾巴上已有内容就先定稿成历史，新消息从一个空 label 开始
+    if (lv_label_get_text(chat_message_label_)[0] != '\0') {
+        chat_message_label_ = NewChatEntry();
+    }
+    chat_tail_role_ = role != nullptr ? role : "";
+    lv_label_set_text(chat_message_label_, content);
+    lv_obj_scroll_to_view(chat_message_label_, LV_ANIM_OFF);
+}
+
+void LcdDisplay::UpdateChatMessage(const char* role, const char* content) {
+    DisplayLockGuard lock(this);
+    if (chat_history_ == nullptr) {
+        return;
+    }
+    SetChatMessageLocked(role, content);
+}
+
+void LcdDisplay::UpdateChatAppend(const char* role, const char* content) {
+    DisplayLockGuard lock(this);
+    if (chat_history_ == nullptr || content == nullptr || content[0] == '\0') {
+        return;
+    }
+    // 角色换了或尾巴还是空的，按新消息处理
+    if (chat_tail_role_ != (role != nullptr ? role : "") ||
+        lv_label_get_text(chat_message_label_)[0] == '\0') {
+        SetChatMessageLocked(role, content);
+        return;
     }
+    // 同一条回复的下一句：只插入新增的文本段，已显示的句子留在原位，
+    // 历史里的 label 一个都不碰
+    std::string run = "\n";
+    run += content;
+    lv_label_ins_text(chat_message_label_, LV_LABEL_POS_LAST, run.c_str());
+    lv_obj_scroll_to_view(chat_message_label_, LV_ANIM_OFF);
 }
 
 void LcdDisplay::SetIcon(const char* icon) {
@@ -314,6 +726,8 @@ void LcdDisplay::SetIcon(const char* icon) {
     if (emotion_label_ == nullptr) {
         return;
     }
+    // 图标接管了表情 label，下一次 SetEmotion 必须重设字体和文本
+    current_emotion_icon_ = nullptr;
     lv_obj_set_style_text_font(emotion_label_, &font_awesome_30_4, 0);
     lv_label_set_text(emotion_label_, icon);
 }
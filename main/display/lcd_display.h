@@ -8,6 +8,7 @@
 #include <font_emoji.h>
 
 #include <atomic>
+#include <string>
 
 class LcdDisplay : public Display {
 protected:
@@ -19,10 +20,36 @@ protected:
     lv_obj_t* content_ = nullptr;
     lv_obj_t* container_ = nullptr;
     lv_obj_t* side_bar_ = nullptr;
+    // 滚动消息历史：每条消息一个独立 label，定稿后不再改动，
+    // chat_message_label_ 始终指向正在更新的末尾一条
+    lv_obj_t* chat_history_ = nullptr;
+    std::string chat_tail_role_;
 
     DisplayFonts fonts_;
+    // 当前表情图标（指向静态表），用来跳过重复的 SetEmotion
+    const char* current_emotion_icon_ = nullptr;
+    // 休眠快照（PSRAM，面板字节序），RestoreFromSleep 用完即还
+    uint16_t* sleep_snapshot_ = nullptr;
+
+    // 常亮表盘：0-9 和冒号的字模条（PSRAM，面板字节序）+ 拼装缓冲，
+    // 每分钟拼五个字模、一次 draw_bitmap 贴上去
+    uint16_t* ambient_glyphs_ = nullptr;
+    uint16_t* ambient_compose_ = nullptr;
+    int ambient_cell_w_ = 0;
+    int ambient_cell_h_ = 0;
+    int ambient_glyph_w_[11] = {};
+    bool ambient_active_ = false;
+    char ambient_shown_[8] = {};
+    esp_timer_handle_t ambient_timer_ = nullptr;
+
+    bool RenderAmbientGlyphs();
+    void BlitAmbientClock();
+    void ArmAmbientTimer();
 
     virtual void SetupUI();
+    void PrewarmEmotions();
+    lv_obj_t* NewChatEntry();
+    void SetChatMessageLocked(const char* role, const char* content);
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
 
@@ -33,8 +60,15 @@ protected:
     
 public:
     ~LcdDisplay();
-    virtual void SetEmotion(const char* emotion) override;
     virtual void SetIcon(const char* icon) override;
+    virtual void SnapshotForSleep() override;
+    virtual void RestoreFromSleep() override;
+    virtual void SetAmbientClock(bool enable) override;
+
+protected:
+    virtual void UpdateEmotion(const char* emotion) override;
+    virtual void UpdateChatMessage(const char* role, const char* content) override;
+    virtual void UpdateChatAppend(const char* role, const char* content) override;
 };
 
 // RGB LCD显示器
@@ -55,13 +89,21 @@ public:
                    DisplayFonts fonts);
 };
 
+// SPI 屏渲染缓冲配置，板级代码可以按屏幕大小和 PSRAM 情况覆盖默认值
+struct LcdBufferConfig {
+    uint32_t buffer_lines = 10;     // 每个渲染缓冲的行数
+    bool double_buffer = true;      // 双缓冲让 LVGL 渲染和 SPI DMA 传输重叠
+    uint32_t trans_lines = 10;      // PSRAM 整帧模式下单次 DMA 事务的行数
+    bool full_frame_psram = false;  // PSRAM 整帧缓冲 + direct mode，适合八线 PSRAM 的板子
+};
+
 // // SPI LCD显示器
 class SpiLcdDisplay : public LcdDisplay {
 public:
     SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel,
                   int width, int height, int offset_x, int offset_y,
                   bool mirror_x, bool mirror_y, bool swap_xy,
-                  DisplayFonts fonts);
+                  DisplayFonts fonts, LcdBufferConfig buffer_config = {});
 };
 
 // QSPI LCD显示器
@@ -1,12 +1,15 @@
 #include "oled_display.h"
 #include "font_awesome_symbols.h"
+#include "sched_profile.h"
 #include "assets/lang_config.h"
 
 #include <string>
+#include <cstring>
 #include <algorithm>
 
 #include <esp_log.h>
 #include <esp_err.h>
+#include <esp_heap_caps.h>
 #include <esp_lvgl_port.h>
 
 #define TAG "OledDisplay"
@@ -21,7 +24,9 @@ OledDisplay::OledDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handl
 
     ESP_LOGI(TAG, "Initialize LVGL");
     lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
-    port_cfg.task_priority = 1;
+    // 渲染任务的优先级/亲和按调度档案走，和音频链的摆放一起定
+    port_cfg.task_priority = sched_profile::Current().lvgl_priority;
+    port_cfg.task_affinity = sched_profile::LvglAffinity(sched_profile::Current().lvgl_core);
     lvgl_port_init(&port_cfg);
 
     ESP_LOGI(TAG, "Adding LCD screen");
@@ -55,6 +60,21 @@ OledDisplay::OledDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handl
         return;
     }
 
+    // 页差分刷新：接管 flush 回调，只把和上一帧不同的 8 像素页发上
+    // I2C 总线。典型的聊天更新只动不到 30% 的面板，共享总线的板子
+    // 还能把省下的总线时间让给 codec 的控制通道
+    size_t page_bytes = width_ * height_ / 8;
+    page_buffer_ = (uint8_t*)heap_caps_calloc(1, page_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    last_frame_ = (uint8_t*)heap_caps_calloc(1, page_bytes, MALLOC_CAP_INTERNAL);
+    if (page_buffer_ != nullptr && last_frame_ != nullptr) {
+        lv_display_set_user_data(display_, this);
+        lv_display_set_flush_cb(display_, OnFlush);
+    }
+
+    // FLUSH_START/FINISH 事件由 LVGL 内核在 flush 回调前后发出，
+    // 接管了回调的差分路径一样被统计到
+    AttachRenderStats();
+
     if (height_ == 64) {
         SetupUI_128x64();
     } else {
@@ -62,6 +82,78 @@ OledDisplay::OledDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handl
     }
 }
 
+void OledDisplay::OnFlush(lv_display_t* display, const lv_area_t* area, uint8_t* px_map) {
+    auto self = (OledDisplay*)lv_display_get_user_data(display);
+    self->Flush(area, px_map);
+    lv_display_flush_ready(display);
+}
+
+void OledDisplay::Flush(const lv_area_t* area, uint8_t* px_map) {
+    // LVGL 的 I1 缓冲开头是 8 字节调色板，像素数据在其后
+    px_map += 8;
+    int area_width = area->x2 - area->x1 + 1;
+    int stride = (area_width + 7) / 8;
+
+    // 先把本次渲染的区域转成面板的页格式（1 字节 = 8 个竖向像素），
+    // page_buffer_ 在两次 flush 之间保留，区域外的内容不丢
+    int first_page = area->y1 / 8;
+    int last_page = area->y2 / 8;
+    for (int page = first_page; page <= last_page; page++) {
+        uint8_t* out = &page_buffer_[page * width_];
+        for (int x = area->x1; x <= area->x2; x++) {
+            uint8_t byte = out[x];
+            for (int bit = 0; bit < 8; bit++) {
+                int y = page * 8 + bit;
+                if (y < area->y1 || y > area->y2) {
+                    continue;
+                }
+                int offset = (y - area->y1) * stride + (x - area->x1) / 8;
+                if (px_map[offset] & (0x80 >> ((x - area->x1) % 8))) {
+                    byte |= 1 << bit;
+                } else {
+                    byte &= ~(1 << bit);
+                }
+            }
+            out[x] = byte;
+        }
+    }
+
+    // 和上一帧逐页比对，只发送变化的页。连续的脏页合并成一次
+    // draw_bitmap（page_buffer_ 里各页本来就连续），总线驱动在单次
+    // 传输内部链 DMA 描述符，不用每页付一次事务建立开销
+    int run_start = -1;
+    for (int page = first_page; page <= last_page + 1; page++) {
+        bool dirty = false;
+        if (page <= last_page) {
+            uint8_t* row = &page_buffer_[page * width_];
+            dirty = first_flush_ || memcmp(row, &last_frame_[page * width_], width_) != 0;
+            if (!dirty) {
+                pages_skipped_++;
+            }
+        }
+        if (dirty) {
+            if (run_start < 0) {
+                run_start = page;
+            }
+            continue;
+        }
+        if (run_start >= 0) {
+            esp_lcd_panel_draw_bitmap(panel_, 0, run_start * 8, width_, page * 8,
+                &page_buffer_[run_start * width_]);
+            memcpy(&last_frame_[run_start * width_], &page_buffer_[run_start * width_],
+                (size_t)(page - run_start) * width_);
+            pages_sent_ += page - run_start;
+            run_start = -1;
+        }
+    }
+    first_flush_ = false;
+
+    if (++flush_count_ % 256 == 0) {
+        ESP_LOGI(TAG, "Page diff: sent %lu skipped %lu pages (%lu bytes saved)",
+            pages_sent_, pages_skipped_, pages_skipped_ * width_);
+    }
+}
+
 OledDisplay::~OledDisplay() {
     if (content_ != nullptr) {
         lv_obj_del(content_);
@@ -83,6 +175,13 @@ OledDisplay::~OledDisplay() {
         esp_lcd_panel_io_del(panel_io_);
     }
     lvgl_port_deinit();
+
+    if (page_buffer_ != nullptr) {
+        heap_caps_free(page_buffer_);
+    }
+    if (last_frame_ != nullptr) {
+        heap_caps_free(last_frame_);
+    }
 }
 
 bool OledDisplay::Lock(int timeout_ms) {
@@ -93,7 +192,7 @@ void OledDisplay::Unlock() {
     lvgl_port_unlock();
 }
 
-void OledDisplay::SetChatMessage(const char* role, const char* content) {
+void OledDisplay::UpdateChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
         return;
@@ -115,6 +214,26 @@ void OledDisplay::SetChatMessage(const char* role, const char* content) {
     }
 }
 
+void OledDisplay::UpdateChatAppend(const char* role, const char* content) {
+    // 小屏是单行循环滚动，追加的句子接在后面用空格隔开，换行照旧换成空格
+    std::string content_str = " ";
+    content_str += content;
+    std::replace(content_str.begin(), content_str.end(), '\n', ' ');
+
+    DisplayLockGuard lock(this);
+    if (chat_message_label_ == nullptr) {
+        return;
+    }
+    if (lv_label_get_text(chat_message_label_)[0] == '\0') {
+        lv_label_set_text(chat_message_label_, content_str.c_str() + 1);
+    } else {
+        lv_label_ins_text(chat_message_label_, LV_LABEL_POS_LAST, content_str.c_str());
+    }
+    if (content_right_ != nullptr && content[0] != '\0') {
+        lv_obj_clear_flag(content_right_, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
 void OledDisplay::SetupUI_128x64() {
     DisplayLockGuard lock(this);
 
@@ -20,18 +20,32 @@ private:
 
     DisplayFonts fonts_;
 
+    // 页差分刷新状态：上一帧的页格式缓冲和本帧的转换缓冲，
+    // 只有内容变化的 8 像素页才会走 I2C 发给面板
+    uint8_t* page_buffer_ = nullptr;
+    uint8_t* last_frame_ = nullptr;
+    bool first_flush_ = true;
+    uint32_t pages_sent_ = 0;
+    uint32_t pages_skipped_ = 0;
+    uint32_t flush_count_ = 0;
+
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
 
     void SetupUI_128x64();
     void SetupUI_128x32();
 
+    static void OnFlush(lv_display_t* display, const lv_area_t* area, uint8_t* px_map);
+    void Flush(const lv_area_t* area, uint8_t* px_map);
+
 public:
     OledDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel, int width, int height, bool mirror_x, bool mirror_y,
                 DisplayFonts fonts);
     ~OledDisplay();
 
-    virtual void SetChatMessage(const char* role, const char* content) override;
+protected:
+    virtual void UpdateChatMessage(const char* role, const char* content) override;
+    virtual void UpdateChatAppend(const char* role, const char* content) override;
 };
 
 #endif // OLED_DISPLAY_H
@@ -0,0 +1,173 @@
+#include "event_log.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <cstdio>
+
+#define TAG "EventLog"
+
+namespace event_log {
+
+namespace {
+
+// 16 字节定长记录，环大小 4096 条 = 64KB PSRAM
+struct Record16 {
+    int64_t timestamp_us;
+    uint16_t id;
+    uint16_t a;
+    uint32_t b;
+};
+static_assert(sizeof(Record16) == 16, "record must stay 16 bytes");
+
+constexpr uint32_t kRingSize = 4096;  // 2 的幂，下标用掩码回绕
+
+Record16* ring = nullptr;
+std::atomic<uint32_t> head{0};
+
+const char* IdName(uint16_t id) {
+    switch (id) {
+        case kStateTransition:  return "state";
+        case kChannelOpen:      return "ch_open";
+        case kChannelClose:     return "ch_close";
+        case kNetworkError:     return "net_err";
+        case kChannelOpenFailed: return "ch_fail";
+        case kJitterUnderrun:   return "underrun";
+        case kUplinkDrop:       return "up_drop";
+        case kSegmentEnd:       return "seg_end";
+        case kHeapFragmented:   return "heap_frag";
+        case kHeapReserveSpent: return "heap_reserve";
+        case kCorruptStream:    return "corrupt_stream";
+        default:                return "?";
+    }
+}
+
+// 当前任务的 tid：句柄低 16 位，Perfetto 只要求数值稳定可区分
+uint16_t CurrentTid() {
+    return (uint16_t)(uintptr_t)xTaskGetCurrentTaskHandle();
+}
+
+}  // namespace
+
+void Init() {
+    if (ring != nullptr) {
+        return;
+    }
+    ring = (Record16*)heap_caps_calloc(kRingSize, sizeof(Record16),
+        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (ring == nullptr) {
+        // 没 PSRAM 的板子不抢内部堆，事件环保持关闭
+        ESP_LOGW(TAG, "No PSRAM for event ring, disabled");
+        return;
+    }
+    ESP_LOGI(TAG, "Event ring: %lu records (%u KB PSRAM)",
+        (unsigned long)kRingSize, (unsigned)(kRingSize * sizeof(Record16) / 1024));
+}
+
+void Record(EventId id, uint16_t a, uint32_t b) {
+    if (ring == nullptr) {
+        return;
+    }
+    // 多生产者安全：序号原子领号，槽位独占写。撕裂只可能发生在
+    // 环整整绕了一圈追上正在写的槽时，4096 条的环上可以忽略
+    uint32_t index = head.fetch_add(1, std::memory_order_relaxed) & (kRingSize - 1);
+    auto& record = ring[index];
+    record.timestamp_us = esp_timer_get_time();
+    record.id = id;
+    record.a = a;
+    record.b = b;
+}
+
+void TraceBegin(const char* name) {
+    Record(kTraceBegin, CurrentTid(), (uint32_t)(uintptr_t)name);
+}
+
+void TraceEnd(const char* name) {
+    Record(kTraceEnd, CurrentTid(), (uint32_t)(uintptr_t)name);
+}
+
+void TraceInstant(const char* name) {
+    Record(kTraceInstant, CurrentTid(), (uint32_t)(uintptr_t)name);
+}
+
+std::string DrainJson(size_t max_records) {
+    std::string json = "[";
+    if (ring == nullptr) {
+        return json + "]";
+    }
+    uint32_t end = head.load(std::memory_order_relaxed);
+    uint32_t count = end < kRingSize ? end : kRingSize;
+    if (count > max_records) {
+        count = max_records;
+    }
+    char buffer[96];
+    bool first = true;
+    // 从旧到新
+    for (uint32_t i = end - count; i != end; i++) {
+        auto& record = ring[i & (kRingSize - 1)];
+        if (record.id == 0) {
+            continue;  // 被追上的撕裂槽/未写满的空槽
+        }
+        if (record.id >= kTraceBegin) {
+            continue;  // 打点记录归 DrainPerfettoJson 管，这里不掺
+        }
+        snprintf(buffer, sizeof(buffer),
+            "%s{\"t\":%lld,\"id\":\"%s\",\"a\":%u,\"b\":%lu}",
+            first ? "" : ",", (long long)record.timestamp_us,
+            IdName(record.id), (unsigned)record.a, (unsigned long)record.b);
+        json += buffer;
+        first = false;
+    }
+    json += "]";
+    return json;
+}
+
+std::string DrainPerfettoJson(size_t max_records) {
+    std::string json = "[";
+    if (ring == nullptr) {
+        return json + "]";
+    }
+    uint32_t end = head.load(std::memory_order_relaxed);
+    uint32_t count = end < kRingSize ? end : kRingSize;
+    if (count > max_records) {
+        count = max_records;
+    }
+    char buffer[160];
+    bool first = true;
+    for (uint32_t i = end - count; i != end; i++) {
+        auto& record = ring[i & (kRingSize - 1)];
+        if (record.id == 0) {
+            continue;
+        }
+        if (record.id == kTraceBegin || record.id == kTraceEnd) {
+            snprintf(buffer, sizeof(buffer),
+                "%s{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%lld,\"pid\":0,\"tid\":%u}",
+                first ? "" : ",", (const char*)(uintptr_t)record.b,
+                record.id == kTraceBegin ? "B" : "E",
+                (long long)record.timestamp_us, (unsigned)record.a);
+        } else if (record.id == kTraceInstant) {
+            snprintf(buffer, sizeof(buffer),
+                "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%lld,\"pid\":0,\"tid\":%u}",
+                first ? "" : ",", (const char*)(uintptr_t)record.b,
+                (long long)record.timestamp_us, (unsigned)record.a);
+        } else {
+            // 普通事件降级为即时事件，和打点标在同一条时间线上
+            snprintf(buffer, sizeof(buffer),
+                "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%lld,\"pid\":0,\"tid\":0,"
+                "\"args\":{\"a\":%u,\"b\":%lu}}",
+                first ? "" : ",", IdName(record.id),
+                (long long)record.timestamp_us,
+                (unsigned)record.a, (unsigned long)record.b);
+        }
+        json += buffer;
+        first = false;
+    }
+    json += "]";
+    return json;
+}
+
+}  // namespace event_log
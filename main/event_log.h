@@ -0,0 +1,76 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <cstdint>
+#include <string>
+
+// 常开的二进制事件环
+// 性能相关事件（状态切换、欠载、重连……）原本只走 ESP_LOGI，不插
+// 串口就没了，而且把日志开详细本身就会通过 UART 阻塞扭曲时序。
+// 这里给热路径一个近零成本的记录口：定长 16 字节记录写进 PSRAM 环
+//（微秒时间戳 + 事件 ID + 两个参数，不做任何格式化），服务器通过
+// metrics 消息带 "events":true 按需抽干。与 flight_recorder 分工：
+// 那边是崩溃后的 noinit 黑匣子，这边是活着的时候随时可取的时间线
+namespace event_log {
+
+enum EventId : uint16_t {
+    kStateTransition = 1,  // a = from_state, b = to_state
+    kChannelOpen,          // b = 建链耗时 ms（0 = 未知/复用）
+    kChannelClose,
+    kNetworkError,
+    kChannelOpenFailed,    // a = 连续失败次数
+    kJitterUnderrun,       // b = 本周期新增欠载次数
+    kUplinkDrop,           // b = 本周期新增迟到丢帧数
+    kSegmentEnd,
+    kHeapFragmented,       // a = 最大块占总空闲的百分比, b = 最大块字节数
+    kHeapReserveSpent,
+    kCorruptStream,        // a = 触发自愈时的连续解码失败次数
+    // 作用域打点（见下方 TRACE_* 宏）：a = 任务句柄低 16 位（tid），
+    // b = 名字字面量指针（flash 常驻，导出时反解）
+    kTraceBegin,
+    kTraceEnd,
+    kTraceInstant,
+};
+
+// 分配 PSRAM 环（没有 PSRAM 就保持关闭，Record 变空操作）
+void Init();
+
+// 热路径直呼：一次 ccount 级的时间戳 + 原子序号 + 16 字节写入，
+// 无锁无堆无格式化，生产固件常开
+void Record(EventId id, uint16_t a = 0, uint32_t b = 0);
+
+// 抽干最近 max_records 条为 JSON 数组（服务器按需拉取），
+// 不清环——环自己按覆盖滚动
+std::string DrainJson(size_t max_records = 256);
+
+// 跨任务流程的作用域打点：name 必须是常驻字面量（环里只存指针）。
+// 每次打点就是一条 16 字节环记录，热路径可以放心用
+void TraceBegin(const char* name);
+void TraceEnd(const char* name);
+void TraceInstant(const char* name);
+
+// RAII 作用域，配合 TRACE_SCOPE 宏
+struct TraceScope {
+    explicit TraceScope(const char* name) : name_(name) { TraceBegin(name_); }
+    ~TraceScope() { TraceEnd(name_); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+private:
+    const char* name_;
+};
+
+// 导出为 Perfetto/chrome://tracing 的 Trace Event JSON 数组：
+// B/E 成对还原成火焰图（tid = 任务句柄低 16 位），普通事件降级成
+// 即时事件标在同一条时间线上。服务器通过 metrics 消息带
+// "trace":true 拉取，或贴进 ui.perfetto.dev 直接看
+std::string DrainPerfettoJson(size_t max_records = 1024);
+
+}  // namespace event_log
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+// 作用域打点：TRACE_SCOPE("channel_open") 在当前作用域首尾各落一条记录
+#define TRACE_SCOPE(name) \
+    event_log::TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+#endif  // EVENT_LOG_H
@@ -0,0 +1,141 @@
+#include "fast_resampler.h"
+#include "audio_iram.h"
+#include "pcm_simd.h"
+
+#include <esp_log.h>
+
+#include <cstring>
+
+#define TAG "FastResampler"
+
+namespace {
+
+constexpr int kTaps = FastResampler::kTaps;
+constexpr int kMaxL = 3;
+constexpr double kPi = 3.14159265358979323846;
+
+// 编译期可用的 sin：参数规约到 [-pi, pi] 后泰勒展开到 x^15，
+// 误差远小于 Q15 量化步长
+constexpr double CSin(double x) {
+    while (x > kPi) x -= 2.0 * kPi;
+    while (x < -kPi) x += 2.0 * kPi;
+    double term = x;
+    double sum = x;
+    double x2 = x * x;
+    for (int n = 1; n <= 7; ++n) {
+        term *= -x2 / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double CCos(double x) {
+    return CSin(kPi / 2.0 - x);
+}
+
+constexpr double Sinc(double x) {
+    return x == 0.0 ? 1.0 : CSin(kPi * x) / (kPi * x);
+}
+
+struct RateTable {
+    int input_rate;
+    int output_rate;
+    int l;
+    int m;
+    // 相位主序、抽头反转（见 Process 里的内积方向），PIE 要 16 字节对齐
+    alignas(16) int16_t coef[kMaxL * kTaps];
+};
+
+// 加窗 sinc 原型滤波器按 L 相多相分解：截止取上采样后
+// Nyquist 的 0.9/max(L,M)，Hamming 窗，增益 L 保持幅度
+constexpr RateTable MakeTable(int input_rate, int output_rate, int l, int m) {
+    RateTable table{input_rate, output_rate, l, m, {}};
+    const int n = kTaps * l;
+    const double center = (n - 1) / 2.0;
+    const int lm_max = l > m ? l : m;
+    const double cutoff = 0.9 / lm_max;
+    for (int p = 0; p < l; ++p) {
+        for (int k = 0; k < kTaps; ++k) {
+            const int i = p + k * l;
+            const double window = 0.54 - 0.46 * CCos(2.0 * kPi * i / (n - 1));
+            const double h = l * cutoff * Sinc(cutoff * (i - center)) * window;
+            double q = h * 32768.0 + (h >= 0.0 ? 0.5 : -0.5);
+            if (q > 32767.0) q = 32767.0;
+            if (q < -32768.0) q = -32768.0;
+            table.coef[p * kTaps + (kTaps - 1 - k)] = (int16_t)q;
+        }
+    }
+    return table;
+}
+
+// 输入链（板级 config.h 的采样率 → 16k）和输出链（服务器 hello
+// 的采样率 → 编解码器输出率）实际会出现的组合
+constexpr RateTable kTables[] = {
+    MakeTable(24000, 16000, 2, 3),
+    MakeTable(48000, 16000, 1, 3),
+    MakeTable(16000, 24000, 3, 2),
+    MakeTable(16000, 48000, 3, 1),
+    MakeTable(24000, 48000, 2, 1),
+    MakeTable(48000, 24000, 1, 2),
+};
+
+}  // namespace
+
+void FastResampler::Configure(int input_sample_rate, int output_sample_rate) {
+    for (const auto& table : kTables) {
+        if (table.input_rate == input_sample_rate && table.output_rate == output_sample_rate) {
+            ratio_l_ = table.l;
+            ratio_m_ = table.m;
+            phases_ = table.coef;
+            use_fallback_ = false;
+            memset(history_, 0, sizeof(history_));
+            ESP_LOGI(TAG, "Using polyphase table %d -> %d (L=%d M=%d)",
+                     input_sample_rate, output_sample_rate, ratio_l_, ratio_m_);
+            return;
+        }
+    }
+    ESP_LOGI(TAG, "No table for %d -> %d, falling back to OpusResampler",
+             input_sample_rate, output_sample_rate);
+    use_fallback_ = true;
+    fallback_.Configure(input_sample_rate, output_sample_rate);
+}
+
+int FastResampler::GetOutputSamples(int input_samples) const {
+    if (use_fallback_) {
+        return fallback_.GetOutputSamples(input_samples);
+    }
+    return input_samples * ratio_l_ / ratio_m_;
+}
+
+AUDIO_IRAM_ATTR void FastResampler::Process(const int16_t* input, int input_samples, int16_t* output) {
+    if (use_fallback_) {
+        fallback_.Process(input, input_samples, output);
+        return;
+    }
+
+    // 历史尾巴拼在前面，卷积的负索引不用分支
+    work_.resize(kTaps - 1 + input_samples);
+    memcpy(work_.data(), history_, (kTaps - 1) * sizeof(int16_t));
+    memcpy(work_.data() + kTaps - 1, input, input_samples * sizeof(int16_t));
+
+    const int16_t* x = work_.data();
+    const int out_samples = input_samples * ratio_l_ / ratio_m_;
+    for (int j = 0; j < out_samples; ++j) {
+        const int u = j * ratio_m_;
+        const int phase = u % ratio_l_;
+        const int base = u / ratio_l_;
+        // src[i] 对应输入 base-(kTaps-1)+i，系数已反转，正向内积即卷积
+        int32_t acc = pcm_simd::DotQ15(x + base, phases_ + phase * kTaps, kTaps);
+        acc = (acc + (1 << 14)) >> 15;
+        if (acc > 32767) acc = 32767;
+        if (acc < -32768) acc = -32768;
+        output[j] = (int16_t)acc;
+    }
+
+    if (input_samples >= kTaps - 1) {
+        memcpy(history_, input + input_samples - (kTaps - 1), (kTaps - 1) * sizeof(int16_t));
+    } else {
+        memmove(history_, history_ + input_samples, (kTaps - 1 - input_samples) * sizeof(int16_t));
+        memcpy(history_ + kTaps - 1 - input_samples, input, input_samples * sizeof(int16_t));
+    }
+}
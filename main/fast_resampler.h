@@ -0,0 +1,37 @@
+#ifndef FAST_RESAMPLER_H
+#define FAST_RESAMPLER_H
+
+#include <opus_resampler.h>
+
+#include <cstdint>
+#include <vector>
+
+// 常用采样率对的表驱动多相 FIR 重采样。OpusResampler（silk 内核）
+// 逐采样做系数插值，是输入路径第二热的函数；而我们真正用到的
+// 采样率对就那几个（24k/48k ↔ 16k，见各板 config.h 和服务器 hello），
+// 系数表可以在编译期全部生成。Configure 命中表就走定长 16 抽头的
+// 多相内核，内积用 pcm_simd::DotQ15（S3 上对齐时走 PIE SIMD）；
+// 没命中的罕见采样率原样回退到 OpusResampler，行为不变。
+class FastResampler {
+public:
+    static constexpr int kTaps = 16;
+
+    void Configure(int input_sample_rate, int output_sample_rate);
+    void Process(const int16_t* input, int input_samples, int16_t* output);
+    int GetOutputSamples(int input_samples) const;
+
+private:
+    // 有理比 L/M：每 M 个输入采样产出 L 个输出采样
+    int ratio_l_ = 0;
+    int ratio_m_ = 0;
+    // 相位主序、抽头反转的 Q15 系数（L 行 × kTaps 列），指向编译期表
+    const int16_t* phases_ = nullptr;
+    // 跨 Process 调用保留的输入尾巴，卷积的负索引从这里取
+    int16_t history_[kTaps - 1] = {};
+    std::vector<int16_t> work_;
+
+    OpusResampler fallback_;
+    bool use_fallback_ = false;
+};
+
+#endif // FAST_RESAMPLER_H
@@ -0,0 +1,153 @@
+#include "flight_recorder.h"
+
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#define TAG "FlightRecorder"
+
+namespace flight_recorder {
+
+namespace {
+
+enum RecordType : uint8_t {
+    kRecordState = 1,
+    kRecordSnapshot = 2,
+    kRecordAudio = 3,
+};
+
+// 16 字节定长记录，整个环 96 条共 1.5KB noinit
+struct Record {
+    uint32_t uptime_ms;
+    uint8_t type;
+    uint8_t a;
+    uint16_t b;
+    uint32_t c;
+    uint32_t d;
+};
+
+constexpr size_t kDepth = 96;
+constexpr uint32_t kMagic = 0x464C5954;  // "FLYT"
+
+struct Ring {
+    uint32_t magic;
+    uint32_t head;
+    uint32_t count;
+    Record records[kDepth];
+};
+
+// noinit 段：软件复位和 panic 都不清零，掉电才丢。掉电后内容是
+// 随机的，靠 magic + 字段范围校验识别
+__NOINIT_ATTR Ring ring_;
+
+std::mutex mutex_;
+std::string crash_dump_;
+
+bool RingValid() {
+    return ring_.magic == kMagic && ring_.head < kDepth && ring_.count <= kDepth;
+}
+
+void Append(uint8_t type, uint8_t a, uint16_t b, uint32_t c, uint32_t d) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Record& record = ring_.records[ring_.head];
+    record.uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    record.type = type;
+    record.a = a;
+    record.b = b;
+    record.c = c;
+    record.d = d;
+    ring_.head = (ring_.head + 1) % kDepth;
+    if (ring_.count < kDepth) {
+        ring_.count++;
+    }
+}
+
+const char* ResetReasonString(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_PANIC: return "panic";
+        case ESP_RST_INT_WDT: return "int_wdt";
+        case ESP_RST_TASK_WDT: return "task_wdt";
+        case ESP_RST_WDT: return "wdt";
+        case ESP_RST_BROWNOUT: return "brownout";
+        default: return "other";
+    }
+}
+
+std::string BuildDump(esp_reset_reason_t reason) {
+    char buffer[96];
+    std::string json = "{\"reset_reason\":\"";
+    json += ResetReasonString(reason);
+    json += "\",\"records\":[";
+    size_t start = (ring_.head + kDepth - ring_.count) % kDepth;
+    for (size_t i = 0; i < ring_.count; i++) {
+        const Record& record = ring_.records[(start + i) % kDepth];
+        switch (record.type) {
+            case kRecordState:
+                snprintf(buffer, sizeof(buffer),
+                    "%s{\"t\":%lu,\"type\":\"state\",\"from\":%u,\"to\":%u}",
+                    i > 0 ? "," : "", record.uptime_ms, record.a, (unsigned)record.b);
+                break;
+            case kRecordSnapshot:
+                snprintf(buffer, sizeof(buffer),
+                    "%s{\"t\":%lu,\"type\":\"snap\",\"free\":%lu,\"largest\":%lu,\"min_stack\":%u}",
+                    i > 0 ? "," : "", record.uptime_ms, record.c, record.d, (unsigned)record.b);
+                break;
+            case kRecordAudio:
+                snprintf(buffer, sizeof(buffer),
+                    "%s{\"t\":%lu,\"type\":\"audio\",\"underruns\":%lu,\"late_drops\":%lu}",
+                    i > 0 ? "," : "", record.uptime_ms, record.c, record.d);
+                break;
+            default:
+                // 掉电残渣混进有效环的概率极低，跳过即可
+                continue;
+        }
+        json += buffer;
+    }
+    json += "]}";
+    return json;
+}
+
+}  // namespace
+
+void Init() {
+    auto reason = esp_reset_reason();
+    bool crashed = reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+                   reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT;
+    if (crashed && RingValid() && ring_.count > 0) {
+        crash_dump_ = BuildDump(reason);
+        ESP_LOGW(TAG, "Crash reboot (%s), preserved %lu flight records",
+            ResetReasonString(reason), ring_.count);
+    }
+    // 本次开机从空环开始；上一轮正常开机的记录没有价值
+    ring_.magic = kMagic;
+    ring_.head = 0;
+    ring_.count = 0;
+}
+
+void RecordState(uint8_t from_state, uint8_t to_state) {
+    Append(kRecordState, from_state, to_state, 0, 0);
+}
+
+void RecordSnapshot(uint32_t free_internal, uint32_t largest_block, uint16_t min_task_stack_free) {
+    Append(kRecordSnapshot, 0, min_task_stack_free, free_internal, largest_block);
+}
+
+void RecordAudio(uint32_t underruns, uint32_t late_drops) {
+    Append(kRecordAudio, 0, 0, underruns, late_drops);
+}
+
+const std::string& GetCrashDump() {
+    return crash_dump_;
+}
+
+void DiscardCrashDump() {
+    crash_dump_.clear();
+    crash_dump_.shrink_to_fit();
+}
+
+}  // namespace flight_recorder
@@ -0,0 +1,33 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <cstdint>
+#include <string>
+
+// 崩溃飞行记录仪：noinit 段里的小环形缓冲，持续记录状态机切换和
+// 周期健康快照（堆、任务栈水位、抖动缓冲计数）。panic/看门狗复位
+// 不清 noinit 内存，重启后 Init 发现上次是崩溃重启就把环里的最后
+// N 条记录组成 JSON，搭每次开机都会发的 OTA 检查 POST 上报——
+// 野外"聊着聊着重启了"终于能看到重启前设备在干什么。
+// 记录是写内存加一次拷贝，热路径开销可以忽略。
+namespace flight_recorder {
+
+// 越早调越好（Application::Start 开头）：先判上次复位原因并留存
+// 崩溃现场，再把环重置给本次开机用
+void Init();
+
+// 状态机切换（SetDeviceState 已经打日志，这里留进环里）
+void RecordState(uint8_t from_state, uint8_t to_state);
+// 10 秒健康快照：内部堆 free/最大块 + 全任务最小栈余量
+void RecordSnapshot(uint32_t free_internal, uint32_t largest_block, uint16_t min_task_stack_free);
+// 音频链路计数（抖动缓冲欠载/迟到丢帧），只在播放时有意义
+void RecordAudio(uint32_t underruns, uint32_t late_drops);
+
+// 上次崩溃的现场 JSON；没有崩溃或已丢弃时返回空串
+const std::string& GetCrashDump();
+// 上报成功后丢弃，避免重复发
+void DiscardCrashDump();
+
+}  // namespace flight_recorder
+
+#endif // FLIGHT_RECORDER_H
@@ -0,0 +1,99 @@
+#include "heap_guard.h"
+#include "event_log.h"
+#include "packet_pool.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+#define TAG "HeapGuard"
+
+void HeapGuard::PreallocateReserve() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (reserve_ != nullptr) {
+        return;
+    }
+    reserve_ = heap_caps_malloc(kReserveBytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (reserve_ == nullptr) {
+        ESP_LOGW(TAG, "No room for %u byte reserve at boot", (unsigned)kReserveBytes);
+        return;
+    }
+    // 任何内部堆分配失败都立刻放储备：失败的那次救不回来，但
+    // 紧接着的重试（提示音下一帧、重建路径）就有连续大块可用
+    heap_caps_register_failed_alloc_callback(OnAllocFailed);
+    ESP_LOGI(TAG, "Holding %u byte contiguous reserve", (unsigned)kReserveBytes);
+}
+
+void HeapGuard::OnAllocFailed(size_t size, uint32_t caps, const char* function_name) {
+    ESP_LOGE(TAG, "Alloc failed: %zu bytes (caps 0x%lx) in %s",
+        size, (unsigned long)caps, function_name);
+    GetInstance().ReleaseReserve("alloc_failed");
+}
+
+void HeapGuard::ReleaseReserve(const char* reason) {
+    void* reserve;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reserve = reserve_;
+        reserve_ = nullptr;
+    }
+    if (reserve == nullptr) {
+        return;
+    }
+    heap_caps_free(reserve);
+    ESP_LOGW(TAG, "Released heap reserve (%s)", reason);
+    event_log::Record(event_log::kHeapReserveSpent);
+}
+
+void HeapGuard::Maintain(bool idle) {
+    size_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+
+    // 碎片化预警：总量还剩得多（> 64KB）但最大块不足总空闲的四分之
+    // 一。带回差：恢复到一半以上才重新武装，阈值附近不反复告警
+    if (free_bytes > 4 * kLowWatermark && largest < free_bytes / 4) {
+        if (!frag_alarmed_) {
+            frag_alarmed_ = true;
+            ESP_LOGW(TAG, "Internal heap fragmenting: largest %zu of %zu free",
+                largest, free_bytes);
+            event_log::Record(event_log::kHeapFragmented,
+                (uint16_t)(largest * 100 / free_bytes), (uint32_t)largest);
+        }
+    } else if (largest > free_bytes / 2) {
+        frag_alarmed_ = false;
+    }
+
+    if (!idle) {
+        return;
+    }
+
+    // 空闲窗口的整理：回收池里散布的缓冲还给堆，让分配器把相邻
+    // 空洞合并成大块；下一轮会话按需回灌，空闲期间本来就没流量。
+    // 音频缓冲池是开机一次性的定长板材，句柄在外面飘着，不动它
+    PacketPool::GetInstance().Trim();
+
+    bool holding;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        holding = reserve_ != nullptr;
+    }
+    if (holding) {
+        // 最大块逼近水位就主动放储备：比等分配失败早一步
+        if (largest < kLowWatermark) {
+            ReleaseReserve("low_watermark");
+        }
+    } else if (largest >= 2 * kReserveBytes) {
+        // 整理过后堆缓过来了，把储备抓回来重新武装
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (reserve_ == nullptr) {
+            reserve_ = heap_caps_malloc(kReserveBytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            if (reserve_ != nullptr) {
+                ESP_LOGI(TAG, "Reacquired %u byte heap reserve", (unsigned)kReserveBytes);
+            }
+        }
+    }
+}
+
+size_t HeapGuard::ReserveBytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reserve_ != nullptr ? kReserveBytes : 0;
+}
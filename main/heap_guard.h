@@ -0,0 +1,52 @@
+#ifndef HEAP_GUARD_H
+#define HEAP_GUARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// 内部堆的碎片化哨兵 + 雨天储备
+// 跑上几天后混合生命周期的分配会把内部 SRAM 切碎：总量还剩不少，
+// heap_caps_get_largest_free_block 却缩到激活提示（~9KB）或 codec
+// 重建一次分不出来。这里做三件事：
+//  1. 开机收尾、堆还干净时抓一块最坏情况大小的连续储备；
+//  2. 空闲窗口里做整理——回收池里散布的缓冲还给堆让分配器合并，
+//     最大块跌破水位就放出储备、恢复后再抓回来；分配失败钩子
+//     兜底，任何内部堆分配失败立刻放储备；
+//  3. 最大块/总空闲比穿越阈值时告警进事件环和堆遥测——野外故障
+//     之前先看到预警。
+class HeapGuard {
+public:
+    static HeapGuard& GetInstance() {
+        static HeapGuard instance;
+        return instance;
+    }
+    HeapGuard(const HeapGuard&) = delete;
+    HeapGuard& operator=(const HeapGuard&) = delete;
+
+    // 开机流程收尾后调一次：此时大件初始化都完成了，储备不会
+    // 挤占启动路径
+    void PreallocateReserve();
+    // 时钟定时器每秒调用；idle = 处于可睡的空闲窗口，才做整理
+    void Maintain(bool idle);
+    // 储备现存字节数，堆遥测 gauge 用（0 = 已放出，本身就是告警）
+    size_t ReserveBytes();
+
+private:
+    HeapGuard() = default;
+
+    static void OnAllocFailed(size_t size, uint32_t caps, const char* function_name);
+    void ReleaseReserve(const char* reason);
+
+    // 12KB 盖住已知最大的瞬态分配（激活提示解码 ~9KB + 余量）
+    static constexpr size_t kReserveBytes = 12 * 1024;
+    // 最大块跌破这个水位就先放储备，别等分配失败
+    static constexpr size_t kLowWatermark = 16 * 1024;
+
+    std::mutex mutex_;
+    void* reserve_ = nullptr;
+    // 碎片化告警的回差闩：穿越阈值记一次，恢复后才重新武装
+    bool frag_alarmed_ = false;
+};
+
+#endif // HEAP_GUARD_H
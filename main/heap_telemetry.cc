@@ -0,0 +1,82 @@
+#include "heap_telemetry.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+#include <cstdio>
+
+#define TAG "HeapTelemetry"
+
+void HeapTelemetry::RegisterGauge(const char* name, std::function<size_t()> bytes_fn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    gauges_.emplace_back(name, std::move(bytes_fn));
+}
+
+void HeapTelemetry::Sample() {
+    HeapSample sample = {
+        (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),
+        (uint32_t)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+        (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM),
+    };
+    std::lock_guard<std::mutex> lock(mutex_);
+    history_[history_head_] = sample;
+    history_head_ = (history_head_ + 1) % kHistoryDepth;
+    if (history_count_ < kHistoryDepth) {
+        history_count_++;
+    }
+}
+
+std::string HeapTelemetry::BuildJson() {
+    char buffer[160];
+    std::string json = "{";
+
+    // 当前快照：free/min-free/最大块，内部 SRAM 和 PSRAM 各一份。
+    // 最大块和 free 的差距就是碎片化程度
+    snprintf(buffer, sizeof(buffer),
+        "\"internal\":{\"free\":%u,\"min_free\":%u,\"largest_block\":%u},",
+        heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+        heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+    json += buffer;
+    snprintf(buffer, sizeof(buffer),
+        "\"spiram\":{\"free\":%u,\"min_free\":%u,\"largest_block\":%u},",
+        heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+        heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM),
+        heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM));
+    json += buffer;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 子系统自报占用
+    json += "\"subsystems\":{";
+    for (size_t i = 0; i < gauges_.size(); i++) {
+        snprintf(buffer, sizeof(buffer), "%s\"%s\":%zu",
+            i > 0 ? "," : "", gauges_[i].first, gauges_[i].second());
+        json += buffer;
+    }
+    json += "},";
+
+    // 最近 5 分钟的 free/最大块历史，从旧到新
+    json += "\"history\":{\"interval_s\":10,\"internal_free\":[";
+    size_t start = (history_head_ + kHistoryDepth - history_count_) % kHistoryDepth;
+    for (size_t i = 0; i < history_count_; i++) {
+        const auto& sample = history_[(start + i) % kHistoryDepth];
+        snprintf(buffer, sizeof(buffer), "%s%u", i > 0 ? "," : "", sample.free_internal);
+        json += buffer;
+    }
+    json += "],\"internal_largest\":[";
+    for (size_t i = 0; i < history_count_; i++) {
+        const auto& sample = history_[(start + i) % kHistoryDepth];
+        snprintf(buffer, sizeof(buffer), "%s%u", i > 0 ? "," : "", sample.largest_internal);
+        json += buffer;
+    }
+    json += "],\"spiram_free\":[";
+    for (size_t i = 0; i < history_count_; i++) {
+        const auto& sample = history_[(start + i) % kHistoryDepth];
+        snprintf(buffer, sizeof(buffer), "%s%u", i > 0 ? "," : "", sample.free_spiram);
+        json += buffer;
+    }
+    json += "]}}";
+    return json;
+}
@@ -0,0 +1,51 @@
+#ifndef HEAP_TELEMETRY_H
+#define HEAP_TELEMETRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 堆健康遥测：周期采样内部 SRAM 和 PSRAM 的 free/min-free/最大连续块，
+// 留一段环形历史；各子系统注册 gauge 自报占用（音频缓冲池、包池等）。
+// 服务器通过 JSON 通道发 {"type":"metrics"} 即可拉取完整快照，
+// 用来追野外跑一周才出现的碎片化和泄漏。
+class HeapTelemetry {
+public:
+    static HeapTelemetry& GetInstance() {
+        static HeapTelemetry instance;
+        return instance;
+    }
+    HeapTelemetry(const HeapTelemetry&) = delete;
+    HeapTelemetry& operator=(const HeapTelemetry&) = delete;
+
+    // name 须是常驻字符串；bytes_fn 会在拉取快照时被调用
+    void RegisterGauge(const char* name, std::function<size_t()> bytes_fn);
+    // 每 10 秒从时钟定时器调用一次
+    void Sample();
+    // 组出完整的 JSON 对象（不含外层消息包装）
+    std::string BuildJson();
+
+private:
+    HeapTelemetry() = default;
+
+    struct HeapSample {
+        uint32_t free_internal;
+        uint32_t largest_internal;
+        uint32_t free_spiram;
+        uint32_t largest_spiram;
+    };
+
+    // 10 秒一采，30 个样本 = 5 分钟趋势，足够看出碎片化斜率
+    static constexpr size_t kHistoryDepth = 30;
+
+    std::mutex mutex_;
+    HeapSample history_[kHistoryDepth] = {};
+    size_t history_head_ = 0;
+    size_t history_count_ = 0;
+    std::vector<std::pair<const char*, std::function<size_t()>>> gauges_;
+};
+
+#endif // HEAP_TELEMETRY_H
@@ -0,0 +1,34 @@
+#include "http_worker.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+void HttpWorker::Submit(std::function<void()> job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(std::move(job));
+    if (!task_running_) {
+        task_running_ = true;
+        // TLS 握手 + 证书链验证的栈峰值和原 check_new_version 任务一致
+        xTaskCreate([](void* arg) {
+            static_cast<HttpWorker*>(arg)->WorkerLoop();
+            vTaskDelete(NULL);
+        }, "http_worker", 4096 * 2, this, 2, nullptr);
+    }
+}
+
+void HttpWorker::WorkerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (jobs_.empty()) {
+                // 退出决定和 Submit 的拉起检查在同一把锁下，不会漏作业
+                task_running_ = false;
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef HTTP_WORKER_H
+#define HTTP_WORKER_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// 共享的 HTTP 工作任务。版本检查这类作业是长阻塞 I/O（弱网下一次
+// 请求几十秒），放进 BackgroundTask 会把一个工人整段占死，各自拉
+// 专属任务又是每个用户 8KB 栈。这里收口成一个按需拉起的工作任务：
+// 作业排队串行执行，完成回调也在工作任务上跑，队列清空任务就退出，
+// 空闲期间一字节栈都不占。作业内部照常用 Board::CreateHttp 自取
+// 连接——传输组件不暴露连接复用，keep-alive 收不进来，省的是任务栈
+class HttpWorker {
+public:
+    static HttpWorker& GetInstance() {
+        static HttpWorker instance;
+        return instance;
+    }
+    HttpWorker(const HttpWorker&) = delete;
+    HttpWorker& operator=(const HttpWorker&) = delete;
+
+    // 把阻塞 HTTP 作业排到工作任务上；按提交顺序串行执行
+    void Submit(std::function<void()> job);
+
+private:
+    HttpWorker() = default;
+
+    void WorkerLoop();
+
+    std::mutex mutex_;
+    std::deque<std::function<void()>> jobs_;
+    bool task_running_ = false;
+};
+
+#endif // HTTP_WORKER_H
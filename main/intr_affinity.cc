@@ -0,0 +1,51 @@
+#include "intr_affinity.h"
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#define TAG "IntrAffinity"
+
+namespace intr_affinity {
+
+namespace {
+
+struct RunContext {
+    const std::function<void()>* fn;
+    SemaphoreHandle_t done;
+};
+
+}  // namespace
+
+void RunOn(int core, const char* name, const std::function<void()>& fn) {
+#if CONFIG_FREERTOS_UNICORE
+    (void)core;
+    (void)name;
+    fn();
+#else
+    if (core < 0 || core >= portNUM_PROCESSORS || core == xPortGetCoreID()) {
+        fn();
+        return;
+    }
+    // 驱动安装的 ESP_ERROR_CHECK 链很深，栈给足（同 BoardInitStages）；
+    // 优先级压过调用方，跳板任务不排队
+    UBaseType_t priority = uxTaskPriorityGet(NULL) + 1;
+    if (priority >= configMAX_PRIORITIES) {
+        priority = configMAX_PRIORITIES - 1;
+    }
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    RunContext ctx = { &fn, done };
+    xTaskCreatePinnedToCore([](void* arg) {
+        auto* ctx = static_cast<RunContext*>(arg);
+        (*ctx->fn)();
+        xSemaphoreGive(ctx->done);
+        vTaskDelete(NULL);
+    }, name, 4096, &ctx, priority, nullptr, core);
+    xSemaphoreTake(done, portMAX_DELAY);
+    vSemaphoreDelete(done);
+    ESP_LOGI(TAG, "%s installed on core %d", name, core);
+#endif
+}
+
+}  // namespace intr_affinity
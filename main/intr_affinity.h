@@ -0,0 +1,35 @@
+#ifndef INTR_AFFINITY_H
+#define INTR_AFFINITY_H
+
+#include <functional>
+
+#include "config.h"
+
+// 中断归核
+// esp_intr_alloc 没有核参数：中断固定落在执行分配的那个核上，所以
+// I2S/LCD SPI 的 ISR 一直跟着驱动安装的任务走——板级构造函数都在
+// 主任务（核 0）上跑，结果 I2S 收发完成中断和 WiFi、LCD DMA 全挤在
+// 核 0，屏幕整帧刷新的中断风暴会推迟音频回调。RunOn 把驱动安装路径
+// 搬到指定核上同步执行，中断从此归那个核服务。
+// WiFi 的 ISR 归属由 sdkconfig 决定（默认核 0），这里的旋钮移动的是
+// 音频/显示相对它的位置；验证手段是 LatencyTracker 的 rx_isr_gap
+// 直方图（采集完成中断的到达间隔）。
+#ifndef AUDIO_INTR_CORE
+// I2S 收发完成中断默认归核 1，和 AFE/编解码任务同侧，离 WiFi 远点
+#define AUDIO_INTR_CORE 1
+#endif
+#ifndef DISPLAY_INTR_CORE
+// LCD SPI 主机的 ISR 默认留在安装核（通常核 0）；想挪的板子在
+// config.h 覆盖后用 RunOn 包住 esp_lcd_new_panel_io_spi
+#define DISPLAY_INTR_CORE -1
+#endif
+
+namespace intr_affinity {
+
+// 在指定核上同步跑 fn（内部 esp_intr_alloc 的中断随之归核）。
+// core < 0、单核目标或已在目标核上时原地执行
+void RunOn(int core, const char* name, const std::function<void()>& fn);
+
+}  // namespace intr_affinity
+
+#endif  // INTR_AFFINITY_H
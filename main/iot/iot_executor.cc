@@ -0,0 +1,125 @@
+#include "iot_executor.h"
+#include "thing.h"
+#include "json_builder.h"
+#include "task_telemetry.h"
+
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <memory>
+
+#define TAG "IotExecutor"
+
+namespace iot {
+
+IotExecutor::IotExecutor() {
+    queue_ = xQueueCreate(8, sizeof(Job));
+    TaskHandle_t handle = nullptr;
+    xTaskCreate([](void* arg) {
+        static_cast<IotExecutor*>(arg)->ExecutorLoop();
+        vTaskDelete(NULL);
+    }, "iot_executor", 4096 * 2, this, 2, &handle);
+    TaskTelemetry::GetInstance().RegisterTask("iot_executor", handle, 4096 * 2);
+}
+
+bool IotExecutor::Submit(Thing* thing, Method* method) {
+    Job job = { thing, method };
+    return xQueueSend(queue_, &job, 0) == pdTRUE;
+}
+
+void IotExecutor::ExecutorLoop() {
+    Job job;
+    while (xQueueReceive(queue_, &job, portMAX_DELAY) == pdTRUE) {
+        int64_t start_us = esp_timer_get_time();
+        if (job.method->async()) {
+            // 异步方法：只负责发起，发起完立即服务下一条命令。done
+            // 可能从任意任务/定时器进来也可能被误调多次，原子标志保证
+            // 收尾只走一遍。账本记的是发起耗时——动作本身跑多久不占
+            // 执行任务，不该算进"谁堵住了队列"
+            Thing* thing = job.thing;
+            Method* method = job.method;
+            pending_.fetch_add(1, std::memory_order_relaxed);
+            auto fired = std::make_shared<std::atomic<bool>>(false);
+            method->InvokeAsync([this, thing, fired]() {
+                if (fired->exchange(true)) {
+                    return;
+                }
+                FinishAsync(thing);
+            });
+            Account(thing, method, esp_timer_get_time() - start_us);
+            continue;
+        }
+        job.method->Invoke();
+        // 方法执行完之后再标脏，避免上报跑在方法前面把标记清掉
+        job.thing->MarkStateDirty();
+        Account(job.thing, job.method, esp_timer_get_time() - start_us);
+    }
+}
+
+void IotExecutor::FinishAsync(Thing* thing) {
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    // 完成时标脏：下一轮增量状态上报会带上该 thing 的新状态，
+    // 服务器由此得知动作结束（handler 在 done 之前更新自己的属性）
+    thing->MarkStateDirty();
+}
+
+void IotExecutor::Account(Thing* thing, Method* method, int64_t elapsed_us) {
+    if (elapsed_us > (int64_t)kBudgetMs * 1000) {
+        ESP_LOGW(TAG, "%s.%s took %lld ms (budget %d ms)",
+            thing->name().c_str(), method->name().c_str(),
+            elapsed_us / 1000, kBudgetMs);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = nullptr;
+    for (size_t i = 0; i < entry_count_; i++) {
+        if (entries_[i].thing == thing) {
+            entry = &entries_[i];
+            break;
+        }
+    }
+    if (entry == nullptr) {
+        entry = entry_count_ < kMaxThings
+            ? &entries_[entry_count_++] : &entries_[kMaxThings - 1];
+        entry->thing = thing;
+    }
+    entry->count++;
+    entry->total_us += elapsed_us;
+    if (elapsed_us > entry->worst_us) {
+        entry->worst_us = elapsed_us;
+    }
+    if (elapsed_us > (int64_t)kBudgetMs * 1000) {
+        entry->over_budget++;
+    }
+}
+
+std::string IotExecutor::BuildJson() {
+    char buffer[512];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddNumber("budget_ms", kBudgetMs);
+    json.AddNumber("pending", (int)pending_.load(std::memory_order_relaxed));
+    json.BeginArray("things");
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < entry_count_; i++) {
+            const auto& entry = entries_[i];
+            json.BeginObject();
+            json.AddString("name", entry.thing->name().c_str());
+            json.AddNumber("count", (int)entry.count);
+            json.AddNumber("over_budget", (int)entry.over_budget);
+            json.AddNumber("worst_ms", (int)(entry.worst_us / 1000));
+            json.AddNumber("total_ms", (int)(entry.total_us / 1000));
+            json.EndObject();
+        }
+    }
+    json.EndArray();
+    json.EndObject();
+    if (json.overflowed()) {
+        return "{}";
+    }
+    return json.str();
+}
+
+} // namespace iot
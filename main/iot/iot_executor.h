@@ -0,0 +1,78 @@
+#ifndef IOT_EXECUTOR_H
+#define IOT_EXECUTOR_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace iot {
+
+class Thing;
+class Method;
+
+// IoT 方法的专用执行任务。方法回调什么都可能干——亮度渐变、底盘
+// 运动、I2C 事务——放在主循环上执行会把音频状态杂务压在后面（长任务
+// 遥测里 iot_invoke 桶基本都是它）。这里收口成一条低优先级任务串行
+// 执行：上游路径只入队两个指针（POD、零分配、不阻塞），每个 thing
+// 按执行耗时记账，超预算的告警并计数，telemetry 的 iot 供应器能
+// 直接看到是哪个 thing 在拖
+class IotExecutor {
+public:
+    static IotExecutor& GetInstance() {
+        static IotExecutor instance;
+        return instance;
+    }
+    IotExecutor(const IotExecutor&) = delete;
+    IotExecutor& operator=(const IotExecutor&) = delete;
+
+    // 参数已经绑定在 method 上，这里只入队。队满返回 false 丢弃
+    // 新命令（调用路径绝不等待），由调用方告警
+    bool Submit(Thing* thing, Method* method);
+    // 每 thing 的执行耗时账本，预序列化给遥测
+    std::string BuildJson();
+
+private:
+    IotExecutor();
+
+    void ExecutorLoop();
+    // 异步方法的完成收尾：挂起计数回落、thing 标脏（增量状态上报
+    // 由此把"动作做完了"带给服务器）。done 回调可能来自任意上下文
+    void FinishAsync(Thing* thing);
+    // 记一次执行耗时进账本；异步方法记的是发起耗时（占用执行任务
+    // 的时间），动作本身在别处跑多久不在这本账里
+    void Account(Thing* thing, Method* method, int64_t elapsed_us);
+
+    // 单次方法执行的预算：超过就告警并记账。挡不住已经在跑的回调，
+    // 但能把"是谁把命令队列堵住了"直接点名
+    static constexpr int kBudgetMs = 100;
+    static constexpr size_t kMaxThings = 12;
+
+    struct Job {
+        Thing* thing;
+        Method* method;
+    };
+
+    struct Entry {
+        Thing* thing;
+        uint32_t count;
+        uint32_t over_budget;
+        int64_t total_us;
+        int64_t worst_us;
+    };
+
+    QueueHandle_t queue_ = nullptr;
+    std::mutex mutex_;
+    // 已发起还没回报 done 的异步命令数；一直不归零说明有 handler
+    // 忘了调 done，遥测面板上能直接看到
+    std::atomic<uint32_t> pending_{0};
+    // 板子注册的 thing 就几个，定长表足够；满了的记到最后一格
+    Entry entries_[kMaxThings] = {};
+    size_t entry_count_ = 0;
+};
+
+} // namespace iot
+
+#endif // IOT_EXECUTOR_H
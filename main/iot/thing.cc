@@ -1,8 +1,12 @@
 #include "thing.h"
-#include "application.h"
+#include "iot_executor.h"
+#include "json_builder.h"
 
 #include <esp_log.h>
 
+#include <cstdlib>
+#include <cstring>
+
 #define TAG "Thing"
 
 
@@ -27,21 +31,332 @@ Thing* CreateThing(const std::string& type) {
 }
 
 std::string Thing::GetDescriptorJson() {
-    std::string json_str = "{";
-    json_str += "\"name\":\"" + name_ + "\",";
-    json_str += "\"description\":\"" + description_ + "\",";
-    json_str += "\"properties\":" + properties_.GetDescriptorJson() + ",";
-    json_str += "\"methods\":" + methods_.GetDescriptorJson();
-    json_str += "}";
-    return json_str;
+    std::string properties = properties_.GetDescriptorJson();
+    std::string methods = methods_.GetDescriptorJson();
+    // 二进制状态的布局声明（schema 握手）：服务器据此解码 0x05 帧里
+    // 本 thing 的记录。LLM 看到的 properties/methods 不受影响
+    std::string binary_state;
+    if (binary_enabled_) {
+        binary_state = "{\"id\":" + std::to_string(binary_state_id_) + ",\"fields\":[";
+        bool first = true;
+        for (auto& property : properties_) {
+            if (!first) {
+                binary_state += ',';
+            }
+            first = false;
+            binary_state += "{\"name\":\"" + property.name() + "\",\"type\":\"";
+            binary_state += property.type() == kValueTypeBoolean ? "bool" : "i32";
+            binary_state += "\"}";
+        }
+        binary_state += "]}";
+    }
+    char buffer[2048];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddString("name", name_);
+    json.AddString("description", description_);
+    json.AddRaw("properties", properties);
+    json.AddRaw("methods", methods);
+    if (!binary_state.empty()) {
+        json.AddRaw("binary_state", binary_state);
+    }
+    json.EndObject();
+    if (json.overflowed()) {
+        // 接口特别多的 Thing 退回动态拼接
+        std::string fallback = "{\"name\":\"" + name_ + "\",\"description\":\"" + description_ +
+            "\",\"properties\":" + properties + ",\"methods\":" + methods;
+        if (!binary_state.empty()) {
+            fallback += ",\"binary_state\":" + binary_state;
+        }
+        return fallback + "}";
+    }
+    return json.str();
+}
+
+void Thing::PrepareStateArena() {
+    std::string skeleton = "{\"name\":\"" + name_ + "\",\"state\":{";
+    state_cuts_.clear();
+    bool first = true;
+    for (auto& property : properties_) {
+        if (!first) {
+            skeleton += ',';
+        }
+        first = false;
+        skeleton += "\"" + property.name() + "\":";
+        state_cuts_.push_back((uint16_t)skeleton.size());
+    }
+    skeleton += "}}";
+    state_skeleton_.assign(skeleton.data(), skeleton.size());
+
+    // 顺手判定二进制状态资格：全 bool/number 且记录不超上限。
+    // 带字符串属性（变长、要转义）的 thing 留在 JSON 路径
+    size_t record_size = 1;  // id 字节
+    bool has_properties = false;
+    binary_eligible_ = true;
+    for (auto& property : properties_) {
+        has_properties = true;
+        if (property.type() == kValueTypeBoolean) {
+            record_size += 1;
+        } else if (property.type() == kValueTypeNumber) {
+            record_size += 4;
+        } else {
+            binary_eligible_ = false;
+            break;
+        }
+    }
+    if (!has_properties || record_size > kBinaryStateMaxRecord) {
+        binary_eligible_ = false;
+    }
+
+    // 顺手记下有没有阻塞属性，采集器只扫需要的 thing
+    has_blocking_ = false;
+    for (auto& property : properties_) {
+        if (property.blocking()) {
+            has_blocking_ = true;
+            break;
+        }
+    }
+}
+
+void Thing::SampleBlockingProperties() {
+    for (auto& property : properties_) {
+        if (property.blocking()) {
+            property.Sample();
+        }
+    }
+}
+
+size_t Thing::WriteStateBinary(uint8_t* out, size_t capacity) {
+    if (!binary_enabled_ || capacity < 1) {
+        return 0;
+    }
+    size_t len = 0;
+    out[len++] = binary_state_id_;
+    for (auto& property : properties_) {
+        if (property.type() == kValueTypeBoolean) {
+            if (len + 1 > capacity) {
+                return 0;
+            }
+            out[len++] = property.boolean() ? 1 : 0;
+        } else {
+            if (len + 4 > capacity) {
+                return 0;
+            }
+            int32_t v = property.number();
+            out[len++] = (uint8_t)(v & 0xFF);
+            out[len++] = (uint8_t)((v >> 8) & 0xFF);
+            out[len++] = (uint8_t)((v >> 16) & 0xFF);
+            out[len++] = (uint8_t)((v >> 24) & 0xFF);
+        }
+    }
+    return len;
+}
+
+// 快速整数转 ASCII：状态上报每次转换都要过这里，不值得付 snprintf
+// 的格式解析开销
+static size_t WriteInt(char* out, int value) {
+    char tmp[12];
+    size_t n = 0;
+    unsigned int v = value < 0 ? (unsigned int)(-(int64_t)value) : (unsigned int)value;
+    do {
+        tmp[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v > 0);
+    size_t len = 0;
+    if (value < 0) {
+        out[len++] = '-';
+    }
+    while (n > 0) {
+        out[len++] = tmp[--n];
+    }
+    return len;
+}
+
+size_t Thing::WriteStateJson(char* out, size_t capacity) {
+    if (state_skeleton_.empty()) {
+        return 0;  // 还没注册进管理器，走动态路径
+    }
+    const char* skeleton = state_skeleton_.data();
+    size_t len = 0;
+    size_t prev = 0;
+    size_t slot = 0;
+    for (auto& property : properties_) {
+        size_t cut = state_cuts_[slot++];
+        size_t seg = cut - prev;
+        // 骨架段 + 一个标量的最坏宽度，留够余量再写
+        if (len + seg + 12 > capacity) {
+            return 0;
+        }
+        memcpy(out + len, skeleton + prev, seg);
+        len += seg;
+        prev = cut;
+        if (property.type() == kValueTypeBoolean) {
+            const char* v = property.boolean() ? "true" : "false";
+            size_t n = strlen(v);
+            memcpy(out + len, v, n);
+            len += n;
+        } else if (property.type() == kValueTypeNumber) {
+            len += WriteInt(out + len, property.number());
+        } else {
+            std::string value = property.string();
+            if (len + 2 * value.size() + 2 > capacity) {
+                return 0;
+            }
+            out[len++] = '"';
+            for (char c : value) {
+                if (c == '"' || c == '\\') {
+                    out[len++] = '\\';
+                }
+                out[len++] = c;
+            }
+            out[len++] = '"';
+        }
+    }
+    size_t tail = state_skeleton_.size() - prev;
+    if (len + tail > capacity) {
+        return 0;
+    }
+    memcpy(out + len, skeleton + prev, tail);
+    return len + tail;
 }
 
 std::string Thing::GetStateJson() {
-    std::string json_str = "{";
-    json_str += "\"name\":\"" + name_ + "\",";
-    json_str += "\"state\":" + properties_.GetStateJson();
-    json_str += "}";
-    return json_str;
+    char buffer[1024];
+    size_t len = WriteStateJson(buffer, sizeof(buffer));
+    if (len > 0) {
+        return std::string(buffer, len);
+    }
+    // 属性特别多或字符串特别长的 thing 退回动态拼接
+    return "{\"name\":\"" + name_ + "\",\"state\":" + properties_.GetStateJson() + "}";
+}
+
+static inline const char* SkipWs(const char* p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+        p++;
+    }
+    return p;
+}
+
+// 在平坦对象原文里定位 "key" 对应的值起点。嵌套值、带转义的 key
+// 都不在受限 invoke 模式内，返回 nullptr 等同没找到
+static const char* FindParamValue(const char* obj, const char* key) {
+    const char* p = SkipWs(obj);
+    if (*p != '{') {
+        return nullptr;
+    }
+    p = SkipWs(p + 1);
+    if (*p == '}') {
+        return nullptr;
+    }
+    size_t key_len = strlen(key);
+    while (true) {
+        if (*p != '"') {
+            return nullptr;
+        }
+        const char* k = p + 1;
+        const char* k_end = k;
+        while (*k_end != '"') {
+            if (*k_end == '\\' || *k_end == '\0') {
+                return nullptr;
+            }
+            k_end++;
+        }
+        bool match = (size_t)(k_end - k) == key_len && memcmp(k, key, key_len) == 0;
+        p = SkipWs(k_end + 1);
+        if (*p != ':') {
+            return nullptr;
+        }
+        p = SkipWs(p + 1);
+        if (match) {
+            return p;
+        }
+        // 跳过不相干的值
+        if (*p == '"') {
+            p++;
+            while (*p != '"') {
+                if (*p == '\\') {
+                    p++;
+                }
+                if (*p == '\0') {
+                    return nullptr;
+                }
+                p++;
+            }
+            p++;
+        } else if (*p == '{' || *p == '[') {
+            return nullptr;
+        } else {
+            while (*p != ',' && *p != '}' && *p != '\0') {
+                p++;
+            }
+        }
+        p = SkipWs(p);
+        if (*p == ',') {
+            p = SkipWs(p + 1);
+            continue;
+        }
+        return nullptr;  // 到对象尾也没找到
+    }
+}
+
+bool Thing::InvokeRaw(const char* method_name, const char* params_json, bool execute) {
+    Method* method = methods_.Find(method_name);
+    if (method == nullptr) {
+        return false;
+    }
+    for (auto& param : method->parameters()) {
+        const char* value = params_json != nullptr
+            ? FindParamValue(params_json, param.name().c_str()) : nullptr;
+        if (value == nullptr) {
+            if (param.required()) {
+                return false;
+            }
+            continue;
+        }
+        if (param.type() == kValueTypeString) {
+            if (*value != '"') {
+                return false;
+            }
+            const char* end = value + 1;
+            while (*end != '"') {
+                // 带转义的参数值不在受限模式内，交回 cJSON
+                if (*end == '\\' || *end == '\0') {
+                    return false;
+                }
+                end++;
+            }
+            if (execute) {
+                param.set_string(value + 1, end - (value + 1));
+            }
+        } else if (param.type() == kValueTypeNumber) {
+            if (*value != '-' && (*value < '0' || *value > '9')) {
+                return false;
+            }
+            if (execute) {
+                param.set_number(atoi(value));
+            }
+        } else {
+            if (strncmp(value, "true", 4) == 0) {
+                if (execute) {
+                    param.set_boolean(true);
+                }
+            } else if (strncmp(value, "false", 5) == 0) {
+                if (execute) {
+                    param.set_boolean(false);
+                }
+            } else {
+                return false;
+            }
+        }
+    }
+    if (!execute) {
+        return true;
+    }
+    if (!IotExecutor::GetInstance().Submit(this, method)) {
+        ESP_LOGW(TAG, "Executor queue full, dropped %s.%s",
+            name_.c_str(), method->name().c_str());
+    }
+    return true;
 }
 
 void Thing::Invoke(const cJSON* command) {
@@ -64,9 +379,13 @@ void Thing::Invoke(const cJSON* command) {
             }
         }
 
-        Application::GetInstance().Schedule([&method]() {
-            method.Invoke();
-        });
+        // 执行交给专用的 IoT 执行任务：方法回调可能是几十上百毫秒的
+        // 慢活（亮度渐变、底盘运动），不能占着主循环；这条路径上
+        // 只入队指针，不分配不等待
+        if (!IotExecutor::GetInstance().Submit(this, &method)) {
+            ESP_LOGW(TAG, "Executor queue full, dropped %s.%s",
+                name_.c_str(), method.name().c_str());
+        }
     } catch (const std::runtime_error& e) {
         ESP_LOGE(TAG, "Method not found: %s", method_name->valuestring);
         return;
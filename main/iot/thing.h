@@ -1,6 +1,8 @@
 #ifndef THING_H
 #define THING_H
 
+#include "psram_pmr.h"
+
 #include <string>
 #include <map>
 #include <functional>
@@ -21,24 +23,47 @@ private:
     std::string name_;
     std::string description_;
     ValueType type_;
+    // 阻塞 getter（走 I2C 读电量计这类）：序列化只读缓存，真 getter
+    // 由后台采集器跑（见 Thing::SampleBlockingProperties）。缓存是
+    // 对齐标量，采集任务写、序列化读，无锁即可；字符串 getter 不
+    // 支持标记阻塞（换缓冲没法无锁，实际的总线读数也都是数值）
+    bool blocking_ = false;
+    volatile bool cached_boolean_ = false;
+    volatile int cached_number_ = 0;
     std::function<bool()> boolean_getter_;
     std::function<int()> number_getter_;
     std::function<std::string()> string_getter_;
 
 public:
-    Property(const std::string& name, const std::string& description, std::function<bool()> getter) :
-        name_(name), description_(description), type_(kValueTypeBoolean), boolean_getter_(getter) {}
-    Property(const std::string& name, const std::string& description, std::function<int()> getter) :
-        name_(name), description_(description), type_(kValueTypeNumber), number_getter_(getter) {}
+    Property(const std::string& name, const std::string& description, std::function<bool()> getter, bool blocking = false) :
+        name_(name), description_(description), type_(kValueTypeBoolean), blocking_(blocking), boolean_getter_(getter) {}
+    Property(const std::string& name, const std::string& description, std::function<int()> getter, bool blocking = false) :
+        name_(name), description_(description), type_(kValueTypeNumber), blocking_(blocking), number_getter_(getter) {}
     Property(const std::string& name, const std::string& description, std::function<std::string()> getter) :
         name_(name), description_(description), type_(kValueTypeString), string_getter_(getter) {}
 
+    Property(const Property& other) :
+        name_(other.name_), description_(other.description_), type_(other.type_),
+        blocking_(other.blocking_), cached_boolean_(other.cached_boolean_),
+        cached_number_(other.cached_number_), boolean_getter_(other.boolean_getter_),
+        number_getter_(other.number_getter_), string_getter_(other.string_getter_) {}
+
     const std::string& name() const { return name_; }
     const std::string& description() const { return description_; }
     ValueType type() const { return type_; }
+    bool blocking() const { return blocking_; }
+
+    // 跑真 getter 刷新缓存，在后台采集器的任务上调用
+    void Sample() {
+        if (type_ == kValueTypeBoolean) {
+            cached_boolean_ = boolean_getter_();
+        } else if (type_ == kValueTypeNumber) {
+            cached_number_ = number_getter_();
+        }
+    }
 
-    bool boolean() const { return boolean_getter_(); }
-    int number() const { return number_getter_(); }
+    bool boolean() const { return blocking_ ? cached_boolean_ : boolean_getter_(); }
+    int number() const { return blocking_ ? cached_number_ : number_getter_(); }
     std::string string() const { return string_getter_(); }
 
     std::string GetDescriptorJson() {
@@ -57,9 +82,9 @@ public:
 
     std::string GetStateJson() {
         if (type_ == kValueTypeBoolean) {
-            return boolean_getter_() ? "true" : "false";
+            return boolean() ? "true" : "false";
         } else if (type_ == kValueTypeNumber) {
-            return std::to_string(number_getter_());
+            return std::to_string(number());
         } else if (type_ == kValueTypeString) {
             return "\"" + string_getter_() + "\"";
         }
@@ -75,11 +100,13 @@ public:
     PropertyList() = default;
     PropertyList(const std::vector<Property>& properties) : properties_(properties) {}
 
-    void AddBooleanProperty(const std::string& name, const std::string& description, std::function<bool()> getter) {
-        properties_.push_back(Property(name, description, getter));
+    // blocking 为 true 声明 getter 会卡（I2C/SPI 总线读数）：序列化
+    // 改读后台采样的缓存，通道建立不再碰硬件
+    void AddBooleanProperty(const std::string& name, const std::string& description, std::function<bool()> getter, bool blocking = false) {
+        properties_.push_back(Property(name, description, getter, blocking));
     }
-    void AddNumberProperty(const std::string& name, const std::string& description, std::function<int()> getter) {
-        properties_.push_back(Property(name, description, getter));
+    void AddNumberProperty(const std::string& name, const std::string& description, std::function<int()> getter, bool blocking = false) {
+        properties_.push_back(Property(name, description, getter, blocking));
     }
     void AddStringProperty(const std::string& name, const std::string& description, std::function<std::string()> getter) {
         properties_.push_back(Property(name, description, getter));
@@ -94,6 +121,10 @@ public:
         throw std::runtime_error("Property not found: " + name);
     }
 
+    // iterator
+    auto begin() { return properties_.begin(); }
+    auto end() { return properties_.end(); }
+
     std::string GetDescriptorJson() {
         std::string json_str = "{";
         for (auto& property : properties_) {
@@ -145,6 +176,8 @@ public:
     void set_boolean(bool value) { boolean_ = value; }
     void set_number(int value) { number_ = value; }
     void set_string(const std::string& value) { string_ = value; }
+    // 零分配 invoke 路径用：assign 复用已有容量，不换缓冲
+    void set_string(const char* value, size_t len) { string_.assign(value, len); }
 
     std::string GetDescriptorJson() {
         std::string json_str = "{";
@@ -204,10 +237,16 @@ private:
     std::string description_;
     ParameterList parameters_;
     std::function<void(const ParameterList&)> callback_;
+    // 异步形态：回调发起动作后立即返回，动作真正结束时（任意任务或
+    // 定时器上下文）调用 done。执行任务发起后就空出来服务下一条命令，
+    // 几秒钟的底盘运动不再占着执行线程
+    std::function<void(const ParameterList&, std::function<void()>)> async_callback_;
 
 public:
     Method(const std::string& name, const std::string& description, const ParameterList& parameters, std::function<void(const ParameterList&)> callback) :
         name_(name), description_(description), parameters_(parameters), callback_(callback) {}
+    Method(const std::string& name, const std::string& description, const ParameterList& parameters, std::function<void(const ParameterList&, std::function<void()>)> callback) :
+        name_(name), description_(description), parameters_(parameters), async_callback_(callback) {}
 
     const std::string& name() const { return name_; }
     const std::string& description() const { return description_; }
@@ -221,9 +260,15 @@ public:
         return json_str;
     }
 
+    bool async() const { return (bool)async_callback_; }
+
     void Invoke() {
         callback_(parameters_);
     }
+
+    void InvokeAsync(std::function<void()> done) {
+        async_callback_(parameters_, std::move(done));
+    }
 };
 
 class MethodList {
@@ -238,6 +283,10 @@ public:
         methods_.push_back(Method(name, description, parameters, callback));
     }
 
+    void AddAsyncMethod(const std::string& name, const std::string& description, const ParameterList& parameters, std::function<void(const ParameterList&, std::function<void()>)> callback) {
+        methods_.push_back(Method(name, description, parameters, callback));
+    }
+
     Method& operator[](const std::string& name) {
         for (auto& method : methods_) {
             if (method.name() == name) {
@@ -247,6 +296,16 @@ public:
         throw std::runtime_error("Method not found: " + name);
     }
 
+    // 零分配路径的查找：找不到返回 nullptr，不抛异常不拼字符串
+    Method* Find(const char* name) {
+        for (auto& method : methods_) {
+            if (method.name() == name) {
+                return &method;
+            }
+        }
+        return nullptr;
+    }
+
     std::string GetDescriptorJson() {
         std::string json_str = "{";
         for (auto& method : methods_) {
@@ -270,16 +329,73 @@ public:
     virtual std::string GetStateJson();
     virtual void Invoke(const cJSON* command);
 
+    // AddThing 时预拼状态骨架：名字和属性名运行期不变，常量部分
+    // 一次拼好并记下每个属性值的插入点，之后每次序列化只剩 memcpy
+    // 骨架段 + 写属性值，每次状态上报的开销近似常量
+    void PrepareStateArena();
+    // 把状态 JSON 写进调用方缓冲，返回长度；容量不足或骨架未备好
+    // 返回 0，调用方退回动态拼接
+    size_t WriteStateJson(char* out, size_t capacity);
+    // 受限 invoke 模式的零分配路径：method 名和 parameters 对象原文
+    // 由 ThingManager 扫出。execute 为 false 只验证（查方法、对参数
+    // 名和类型），为 true 才绑定并入队。任何拿不准的形态返回 false，
+    // 由调用方回退 cJSON 老路径
+    bool InvokeRaw(const char* method_name, const char* params_json, bool execute);
+
+    // 二进制状态通道：属性全是 bool/number 的 thing（音量、电量这类
+    // 高频数值遥测）状态可以编码成定长二进制记录，布局在描述符的
+    // binary_state 段里声明给服务器，上报时不再有 JSON 格式化开销。
+    // 是否可用在 PrepareStateArena 时判定，id 由 ThingManager 注册序
+    // 分配；带字符串属性的 thing 照旧走 JSON
+    bool binary_state_eligible() const { return binary_eligible_; }
+    bool binary_state_enabled() const { return binary_enabled_; }
+    uint8_t binary_state_id() const { return binary_state_id_; }
+    void EnableBinaryState(uint8_t id) { binary_state_id_ = id; binary_enabled_ = true; }
+    // 单条记录的上限（1 字节 id + 属性值），超出的 thing 不参与
+    static constexpr size_t kBinaryStateMaxRecord = 64;
+    // 把状态编码成记录 [u8 id][按声明序: bool=u8, number=i32 小端]
+    // 写进调用方缓冲，返回长度；未启用或容量不足返回 0
+    size_t WriteStateBinary(uint8_t* out, size_t capacity);
+
+    // 跑一遍标记为阻塞的属性 getter 刷新缓存（后台采集器/注册时
+    // 调用）；序列化路径只读缓存，通道建立不再被总线读数卡住
+    void SampleBlockingProperties();
+    bool has_blocking_properties() const { return has_blocking_; }
+
     const std::string& name() const { return name_; }
     const std::string& description() const { return description_; }
 
+    // 脏标记：开启追踪后，状态只会因方法调用或 MarkStateDirty 改变，
+    // ThingManager 做增量上报时可以直接跳过干净的 thing，连序列化都省掉。
+    // 未开启追踪（状态会自己变，比如电池电量）则永远视为脏，保持旧行为。
+    bool IsStateDirty() const { return !dirty_tracking_ || state_dirty_; }
+    void ClearStateDirty() { state_dirty_ = false; }
+
 protected:
     PropertyList properties_;
     MethodList methods_;
 
+    // 子类在构造函数里声明"我的状态只通过方法改变"，换取增量上报跳过
+    void EnableDirtyTracking() { dirty_tracking_ = true; }
+    // 状态在方法之外被改动时（比如本地按键调音量），由子类主动标脏
+    void MarkStateDirty() { state_dirty_ = true; }
+
 private:
     std::string name_;
     std::string description_;
+    bool dirty_tracking_ = false;
+    // 有阻塞属性的 thing 才值得被采集器扫（PrepareStateArena 判定）
+    bool has_blocking_ = false;
+    // 二进制状态：可用性（属性形态决定）与启用态（管理器分配了 id）
+    bool binary_eligible_ = false;
+    bool binary_enabled_ = false;
+    uint8_t binary_state_id_ = 0;
+    // 初始为脏，保证首次上报包含完整状态
+    volatile bool state_dirty_ = true;
+    // 预拼好的状态骨架与每个属性值的插入点（PrepareStateArena 构建，
+    // 常驻不变，落 PSRAM 池）
+    psram_pmr::string state_skeleton_{psram_pmr::cold()};
+    std::vector<uint16_t> state_cuts_;
 };
 
 
@@ -2,15 +2,45 @@
 
 #include <esp_log.h>
 
+#include <cstring>
+
 #define TAG "ThingManager"
 
 namespace iot {
 
 void ThingManager::AddThing(Thing* thing) {
+    // 状态骨架在注册时拼好，之后每次状态上报只写属性值
+    thing->PrepareStateArena();
+    // 全数值属性的 thing 按注册序分配二进制状态 id，布局随描述符的
+    // binary_state 段下发给服务器
+    if (thing->binary_state_eligible() && binary_things_ <= 0xFF) {
+        thing->EnableBinaryState((uint8_t)binary_things_++);
+    }
     things_.push_back(thing);
+    thing_index_[thing->name()] = thing;
+    // 阻塞属性在注册时采一次底（板级初始化上下文，碰总线无妨），
+    // 之后由应用的后台采集闭包周期刷新；序列化永远只读缓存
+    if (thing->has_blocking_properties()) {
+        thing->SampleBlockingProperties();
+        has_blocking_things_ = true;
+    }
+    // 注册新 thing 后缓存失效，下次取的时候重建
+    descriptors_json_.clear();
+}
+
+void ThingManager::SampleBlockingProperties() {
+    for (auto& thing : things_) {
+        if (thing->has_blocking_properties()) {
+            thing->SampleBlockingProperties();
+        }
+    }
 }
 
 std::string ThingManager::GetDescriptorsJson() {
+    // 描述符运行期不变，拼一次就缓存；通道打开是用户可感知的延迟路径
+    if (!descriptors_json_.empty()) {
+        return std::string(descriptors_json_.data(), descriptors_json_.size());
+    }
     std::string json_str = "[";
     for (auto& thing : things_) {
         json_str += thing->GetDescriptorJson() + ",";
@@ -19,27 +49,47 @@ std::string ThingManager::GetDescriptorsJson() {
         json_str.pop_back();
     }
     json_str += "]";
+    descriptors_json_.assign(json_str.data(), json_str.size());
     return json_str;
 }
 
-bool ThingManager::GetStatesJson(std::string& json, bool delta) {
+bool ThingManager::GetStatesJson(std::string& json, bool delta, bool skip_binary) {
     if (!delta) {
         last_states_.clear();
     }
     bool changed = false;
-    json = "[";
+    json.clear();
+    // 按上次的最终长度预留，拼接过程不再反复扩容
+    json.reserve(last_states_capacity_);
+    json += "[";
     // 枚举thing，获取每个thing的state，如果发生变化，则更新，保存到last_states_
     // 如果delta为true，则只返回变化的部分
     for (auto& thing : things_) {
+        if (skip_binary && thing->binary_state_enabled()) {
+            // 这个 thing 的状态走二进制通道，JSON 路径不再重复报
+            continue;
+        }
+        if (delta && !thing->IsStateDirty() &&
+            last_states_.find(thing->name()) != last_states_.end()) {
+            // 脏标记干净且已经上报过：状态不可能变，连序列化都不用做
+            continue;
+        }
         std::string state = thing->GetStateJson();
+        thing->ClearStateDirty();
         if (delta) {
             // 如果delta为true，则只返回变化的部分
             auto it = last_states_.find(thing->name());
-            if (it != last_states_.end() && it->second == state) {
+            if (it != last_states_.end() && it->second == state.c_str()) {
                 continue;
             }
             changed = true;
-            last_states_[thing->name()] = state;
+            if (it != last_states_.end()) {
+                it->second.assign(state.data(), state.size());
+            } else {
+                // operator[] 会用默认资源建值，这里必须显式带上池资源
+                last_states_.emplace(thing->name(),
+                    psram_pmr::string(state.data(), state.size(), psram_pmr::cold()));
+            }
         }
         json += state + ",";
     }
@@ -47,16 +97,279 @@ bool ThingManager::GetStatesJson(std::string& json, bool delta) {
         json.pop_back();
     }
     json += "]";
+    if (json.size() > last_states_capacity_) {
+        last_states_capacity_ = json.size();
+    }
     return changed;
 }
 
-void ThingManager::Invoke(const cJSON* command) {
-    auto name = cJSON_GetObjectItem(command, "name");
+bool ThingManager::GetStatesBinary(std::string& payload, bool delta) {
+    if (!delta) {
+        last_binary_.clear();
+    }
+    bool changed = false;
+    payload.clear();
+    // 与 GetStatesJson 同一套增量逻辑，只是序列化换成定长记录：
+    // 编码就是逐字节写值，状态路径上没有任何格式化开销
     for (auto& thing : things_) {
-        if (thing->name() == name->valuestring) {
-            thing->Invoke(command);
-            return;
+        if (!thing->binary_state_enabled()) {
+            continue;
+        }
+        if (delta && !thing->IsStateDirty() &&
+            last_binary_.find(thing->name()) != last_binary_.end()) {
+            continue;
+        }
+        uint8_t record[Thing::kBinaryStateMaxRecord];
+        size_t n = thing->WriteStateBinary(record, sizeof(record));
+        if (n == 0) {
+            continue;
+        }
+        thing->ClearStateDirty();
+        if (delta) {
+            auto it = last_binary_.find(thing->name());
+            if (it != last_binary_.end() && it->second.size() == n &&
+                memcmp(it->second.data(), record, n) == 0) {
+                continue;
+            }
+            changed = true;
+            if (it != last_binary_.end()) {
+                it->second.assign((const char*)record, n);
+            } else {
+                last_binary_.emplace(thing->name(),
+                    psram_pmr::string((const char*)record, n, psram_pmr::cold()));
+            }
+        }
+        payload.append((const char*)record, n);
+    }
+    return changed;
+}
+
+static inline const char* SkipWs(const char* p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+        p++;
+    }
+    return p;
+}
+
+// 拷出不含转义的短字符串值到定长缓冲；超长或带转义返回 nullptr。
+// 返回值指向收尾引号之后
+static const char* CopyPlainString(const char* p, char* out, size_t cap) {
+    if (*p != '"') {
+        return nullptr;
+    }
+    p++;
+    size_t n = 0;
+    while (*p != '"') {
+        if (*p == '\\' || *p == '\0' || n + 1 >= cap) {
+            return nullptr;
+        }
+        out[n++] = *p++;
+    }
+    out[n] = '\0';
+    return p + 1;
+}
+
+// 平衡跳过一个对象/数组（照顾字符串里的括号和转义）
+static const char* SkipBalanced(const char* p) {
+    int depth = 0;
+    do {
+        if (*p == '"') {
+            p++;
+            while (*p != '"') {
+                if (*p == '\\') {
+                    p++;
+                }
+                if (*p == '\0') {
+                    return nullptr;
+                }
+                p++;
+            }
+            p++;
+            continue;
+        }
+        if (*p == '{' || *p == '[') {
+            depth++;
+        } else if (*p == '}' || *p == ']') {
+            depth--;
+        } else if (*p == '\0') {
+            return nullptr;
         }
+        p++;
+    } while (depth > 0);
+    return p;
+}
+
+// 扫一个 command 对象，抽出 name/method 和 parameters 原文起点；
+// 成功返回指向 '}' 之后，任何受限模式外的形态返回 nullptr
+static const char* ScanCommand(const char* p, char* name, size_t name_cap,
+                               char* method, size_t method_cap, const char** params) {
+    *params = nullptr;
+    name[0] = '\0';
+    method[0] = '\0';
+    p = SkipWs(p);
+    if (*p != '{') {
+        return nullptr;
+    }
+    p = SkipWs(p + 1);
+    if (*p == '}') {
+        return nullptr;
+    }
+    char key[16];
+    while (true) {
+        p = CopyPlainString(p, key, sizeof(key));
+        if (p == nullptr) {
+            return nullptr;
+        }
+        p = SkipWs(p);
+        if (*p != ':') {
+            return nullptr;
+        }
+        p = SkipWs(p + 1);
+        if (strcmp(key, "name") == 0) {
+            p = CopyPlainString(p, name, name_cap);
+        } else if (strcmp(key, "method") == 0) {
+            p = CopyPlainString(p, method, method_cap);
+        } else if (strcmp(key, "parameters") == 0) {
+            if (*p != '{') {
+                return nullptr;
+            }
+            *params = p;
+            p = SkipBalanced(p);
+        } else if (*p == '"') {
+            // 其他字符串字段原样跳过
+            p++;
+            while (*p != '"') {
+                if (*p == '\\') {
+                    p++;
+                }
+                if (*p == '\0') {
+                    return nullptr;
+                }
+                p++;
+            }
+            p++;
+        } else if (*p == '{' || *p == '[') {
+            return nullptr;
+        } else {
+            while (*p != ',' && *p != '}' && *p != '\0') {
+                p++;
+            }
+        }
+        if (p == nullptr) {
+            return nullptr;
+        }
+        p = SkipWs(p);
+        if (*p == ',') {
+            p = SkipWs(p + 1);
+            continue;
+        }
+        if (*p == '}') {
+            break;
+        }
+        return nullptr;
+    }
+    return p + 1;
+}
+
+bool ThingManager::InvokeRaw(const char* json) {
+    // 顶层找 "commands" 数组，其余字段跳过
+    const char* p = SkipWs(json);
+    if (*p != '{') {
+        return false;
+    }
+    p = SkipWs(p + 1);
+    const char* commands = nullptr;
+    char key[16];
+    while (*p != '}') {
+        p = CopyPlainString(p, key, sizeof(key));
+        if (p == nullptr) {
+            return false;
+        }
+        p = SkipWs(p);
+        if (*p != ':') {
+            return false;
+        }
+        p = SkipWs(p + 1);
+        if (strcmp(key, "commands") == 0) {
+            if (*p != '[') {
+                return false;
+            }
+            commands = p;
+            p = SkipBalanced(p);
+        } else if (*p == '"') {
+            p++;
+            while (*p != '"') {
+                if (*p == '\\') {
+                    p++;
+                }
+                if (*p == '\0') {
+                    return false;
+                }
+                p++;
+            }
+            p++;
+        } else if (*p == '{' || *p == '[') {
+            p = SkipBalanced(p);
+        } else {
+            while (*p != ',' && *p != '}' && *p != '\0') {
+                p++;
+            }
+        }
+        if (p == nullptr) {
+            return false;
+        }
+        p = SkipWs(p);
+        if (*p == ',') {
+            p = SkipWs(p + 1);
+        } else if (*p != '}') {
+            return false;
+        }
+    }
+    if (commands == nullptr) {
+        return false;
+    }
+
+    // 两遍：第一遍只验证，第二遍才绑定参数并入队
+    for (int pass = 0; pass < 2; pass++) {
+        bool execute = pass == 1;
+        p = SkipWs(commands + 1);
+        if (*p == ']') {
+            return true;  // 空数组：老路径同样无事可做
+        }
+        while (true) {
+            char name[48];
+            char method[48];
+            const char* params;
+            p = ScanCommand(p, name, sizeof(name), method, sizeof(method), &params);
+            if (p == nullptr) {
+                return false;
+            }
+            auto it = thing_index_.find(name);
+            if (it == thing_index_.end()) {
+                return false;  // 未注册的 thing 交回老路径处理（会被忽略）
+            }
+            if (!it->second->InvokeRaw(method, params, execute)) {
+                return false;
+            }
+            p = SkipWs(p);
+            if (*p == ',') {
+                p = SkipWs(p + 1);
+                continue;
+            }
+            if (*p == ']') {
+                break;
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void ThingManager::Invoke(const cJSON* command) {
+    auto name = cJSON_GetObjectItem(command, "name");
+    auto it = thing_index_.find(name->valuestring);
+    if (it != thing_index_.end()) {
+        it->second->Invoke(command);
     }
 }
 
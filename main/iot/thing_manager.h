@@ -3,6 +3,7 @@
 
 
 #include "thing.h"
+#include "psram_pmr.h"
 
 #include <cJSON.h>
 
@@ -10,6 +11,7 @@
 #include <memory>
 #include <functional>
 #include <map>
+#include <unordered_map>
 
 namespace iot {
 
@@ -25,15 +27,42 @@ public:
     void AddThing(Thing* thing);
 
     std::string GetDescriptorsJson();
-    bool GetStatesJson(std::string& json, bool delta = false);
+    // skip_binary 为 true 时跳过走二进制通道的 thing（由协议层是否
+    // 支持 0x05 帧决定），避免同一状态两条路都报
+    bool GetStatesJson(std::string& json, bool delta = false, bool skip_binary = false);
+    // 二进制状态通道：把启用了二进制编码的 thing 的记录串进 payload，
+    // delta 语义与 GetStatesJson 一致（脏标记跳过 + 逐字节比对）
+    bool GetStatesBinary(std::string& payload, bool delta = false);
+    // 阻塞属性（I2C 读数这类 getter）的后台采样：在低优先级任务上
+    // 周期调用，刷新各 thing 的属性缓存。GetStatesJson/Binary 只读
+    // 缓存，通道建立路径不再碰硬件总线
+    void SampleBlockingProperties();
+    bool has_blocking_things() const { return has_blocking_things_; }
     void Invoke(const cJSON* command);
+    // 整条下行消息原文进来，零分配扫 "commands" 数组并逐条执行。
+    // 先整体验证再执行：数组中途有拿不准的形态直接返回 false 且
+    // 一条都不跑，回退的 cJSON 路径重放时不会重复触发已执行的命令
+    bool InvokeRaw(const char* json);
 
 private:
     ThingManager() = default;
     ~ThingManager() = default;
 
     std::vector<Thing*> things_;
-    std::map<std::string, std::string> last_states_;
+    // 常驻的状态快照和描述符缓存都是冷字符串，落 PSRAM 池
+    std::map<std::string, psram_pmr::string> last_states_;
+    // 二进制通道的上次记录快照（增量比对用）
+    std::map<std::string, psram_pmr::string> last_binary_;
+    // 已分配的二进制状态 id 数（注册序即 id）
+    int binary_things_ = 0;
+    // 注册了带阻塞属性的 thing 才调度采样闭包
+    bool has_blocking_things_ = false;
+    // 描述符在运行期不会变，注册完首次拼好就缓存；通道每次打开都要发它
+    psram_pmr::string descriptors_json_{psram_pmr::cold()};
+    // Invoke 按名字直查，不再线性扫 things_
+    std::unordered_map<std::string, Thing*> thing_index_;
+    // 上次状态 JSON 的长度，下次预留容量避免反复扩容
+    size_t last_states_capacity_ = 64;
 };
 
 
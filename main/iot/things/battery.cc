@@ -17,13 +17,16 @@ private:
 public:
     Battery() : Thing("Battery", "电池管理") {
         // 定义设备的属性
+        // GetBatteryLevel 在 AXP2101 这类板子上是 I2C 往返，标记阻塞：
+        // 真 getter 由后台采集器跑，状态上报只读缓存（charging 属性
+        // 读的是同一次采样顺手刷新的成员，保持即时）
         properties_.AddNumberProperty("level", "当前电量百分比", [this]() -> int {
             auto& board = Board::GetInstance();
             if (board.GetBatteryLevel(level_, charging_, discharging_)) {
                 return level_;
             }
             return 0;
-        });
+        }, true);
         properties_.AddBooleanProperty("charging", "是否充电中", [this]() -> int {
             return charging_;
         });
@@ -13,6 +13,9 @@ namespace iot {
 class Backlight : public Thing {
 public:
     Backlight() : Thing("Backlight", "屏幕背光") {
+        // 亮度只通过 SetBrightness 方法改变，增量上报可以跳过未动过的状态
+        EnableDirtyTracking();
+
         // 定义设备的属性
         properties_.AddNumberProperty("brightness", "当前亮度百分比", [this]() -> int {
             // 这里可以添加获取当前亮度的逻辑
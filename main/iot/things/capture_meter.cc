@@ -0,0 +1,30 @@
+#include "iot/thing.h"
+#include "capture_health.h"
+
+#define TAG "CaptureMeter"
+
+namespace iot {
+
+// 麦克风采集健康的只读面板：运维问一句“设备听得见吗”，服务器
+// 拉一次属性就有答案，不用再寄回来查增益和断线
+class CaptureMeter : public Thing {
+public:
+    CaptureMeter() : Thing("CaptureMeter", "麦克风采集健康") {
+        properties_.AddNumberProperty("mic_rms_db", "主通道滑窗 RMS（dBFS）", []() -> int {
+            return CaptureHealth::GetInstance().GetSnapshot().rms_db[0];
+        });
+        properties_.AddNumberProperty("mic_peak_db", "主通道峰值（dBFS）", []() -> int {
+            return CaptureHealth::GetInstance().GetSnapshot().peak_db[0];
+        });
+        properties_.AddNumberProperty("clip_count", "累计削顶采样数", []() -> int {
+            return (int)CaptureHealth::GetInstance().GetSnapshot().clips[0];
+        });
+        properties_.AddBooleanProperty("ref_dead", "回采参考通道疑似断线", []() -> bool {
+            return CaptureHealth::GetInstance().GetSnapshot().dead[1];
+        });
+    }
+};
+
+}  // namespace iot
+
+DECLARE_THING(CaptureMeter);
@@ -34,6 +34,8 @@ private:
 public:
     Lamp() : Thing("Lamp", "一个测试用的灯"), power_(false) {
         InitializeGpio();
+        // power_ 只通过方法改变，增量上报可以跳过未动过的状态
+        EnableDirtyTracking();
 
         // 定义设备的属性
         properties_.AddBooleanProperty("power", "灯是否打开", [this]() -> bool {
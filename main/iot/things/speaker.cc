@@ -12,6 +12,9 @@ namespace iot {
 class Speaker : public Thing {
 public:
     Speaker() : Thing("Speaker", "扬声器") {
+        // 音量只通过 SetVolume 方法改变，增量上报可以跳过未动过的状态
+        EnableDirtyTracking();
+
         // 定义设备的属性
         properties_.AddNumberProperty("volume", "当前音量值", [this]() -> int {
             auto codec = Board::GetInstance().GetAudioCodec();
@@ -0,0 +1,172 @@
+#include "jitter_buffer.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#define TAG "JitterBuffer"
+
+void JitterBuffer::Configure(int frame_duration_ms, size_t min_depth, size_t max_depth) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_duration_ms_ = frame_duration_ms;
+    min_depth_ = min_depth;
+    max_depth_ = max_depth;
+    target_depth_ = min_depth;
+    buffering_ = true;
+    // 缺省水位按容量推导，ConfigureWatermarks 可覆盖
+    high_watermark_ = max_depth * 3 / 4;
+    low_watermark_ = max_depth / 4;
+}
+
+void JitterBuffer::ConfigureWatermarks(size_t high, size_t low) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    high_watermark_ = high;
+    low_watermark_ = low;
+}
+
+void JitterBuffer::OnBackpressure(std::function<void(bool)> callback) {
+    backpressure_callback_ = callback;
+}
+
+void JitterBuffer::RaiseFloor(size_t min_depth) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (min_depth > max_depth_) {
+        min_depth = max_depth_;
+    }
+    min_depth_ = min_depth;
+    if (target_depth_ < min_depth_) {
+        target_depth_ = min_depth_;
+    }
+}
+
+void JitterBuffer::Push(std::vector<uint8_t>&& frame, uint32_t stream_ms) {
+    auto now = std::chrono::steady_clock::now();
+    bool notify_pause = false;
+    {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 空载荷是传输层的丢包标记：占一个播放槽位让解码端做隐藏，
+    // 但不是真实到达，不能喂进抖动估计
+    if (frame.empty()) {
+        frames_.emplace_back(AudioFrame{{}, {}, esp_timer_get_time()});
+        return;
+    }
+
+    if (has_last_arrival_) {
+        float interval_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+            now - last_arrival_).count() / 1000.0f;
+        // RFC 3550 风格的指数平滑抖动估计
+        if (avg_interval_ms_ == 0.0f) {
+            avg_interval_ms_ = interval_ms;
+        } else {
+            avg_interval_ms_ += (interval_ms - avg_interval_ms_) / 16.0f;
+        }
+        float deviation = interval_ms - avg_interval_ms_;
+        if (deviation < 0) {
+            deviation = -deviation;
+        }
+        jitter_ms_ += (deviation - jitter_ms_) / 16.0f;
+
+        // One frame of headroom plus enough to ride out the observed jitter
+        size_t target = 1 + (size_t)(jitter_ms_ * 2.0f / frame_duration_ms_ + 0.5f);
+        if (target < min_depth_) {
+            target = min_depth_;
+        } else if (target > max_depth_) {
+            target = max_depth_;
+        }
+        target_depth_ = target;
+    }
+    last_arrival_ = now;
+    has_last_arrival_ = true;
+
+    frames_.emplace_back(AudioFrame{std::move(frame), {}, esp_timer_get_time(), stream_ms});
+
+    // 越过高水位先请服务器暂停推流，丢帧只是最后的保险
+    if (!paused_ && frames_.size() >= high_watermark_) {
+        paused_ = true;
+        pause_events_++;
+        notify_pause = true;
+    }
+    DropLateFramesLocked();
+    }
+    if (notify_pause && backpressure_callback_) {
+        backpressure_callback_(true);
+    }
+}
+
+bool JitterBuffer::Pop(AudioFrame& frame) {
+    bool notify_resume = false;
+    bool popped = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (frames_.empty()) {
+            if (!buffering_) {
+                // Ran dry mid-stream: go back to pre-buffering
+                buffering_ = true;
+                underruns_++;
+            }
+        } else if (buffering_ && frames_.size() < target_depth_) {
+            // still pre-buffering
+        } else {
+            buffering_ = false;
+            frame = std::move(frames_.front());
+            frames_.pop_front();
+            popped = true;
+            // 消费到低水位，请服务器继续推
+            if (paused_ && frames_.size() <= low_watermark_) {
+                paused_ = false;
+                notify_resume = true;
+            }
+        }
+    }
+    if (notify_resume && backpressure_callback_) {
+        backpressure_callback_(false);
+    }
+    return popped;
+}
+
+void JitterBuffer::Clear() {
+    bool notify_resume = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 打断冲掉的帧记账：长回复的内存尖峰主要就耗在这里
+        abort_flushed_ += frames_.size();
+        frames_.clear();
+        buffering_ = true;
+        has_last_arrival_ = false;
+        if (paused_) {
+            paused_ = false;
+            notify_resume = true;
+        }
+    }
+    if (notify_resume && backpressure_callback_) {
+        backpressure_callback_(false);
+    }
+}
+
+bool JitterBuffer::IsEmpty() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frames_.empty();
+}
+
+JitterBuffer::Stats JitterBuffer::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Stats{
+        .depth = frames_.size(),
+        .target_depth = target_depth_,
+        .underruns = underruns_,
+        .late_drops = late_drops_,
+        .pause_events = pause_events_,
+        .abort_flushed = abort_flushed_,
+    };
+}
+
+void JitterBuffer::DropLateFramesLocked() {
+    while (frames_.size() > max_depth_) {
+        frames_.pop_front();
+        late_drops_++;
+    }
+    if (late_drops_ > 0 && late_drops_ % 50 == 1) {
+        ESP_LOGW(TAG, "Dropped %lu late frames, depth %zu target %zu",
+            late_drops_, frames_.size(), target_depth_);
+    }
+}
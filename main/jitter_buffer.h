@@ -0,0 +1,101 @@
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <cstdint>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// 网络音频的自适应抖动缓冲
+// Adaptive jitter buffer between Protocol::OnIncomingAudio and the
+// playout path. It delays playout start until a target depth of frames
+// is buffered, grows the target when the observed inter-arrival jitter
+// rises and shrinks it back when the link calms down, and drops the
+// oldest frames when the queue exceeds the allowed depth so latency
+// stays bounded.
+class JitterBuffer {
+public:
+    // A queued Opus packet: owned heap data (network audio) or a view
+    // into constant storage. UI 音效已分流到 SoundMixer，正常路径下
+    // 只有 owned 帧，view 形态保留给将来的零拷贝来源。
+    struct AudioFrame {
+        std::vector<uint8_t> owned;
+        std::string_view view;
+        // 到达时间（esp_timer_get_time），给延迟统计用；flash 切片为 0
+        int64_t recv_time_us = 0;
+        // 流时间线位置（ms，相对本轮 TTS 起点）；0 = 无时间戳。
+        // 带戳的帧在播放时校准字幕时间线（见 CreditAudioWindow）
+        uint32_t stream_ms = 0;
+
+        const uint8_t* data() const {
+            return owned.empty() ? (const uint8_t*)view.data() : owned.data();
+        }
+        size_t size() const {
+            return owned.empty() ? view.size() : owned.size();
+        }
+    };
+
+    struct Stats {
+        size_t depth;           // frames currently queued
+        size_t target_depth;    // current adaptive playout target
+        uint32_t underruns;     // Pop() calls that found no frame ready
+        uint32_t late_drops;    // frames dropped to bound latency
+        uint32_t pause_events;  // high-watermark crossings (backpressure sent)
+        uint32_t abort_flushed; // frames thrown away by Clear() on abort
+    };
+
+    // frame_duration_ms 与 Opus 帧长一致，用于把抖动换算成帧数
+    void Configure(int frame_duration_ms, size_t min_depth, size_t max_depth);
+    // 链路质量降档时抬高下限：宁可多垫几帧延迟也不要断续
+    void RaiseFloor(size_t min_depth);
+    // 背压水位，默认 Configure 时按 max_depth 推导（3/4 暂停、1/4 恢复）
+    void ConfigureWatermarks(size_t high, size_t low);
+    // 深度穿过高水位回调 true（该叫服务器停），回落到低水位回调 false。
+    // 回调在锁外执行，可以直接发协议消息
+    void OnBackpressure(std::function<void(bool paused)> callback);
+    // Network path: records arrival timing and adapts the target depth.
+    void Push(std::vector<uint8_t>&& frame, uint32_t stream_ms = 0);
+
+    // Returns false while pre-buffering or when the buffer underruns.
+    bool Pop(AudioFrame& frame);
+
+    void Clear();
+    bool IsEmpty();
+    Stats GetStats();
+
+private:
+    void DropLateFramesLocked();
+
+    std::mutex mutex_;
+    std::deque<AudioFrame> frames_;
+
+    int frame_duration_ms_ = 60;
+    size_t min_depth_ = 2;
+    size_t max_depth_ = 16;
+    size_t target_depth_ = 2;
+    bool buffering_ = true;
+
+    // EWMA of inter-arrival time and its deviation, in milliseconds
+    float avg_interval_ms_ = 0.0f;
+    float jitter_ms_ = 0.0f;
+    std::chrono::steady_clock::time_point last_arrival_;
+    bool has_last_arrival_ = false;
+
+    uint32_t underruns_ = 0;
+    uint32_t late_drops_ = 0;
+
+    // 服务器推流比实时快（TTS 就是），深度限死靠丢帧兜底会丢内容；
+    // 先用水位让服务器停一停，丢帧只剩最后的保险
+    size_t high_watermark_ = 15;
+    size_t low_watermark_ = 5;
+    bool paused_ = false;
+    uint32_t pause_events_ = 0;
+    uint32_t abort_flushed_ = 0;
+    std::function<void(bool)> backpressure_callback_;
+    // 一次性，触发后清空
+};
+
+#endif // JITTER_BUFFER_H
@@ -0,0 +1,114 @@
+#include "json_builder.h"
+
+#include <cstdio>
+#include <cstring>
+
+JsonBuilder::JsonBuilder(char* buffer, size_t capacity)
+    : buffer_(buffer), capacity_(capacity) {
+}
+
+void JsonBuilder::Put(char c) {
+    if (length_ + 1 >= capacity_) {
+        overflowed_ = true;
+        return;
+    }
+    buffer_[length_++] = c;
+}
+
+void JsonBuilder::Append(const char* s) {
+    size_t len = strlen(s);
+    if (length_ + len + 1 >= capacity_) {
+        overflowed_ = true;
+        return;
+    }
+    memcpy(buffer_ + length_, s, len);
+    length_ += len;
+}
+
+void JsonBuilder::AppendEscaped(const char* s) {
+    Put('"');
+    for (const char* p = s; *p != '\0'; ++p) {
+        char c = *p;
+        switch (c) {
+            case '"':  Append("\\\""); break;
+            case '\\': Append("\\\\"); break;
+            case '\n': Append("\\n"); break;
+            case '\r': Append("\\r"); break;
+            case '\t': Append("\\t"); break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char hex[8];
+                    snprintf(hex, sizeof(hex), "\\u%04x", c);
+                    Append(hex);
+                } else {
+                    Put(c);
+                }
+                break;
+        }
+    }
+    Put('"');
+}
+
+void JsonBuilder::BeginValue(const char* key) {
+    if (depth_ > 0 && (comma_stack_ & (1u << depth_))) {
+        Put(',');
+    }
+    if (depth_ > 0) {
+        comma_stack_ |= 1u << depth_;
+    }
+    if (key != nullptr) {
+        AppendEscaped(key);
+        Put(':');
+    }
+}
+
+void JsonBuilder::BeginObject(const char* key) {
+    BeginValue(key);
+    Put('{');
+    depth_++;
+    comma_stack_ &= ~(1u << depth_);
+}
+
+void JsonBuilder::EndObject() {
+    Put('}');
+    depth_--;
+}
+
+void JsonBuilder::BeginArray(const char* key) {
+    BeginValue(key);
+    Put('[');
+    depth_++;
+    comma_stack_ &= ~(1u << depth_);
+}
+
+void JsonBuilder::EndArray() {
+    Put(']');
+    depth_--;
+}
+
+void JsonBuilder::AddString(const char* key, const char* value) {
+    BeginValue(key);
+    AppendEscaped(value);
+}
+
+void JsonBuilder::AddNumber(const char* key, int value) {
+    BeginValue(key);
+    char num[16];
+    snprintf(num, sizeof(num), "%d", value);
+    Append(num);
+}
+
+void JsonBuilder::AddBool(const char* key, bool value) {
+    BeginValue(key);
+    Append(value ? "true" : "false");
+}
+
+void JsonBuilder::AddRaw(const char* key, const char* json) {
+    BeginValue(key);
+    Append(json);
+}
+
+const char* JsonBuilder::c_str() {
+    buffer_[length_ < capacity_ ? length_ : capacity_ - 1] = '\0';
+    return buffer_;
+}
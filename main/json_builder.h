@@ -0,0 +1,61 @@
+#ifndef JSON_BUILDER_H
+#define JSON_BUILDER_H
+
+#include <cstddef>
+#include <string>
+
+// 控制消息的定长缓冲 JSON 组装器
+// Serializes protocol control messages (hello / listen / iot) into a
+// caller-provided stack buffer in one pass, instead of chained
+// std::string operator+= that reallocates several times per message.
+// SendStartListening sits between wake word detection and the server
+// starting ASR, so build time here is on the interaction latency path.
+// String values are escaped; overflow sets a flag instead of writing
+// past the buffer so callers can fall back to the dynamic path.
+class JsonBuilder {
+public:
+    JsonBuilder(char* buffer, size_t capacity);
+
+    // key 为 nullptr 时作为数组元素或顶层值
+    void BeginObject(const char* key = nullptr);
+    void EndObject();
+    void BeginArray(const char* key = nullptr);
+    void EndArray();
+
+    // 字符串值做转义
+    void AddString(const char* key, const char* value);
+    void AddString(const char* key, const std::string& value) {
+        AddString(key, value.c_str());
+    }
+    void AddNumber(const char* key, int value);
+    void AddBool(const char* key, bool value);
+    // 已经序列化好的嵌套 JSON，原样拼入
+    void AddRaw(const char* key, const char* json);
+    void AddRaw(const char* key, const std::string& json) {
+        AddRaw(key, json.c_str());
+    }
+
+    // 保证 NUL 结尾后返回缓冲指针
+    const char* c_str();
+    size_t length() const { return length_; }
+    bool overflowed() const { return overflowed_; }
+    // 拷出 std::string，一次分配
+    std::string str() { return std::string(c_str(), length_); }
+
+private:
+    void Put(char c);
+    void Append(const char* s);
+    void AppendEscaped(const char* s);
+    // 同层的第二个成员起补逗号，key 非空时写出 "key":
+    void BeginValue(const char* key);
+
+    char* buffer_;
+    size_t capacity_;
+    size_t length_ = 0;
+    bool overflowed_ = false;
+    // 每层一位的"本层已有成员"标记，嵌套深度够协议消息用
+    uint32_t comma_stack_ = 0;
+    int depth_ = 0;
+};
+
+#endif // JSON_BUILDER_H
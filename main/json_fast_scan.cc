@@ -0,0 +1,154 @@
+#include "json_fast_scan.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static inline const char* SkipWhitespace(const char* p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+        p++;
+    }
+    return p;
+}
+
+// 解析一个字符串值到 out（nullptr 表示只跳过），处理常见转义；
+// 碰到 \u 直接放弃，让 cJSON 去管 UTF-16 代理对
+static const char* ScanString(const char* p, std::string* out) {
+    if (*p != '"') {
+        return nullptr;
+    }
+    p++;
+    while (*p != '"') {
+        if (*p == '\0') {
+            return nullptr;
+        }
+        if (*p == '\\') {
+            p++;
+            char c;
+            switch (*p) {
+                case '"':  c = '"'; break;
+                case '\\': c = '\\'; break;
+                case '/':  c = '/'; break;
+                case 'n':  c = '\n'; break;
+                case 'r':  c = '\r'; break;
+                case 't':  c = '\t'; break;
+                case 'b':  c = '\b'; break;
+                case 'f':  c = '\f'; break;
+                default:   return nullptr;  // \uXXXX 等，回退完整解析
+            }
+            if (out != nullptr) {
+                out->push_back(c);
+            }
+            p++;
+        } else {
+            if (out != nullptr) {
+                out->push_back(*p);
+            }
+            p++;
+        }
+    }
+    return p + 1;
+}
+
+// 跳过数字 / true / false / null 标量
+static const char* ScanScalar(const char* p) {
+    while (*p != ',' && *p != '}' && *p != '\0' &&
+           *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+        if (*p == '{' || *p == '[' || *p == '"') {
+            return nullptr;
+        }
+        p++;
+    }
+    return p;
+}
+
+// 平衡跳过嵌套数组/对象（照顾字符串里的括号和转义）；iot 的
+// commands 数组走这里原样越过，内容留给 ThingManager 二次扫描
+static const char* SkipNested(const char* p) {
+    int depth = 0;
+    do {
+        if (*p == '"') {
+            p = ScanString(p, nullptr);
+            if (p == nullptr) {
+                return nullptr;
+            }
+            continue;
+        }
+        if (*p == '{' || *p == '[') {
+            depth++;
+        } else if (*p == '}' || *p == ']') {
+            depth--;
+        } else if (*p == '\0') {
+            return nullptr;
+        }
+        p++;
+    } while (depth > 0);
+    return p;
+}
+
+bool JsonFastScan(const char* data, FastMessage& out) {
+    out.raw = data;
+    const char* p = SkipWhitespace(data);
+    if (*p != '{') {
+        return false;
+    }
+    p = SkipWhitespace(p + 1);
+    if (*p == '}') {
+        return false;  // 空对象没有 type
+    }
+
+    while (true) {
+        std::string key;
+        p = ScanString(p, &key);
+        if (p == nullptr) {
+            return false;
+        }
+        p = SkipWhitespace(p);
+        if (*p != ':') {
+            return false;
+        }
+        p = SkipWhitespace(p + 1);
+
+        if (*p == '"') {
+            std::string* dest = nullptr;
+            if (key == "type") {
+                dest = &out.type;
+            } else if (key == "state") {
+                dest = &out.state;
+            } else if (key == "text") {
+                dest = &out.text;
+            } else if (key == "emotion") {
+                dest = &out.emotion;
+            }
+            p = ScanString(p, dest);
+        } else if (*p == '{' || *p == '[') {
+            if (key == "commands" && *p == '[') {
+                p = SkipNested(p);
+            } else {
+                // 其他嵌套结构不在快速路径的射程内
+                return false;
+            }
+        } else {
+            if (key == "offset_ms") {
+                out.offset_ms = atoi(p);
+            }
+            p = ScanScalar(p);
+        }
+        if (p == nullptr) {
+            return false;
+        }
+
+        p = SkipWhitespace(p);
+        if (*p == ',') {
+            p = SkipWhitespace(p + 1);
+            continue;
+        }
+        if (*p == '}') {
+            break;
+        }
+        return false;
+    }
+
+    // 只替高频、结构稳定的消息类型做主，其余交还 cJSON
+    return out.type == "tts" || out.type == "stt" || out.type == "llm" ||
+           out.type == "iot";
+}
@@ -0,0 +1,32 @@
+#ifndef JSON_FAST_SCAN_H
+#define JSON_FAST_SCAN_H
+
+#include <string>
+
+// 下行高频消息的免建树解析
+// Streaming TTS pushes tts/stt/llm events dozens of times per second,
+// and each one used to allocate a full cJSON tree just to read two or
+// three string fields. JsonFastScan handles exactly that shape: a flat
+// object of string/scalar members, extracting type/state/text/emotion
+// in one pass over the buffer. Anything it is not sure about — nested
+// values, arrays, \u escapes, an unrecognized type — makes it return
+// false and the caller falls back to cJSON, so correctness never
+// depends on the fast path.
+struct FastMessage {
+    std::string type;
+    std::string state;
+    std::string text;
+    std::string emotion;
+    // sentence_start 的时间线位置（相对 TTS 音频起点，ms），
+    // 服务器没带字段时为 -1
+    int offset_ms = -1;
+    // 原始缓冲指针（生存期同协议回调）：iot 命令这类需要二次扫描
+    // 的消息由下游自己零分配解析，这里只负责认出类型
+    const char* raw = nullptr;
+};
+
+// 成功时返回 true 并填充 out；只认 type 为 tts/stt/llm/iot 的消息
+//（iot 的 commands 数组原样跳过，由 ThingManager::InvokeRaw 二次扫描）
+bool JsonFastScan(const char* data, FastMessage& out);
+
+#endif // JSON_FAST_SCAN_H
@@ -0,0 +1,59 @@
+#include "latency_tracker.h"
+
+#if CONFIG_AUDIO_LATENCY_STATS
+
+#include <esp_log.h>
+
+#define TAG "Latency"
+
+static const char* STAGE_NAMES[] = {
+    "capture", "encode", "send", "decode", "output", "rx_isr_gap"
+};
+
+void LatencyTracker::Record(Stage stage, int64_t duration_us) {
+    if (duration_us < 0) {
+        return;
+    }
+    auto& histogram = histograms_[stage];
+    // 桶号 = log2(us)，0us 落在第 0 桶
+    int bucket = 0;
+    while (bucket < kNumBuckets - 1 && (duration_us >> (bucket + 1)) != 0) {
+        bucket++;
+    }
+    histogram.buckets[bucket]++;
+    histogram.count++;
+    if (duration_us > histogram.max_us) {
+        histogram.max_us = duration_us;
+    }
+}
+
+int64_t LatencyTracker::PercentileUs(const Histogram& histogram, int percent) const {
+    if (histogram.count == 0) {
+        return 0;
+    }
+    uint32_t threshold = (histogram.count * percent + 99) / 100;
+    uint32_t cumulative = 0;
+    for (int i = 0; i < kNumBuckets; i++) {
+        cumulative += histogram.buckets[i];
+        if (cumulative >= threshold) {
+            // 报桶的上界，误差最多一倍，排延迟够用了
+            return (int64_t)1 << (i + 1);
+        }
+    }
+    return histogram.max_us;
+}
+
+void LatencyTracker::Report() {
+    for (int i = 0; i < kStageCount; i++) {
+        auto& histogram = histograms_[i];
+        if (histogram.count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%s: n=%lu p50=%lldus p95=%lldus max=%lldus",
+            STAGE_NAMES[i], histogram.count,
+            PercentileUs(histogram, 50), PercentileUs(histogram, 95),
+            histogram.max_us);
+    }
+}
+
+#endif // CONFIG_AUDIO_LATENCY_STATS
@@ -0,0 +1,71 @@
+#ifndef LATENCY_TRACKER_H
+#define LATENCY_TRACKER_H
+
+#include <sdkconfig.h>
+
+#if CONFIG_AUDIO_LATENCY_STATS
+
+#include <cstdint>
+#include <cstddef>
+
+// 音频链路分段延迟统计
+// Per-stage latency histograms for the audio pipeline. Each stage keeps
+// an exponential-bucket histogram (power-of-two microsecond buckets) so
+// recording is a few instructions on the hot path and percentiles come
+// out of a 32-entry walk at report time. Counters are not atomic: the
+// numbers are telemetry, an occasional lost increment is acceptable.
+class LatencyTracker {
+public:
+    enum Stage {
+        kStageCapture = 0,  // 采集帧读出 -> 编码完成
+        kStageEncode,       // Opus 编码本体
+        kStageSend,         // 编码完成 -> 交给协议层发送
+        kStageDecode,       // Opus 解码本体
+        kStageOutput,       // 收到下行包 -> 写入 codec 输出
+        kStageRxIsrGap,     // I2S 收包完成中断的到达间隔（核亲和验证）
+        kStageCount
+    };
+
+    static LatencyTracker& GetInstance() {
+        static LatencyTracker instance;
+        return instance;
+    }
+    LatencyTracker(const LatencyTracker&) = delete;
+    LatencyTracker& operator=(const LatencyTracker&) = delete;
+
+    void Record(Stage stage, int64_t duration_us);
+    // 打印每个阶段的 p50/p95/max，跟 OnClockTimer 的内存日志放在一起
+    void Report();
+
+private:
+    LatencyTracker() = default;
+
+    static constexpr int kNumBuckets = 32;
+
+    struct Histogram {
+        uint32_t buckets[kNumBuckets];
+        uint32_t count;
+        int64_t max_us;
+    };
+
+    int64_t PercentileUs(const Histogram& histogram, int percent) const;
+
+    Histogram histograms_[kStageCount] = {};
+};
+
+#endif // CONFIG_AUDIO_LATENCY_STATS
+
+// 热路径打点宏：关掉 CONFIG_AUDIO_LATENCY_STATS 后不取时间戳、不留代码
+#if CONFIG_AUDIO_LATENCY_STATS
+#include <esp_timer.h>
+#define LATENCY_TIMESTAMP(var) int64_t var = esp_timer_get_time()
+#define LATENCY_RECORD(stage, start_us) \
+    LatencyTracker::GetInstance().Record(LatencyTracker::stage, esp_timer_get_time() - (start_us))
+#define LATENCY_REPORT() LatencyTracker::GetInstance().Report()
+#else
+#define LATENCY_TIMESTAMP(var) int64_t var = 0
+#define LATENCY_RECORD(stage, start_us) (void)(start_us)
+#define LATENCY_REPORT()
+#endif
+
+#endif // LATENCY_TRACKER_H
@@ -11,6 +11,8 @@ CircularStrip::CircularStrip(gpio_num_t gpio, uint8_t max_leds) : max_leds_(max_
     assert(gpio != GPIO_NUM_NC);
 
     colors_.resize(max_leds_);
+    frame_.resize(max_leds_);
+    push_frame_.resize(max_leds_);
 
     led_strip_config_t strip_config = {};
     strip_config.strip_gpio_num = gpio;
@@ -24,46 +26,86 @@ CircularStrip::CircularStrip(gpio_num_t gpio, uint8_t max_leds) : max_leds_(max_
     ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip_));
     led_strip_clear(led_strip_);
 
-    esp_timer_create_args_t strip_timer_args = {
-        .callback = [](void *arg) {
-            auto strip = static_cast<CircularStrip*>(arg);
-            std::lock_guard<std::mutex> lock(strip->mutex_);
-            if (strip->strip_callback_ != nullptr) {
-                strip->strip_callback_();
-            }
-        },
-        .arg = this,
-        .dispatch_method = ESP_TIMER_TASK,
-        .name = "strip_timer",
-        .skip_unhandled_events = false,
-    };
-    ESP_ERROR_CHECK(esp_timer_create(&strip_timer_args, &strip_timer_));
+    // 以前动画直接跑在共享的 esp_timer 任务里，32 灯的环形屏一帧
+    // RMT 阻塞一毫秒多，时钟定时器等其他用户全被拖着排队。现在
+    // 专职任务推帧，定时也由它自己用带超时的通知等出来
+    xTaskCreate([](void* arg) {
+        auto this_ = static_cast<CircularStrip*>(arg);
+        this_->StripTaskLoop();
+        vTaskDelete(NULL);
+    }, "led_strip", 2048, this, 1, &strip_task_);
 }
 
 CircularStrip::~CircularStrip() {
-    esp_timer_stop(strip_timer_);
+    if (strip_task_ != nullptr) {
+        vTaskDelete(strip_task_);
+    }
     if (led_strip_ != nullptr) {
         led_strip_del(led_strip_);
     }
 }
 
+void CircularStrip::CommitFrameLocked() {
+    frame_pending_ = true;
+    if (strip_task_ != nullptr) {
+        xTaskNotifyGive(strip_task_);
+    }
+}
+
+void CircularStrip::StripTaskLoop() {
+    while (true) {
+        TickType_t timeout = portMAX_DELAY;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (animation_running_ && interval_ms_ > 0) {
+                timeout = pdMS_TO_TICKS(interval_ms_);
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, timeout);
+
+        bool push = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (animation_running_ && strip_callback_ != nullptr) {
+                // 动画回调只在锁内准备 frame_，不碰 RMT
+                strip_callback_();
+                push = true;
+            } else if (frame_pending_) {
+                push = true;
+            }
+            if (push) {
+                frame_pending_ = false;
+                // 拷到推帧缓冲后立刻放锁：传输阻塞期间
+                // 下一帧可以继续准备
+                push_frame_ = frame_;
+            }
+        }
+        if (push) {
+            for (int i = 0; i < max_leds_; i++) {
+                led_strip_set_pixel(led_strip_, i,
+                    push_frame_[i].red, push_frame_[i].green, push_frame_[i].blue);
+            }
+            led_strip_refresh(led_strip_);
+        }
+    }
+}
 
 void CircularStrip::SetAllColor(StripColor color) {
     std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(strip_timer_);
+    animation_running_ = false;
     for (int i = 0; i < max_leds_; i++) {
         colors_[i] = color;
-        led_strip_set_pixel(led_strip_, i, color.red, color.green, color.blue);
+        frame_[i] = color;
     }
-    led_strip_refresh(led_strip_);
+    CommitFrameLocked();
 }
 
 void CircularStrip::SetSingleColor(uint8_t index, StripColor color) {
     std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(strip_timer_);
+    animation_running_ = false;
     colors_[index] = color;
-    led_strip_set_pixel(led_strip_, index, color.red, color.green, color.blue);
-    led_strip_refresh(led_strip_);
+    frame_ = colors_;
+    CommitFrameLocked();
 }
 
 void CircularStrip::Blink(StripColor color, int interval_ms) {
@@ -73,12 +115,11 @@ void CircularStrip::Blink(StripColor color, int interval_ms) {
     StartStripTask(interval_ms, [this]() {
         static bool on = true;
         if (on) {
+            frame_ = colors_;
+        } else {
             for (int i = 0; i < max_leds_; i++) {
-                led_strip_set_pixel(led_strip_, i, colors_[i].red, colors_[i].green, colors_[i].blue);
+                frame_[i] = StripColor{};
             }
-            led_strip_refresh(led_strip_);
-        } else {
-            led_strip_clear(led_strip_);
         }
         on = !on;
     });
@@ -94,13 +135,10 @@ void CircularStrip::FadeOut(int interval_ms) {
             if (colors_[i].red != 0 || colors_[i].green != 0 || colors_[i].blue != 0) {
                 all_off = false;
             }
-            led_strip_set_pixel(led_strip_, i, colors_[i].red, colors_[i].green, colors_[i].blue);
+            frame_[i] = colors_[i];
         }
         if (all_off) {
-            led_strip_clear(led_strip_);
-            esp_timer_stop(strip_timer_);
-        } else {
-            led_strip_refresh(led_strip_);
+            animation_running_ = false;
         }
     });
 }
@@ -137,9 +175,8 @@ void CircularStrip::Breathe(StripColor low, StripColor high, int interval_ms) {
             }
         }
         for (int i = 0; i < max_leds_; i++) {
-            led_strip_set_pixel(led_strip_, i, color.red, color.green, color.blue);
+            frame_[i] = color;
         }
-        led_strip_refresh(led_strip_);
     });
 }
 
@@ -156,10 +193,7 @@ void CircularStrip::Scroll(StripColor low, StripColor high, int length, int inte
             int i = (offset + j) % max_leds_;
             colors_[i] = high;
         }
-        for (int i = 0; i < max_leds_; i++) {
-            led_strip_set_pixel(led_strip_, i, colors_[i].red, colors_[i].green, colors_[i].blue);
-        }
-        led_strip_refresh(led_strip_);
+        frame_ = colors_;
         offset = (offset + 1) % max_leds_;
     });
 }
@@ -170,10 +204,12 @@ void CircularStrip::StartStripTask(int interval_ms, std::function<void()> cb) {
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(strip_timer_);
-    
     strip_callback_ = cb;
-    esp_timer_start_periodic(strip_timer_, interval_ms * 1000);
+    interval_ms_ = interval_ms;
+    animation_running_ = true;
+    if (strip_task_ != nullptr) {
+        xTaskNotifyGive(strip_task_);
+    }
 }
 
 void CircularStrip::SetBrightness(uint8_t default_brightness, uint8_t low_brightness) {
@@ -4,8 +4,9 @@
 #include "led.h"
 #include <driver/gpio.h>
 #include <led_strip.h>
-#include <esp_timer.h>
-#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <functional>
 #include <mutex>
 #include <vector>
 
@@ -31,21 +32,31 @@ public:
 
 private:
     std::mutex mutex_;
-    TaskHandle_t blink_task_ = nullptr;
     led_strip_handle_t led_strip_ = nullptr;
     int max_leds_ = 0;
+    // colors_ 是动画的逻辑状态，frame_ 是锁内准备好的下一帧，
+    // push_frame_ 是推帧任务锁外持有的拷贝——RMT 阻塞期间
+    // 动画和状态切换可以继续改 frame_，互不踩踏
     std::vector<StripColor> colors_;
-    int blink_counter_ = 0;
-    int blink_interval_ms_ = 0;
-    esp_timer_handle_t strip_timer_ = nullptr;
+    std::vector<StripColor> frame_;
+    std::vector<StripColor> push_frame_;
+
+    // 动画和静态帧都由专职低优先级任务推给 RMT：阻塞的传输等待
+    // 不再发生在共享的 esp_timer 任务或主循环上
+    TaskHandle_t strip_task_ = nullptr;
     std::function<void()> strip_callback_ = nullptr;
+    bool animation_running_ = false;
+    bool frame_pending_ = false;
+    int interval_ms_ = 0;
 
     uint8_t default_brightness_ = DEFAULT_BRIGHTNESS;
     uint8_t low_brightness_ = LOW_BRIGHTNESS;
 
     void StartStripTask(int interval_ms, std::function<void()> cb);
-    void Rainbow(StripColor low, StripColor high, int interval_ms);
     void FadeOut(int interval_ms);
+    void StripTaskLoop();
+    // 锁内调用：标记 frame_ 待推并唤醒推帧任务
+    void CommitFrameLocked();
 };
 
 #endif // _CIRCULAR_STRIP_H_
@@ -0,0 +1,60 @@
+#include "long_task_detector.h"
+#include "json_builder.h"
+
+#include <esp_log.h>
+
+#define TAG "LongTask"
+
+void LongTaskDetector::RecordSlow(const char* tag, int64_t elapsed_us) {
+    if (tag == nullptr) {
+        tag = "untagged";
+    }
+    ESP_LOGW(TAG, "closure '%s' ran %lld ms (budget %lld ms)",
+             tag, elapsed_us / 1000, budget_us_ / 1000);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    total_slow_++;
+    // tag 是常驻字面量，指针比较即可；没抢到空位的都记进最后一格
+    size_t slot = kMaxEntries - 1;
+    for (size_t i = 0; i < kMaxEntries; i++) {
+        if (entries_[i].tag == tag || entries_[i].tag == nullptr) {
+            slot = i;
+            break;
+        }
+    }
+    if (entries_[slot].tag == nullptr) {
+        entries_[slot].tag = (slot == kMaxEntries - 1) ? "other" : tag;
+    }
+    entries_[slot].count++;
+    if (elapsed_us > entries_[slot].worst_us) {
+        entries_[slot].worst_us = elapsed_us;
+    }
+}
+
+std::string LongTaskDetector::BuildJson() {
+    char buffer[512];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    json.AddNumber("budget_ms", (int)(budget_us_ / 1000));
+    json.AddNumber("total", (int)total_slow_);
+    json.BeginArray("slow");
+    for (size_t i = 0; i < kMaxEntries; i++) {
+        if (entries_[i].tag == nullptr) {
+            break;
+        }
+        json.BeginObject();
+        json.AddString("tag", entries_[i].tag);
+        json.AddNumber("count", (int)entries_[i].count);
+        json.AddNumber("worst_ms", (int)(entries_[i].worst_us / 1000));
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    // 8 条定长条目 512 字节放得下，溢出只可能是表改大了忘了调缓冲
+    if (json.overflowed()) {
+        return "{}";
+    }
+    return json.str();
+}
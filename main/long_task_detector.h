@@ -0,0 +1,55 @@
+#ifndef LONG_TASK_DETECTOR_H
+#define LONG_TASK_DETECTOR_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 调度闭包的长任务探测器。主循环和后台工人逐个执行闭包，一个慢闭包
+// 就会把音频压在后面——以前只能靠耳朵听出来。这里给每次执行计时，
+// 超预算的按调度点提供的 tag 记账并打日志，把最难查的延迟毛刺变成
+// 遥测里有名有姓的条目。
+// Record 的快路径只有一次比较，不超预算时零开销。
+class LongTaskDetector {
+public:
+    static LongTaskDetector& GetInstance() {
+        static LongTaskDetector instance;
+        return instance;
+    }
+    LongTaskDetector(const LongTaskDetector&) = delete;
+    LongTaskDetector& operator=(const LongTaskDetector&) = delete;
+
+    // 预算（毫秒），默认 20ms；0 关闭探测
+    void SetBudgetMs(int budget_ms) { budget_us_ = budget_ms * 1000; }
+
+    // tag 必须是常驻字符串（调度点的字面量），按指针去重
+    void Record(const char* tag, int64_t elapsed_us) {
+        if (budget_us_ <= 0 || elapsed_us < budget_us_) {
+            return;
+        }
+        RecordSlow(tag, elapsed_us);
+    }
+
+    // 遥测快照：{"budget_ms":20,"total":N,"slow":[{"tag":...,"count":N,"worst_ms":N},...]}
+    std::string BuildJson();
+
+private:
+    LongTaskDetector() = default;
+
+    struct Entry {
+        const char* tag = nullptr;
+        uint32_t count = 0;
+        int64_t worst_us = 0;
+    };
+    // 超预算的 tag 通常只有个位数，定长表够用；溢出的归进最后一格
+    static constexpr size_t kMaxEntries = 8;
+
+    void RecordSlow(const char* tag, int64_t elapsed_us);
+
+    std::mutex mutex_;
+    Entry entries_[kMaxEntries];
+    uint32_t total_slow_ = 0;
+    int64_t budget_us_ = 20 * 1000;
+};
+
+#endif // LONG_TASK_DETECTOR_H
@@ -7,6 +7,9 @@
 
 #include "application.h"
 #include "system_info.h"
+#if CONFIG_AUDIO_BENCHMARK
+#include "audio_benchmark.h"
+#endif
 
 #define TAG "main"
 
@@ -24,6 +27,12 @@ extern "C" void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
 
+#if CONFIG_AUDIO_BENCHMARK
+    // 基准测试固件：跑完标准 DSP 负载直接退出，不启动应用
+    audio_benchmark::Run();
+    return;
+#endif
+
     // Launch the application
     Application::GetInstance().Start();
     // The main thread will exit and release the stack memory
@@ -0,0 +1,123 @@
+#include "memory_budget.h"
+#include "config.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#define TAG "MemoryBudget"
+
+// 板级 config.h 可覆盖：预算之外留给运行期动态分配（TLS 握手、
+// 事件环、抖动缓冲临时增长）的 PSRAM 余量
+#ifndef PSRAM_BUDGET_RESERVE_KB
+#define PSRAM_BUDGET_RESERVE_KB 256
+#endif
+
+namespace memory_budget {
+
+namespace {
+
+struct Entry {
+    const char* name;
+    size_t declared;
+    size_t actual;  // 0 = 未回填
+    bool granted;
+};
+
+std::mutex mutex;
+std::vector<Entry> entries;
+bool initialized = false;
+bool has_psram = false;
+size_t budget = 0;   // 可分配总预算
+size_t claimed = 0;  // 已批准的声明值合计（回填后按实测算）
+
+// Claim 可能比 Application::Start 里的显式 Init 先到（板级构造里
+// 的显示缓冲），所以初始化做成懒式幂等
+void EnsureInitLocked() {
+    if (initialized) {
+        return;
+    }
+    initialized = true;
+    has_psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+    if (!has_psram) {
+        ESP_LOGI(TAG, "No PSRAM, budget gate disabled");
+        return;
+    }
+    // 以当前空闲为基数而不是总量：到这里已经花掉的（堆元数据、
+    // 事件环）不该重复记进预算
+    size_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    size_t reserve = PSRAM_BUDGET_RESERVE_KB * 1024;
+    budget = free_bytes > reserve ? free_bytes - reserve : 0;
+    ESP_LOGI(TAG, "PSRAM budget: %u KB of %u KB free (%u KB runtime reserve)",
+        (unsigned)(budget / 1024), (unsigned)(free_bytes / 1024),
+        (unsigned)(reserve / 1024));
+}
+
+}  // namespace
+
+void Init() {
+    std::lock_guard<std::mutex> lock(mutex);
+    EnsureInitLocked();
+}
+
+bool Claim(const char* name, size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    EnsureInitLocked();
+    bool granted = !has_psram || claimed + bytes <= budget;
+    entries.push_back({name, bytes, 0, granted});
+    if (granted) {
+        claimed += bytes;
+        if (has_psram) {
+            ESP_LOGI(TAG, "%s: %u KB granted (%u of %u KB committed)",
+                name, (unsigned)(bytes / 1024),
+                (unsigned)(claimed / 1024), (unsigned)(budget / 1024));
+        }
+    } else {
+        ESP_LOGW(TAG, "%s: %u KB denied (%u of %u KB committed)",
+            name, (unsigned)(bytes / 1024),
+            (unsigned)(claimed / 1024), (unsigned)(budget / 1024));
+    }
+    return granted;
+}
+
+void Settle(const char* name, size_t actual_bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        if (it->granted && strcmp(it->name, name) == 0) {
+            // 把额度里的声明值换成实测值，后来者按真实水位审批
+            claimed = claimed - it->declared + actual_bytes;
+            it->actual = actual_bytes;
+            if (actual_bytes > it->declared) {
+                ESP_LOGW(TAG, "%s: actual %u KB exceeds declared %u KB",
+                    name, (unsigned)(actual_bytes / 1024),
+                    (unsigned)(it->declared / 1024));
+            }
+            return;
+        }
+    }
+}
+
+std::string BuildJson() {
+    std::lock_guard<std::mutex> lock(mutex);
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "{\"budget\":%u,\"claimed\":%u,\"entries\":[",
+        (unsigned)budget, (unsigned)claimed);
+    std::string json = buffer;
+    bool first = true;
+    for (auto& entry : entries) {
+        snprintf(buffer, sizeof(buffer),
+            "%s{\"name\":\"%s\",\"declared\":%u,\"actual\":%u,\"granted\":%s}",
+            first ? "" : ",", entry.name, (unsigned)entry.declared,
+            (unsigned)entry.actual, entry.granted ? "true" : "false");
+        json += buffer;
+        first = false;
+    }
+    json += "]}";
+    return json;
+}
+
+}  // namespace memory_budget
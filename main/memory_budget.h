@@ -0,0 +1,36 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <cstddef>
+#include <string>
+
+// PSRAM 预算账本
+// esp_srmodel_init、AFE、LVGL 整帧缓冲这些大户各自吃掉几百 KB 的
+// PSRAM，实际占多少只有盯着 free 曲线掉下去才知道；2MB PSRAM 的
+// 板子（atoms3r-echo-base 这类）几家合计超额时的表现是分配失败
+// 连环崩、开机回环。这里让每个大户在分配之前先来记账：按声明额度
+// 对照板载 PSRAM 审批，批不下来的调用方走自己的降级路径（跳过
+// 唤醒词、整帧缓冲退回行缓冲）而不是带着整机一起重启。批准之后
+// 可以用实测值回填（Settle），账本通过遥测的 psram_budget 面板可查
+namespace memory_budget {
+
+// 开机尽早调用（任何大件 PSRAM 分配之前）：采板载 PSRAM 的空闲量，
+// 扣掉运行期余量得出可分配预算
+void Init();
+
+// 申请 bytes 字节的 PSRAM 额度。放得下返回 true 并记账；放不下
+// 返回 false（记日志，账本里留 denied 条目），调用方自行降级。
+// name 须是常驻字符串。没有 PSRAM 的板子一律放行——那类板子上
+// 这些消费者本来就各有内部堆方案，预算门不掺和
+bool Claim(const char* name, size_t bytes);
+
+// 用实测占用回填声明值（esp_srmodel_init 这类只有事后量 free 落差
+// 才知道准确数的消费者），让账本反映真实水位
+void Settle(const char* name, size_t actual_bytes);
+
+// 账本快照：预算/已批合计 + 逐项声明/实测/批驳，挂 TelemetryRegistry
+std::string BuildJson();
+
+}  // namespace memory_budget
+
+#endif  // MEMORY_BUDGET_H
@@ -0,0 +1,101 @@
+#ifndef MESSAGE_TOKENS_H
+#define MESSAGE_TOKENS_H
+
+#include <cstdint>
+#include <cstring>
+
+// 协议消息 type/state 词表的编译期完美哈希。FNV-1a 在这个小词表上
+// 无碰撞（static_assert 把关，新增词条撞上会在编译期爆出来），
+// 运行时一遍哈希 + 一次 strcmp 校验就能分发，消息路径上不再整条
+// strcmp 链挨个比
+namespace message_tokens {
+
+constexpr uint32_t Fnv1a(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h = (h ^ (uint8_t)*s++) * 16777619u;
+    }
+    return h;
+}
+
+enum MessageType {
+    kTypeUnknown = 0,
+    kTypeTts,
+    kTypeStt,
+    kTypeLlm,
+    kTypeIot,
+    kTypeHello,
+    kTypeGoodbye,
+    kTypeResume,
+    kTypeEncoderProfile,
+    kTypeMetrics,
+    kTypeTelemetry,
+};
+
+enum MessageState {
+    kStateUnknown = 0,
+    kStateStart,
+    kStateStop,
+    kStateSentenceStart,
+    kStateDetect,
+};
+
+constexpr uint32_t kTypeHashes[] = {
+    Fnv1a("tts"), Fnv1a("stt"), Fnv1a("llm"), Fnv1a("iot"), Fnv1a("hello"),
+    Fnv1a("goodbye"), Fnv1a("resume"), Fnv1a("encoder_profile"), Fnv1a("metrics"), Fnv1a("telemetry"),
+};
+constexpr uint32_t kStateHashes[] = {
+    Fnv1a("start"), Fnv1a("stop"), Fnv1a("sentence_start"), Fnv1a("detect"),
+};
+
+constexpr bool AllDistinct(const uint32_t* hashes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = i + 1; j < count; j++) {
+            if (hashes[i] == hashes[j]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+static_assert(AllDistinct(kTypeHashes, sizeof(kTypeHashes) / sizeof(kTypeHashes[0])),
+    "message type vocabulary has an FNV-1a collision, pick another hash seed");
+static_assert(AllDistinct(kStateHashes, sizeof(kStateHashes) / sizeof(kStateHashes[0])),
+    "message state vocabulary has an FNV-1a collision, pick another hash seed");
+
+// 哈希命中后仍校验一次原文：词表外的串可能撞上词表内的哈希
+inline MessageType ParseType(const char* s) {
+    if (s == nullptr) {
+        return kTypeUnknown;
+    }
+    switch (Fnv1a(s)) {
+        case Fnv1a("tts"):             return strcmp(s, "tts") == 0 ? kTypeTts : kTypeUnknown;
+        case Fnv1a("stt"):             return strcmp(s, "stt") == 0 ? kTypeStt : kTypeUnknown;
+        case Fnv1a("llm"):             return strcmp(s, "llm") == 0 ? kTypeLlm : kTypeUnknown;
+        case Fnv1a("iot"):             return strcmp(s, "iot") == 0 ? kTypeIot : kTypeUnknown;
+        case Fnv1a("hello"):           return strcmp(s, "hello") == 0 ? kTypeHello : kTypeUnknown;
+        case Fnv1a("goodbye"):         return strcmp(s, "goodbye") == 0 ? kTypeGoodbye : kTypeUnknown;
+        case Fnv1a("resume"):          return strcmp(s, "resume") == 0 ? kTypeResume : kTypeUnknown;
+        case Fnv1a("encoder_profile"): return strcmp(s, "encoder_profile") == 0 ? kTypeEncoderProfile : kTypeUnknown;
+        case Fnv1a("metrics"):         return strcmp(s, "metrics") == 0 ? kTypeMetrics : kTypeUnknown;
+        case Fnv1a("telemetry"):       return strcmp(s, "telemetry") == 0 ? kTypeTelemetry : kTypeUnknown;
+    }
+    return kTypeUnknown;
+}
+
+inline MessageState ParseState(const char* s) {
+    if (s == nullptr) {
+        return kStateUnknown;
+    }
+    switch (Fnv1a(s)) {
+        case Fnv1a("start"):          return strcmp(s, "start") == 0 ? kStateStart : kStateUnknown;
+        case Fnv1a("stop"):           return strcmp(s, "stop") == 0 ? kStateStop : kStateUnknown;
+        case Fnv1a("sentence_start"): return strcmp(s, "sentence_start") == 0 ? kStateSentenceStart : kStateUnknown;
+        case Fnv1a("detect"):         return strcmp(s, "detect") == 0 ? kStateDetect : kStateUnknown;
+    }
+    return kStateUnknown;
+}
+
+}  // namespace message_tokens
+
+#endif // MESSAGE_TOKENS_H
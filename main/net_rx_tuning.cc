@@ -0,0 +1,40 @@
+#include "net_rx_tuning.h"
+#include "config.h"
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define TAG "NetRxTuning"
+
+// 收包任务的目标优先级。高过 LVGL（1）和主循环，低于音频管线，
+// 让下行包从驱动到协议回调一路不被渲染挤占。0 表示不动优先级
+#ifndef NET_RX_TASK_PRIORITY
+#define NET_RX_TASK_PRIORITY 12
+#endif
+
+namespace net_rx_tuning {
+
+void Apply() {
+#if NET_RX_TASK_PRIORITY > 0
+    // 各组件的任务名：esp-mqtt 的客户端任务、LwIP 的 tiT、
+    // esp_websocket_client 的收包任务。WiFi 任务自带高优先级（23）
+    // 不用动；名字找不到属正常（比如收包在别的任务上下文里做），
+    // 不当错误
+    static const char* kRxTasks[] = { "mqtt_task", "tiT", "websocket_task" };
+    for (auto name : kRxTasks) {
+        TaskHandle_t handle = xTaskGetHandle(name);
+        if (handle == nullptr) {
+            continue;
+        }
+        UBaseType_t prio = uxTaskPriorityGet(handle);
+        if ((int)prio < NET_RX_TASK_PRIORITY) {
+            vTaskPrioritySet(handle, NET_RX_TASK_PRIORITY);
+            ESP_LOGI(TAG, "Task %s priority %u -> %d",
+                name, (unsigned)prio, NET_RX_TASK_PRIORITY);
+        }
+    }
+#endif
+}
+
+}  // namespace net_rx_tuning
@@ -0,0 +1,21 @@
+#ifndef NET_RX_TUNING_H
+#define NET_RX_TUNING_H
+
+// 网络收包任务的优先级/亲和整定
+// 传输库（esp-mqtt、WebSocket、LwIP）的任务用的都是组件默认优先级、
+// 默认亲和，跟 LVGL 和 AFE 的竞争全看运气，音频下行的抖动直接跟着
+// WiFi 任务的调度走。推荐布局（用 LatencyTracker 和抖动缓冲遥测
+// 验证）：
+//   核 0：WiFi / LwIP / 传输库收包任务，优先级统一抬到
+//         NET_RX_TASK_PRIORITY（板级 config.h 可覆盖）
+//   核 1：AFE 独占（audio_communication 任务）
+// 亲和只能在任务创建时定，核 0 固定由 sdkconfig.defaults 里的
+// 亲和选项完成；这里负责在任务建出来之后把优先级抬齐
+namespace net_rx_tuning {
+
+// 音频通道打开后调用（幂等）：这时传输库的任务已经建好
+void Apply();
+
+}  // namespace net_rx_tuning
+
+#endif  // NET_RX_TUNING_H
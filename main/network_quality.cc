@@ -0,0 +1,135 @@
+#include "network_quality.h"
+
+#include <esp_log.h>
+
+#define TAG "NetQuality"
+
+void NetworkQuality::ResetSession() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_received_ = 0;
+    window_lost_ = 0;
+    clean_windows_ = 0;
+}
+
+void NetworkQuality::RecordReceived() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_received_++;
+    total_received_++;
+    if (window_received_ + window_lost_ >= kWindowPackets) {
+        CloseWindowLocked();
+    }
+}
+
+void NetworkQuality::RecordLost(uint32_t frames) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_lost_ += frames;
+    total_lost_ += frames;
+    if (window_received_ + window_lost_ >= kWindowPackets) {
+        CloseWindowLocked();
+    }
+}
+
+void NetworkQuality::RecordUplinkDrop() {
+    // TCP 链路不丢下行包，拥塞体现为上行队列挤掉帧，按丢包同等计入
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_lost_++;
+    total_uplink_drops_++;
+    if (window_received_ + window_lost_ >= kWindowPackets) {
+        CloseWindowLocked();
+    }
+}
+
+void NetworkQuality::RecordRttSample(uint32_t rtt_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (rtt_samples_ == 0) {
+        rtt_ewma_ms_ = rtt_ms;
+    } else {
+        rtt_ewma_ms_ += ((int32_t)rtt_ms - (int32_t)rtt_ewma_ms_) / 4;
+    }
+    rtt_samples_++;
+}
+
+void NetworkQuality::RecordRssiSample(int rssi_dbm) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rssi_dbm_ = rssi_dbm;
+    if (rssi_samples_ == 0) {
+        rssi_ewma_dbm_ = rssi_dbm;
+    } else {
+        rssi_ewma_dbm_ += (rssi_dbm - rssi_ewma_dbm_) / 4;
+    }
+    rssi_samples_++;
+
+    // 边缘判据：持续贴边，或在恢复线以下还在快速下坠
+    bool weak = rssi_dbm <= kRssiFringeDbm ||
+        (rssi_dbm <= kRssiRecoverDbm && rssi_dbm <= rssi_ewma_dbm_ - kRssiFallingDb);
+    if (weak) {
+        rssi_ok_streak_ = 0;
+        if (++rssi_weak_streak_ >= kRssiFringeSamples && !rssi_fringe_) {
+            rssi_fringe_ = true;
+            ESP_LOGW(TAG, "Signal fringe: rssi %d dBm (ewma %d), pre-emptive degrade",
+                rssi_dbm, rssi_ewma_dbm_);
+        }
+    } else {
+        rssi_weak_streak_ = 0;
+        if (rssi_dbm >= kRssiRecoverDbm &&
+            ++rssi_ok_streak_ >= kRssiRecoverSamples && rssi_fringe_) {
+            rssi_fringe_ = false;
+            ESP_LOGI(TAG, "Signal recovered: rssi %d dBm", rssi_dbm);
+        }
+    }
+}
+
+void NetworkQuality::CloseWindowLocked() {
+    uint32_t total = window_received_ + window_lost_;
+    last_window_permille_ = window_lost_ * 1000 / total;
+    window_received_ = 0;
+    window_lost_ = 0;
+
+    if (last_window_permille_ >= kDegradePermille) {
+        // 变差不等确认，立即降档
+        clean_windows_ = 0;
+        if (level_ < kPoor) {
+            level_ = (Level)(level_ + 1);
+            ESP_LOGW(TAG, "Link degraded to level %d (loss %lu permille)",
+                level_, last_window_permille_);
+        }
+    } else if (last_window_permille_ <= kCleanPermille) {
+        // 升档要连续几个干净窗口，防抖
+        if (++clean_windows_ >= kRecoverWindows && level_ > kGood) {
+            level_ = (Level)(level_ - 1);
+            clean_windows_ = 0;
+            ESP_LOGI(TAG, "Link recovered to level %d", level_);
+        }
+    } else {
+        clean_windows_ = 0;
+    }
+}
+
+NetworkQuality::Level NetworkQuality::level() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 信号边缘态给档位垫底：还没丢包也先按 kFair 适配（加深抖动
+    // 缓冲、降一档复杂度），真丢起来照常继续降到 kPoor
+    if (rssi_fringe_ && level_ < kFair) {
+        return kFair;
+    }
+    return level_;
+}
+
+std::string NetworkQuality::BuildJson() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string json = "{";
+    json += "\"level\":" + std::to_string(level_);
+    json += ",\"received\":" + std::to_string(total_received_);
+    json += ",\"lost\":" + std::to_string(total_lost_);
+    json += ",\"uplink_drops\":" + std::to_string(total_uplink_drops_);
+    json += ",\"window_loss_permille\":" + std::to_string(last_window_permille_);
+    json += ",\"rtt_ms\":" + std::to_string(rtt_ewma_ms_);
+    if (rssi_samples_ > 0) {
+        json += ",\"rssi_dbm\":" + std::to_string(rssi_dbm_);
+        json += ",\"rssi_ewma_dbm\":" + std::to_string(rssi_ewma_dbm_);
+        json += ",\"rssi_fringe\":";
+        json += rssi_fringe_ ? "true" : "false";
+    }
+    json += "}";
+    return json;
+}
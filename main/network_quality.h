@@ -0,0 +1,97 @@
+#ifndef NETWORK_QUALITY_H
+#define NETWORK_QUALITY_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 链路质量监测：UDP 路径按序列号缺口统计丢包，websocket 路径把上行
+// 发送队列的拥塞丢帧记进来，握手（hello 往返）提供 RTT 样本。
+// 按窗口把观测折算成三档质量，带迟滞：变差立即降档，连续几个干净
+// 窗口才升回来，避免在档位之间来回抖。消费侧（Application）据此
+// 降低 Opus 复杂度、抬高抖动缓冲下限，而不是对着垂死的蜂窝链路
+// 继续推高档音频直到超时。
+class NetworkQuality {
+public:
+    enum Level {
+        kGood = 0,
+        kFair = 1,
+        kPoor = 2,
+    };
+
+    static NetworkQuality& GetInstance() {
+        static NetworkQuality instance;
+        return instance;
+    }
+    NetworkQuality(const NetworkQuality&) = delete;
+    NetworkQuality& operator=(const NetworkQuality&) = delete;
+
+    // 通道建立时调用，清掉上个会话的窗口但保留累计计数
+    void ResetSession();
+    // 按序到达一个下行包
+    void RecordReceived();
+    // UDP 序列号缺口，frames 为缺失的包数
+    void RecordLost(uint32_t frames);
+    // websocket 上行队列满被迫丢帧（TCP 无丢包，拥塞表现在这里）
+    void RecordUplinkDrop();
+    // hello 握手往返时间，毫秒
+    void RecordRttSample(uint32_t rtt_ms);
+    // 周期性的链路信号强度采样（WiFi RSSI，dBm）。丢包统计只能事后
+    // 反应，信号滑向覆盖边缘是丢包的前兆：持续贴边或快速下坠时置
+    // fringe 态，level() 至少按 kFair 上报，消费侧提前加深抖动缓冲
+    void RecordRssiSample(int rssi_dbm);
+
+    Level level();
+    // 组出 JSON 对象，挂在 metrics 快照的 network 字段下
+    std::string BuildJson();
+
+private:
+    NetworkQuality() = default;
+
+    // 每窗口至少这么多个观测（收到 + 丢失）才评估一次档位
+    static constexpr uint32_t kWindowPackets = 100;
+    // 窗口丢包率超过该千分比立即降一档
+    static constexpr uint32_t kDegradePermille = 50;
+    // 丢包率低于该千分比算干净窗口
+    static constexpr uint32_t kCleanPermille = 10;
+    // 连续干净窗口数达到后升一档
+    static constexpr uint32_t kRecoverWindows = 3;
+
+    // RSSI 预警的迟滞阈值：持续低于 -75 dBm 进边缘态，回到 -70 dBm
+    // 以上并稳定若干个采样才退出（5 秒一采，进快退慢）
+    static constexpr int kRssiFringeDbm = -75;
+    static constexpr int kRssiRecoverDbm = -70;
+    static constexpr uint32_t kRssiFringeSamples = 3;
+    static constexpr uint32_t kRssiRecoverSamples = 6;
+    // 在恢复线以下且单采样比 EWMA 再低这么多 dB，算快速下坠，
+    // 同样计入边缘判据——下电梯/出门这类场景不用等到贴边
+    static constexpr int kRssiFallingDb = 6;
+
+    void CloseWindowLocked();
+
+    std::mutex mutex_;
+    Level level_ = kGood;
+
+    // 当前窗口
+    uint32_t window_received_ = 0;
+    uint32_t window_lost_ = 0;
+    uint32_t clean_windows_ = 0;
+    uint32_t last_window_permille_ = 0;
+
+    // 累计计数与 RTT EWMA，供遥测
+    uint32_t total_received_ = 0;
+    uint32_t total_lost_ = 0;
+    uint32_t total_uplink_drops_ = 0;
+    uint32_t rtt_ewma_ms_ = 0;
+    uint32_t rtt_samples_ = 0;
+
+    // 信号强度预警（见 RecordRssiSample）
+    int rssi_dbm_ = 0;
+    int rssi_ewma_dbm_ = 0;
+    uint32_t rssi_samples_ = 0;
+    uint32_t rssi_weak_streak_ = 0;
+    uint32_t rssi_ok_streak_ = 0;
+    bool rssi_fringe_ = false;
+};
+
+#endif // NETWORK_QUALITY_H
@@ -0,0 +1,106 @@
+#include "opus_profiler.h"
+
+#include <esp_cpu.h>
+
+static const char* PATH_NAMES[OpusProfiler::kPathCount] = {
+    "encode", "decode", "wake_encode"
+};
+
+void OpusProfiler::Record(Path path, uint32_t cycles, uint32_t samples_in,
+                          uint32_t bytes_out, int16_t peak) {
+    auto& stats = paths_[path];
+    // 以千周期分桶：240MHz 下一桶 ≈ 4us 起步，32 桶够覆盖到秒级
+    uint32_t kcycles = cycles >> 10;
+    int bucket = 0;
+    while (bucket < kNumBuckets - 1 && (kcycles >> (bucket + 1)) != 0) {
+        bucket++;
+    }
+    stats.buckets[bucket]++;
+    stats.count++;
+    stats.total_cycles += cycles;
+    if (cycles > stats.worst_cycles) {
+        stats.worst_cycles = cycles;
+        stats.worst_samples = samples_in;
+        stats.worst_bytes = bytes_out;
+        stats.worst_peak = peak;
+    }
+}
+
+uint32_t OpusProfiler::PercentileKcycles(const PathStats& stats, int percent) const {
+    if (stats.count == 0) {
+        return 0;
+    }
+    uint32_t threshold = (stats.count * percent + 99) / 100;
+    uint32_t cumulative = 0;
+    for (int i = 0; i < kNumBuckets; i++) {
+        cumulative += stats.buckets[i];
+        if (cumulative >= threshold) {
+            // 报桶的上界，误差最多一倍，看趋势和分桶门禁够用
+            return 1u << (i + 1);
+        }
+    }
+    return stats.worst_cycles >> 10;
+}
+
+std::string OpusProfiler::BuildJson() {
+    std::string json = "{";
+    bool first = true;
+    for (int i = 0; i < kPathCount; i++) {
+        auto& stats = paths_[i];
+        if (stats.count == 0) {
+            continue;
+        }
+        if (!first) {
+            json += ",";
+        }
+        first = false;
+        json += "\"";
+        json += PATH_NAMES[i];
+        json += "\":{";
+        json += "\"frames\":" + std::to_string(stats.count);
+        json += ",\"avg_kcyc\":" + std::to_string((uint32_t)(stats.total_cycles / stats.count >> 10));
+        json += ",\"p50_kcyc\":" + std::to_string(PercentileKcycles(stats, 50));
+        json += ",\"p95_kcyc\":" + std::to_string(PercentileKcycles(stats, 95));
+        json += ",\"worst_kcyc\":" + std::to_string(stats.worst_cycles >> 10);
+        json += ",\"worst_samples\":" + std::to_string(stats.worst_samples);
+        json += ",\"worst_bytes\":" + std::to_string(stats.worst_bytes);
+        json += ",\"worst_peak\":" + std::to_string(stats.worst_peak);
+        json += "}";
+    }
+    json += "}";
+    return json;
+}
+
+void ProfiledOpusEncoder::Encode(std::vector<int16_t>&& pcm,
+                                 std::function<void(std::vector<uint8_t>&& opus)> handler) {
+    // 输入特征先于编码提取：峰值扫一遍 960 样本只有千余次读取，
+    // 相对编码本体的几百万周期可以忽略
+    uint32_t samples = (uint32_t)pcm.size();
+    int16_t peak = 0;
+    for (int16_t s : pcm) {
+        int16_t a = s < 0 ? -s : s;
+        if (a > peak) {
+            peak = a;
+        }
+    }
+    uint32_t bytes_out = 0;
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    OpusEncoderWrapper::Encode(std::move(pcm),
+        [&handler, &bytes_out](std::vector<uint8_t>&& opus) {
+            bytes_out = (uint32_t)opus.size();
+            handler(std::move(opus));
+        });
+    uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+    OpusProfiler::GetInstance().Record(path_, cycles, samples, bytes_out, peak);
+}
+
+bool ProfiledOpusDecoder::Decode(std::vector<uint8_t>&& opus, std::vector<int16_t>& pcm) {
+    uint32_t bytes_in = (uint32_t)opus.size();
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    bool ok = OpusDecoderWrapper::Decode(std::move(opus), pcm);
+    uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+    // 解码侧输入特征就是包大小（PLC 空包也记，丢包补偿的开销同样要看）
+    OpusProfiler::GetInstance().Record(OpusProfiler::kPathDecode, cycles,
+        bytes_in, ok ? (uint32_t)pcm.size() : 0, 0);
+    return ok;
+}
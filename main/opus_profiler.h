@@ -0,0 +1,84 @@
+#ifndef OPUS_PROFILER_H
+#define OPUS_PROFILER_H
+
+#include <opus_encoder.h>
+#include <opus_decoder.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// esp-opus-encoder 组件对我们是黑盒：编码耗时冒尖时分不清是编码器
+// 本体、重采样还是缓存效应。这里在应用侧包一层，每次 Encode/Decode
+// 用 ccount 记周期数进对数分桶直方图，并保留最差帧的现场（输入
+// 特征 + 输出大小），挂进遥测注册表——自适应档位控制要看趋势，
+// 发版门禁要看分布，两边吃的是同一份数据
+class OpusProfiler {
+public:
+    enum Path {
+        kPathEncode = 0,   // 主上行编码（application.cc）
+        kPathDecode,       // 下行 TTS 解码
+        kPathWakeEncode,   // 唤醒词窗口预编码（wake_word_detect.cc）
+        kPathCount
+    };
+
+    static OpusProfiler& GetInstance() {
+        static OpusProfiler instance;
+        return instance;
+    }
+    OpusProfiler(const OpusProfiler&) = delete;
+    OpusProfiler& operator=(const OpusProfiler&) = delete;
+
+    // 热路径上被每帧调用：分桶 + 最差帧比较，几十条指令，无锁
+    //（计数是遥测，偶尔丢一次自增无所谓，跟 LatencyTracker 同一取舍）
+    void Record(Path path, uint32_t cycles, uint32_t samples_in,
+                uint32_t bytes_out, int16_t peak);
+    std::string BuildJson();
+
+private:
+    OpusProfiler() = default;
+
+    static constexpr int kNumBuckets = 32;
+
+    struct PathStats {
+        uint32_t buckets[kNumBuckets];   // 桶号 = log2(kcycles)
+        uint32_t count;
+        uint64_t total_cycles;
+        // 最差帧现场：定位到底是哪类输入把编码器推上去的
+        uint32_t worst_cycles;
+        uint32_t worst_samples;
+        uint32_t worst_bytes;
+        int16_t worst_peak;
+    };
+
+    uint32_t PercentileKcycles(const PathStats& stats, int percent) const;
+
+    PathStats paths_[kPathCount] = {};
+};
+
+// 同签名遮蔽基类方法（组件里不是虚函数）：持有派生类型的调用方走
+// 带计数的版本，音效缓存、基准测试这些使用点继续用裸包装不受影响。
+// 组件的 Encode 同步回调，计时覆盖编码本体 + 内部缓冲搬运
+class ProfiledOpusEncoder : public OpusEncoderWrapper {
+public:
+    ProfiledOpusEncoder(int sample_rate, int channels, int duration_ms,
+                        OpusProfiler::Path path = OpusProfiler::kPathEncode)
+        : OpusEncoderWrapper(sample_rate, channels, duration_ms), path_(path) {}
+
+    void Encode(std::vector<int16_t>&& pcm,
+                std::function<void(std::vector<uint8_t>&& opus)> handler);
+
+private:
+    OpusProfiler::Path path_;
+};
+
+class ProfiledOpusDecoder : public OpusDecoderWrapper {
+public:
+    ProfiledOpusDecoder(int sample_rate, int channels)
+        : OpusDecoderWrapper(sample_rate, channels) {}
+
+    bool Decode(std::vector<uint8_t>&& opus, std::vector<int16_t>& pcm);
+};
+
+#endif // OPUS_PROFILER_H
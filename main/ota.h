@@ -7,6 +7,10 @@
 
 class Ota {
 public:
+    // 升级流水线单个缓冲的大小：读取任务填一块、写入任务刷一块。
+    // 有 PSRAM 时用这个值，没有时退到 8KB 内部内存
+    static constexpr size_t kUpgradeBufferSize = 32 * 1024;
+
     Ota();
     ~Ota();
 
@@ -19,6 +23,13 @@ public:
     bool HasActivationCode() { return has_activation_code_; }
     bool HasServerTime() { return has_server_time_; }
     void StartUpgrade(std::function<void(int progress, size_t speed)> callback);
+    // 后台预取：低优先级任务把新固件悄悄下到备用分区，may_run 返回 false 时
+    // 立刻断开让路（断点靠 NVS 续传状态接力），下载完成只置位、不切分区不重启
+    void StartPrefetch(std::function<bool()> may_run, std::function<void()> on_complete);
+    bool IsPrefetchReady() const { return prefetch_ready_; }
+    // 激活预取好的固件：切启动分区（自带完整镜像校验）并重启；
+    // 备用槽里预取好的资产包在同一步翻转激活
+    bool ActivatePrefetchedFirmware();
     void MarkCurrentVersionValid();
 
     const std::string& GetFirmwareVersion() const { return firmware_version_; }
@@ -37,10 +48,26 @@ private:
     std::string current_version_;
     std::string firmware_version_;
     std::string firmware_url_;
+    // 差分包地址，base_version 匹配当前运行版本时由 CheckVersion 填入
+    bool has_patch_ = false;
+    std::string patch_url_;
+    // 随固件下发的资产包地址，跟 firmware_version_ 绑定
+    bool has_assets_ = false;
+    std::string assets_url_;
     std::string post_data_;
     std::map<std::string, std::string> headers_;
 
-    void Upgrade(const std::string& firmware_url);
+    bool prefetch_mode_ = false;
+    bool prefetch_paused_ = false;
+    volatile bool prefetch_ready_ = false;
+    volatile bool assets_ready_ = false;
+    bool prefetch_task_running_ = false;
+    std::function<bool()> prefetch_may_run_;
+    std::function<void()> prefetch_on_complete_;
+
+    bool Upgrade(const std::string& firmware_url);
+    void PrefetchTask();
+    bool PrefetchAssets();
     std::function<void(int progress, size_t speed)> upgrade_callback_;
     std::vector<int> ParseVersion(const std::string& version);
     bool IsNewVersionAvailable(const std::string& currentVersion, const std::string& newVersion);
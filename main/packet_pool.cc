@@ -0,0 +1,40 @@
+#include "packet_pool.h"
+
+std::vector<uint8_t> PacketPool::Acquire(size_t size) {
+    std::vector<uint8_t> buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_list_.empty()) {
+            buffer = std::move(free_list_.back());
+            free_list_.pop_back();
+        }
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+size_t PacketPool::BytesPooled() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = 0;
+    for (const auto& buffer : free_list_) {
+        bytes += buffer.capacity();
+    }
+    return bytes;
+}
+
+void PacketPool::Release(std::vector<uint8_t>&& buffer) {
+    if (buffer.capacity() == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_list_.size() >= kMaxPooledBuffers) {
+        return;
+    }
+    buffer.clear();
+    free_list_.emplace_back(std::move(buffer));
+}
+
+void PacketPool::Trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_list_.clear();
+}
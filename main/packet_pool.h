@@ -0,0 +1,47 @@
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// 下行 Opus 包缓冲的回收池
+// Recycling pool for downlink packet buffers. The transport layer only
+// lends us its receive buffer for the duration of the callback, so one
+// copy per packet is unavoidable — but the heap allocation isn't: the
+// decode path returns its spent vectors here and the receive path picks
+// them up again, keeping the playback hot path allocation-free in the
+// steady state.
+class PacketPool {
+public:
+    static PacketPool& GetInstance() {
+        static PacketPool instance;
+        return instance;
+    }
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    // Returns a buffer sized to size, reusing recycled storage when any
+    // is available.
+    std::vector<uint8_t> Acquire(size_t size);
+    // Hands back a spent buffer. Buffers whose storage was moved away
+    // downstream (capacity 0) and anything past the pool bound are
+    // simply freed.
+    void Release(std::vector<uint8_t>&& buffer);
+    // 空闲缓冲占用的字节数，供堆遥测上报
+    size_t BytesPooled();
+    // 空闲窗口把池里散布的缓冲还给堆（HeapGuard 的碎片整理），
+    // 下一轮会话按需回灌
+    void Trim();
+
+private:
+    PacketPool() = default;
+
+    static constexpr size_t kMaxPooledBuffers = 16;
+
+    std::mutex mutex_;
+    std::deque<std::vector<uint8_t>> free_list_;
+};
+
+#endif // PACKET_POOL_H
@@ -0,0 +1,246 @@
+#include "pcm_simd.h"
+#include "audio_iram.h"
+
+#include <sdkconfig.h>
+
+namespace pcm_simd {
+
+#if CONFIG_IDF_TARGET_ESP32S3
+// PIE 的 128 位访存要求 16 字节对齐
+static inline bool Aligned16(const void* p) {
+    return (reinterpret_cast<uintptr_t>(p) & 0xF) == 0;
+}
+#endif
+
+AUDIO_IRAM_ATTR void Deinterleave2(const int16_t* in, size_t frames, int16_t* left, int16_t* right) {
+#if CONFIG_IDF_TARGET_ESP32S3
+    if (Aligned16(in) && Aligned16(left) && Aligned16(right)) {
+        // 每次迭代处理 8 帧（16 个采样），ee.vunzip.16 做偶奇拆分
+        size_t blocks = frames / 8;
+        if (blocks > 0) {
+            asm volatile(
+                "loopnez %3, .Ldeint_done%=\n"
+                "  ee.vld.128.ip q0, %0, 16\n"
+                "  ee.vld.128.ip q1, %0, 16\n"
+                "  ee.vunzip.16 q0, q1\n"
+                "  ee.vst.128.ip q0, %1, 16\n"
+                "  ee.vst.128.ip q1, %2, 16\n"
+                ".Ldeint_done%=:\n"
+                : "+&r"(in), "+&r"(left), "+&r"(right)
+                : "r"(blocks)
+                : "memory");
+            frames -= blocks * 8;
+        }
+    }
+#endif
+    for (size_t i = 0; i < frames; ++i) {
+        left[i] = in[i * 2];
+        right[i] = in[i * 2 + 1];
+    }
+}
+
+AUDIO_IRAM_ATTR void Interleave2(const int16_t* left, const int16_t* right, size_t frames, int16_t* out) {
+#if CONFIG_IDF_TARGET_ESP32S3
+    if (Aligned16(left) && Aligned16(right) && Aligned16(out)) {
+        size_t blocks = frames / 8;
+        if (blocks > 0) {
+            asm volatile(
+                "loopnez %3, .Lint_done%=\n"
+                "  ee.vld.128.ip q0, %0, 16\n"
+                "  ee.vld.128.ip q1, %1, 16\n"
+                "  ee.vzip.16 q0, q1\n"
+                "  ee.vst.128.ip q0, %2, 16\n"
+                "  ee.vst.128.ip q1, %2, 16\n"
+                ".Lint_done%=:\n"
+                : "+&r"(left), "+&r"(right), "+&r"(out)
+                : "r"(blocks)
+                : "memory");
+            frames -= blocks * 8;
+        }
+    }
+#endif
+    for (size_t i = 0; i < frames; ++i) {
+        out[i * 2] = left[i];
+        out[i * 2 + 1] = right[i];
+    }
+}
+
+AUDIO_IRAM_ATTR void ApplyGainQ14(int16_t* data, size_t samples, int16_t gain_q14) {
+#if CONFIG_IDF_TARGET_ESP32S3
+    if (Aligned16(data)) {
+        size_t blocks = samples / 8;
+        if (blocks > 0) {
+            // ee.vmul.s16 按 SAR 右移并饱和，增益向量广播到 8 个 lane
+            alignas(16) int16_t gain_vec[8] = {
+                gain_q14, gain_q14, gain_q14, gain_q14,
+                gain_q14, gain_q14, gain_q14, gain_q14};
+            int16_t* rd = data;
+            int16_t* wr = data;
+            const int16_t* gp = gain_vec;
+            int shift = 14;
+            asm volatile(
+                "wsr.sar %3\n"
+                "ee.vld.128.ip q1, %2, 0\n"
+                "loopnez %4, .Lgain_done%=\n"
+                "  ee.vld.128.ip q0, %0, 16\n"
+                "  ee.vmul.s16 q0, q0, q1\n"
+                "  ee.vst.128.ip q0, %1, 16\n"
+                ".Lgain_done%=:\n"
+                : "+&r"(rd), "+&r"(wr), "+&r"(gp)
+                : "r"(shift), "r"(blocks)
+                : "memory");
+            data += blocks * 8;
+            samples -= blocks * 8;
+        }
+    }
+#endif
+    for (size_t i = 0; i < samples; ++i) {
+        int32_t value = ((int32_t)data[i] * gain_q14) >> 14;
+        data[i] = value > INT16_MAX ? INT16_MAX : value < -INT16_MAX ? -INT16_MAX : (int16_t)value;
+    }
+}
+
+AUDIO_IRAM_ATTR int32_t DotQ15(const int16_t* a, const int16_t* b, size_t n) {
+    int32_t sum = 0;
+#if CONFIG_IDF_TARGET_ESP32S3
+    if (Aligned16(a) && Aligned16(b)) {
+        size_t blocks = n / 8;
+        if (blocks > 0) {
+            // 乘积在 40 位 ACCX 里累加，结束后不移位直接取出
+            int32_t result;
+            int zero = 0;
+            asm volatile(
+                "ee.zero.accx\n"
+                "loopnez %3, .Ldot_done%=\n"
+                "  ee.vld.128.ip q0, %1, 16\n"
+                "  ee.vld.128.ip q1, %2, 16\n"
+                "  ee.vmulas.s16.accx q0, q1\n"
+                ".Ldot_done%=:\n"
+                "ee.srs.accx %0, %4, 0\n"
+                : "=&r"(result), "+&r"(a), "+&r"(b)
+                : "r"(blocks), "r"(zero)
+                : "memory");
+            sum = result;
+            n -= blocks * 8;
+        }
+    }
+#endif
+    for (size_t i = 0; i < n; ++i) {
+        sum += (int32_t)a[i] * b[i];
+    }
+    return sum;
+}
+
+AUDIO_IRAM_ATTR void WidenHigh16(const int16_t* in, size_t samples, int32_t* out) {
+#if CONFIG_IDF_TARGET_ESP32S3
+    if (Aligned16(in) && Aligned16(out)) {
+        size_t blocks = samples / 8;
+        if (blocks > 0) {
+            // 32 位槽的小端布局是 [低16, 高16]：与零向量 vzip 之后
+            // 低半字是 0、高半字是采样，正好等于 x << 16
+            alignas(16) int16_t zeros[8] = {};
+            const int16_t* zp = zeros;
+            asm volatile(
+                "ee.vld.128.ip q2, %2, 0\n"
+                "loopnez %3, .Lwiden_done%=\n"
+                "  ee.vld.128.ip q1, %0, 16\n"
+                "  mv.qr q0, q2\n"
+                "  ee.vzip.16 q0, q1\n"
+                "  ee.vst.128.ip q0, %1, 16\n"
+                "  ee.vst.128.ip q1, %1, 16\n"
+                ".Lwiden_done%=:\n"
+                : "+&r"(in), "+&r"(out), "+&r"(zp)
+                : "r"(blocks)
+                : "memory");
+            samples -= blocks * 8;
+        }
+    }
+#endif
+    for (size_t i = 0; i < samples; ++i) {
+        out[i] = (int32_t)in[i] << 16;
+    }
+}
+
+AUDIO_IRAM_ATTR void NarrowSat32(const int32_t* in, size_t samples, int shift, int16_t* out) {
+    // PIE 没有 32→16 的饱和收窄指令，但 Xtensa 核心指令集里的 CLAMPS
+    // 一条顶掉标量版的两次比较分支
+    for (size_t i = 0; i < samples; ++i) {
+        int32_t value = in[i] >> shift;
+#if CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32
+        asm("clamps %0, %1, 15" : "=r"(value) : "r"(value));
+        out[i] = (int16_t)value;
+#else
+        out[i] = value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : (int16_t)value;
+#endif
+    }
+}
+
+AUDIO_IRAM_ATTR void MixSat(int16_t* dst, const int16_t* src, size_t samples) {
+#if CONFIG_IDF_TARGET_ESP32S3
+    if (Aligned16(dst) && Aligned16(src)) {
+        size_t blocks = samples / 8;
+        if (blocks > 0) {
+            int16_t* wr = dst;
+            asm volatile(
+                "loopnez %3, .Lmix_done%=\n"
+                "  ee.vld.128.ip q0, %0, 16\n"
+                "  ee.vld.128.ip q1, %1, 16\n"
+                "  ee.vadds.s16 q0, q0, q1\n"
+                "  ee.vst.128.ip q0, %2, 16\n"
+                ".Lmix_done%=:\n"
+                : "+&r"(dst), "+&r"(src), "+&r"(wr)
+                : "r"(blocks)
+                : "memory");
+            samples -= blocks * 8;
+        }
+    }
+#endif
+    for (size_t i = 0; i < samples; ++i) {
+        int32_t value = (int32_t)dst[i] + src[i];
+        dst[i] = value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : (int16_t)value;
+    }
+}
+
+AUDIO_IRAM_ATTR int16_t PeakAbs(const int16_t* data, size_t samples) {
+    int32_t peak = 0;
+#if CONFIG_IDF_TARGET_ESP32S3
+    if (Aligned16(data)) {
+        size_t blocks = samples / 8;
+        if (blocks > 0) {
+            // 最大/最小向量分开累，收尾时在标量里合成绝对峰值；
+            // 累加器从零起步，对"求绝对值的最大"正好是恒等元
+            alignas(16) int16_t maxv[8] = {};
+            alignas(16) int16_t minv[8] = {};
+            const int16_t* mxp = maxv;
+            const int16_t* mnp = minv;
+            int16_t* mxw = maxv;
+            int16_t* mnw = minv;
+            asm volatile(
+                "ee.vld.128.ip q1, %1, 0\n"
+                "ee.vld.128.ip q2, %2, 0\n"
+                "loopnez %5, .Lpeak_done%=\n"
+                "  ee.vld.128.ip q0, %0, 16\n"
+                "  ee.vmax.s16 q1, q1, q0\n"
+                "  ee.vmin.s16 q2, q2, q0\n"
+                ".Lpeak_done%=:\n"
+                "ee.vst.128.ip q1, %3, 0\n"
+                "ee.vst.128.ip q2, %4, 0\n"
+                : "+&r"(data), "+&r"(mxp), "+&r"(mnp), "+&r"(mxw), "+&r"(mnw)
+                : "r"(blocks)
+                : "memory");
+            for (int i = 0; i < 8; ++i) {
+                if (maxv[i] > peak) peak = maxv[i];
+                if (-(int32_t)minv[i] > peak) peak = -(int32_t)minv[i];
+            }
+            samples -= blocks * 8;
+        }
+    }
+#endif
+    for (size_t i = 0; i < samples; ++i) {
+        int32_t v = data[i] < 0 ? -(int32_t)data[i] : data[i];
+        if (v > peak) peak = v;
+    }
+    return peak > INT16_MAX ? INT16_MAX : (int16_t)peak;
+}
+
+}  // namespace pcm_simd
@@ -0,0 +1,43 @@
+#ifndef PCM_SIMD_H
+#define PCM_SIMD_H
+
+#include <cstdint>
+#include <cstddef>
+
+// int16 PCM 的向量化小内核
+// Vectorized kernels for the int16 PCM hot paths. On ESP32-S3 these use
+// the PIE 128-bit SIMD instructions (8 samples per operation); on ESP32
+// and C3 targets they compile to the plain scalar loops.
+namespace pcm_simd {
+
+// Split interleaved L/R frames into two planar channels.
+void Deinterleave2(const int16_t* in, size_t frames, int16_t* left, int16_t* right);
+
+// Merge two planar channels back into interleaved L/R frames.
+void Interleave2(const int16_t* left, const int16_t* right, size_t frames, int16_t* out);
+
+// In-place Q14 fixed-point gain with saturation: x = sat16((x * gain) >> 14).
+// gain 16384 == 1.0; callers should skip the call at unity gain.
+void ApplyGainQ14(int16_t* data, size_t samples, int16_t gain_q14);
+
+// Q15 dot product: returns the raw 32-bit accumulator (no shift).
+// The SIMD path engages when both pointers are 16-byte aligned.
+int32_t DotQ15(const int16_t* a, const int16_t* b, size_t n);
+
+// Widen int16 samples into the high half of 32-bit I2S slots (x << 16).
+// This is the per-sample loop in every NoAudioCodec write.
+void WidenHigh16(const int16_t* in, size_t samples, int32_t* out);
+
+// Saturate-narrow 32-bit I2S samples to int16: sat16(x >> shift).
+// Clamps to [-32768, 32767] via the Xtensa CLAMPS instruction.
+void NarrowSat32(const int32_t* in, size_t samples, int shift, int16_t* out);
+
+// Saturating in-place mix: dst = sat16(dst + src).
+void MixSat(int16_t* dst, const int16_t* src, size_t samples);
+
+// Peak absolute value of a block (block-max for the output limiter).
+int16_t PeakAbs(const int16_t* data, size_t samples);
+
+}  // namespace pcm_simd
+
+#endif // PCM_SIMD_H
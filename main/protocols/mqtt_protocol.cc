@@ -2,8 +2,17 @@
 #include "board.h"
 #include "application.h"
 #include "settings.h"
+#include "config_blobs.h"
+#include "packet_pool.h"
+#include "network_quality.h"
+#include "json_builder.h"
+#include "message_tokens.h"
+#include "event_log.h"
+
+#include <esp_timer.h>
 
 #include <esp_log.h>
+#include <esp_cpu.h>
 #include <ml307_mqtt.h>
 #include <ml307_udp.h>
 #include <cstring>
@@ -38,11 +47,22 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     }
 
     Settings settings("mqtt", false);
-    endpoint_ = settings.GetString("endpoint");
-    client_id_ = settings.GetString("client_id");
-    username_ = settings.GetString("username");
-    password_ = settings.GetString("password");
-    publish_topic_ = settings.GetString("publish_topic");
+    config_blobs::MqttConfig config = {};
+    if (settings.GetBlob("config", config_blobs::MqttConfig::kVersion, &config, sizeof(config))) {
+        // 整组一次 blob 读出，重连周期只有一次 NVS 查找
+        endpoint_ = config.endpoint;
+        client_id_ = config.client_id;
+        username_ = config.username;
+        password_ = config.password;
+        publish_topic_ = config.publish_topic;
+    } else {
+        // 老固件逐键写的存量配置，兜底读一次；下次 OTA 下发会写成 blob
+        endpoint_ = settings.GetString("endpoint");
+        client_id_ = settings.GetString("client_id");
+        username_ = settings.GetString("username");
+        password_ = settings.GetString("password");
+        publish_topic_ = settings.GetString("publish_topic");
+    }
 
     if (endpoint_.empty()) {
         ESP_LOGW(TAG, "MQTT endpoint is not specified");
@@ -60,6 +80,14 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     });
 
     mqtt_->OnMessage([this](const std::string& topic, const std::string& payload) {
+        // 高频 tts/stt/llm 消息免建树就地分发，其余回退 cJSON
+        if (on_incoming_fast_json_ != nullptr) {
+            FastMessage msg;
+            if (JsonFastScan(payload.c_str(), msg) && on_incoming_fast_json_(msg)) {
+                last_incoming_time_ = std::chrono::steady_clock::now();
+                return;
+            }
+        }
         cJSON* root = cJSON_Parse(payload.c_str());
         if (root == nullptr) {
             ESP_LOGE(TAG, "Failed to parse json message %s", payload.c_str());
@@ -72,9 +100,21 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
             return;
         }
 
-        if (strcmp(type->valuestring, "hello") == 0) {
+        switch (message_tokens::ParseType(type->valuestring)) {
+        case message_tokens::kTypeHello:
             ParseServerHello(root);
-        } else if (strcmp(type->valuestring, "goodbye") == 0) {
+            break;
+        case message_tokens::kTypeResume: {
+            // 驻留会话的复活确认：session 匹配且 status 为 ok 才算成功
+            auto session_id = cJSON_GetObjectItem(root, "session_id");
+            auto status = cJSON_GetObjectItem(root, "status");
+            bool ok = session_id != nullptr && session_id_ == session_id->valuestring &&
+                status != nullptr && strcmp(status->valuestring, "ok") == 0;
+            xEventGroupSetBits(event_group_handle_,
+                ok ? MQTT_PROTOCOL_RESUME_OK_EVENT : MQTT_PROTOCOL_RESUME_FAIL_EVENT);
+            break;
+        }
+        case message_tokens::kTypeGoodbye: {
             auto session_id = cJSON_GetObjectItem(root, "session_id");
             ESP_LOGI(TAG, "Received goodbye message, session_id: %s", session_id ? session_id->valuestring : "null");
             if (session_id == nullptr || session_id_ == session_id->valuestring) {
@@ -82,8 +122,13 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
                     CloseAudioChannel();
                 });
             }
-        } else if (on_incoming_json_ != nullptr) {
-            on_incoming_json_(root);
+            break;
+        }
+        default:
+            if (on_incoming_json_ != nullptr) {
+                on_incoming_json_(root);
+            }
+            break;
         }
         cJSON_Delete(root);
         last_incoming_time_ = std::chrono::steady_clock::now();
@@ -100,7 +145,17 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     return true;
 }
 
+// MQTT 路径天然就是双车道：控制消息走 MQTT（TCP），音频帧走 UDP，
+// 互不排队——abort 不会压在积压的音频后面，这是要保持的性质，别把
+// 控制消息挪去 UDP 或把音频塞进 publish
 void MqttProtocol::SendText(const std::string& text) {
+    {
+        // 控制消息之前先把攒着的音频尾帧冲出去，保证停止监听时不留残帧
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        if (udp_ != nullptr) {
+            FlushPendingAudioLocked();
+        }
+    }
     if (publish_topic_.empty()) {
         return;
     }
@@ -112,49 +167,129 @@ void MqttProtocol::SendText(const std::string& text) {
 
 void MqttProtocol::SendAudio(const std::vector<uint8_t>& data) {
     std::lock_guard<std::mutex> lock(channel_mutex_);
-    if (udp_ == nullptr) {
+    if (udp_ == nullptr || parked_) {
         return;
     }
 
-    std::string nonce(aes_nonce_);
-    *(uint16_t*)&nonce[2] = htons(data.size());
-    *(uint32_t*)&nonce[12] = htonl(++local_sequence_);
+    if (aggregation_frames_ <= 1) {
+        SendDatagram(data.data(), data.size());
+        return;
+    }
+
+    // 每帧带 uint16 大端长度前缀，攒够协商的帧数再发
+    pending_payload_.push_back((uint8_t)(data.size() >> 8));
+    pending_payload_.push_back((uint8_t)(data.size() & 0xFF));
+    pending_payload_.insert(pending_payload_.end(), data.begin(), data.end());
+    pending_count_++;
+    if (pending_count_ >= aggregation_frames_) {
+        FlushPendingAudioLocked();
+    }
+}
+
+void MqttProtocol::FlushPendingAudioLocked() {
+    if (pending_count_ == 0) {
+        return;
+    }
+    SendDatagram(pending_payload_.data(), pending_payload_.size());
+    pending_payload_.clear();
+    pending_count_ = 0;
+}
 
-    std::string encrypted;
-    encrypted.resize(aes_nonce_.size() + data.size());
-    memcpy(encrypted.data(), nonce.data(), nonce.size());
+void MqttProtocol::SendDatagram(const uint8_t* payload, size_t size) {
+    // 常驻缓冲，resize 只动长度不丢容量；头 16 字节是 hello 时排好的
+    // nonce 模板，每包就地改长度和序列号两个字段
+    send_packet_.resize(aes_nonce_.size() + size);
+    *(uint16_t*)&send_packet_[2] = htons(size);
+    *(uint32_t*)&send_packet_[12] = htonl(++local_sequence_);
+
+    // CTR 过程会把 nonce 当计数器递增，给外设一份栈上工作副本，
+    // 缓冲里的模板保持原样随包发出
+    uint8_t nonce_work[16];
+    memcpy(nonce_work, send_packet_.data(), sizeof(nonce_work));
 
     size_t nc_off = 0;
     uint8_t stream_block[16] = {0};
-    if (mbedtls_aes_crypt_ctr(&aes_ctx_, data.size(), &nc_off, (uint8_t*)nonce.c_str(), stream_block,
-        (uint8_t*)data.data(), (uint8_t*)&encrypted[nonce.size()]) != 0) {
+    uint32_t start_cycles = esp_cpu_get_cycle_count();
+    if (esp_aes_crypt_ctr(&aes_ctx_, size, &nc_off, nonce_work, stream_block,
+        payload, (uint8_t*)&send_packet_[aes_nonce_.size()]) != 0) {
         ESP_LOGE(TAG, "Failed to encrypt audio data");
         return;
     }
-    udp_->Send(encrypted);
+    uint32_t cycles = esp_cpu_get_cycle_count() - start_cycles;
+    crypt_cycles_avg_ += ((int32_t)cycles - (int32_t)crypt_cycles_avg_) / 16;
+    if (++crypt_packets_ % 500 == 0) {
+        ESP_LOGI(TAG, "AES-CTR: ~%lu cycles/packet over %lu packets", crypt_cycles_avg_, crypt_packets_);
+    }
+    udp_->Send(send_packet_);
 }
 
 void MqttProtocol::CloseAudioChannel() {
     {
         std::lock_guard<std::mutex> lock(channel_mutex_);
+        pending_payload_.clear();
+        pending_count_ = 0;
         if (udp_ != nullptr) {
-            delete udp_;
-            udp_ = nullptr;
+            if (resume_grace_period_s_ > 0 && !session_id_.empty()) {
+                // 服务器给了宽限期：UDP 套接字和密钥原地驻留，
+                // 宽限期内的下一轮对话一条 resume 就能复活
+                parked_ = true;
+                parked_at_ = std::chrono::steady_clock::now();
+            } else {
+                delete udp_;
+                udp_ = nullptr;
+            }
         }
     }
 
-    std::string message = "{";
-    message += "\"session_id\":\"" + session_id_ + "\",";
-    message += "\"type\":\"goodbye\"";
-    message += "}";
-    SendText(message);
+    char buffer[128];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddString("session_id", session_id_);
+    json.AddString("type", "goodbye");
+    json.EndObject();
+    SendText(json.str());
 
     if (on_audio_channel_closed_ != nullptr) {
         on_audio_channel_closed_();
     }
 }
 
+bool MqttProtocol::TryResumeSession() {
+    xEventGroupClearBits(event_group_handle_,
+        MQTT_PROTOCOL_RESUME_OK_EVENT | MQTT_PROTOCOL_RESUME_FAIL_EVENT);
+
+    char buffer[128];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddString("session_id", session_id_);
+    json.AddString("type", "resume");
+    json.EndObject();
+    int64_t sent_time_us = esp_timer_get_time();
+    SendText(json.str());
+
+    EventBits_t bits = xEventGroupWaitBits(event_group_handle_,
+        MQTT_PROTOCOL_RESUME_OK_EVENT | MQTT_PROTOCOL_RESUME_FAIL_EVENT,
+        pdTRUE, pdFALSE, pdMS_TO_TICKS(4000));
+    if (!(bits & MQTT_PROTOCOL_RESUME_OK_EVENT)) {
+        // 被拒或超时都回退完整 hello，不再重试 resume
+        return false;
+    }
+    NetworkQuality::GetInstance().RecordRttSample(
+        (uint32_t)((esp_timer_get_time() - sent_time_us) / 1000));
+    return true;
+}
+
+void MqttProtocol::DiscardParkedChannel() {
+    std::lock_guard<std::mutex> lock(channel_mutex_);
+    parked_ = false;
+    if (udp_ != nullptr) {
+        delete udp_;
+        udp_ = nullptr;
+    }
+}
+
 bool MqttProtocol::OpenAudioChannel() {
+    TRACE_SCOPE("mqtt_open");
     if (mqtt_ == nullptr || !mqtt_->IsConnected()) {
         ESP_LOGI(TAG, "MQTT is not connected, try to connect now");
         if (!StartMqttClient(true)) {
@@ -163,18 +298,55 @@ bool MqttProtocol::OpenAudioChannel() {
     }
 
     error_occurred_ = false;
+
+    // 宽限期内的驻留会话先试单往返复活：省掉完整 hello 协商在蜂窝
+    // RTT 下的一秒多。复活后双方序列号归零，密钥和聚合参数沿用
+    if (parked_) {
+        auto parked_for = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - parked_at_).count();
+        if (parked_for < resume_grace_period_s_ && TryResumeSession()) {
+            {
+                std::lock_guard<std::mutex> lock(channel_mutex_);
+                parked_ = false;
+                local_sequence_ = 0;
+                remote_sequence_ = 0;
+            }
+            last_incoming_time_ = std::chrono::steady_clock::now();
+            if (on_audio_channel_opened_ != nullptr) {
+                on_audio_channel_opened_();
+            }
+            ESP_LOGI(TAG, "Resumed parked session %s", session_id_.c_str());
+            return true;
+        }
+        DiscardParkedChannel();
+    }
+
     session_id_ = "";
     xEventGroupClearBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 
     // 发送 hello 消息申请 UDP 通道
-    std::string message = "{";
-    message += "\"type\":\"hello\",";
-    message += "\"version\": 3,";
-    message += "\"transport\":\"udp\",";
-    message += "\"audio_params\":{";
-    message += "\"format\":\"opus\", \"sample_rate\":16000, \"channels\":1, \"frame_duration\":" + std::to_string(OPUS_FRAME_DURATION_MS);
-    message += "}}";
-    SendText(message);
+    char buffer[256];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddString("type", "hello");
+    json.AddNumber("version", 3);
+    json.AddString("transport", "udp");
+    // 报价聚合能力，服务器在 hello 响应的 udp.aggregation 里定实际帧数
+    json.BeginObject("features");
+    json.AddNumber("udp_aggregation", MQTT_UDP_MAX_AGGREGATED_FRAMES);
+    // 告诉服务器支持 goodbye 后驻留会话，宽限期由服务器在
+    // hello 响应的 udp.resume_grace 里指定
+    json.AddBool("session_resume", true);
+    json.EndObject();
+    json.BeginObject("audio_params");
+    json.AddString("format", "opus");
+    json.AddNumber("sample_rate", 16000);
+    json.AddNumber("channels", 1);
+    json.AddNumber("frame_duration", OPUS_FRAME_DURATION_MS);
+    json.EndObject();
+    json.EndObject();
+    hello_sent_time_us_ = esp_timer_get_time();
+    SendText(json.str());
 
     // 等待服务器响应
     EventBits_t bits = xEventGroupWaitBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(10000));
@@ -205,22 +377,38 @@ bool MqttProtocol::OpenAudioChannel() {
         }
         if (sequence != remote_sequence_ + 1) {
             ESP_LOGW(TAG, "Received audio packet with wrong sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
+            // 序列号缺口就是链路丢包，喂给质量监测
+            uint32_t gap = sequence - remote_sequence_ - 1;
+            NetworkQuality::GetInstance().RecordLost(gap);
+            // 每个缺口帧往下游塞一个空载荷标记占住播放槽位，解码端
+            // 据此做丢包隐藏。只补短缺口：更长的洞是链路断流，交给
+            // 抖动缓冲重新垫底，硬补只会拖长坏声音
+            for (uint32_t i = 0; i < gap && i < 3; i++) {
+                if (on_incoming_audio_ != nullptr) {
+                    on_incoming_audio_(std::vector<uint8_t>(), 0);
+                }
+            }
         }
+        NetworkQuality::GetInstance().RecordReceived();
 
-        std::vector<uint8_t> decrypted;
+        // AES-CTR 解密当搬运用：从传输层缓冲一遍读出、直接写进回收
+        // 池的包缓冲，每包只过一次数据（不先拷密文再解明文）。缓冲
+        // 走 PacketPool，稳态零堆分配，解码端用完还回池里；传输层
+        // 内部那次收包拷贝在 ml307/lwIP 组件里，这层管不到
         size_t decrypted_size = data.size() - aes_nonce_.size();
         size_t nc_off = 0;
         uint8_t stream_block[16] = {0};
-        decrypted.resize(decrypted_size);
+        auto decrypted = PacketPool::GetInstance().Acquire(decrypted_size);
         auto nonce = (uint8_t*)data.data();
         auto encrypted = (uint8_t*)data.data() + aes_nonce_.size();
-        int ret = mbedtls_aes_crypt_ctr(&aes_ctx_, decrypted_size, &nc_off, nonce, stream_block, encrypted, (uint8_t*)decrypted.data());
+        int ret = esp_aes_crypt_ctr(&aes_ctx_, decrypted_size, &nc_off, nonce, stream_block, encrypted, decrypted.data());
         if (ret != 0) {
             ESP_LOGE(TAG, "Failed to decrypt audio data, ret: %d", ret);
+            PacketPool::GetInstance().Release(std::move(decrypted));
             return;
         }
         if (on_incoming_audio_ != nullptr) {
-            on_incoming_audio_(std::move(decrypted));
+            on_incoming_audio_(std::move(decrypted), 0);
         }
         remote_sequence_ = sequence;
         last_incoming_time_ = std::chrono::steady_clock::now();
@@ -268,11 +456,45 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
 
     // auto encryption = cJSON_GetObjectItem(udp, "encryption")->valuestring;
     // ESP_LOGI(TAG, "UDP server: %s, port: %d, encryption: %s", udp_server_.c_str(), udp_port_, encryption);
+    // 硬件 AES 外设，上下文与密钥调度每会话只做一次
     aes_nonce_ = DecodeHexString(nonce);
-    mbedtls_aes_init(&aes_ctx_);
-    mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
+    // 发包缓冲的头模板就是 nonce，之后每包只就地覆盖长度/序列号字段
+    send_packet_.assign(aes_nonce_);
+    esp_aes_init(&aes_ctx_);
+    esp_aes_setkey(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
     local_sequence_ = 0;
     remote_sequence_ = 0;
+
+    // 聚合帧数以服务器为准，缺省不聚合
+    aggregation_frames_ = 1;
+    auto aggregation = cJSON_GetObjectItem(udp, "aggregation");
+    if (aggregation != nullptr && cJSON_IsNumber(aggregation)) {
+        aggregation_frames_ = aggregation->valueint;
+        if (aggregation_frames_ < 1) {
+            aggregation_frames_ = 1;
+        } else if (aggregation_frames_ > MQTT_UDP_MAX_AGGREGATED_FRAMES) {
+            aggregation_frames_ = MQTT_UDP_MAX_AGGREGATED_FRAMES;
+        }
+        ESP_LOGI(TAG, "UDP aggregation: %d frames per datagram", aggregation_frames_);
+    }
+    pending_payload_.clear();
+    pending_count_ = 0;
+
+    // goodbye 后的会话驻留宽限期，服务器不下发就保持拆通道的老行为
+    resume_grace_period_s_ = 0;
+    auto resume_grace = cJSON_GetObjectItem(udp, "resume_grace");
+    if (resume_grace != nullptr && cJSON_IsNumber(resume_grace) && resume_grace->valueint > 0) {
+        resume_grace_period_s_ = resume_grace->valueint;
+        ESP_LOGI(TAG, "Session resume grace period: %d s", resume_grace_period_s_);
+    }
+
+    // hello 往返当作一次 RTT 采样（传输层没有独立的 ping 通道）
+    if (hello_sent_time_us_ > 0) {
+        NetworkQuality::GetInstance().RecordRttSample(
+            (uint32_t)((esp_timer_get_time() - hello_sent_time_us_) / 1000));
+        hello_sent_time_us_ = 0;
+    }
+    NetworkQuality::GetInstance().ResetSession();
     xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 }
 
@@ -296,5 +518,6 @@ std::string MqttProtocol::DecodeHexString(const std::string& hex_string) {
 }
 
 bool MqttProtocol::IsAudioChannelOpened() const {
-    return udp_ != nullptr && !error_occurred_ && !IsTimeout();
+    // 驻留中的通道不算开着：对上层来说会话已经结束，复活走 OpenAudioChannel
+    return udp_ != nullptr && !parked_ && !error_occurred_ && !IsTimeout();
 }
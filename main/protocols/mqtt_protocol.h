@@ -6,7 +6,7 @@
 #include <mqtt.h>
 #include <udp.h>
 #include <cJSON.h>
-#include <mbedtls/aes.h>
+#include <aes/esp_aes.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
 
@@ -19,6 +19,11 @@
 #define MQTT_RECONNECT_INTERVAL_MS 10000
 
 #define MQTT_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
+#define MQTT_PROTOCOL_RESUME_OK_EVENT (1 << 1)
+#define MQTT_PROTOCOL_RESUME_FAIL_EVENT (1 << 2)
+
+// 最多把几个 Opus 帧聚合进一个 UDP 报文（向服务器报价，实际值由 hello 协商）
+#define MQTT_UDP_MAX_AGGREGATED_FRAMES 4
 
 class MqttProtocol : public Protocol {
 public:
@@ -43,14 +48,41 @@ private:
     std::mutex channel_mutex_;
     Mqtt* mqtt_ = nullptr;
     Udp* udp_ = nullptr;
-    mbedtls_aes_context aes_ctx_;
+    // 走 AES 外设，密钥调度在 ParseServerHello 做一次
+    esp_aes_context aes_ctx_;
     std::string aes_nonce_;
+    // 常驻发包缓冲：头 16 字节是预排好的 nonce 模板（序列号/长度
+    // 就地改），密文直接加密进其后，容量跨包保留——稳态零分配。
+    // 只在 channel_mutex_ 下使用
+    std::string send_packet_;
+    // 每包加密开销的滑动平均（CPU cycles），调试用
+    uint32_t crypt_cycles_avg_ = 0;
+    uint32_t crypt_packets_ = 0;
     std::string udp_server_;
     int udp_port_;
     uint32_t local_sequence_;
     uint32_t remote_sequence_;
+    // hello 发出时刻，握手往返当一次 RTT 采样
+    int64_t hello_sent_time_us_ = 0;
+
+    // 聚合上行：>1 时帧先攒在 pending_payload_（每帧带 uint16 大端长度前缀），
+    // 攒够或发控制消息时整体加密发出，摊薄蜂窝链路的每报文开销
+    int aggregation_frames_ = 1;
+    std::vector<uint8_t> pending_payload_;
+    int pending_count_ = 0;
+
+    // 会话驻留：服务器在 hello 里给出宽限期（秒）时，goodbye 后不拆
+    // UDP 通道和 AES 上下文，下次开通道用一条 resume 消息单往返复活，
+    // 省掉蜂窝链路上 1 秒以上的完整 hello 协商。0 表示服务器不支持
+    int resume_grace_period_s_ = 0;
+    bool parked_ = false;
+    std::chrono::steady_clock::time_point parked_at_;
 
     bool StartMqttClient(bool report_error=false);
+    bool TryResumeSession();
+    void DiscardParkedChannel();
+    void SendDatagram(const uint8_t* payload, size_t size);
+    void FlushPendingAudioLocked();
     void ParseServerHello(const cJSON* root);
     std::string DecodeHexString(const std::string& hex_string);
 
@@ -1,5 +1,7 @@
 #include "protocol.h"
+#include "json_builder.h"
 
+#include <cstdio>
 #include <esp_log.h>
 
 #define TAG "Protocol"
@@ -8,10 +10,18 @@ void Protocol::OnIncomingJson(std::function<void(const cJSON* root)> callback) {
     on_incoming_json_ = callback;
 }
 
-void Protocol::OnIncomingAudio(std::function<void(std::vector<uint8_t>&& data)> callback) {
+void Protocol::OnIncomingAudio(std::function<void(std::vector<uint8_t>&& data, uint32_t stream_ms)> callback) {
     on_incoming_audio_ = callback;
 }
 
+void Protocol::OnBroadcastAudio(std::function<void(std::vector<uint8_t>&& data, int64_t playout_epoch_ms)> callback) {
+    on_broadcast_audio_ = callback;
+}
+
+void Protocol::OnIncomingFastJson(std::function<bool(const FastMessage& msg)> callback) {
+    on_incoming_fast_json_ = callback;
+}
+
 void Protocol::OnAudioChannelOpened(std::function<void()> callback) {
     on_audio_channel_opened_ = callback;
 }
@@ -31,38 +41,69 @@ void Protocol::SetError(const std::string& message) {
     }
 }
 
+void Protocol::SendWakeWordAudio(std::list<std::vector<uint8_t>>&& packets) {
+    // 缺省实现逐包发；MQTT/UDP 路径本来就按数据报走，保持原样
+    for (auto& packet : packets) {
+        if (!packet.empty()) {
+            SendAudio(packet);
+        }
+    }
+}
+
+// 定形控制消息整条模板在编译期拼好，运行时只 snprintf 接入
+// session_id 和枚举字面量。session_id 是服务器下发的短 token，
+// 不含需要转义的字符（超长快照的动态拼接回退也是这么直接拼的）；
+// 带用户文本的 SendWakeWordDetected 仍走 JsonBuilder 转义
 void Protocol::SendAbortSpeaking(AbortReason reason) {
-    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"abort\"";
+    char buffer[256];
     if (reason == kAbortReasonWakeWordDetected) {
-        message += ",\"reason\":\"wake_word_detected\"";
+        snprintf(buffer, sizeof(buffer),
+            "{\"session_id\":\"%s\",\"type\":\"abort\",\"reason\":\"wake_word_detected\"}",
+            session_id_.c_str());
+    } else {
+        snprintf(buffer, sizeof(buffer),
+            "{\"session_id\":\"%s\",\"type\":\"abort\"}", session_id_.c_str());
     }
-    message += "}";
-    SendText(message);
+    SendText(std::string(buffer));
 }
 
 void Protocol::SendWakeWordDetected(const std::string& wake_word) {
-    std::string json = "{\"session_id\":\"" + session_id_ + 
-                      "\",\"type\":\"listen\",\"state\":\"detect\",\"text\":\"" + wake_word + "\"}";
-    SendText(json);
+    char buffer[256];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddString("session_id", session_id_);
+    json.AddString("type", "listen");
+    json.AddString("state", "detect");
+    json.AddString("text", wake_word);
+    json.EndObject();
+    SendText(json.str());
 }
 
 void Protocol::SendStartListening(ListeningMode mode) {
-    std::string message = "{\"session_id\":\"" + session_id_ + "\"";
-    message += ",\"type\":\"listen\",\"state\":\"start\"";
-    if (mode == kListeningModeAlwaysOn) {
-        message += ",\"mode\":\"realtime\"";
-    } else if (mode == kListeningModeAutoStop) {
-        message += ",\"mode\":\"auto\"";
-    } else {
-        message += ",\"mode\":\"manual\"";
-    }
-    message += "}";
-    SendText(message);
+    // 这条消息卡在唤醒命中与服务器起 ASR 之间，栈上一次组完
+    const char* mode_str = mode == kListeningModeAlwaysOn ? "realtime"
+        : mode == kListeningModeAutoStop ? "auto" : "manual";
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer),
+        "{\"session_id\":\"%s\",\"type\":\"listen\",\"state\":\"start\",\"mode\":\"%s\"}",
+        session_id_.c_str(), mode_str);
+    SendText(std::string(buffer));
 }
 
 void Protocol::SendStopListening() {
-    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"listen\",\"state\":\"stop\"}";
-    SendText(message);
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer),
+        "{\"session_id\":\"%s\",\"type\":\"listen\",\"state\":\"stop\"}",
+        session_id_.c_str());
+    SendText(std::string(buffer));
+}
+
+void Protocol::SendListenSegmentEnd() {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer),
+        "{\"session_id\":\"%s\",\"type\":\"listen\",\"state\":\"segment_end\"}",
+        session_id_.c_str());
+    SendText(std::string(buffer));
 }
 
 void Protocol::SendIotDescriptors(const std::string& descriptors) {
@@ -110,9 +151,72 @@ void Protocol::SendIotDescriptors(const std::string& descriptors) {
     cJSON_Delete(root);
 }
 
+void Protocol::SendMetrics(const std::string& metrics) {
+    char buffer[2048];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddString("session_id", session_id_);
+    json.AddString("type", "metrics");
+    json.AddRaw("metrics", metrics);
+    json.EndObject();
+    if (json.overflowed()) {
+        // 超长快照罕见，退回动态拼接
+        SendText("{\"session_id\":\"" + session_id_ + "\",\"type\":\"metrics\",\"metrics\":" + metrics + "}");
+        return;
+    }
+    SendText(json.str());
+}
+
+void Protocol::SendTelemetry(const std::string& snapshot) {
+    char buffer[2048];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddString("session_id", session_id_);
+    json.AddString("type", "telemetry");
+    json.AddRaw("data", snapshot);
+    json.EndObject();
+    if (json.overflowed()) {
+        SendText("{\"session_id\":\"" + session_id_ + "\",\"type\":\"telemetry\",\"data\":" + snapshot + "}");
+        return;
+    }
+    SendText(json.str());
+}
+
 void Protocol::SendIotStates(const std::string& states) {
-    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"iot\",\"update\":true,\"states\":" + states + "}";
-    SendText(message);
+    char buffer[2048];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddString("session_id", session_id_);
+    json.AddString("type", "iot");
+    json.AddBool("update", true);
+    json.AddRaw("states", states);
+    json.EndObject();
+    if (json.overflowed()) {
+        SendText("{\"session_id\":\"" + session_id_ + "\",\"type\":\"iot\",\"update\":true,\"states\":" + states + "}");
+        return;
+    }
+    SendText(json.str());
+}
+
+void Protocol::SendIotStatesBinary(const std::string& payload) {
+    // 缺省传输层没有二进制状态通道；SupportsBinaryIotStates 为 false
+    // 时调用方不该走到这里，静默丢弃兜底
+}
+
+void Protocol::SendAudioFlowControl(bool pause) {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer),
+        "{\"session_id\":\"%s\",\"type\":\"audio_flow\",\"state\":\"%s\"}",
+        session_id_.c_str(), pause ? "pause" : "resume");
+    SendText(std::string(buffer));
+}
+
+void Protocol::SendAudioWindowUpdate(int frames) {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer),
+        "{\"session_id\":\"%s\",\"type\":\"audio_flow\",\"state\":\"window\",\"frames\":%d}",
+        session_id_.c_str(), frames);
+    SendText(std::string(buffer));
 }
 
 bool Protocol::IsTimeout() const {
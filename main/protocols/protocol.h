@@ -2,10 +2,13 @@
 #define PROTOCOL_H
 
 #include <cJSON.h>
+#include <list>
 #include <string>
 #include <functional>
 #include <chrono>
 
+#include "json_fast_scan.h"
+
 struct BinaryProtocol3 {
     uint8_t type;
     uint8_t reserved;
@@ -18,6 +21,15 @@ enum AbortReason {
     kAbortReasonWakeWordDetected
 };
 
+// 服务器通过 hello 或会话中的 encoder_profile 消息下发的编码档位，
+// 字段为 -1 表示服务器没有指定，保持设备默认值
+struct EncoderProfile {
+    int bitrate = -1;         // bps
+    int complexity = -1;      // 0-10
+    int vbr = -1;             // 0 = CBR, 1 = VBR
+    int frame_duration = -1;  // ms
+};
+
 enum ListeningMode {
     kListeningModeAutoStop,
     kListeningModeManualStop,
@@ -34,9 +46,26 @@ public:
     inline const std::string& session_id() const {
         return session_id_;
     }
+    inline const EncoderProfile& encoder_profile() const {
+        return encoder_profile_;
+    }
+    // 服务器在 hello features 里确认了回合流水线：播报尾巴还在放时
+    // 就接受下一句上行，切不切回合由服务器判定
+    inline bool turn_pipeline_supported() const {
+        return turn_pipeline_supported_;
+    }
 
-    void OnIncomingAudio(std::function<void(std::vector<uint8_t>&& data)> callback);
+    // stream_ms 是帧在 TTS 流时间线上的位置（带戳的 0x03 帧），
+    // 0 表示传输层没有时间戳
+    void OnIncomingAudio(std::function<void(std::vector<uint8_t>&& data, uint32_t stream_ms)> callback);
+    // 广播音频（0x04 帧）：同屋多台设备的公告，playout_epoch_ms 是
+    // 服务器排定的统一起播时刻（epoch 毫秒，ota 已把系统时钟对到
+    // 服务器时间）。与会话音频分路，不进抖动缓冲
+    void OnBroadcastAudio(std::function<void(std::vector<uint8_t>&& data, int64_t playout_epoch_ms)> callback);
     void OnIncomingJson(std::function<void(const cJSON* root)> callback);
+    // 高频 tts/stt/llm 消息的免建树分发；回调返回 false 表示没处理，
+    // 调用方回退 cJSON 完整解析
+    void OnIncomingFastJson(std::function<bool(const FastMessage& msg)> callback);
     void OnAudioChannelOpened(std::function<void()> callback);
     void OnAudioChannelClosed(std::function<void()> callback);
     void OnNetworkError(std::function<void(const std::string& message)> callback);
@@ -46,21 +75,50 @@ public:
     virtual void CloseAudioChannel() = 0;
     virtual bool IsAudioChannelOpened() const = 0;
     virtual void SendAudio(const std::vector<uint8_t>& data) = 0;
+    // 唤醒词的预编码包整批上传（约 2 秒 / 几十包）。缺省逐包走
+    // SendAudio；WebSocket 在服务器通过 hello 确认批量能力后拼成
+    // 少量大二进制帧，省掉几十条小 TLS 记录
+    virtual void SendWakeWordAudio(std::list<std::vector<uint8_t>>&& packets);
     virtual void SendWakeWordDetected(const std::string& wake_word);
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
+    // 手动模式下设备端点检测到的段尾：采集继续，服务器可以提前
+    // finalize ASR，不用等自己的静音超时。老服务器忽略未知 state
+    virtual void SendListenSegmentEnd();
     virtual void SendAbortSpeaking(AbortReason reason);
     virtual void SendIotDescriptors(const std::string& descriptors);
     virtual void SendIotStates(const std::string& states);
+    // 高频数值 thing 的二进制状态通道：payload 是 [u8 id][按声明序的
+    // 属性值] 记录串，布局已在描述符的 binary_state 段里声明。缺省
+    // 不支持，调用方照旧走 JSON；WebSocket 在服务器通过 hello 确认
+    // 后用 0x05 二进制帧发送
+    virtual bool SupportsBinaryIotStates() const { return false; }
+    virtual void SendIotStatesBinary(const std::string& payload);
+    // metrics 是已经组好的 JSON 对象，如堆遥测快照
+    virtual void SendMetrics(const std::string& metrics);
+    // 周期推送的遥测批：snapshot 是注册表组好的一整块 JSON，每个
+    // 上报周期一条消息。节奏由服务器下发的 telemetry/interval 控制，
+    // 老服务器不下发就一条不推
+    virtual void SendTelemetry(const std::string& snapshot);
+    // 抖动缓冲水位驱动的下行流控：pause=true 请服务器暂停推流，
+    // false 恢复。老服务器忽略未知消息类型，纯优化不影响正确性
+    virtual void SendAudioFlowControl(bool pause);
+    // 接收窗口补充：播放端每消耗 frames 帧回一次额度，支持按窗口
+    // 推流的服务器据此保持近实时节奏；老服务器同样忽略
+    virtual void SendAudioWindowUpdate(int frames);
 
 protected:
     std::function<void(const cJSON* root)> on_incoming_json_;
-    std::function<void(std::vector<uint8_t>&& data)> on_incoming_audio_;
+    std::function<bool(const FastMessage& msg)> on_incoming_fast_json_;
+    std::function<void(std::vector<uint8_t>&& data, uint32_t stream_ms)> on_incoming_audio_;
+    std::function<void(std::vector<uint8_t>&& data, int64_t playout_epoch_ms)> on_broadcast_audio_;
     std::function<void()> on_audio_channel_opened_;
     std::function<void()> on_audio_channel_closed_;
     std::function<void(const std::string& message)> on_network_error_;
 
     int server_sample_rate_ = 16000;
+    EncoderProfile encoder_profile_;
+    bool turn_pipeline_supported_ = false;
     bool error_occurred_ = false;
     std::string session_id_;
     std::chrono::time_point<std::chrono::steady_clock> last_incoming_time_;
@@ -2,20 +2,46 @@
 #include "board.h"
 #include "system_info.h"
 #include "application.h"
+#include "packet_pool.h"
+#include "network_quality.h"
+#include "json_builder.h"
+#include "task_telemetry.h"
+#include "conn_preflight.h"
+#include "event_log.h"
+
+#include <esp_timer.h>
 
 #include <cstring>
 #include <cJSON.h>
 #include <esp_log.h>
 #include <arpa/inet.h>
+#include <netdb.h>
 #include "assets/lang_config.h"
 
 #define TAG "WS"
 
 WebsocketProtocol::WebsocketProtocol() {
     event_group_handle_ = xEventGroupCreate();
+    xTaskCreate([](void* arg) {
+        auto this_ = (WebsocketProtocol*)arg;
+        this_->SenderTaskLoop();
+        vTaskDelete(NULL);
+    }, "ws_sender", 4096, this, 3, &sender_task_);
+    TaskTelemetry::GetInstance().RegisterTask("ws_sender", sender_task_, 4096);
+    TaskTelemetry::GetInstance().RegisterQueue("ws_send", [this]() {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        return send_queue_.size();
+    }, WEBSOCKET_SEND_QUEUE_MAX_FRAMES);
 }
 
 WebsocketProtocol::~WebsocketProtocol() {
+    if (sender_task_ != nullptr) {
+        vTaskDelete(sender_task_);
+    }
+    if (standby_timer_ != nullptr) {
+        esp_timer_stop(standby_timer_);
+        esp_timer_delete(standby_timer_);
+    }
     if (websocket_ != nullptr) {
         delete websocket_;
     }
@@ -23,14 +49,173 @@ WebsocketProtocol::~WebsocketProtocol() {
 }
 
 void WebsocketProtocol::Start() {
+    // WiFi 板子提前把服务器域名解析进 lwIP 的 DNS 缓存并周期刷新，
+    // OpenAudioChannel 的连接路径就不用再付整次查询；
+    // ML307 的 DNS 走模组侧，这里帮不上忙
+    if (Board::GetInstance().GetBoardType() == "wifi") {
+        xTaskCreate([](void* arg) {
+            auto this_ = (WebsocketProtocol*)arg;
+            this_->DnsPrefetchLoop();
+            vTaskDelete(NULL);
+        }, "ws_dns_prefetch", 4096, this, 1, nullptr);
+    }
+}
+
+void WebsocketProtocol::DnsPrefetchLoop() {
+    // 从 wss://host:port/path 里抠出主机名
+    std::string host = CONFIG_WEBSOCKET_URL;
+    auto scheme_end = host.find("://");
+    if (scheme_end != std::string::npos) {
+        host = host.substr(scheme_end + 3);
+    }
+    auto host_end = host.find_first_of(":/");
+    if (host_end != std::string::npos) {
+        host = host.substr(0, host_end);
+    }
+
+    while (true) {
+        struct addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo* result = nullptr;
+        if (getaddrinfo(host.c_str(), "443", &hints, &result) == 0 && result != nullptr) {
+            freeaddrinfo(result);
+        } else {
+            ESP_LOGW(TAG, "DNS prefetch for %s failed", host.c_str());
+        }
+        // lwIP 的 DNS 表按 TTL 过期，5 分钟刷一次保持命中
+        vTaskDelay(pdMS_TO_TICKS(5 * 60 * 1000));
+    }
 }
 
 void WebsocketProtocol::SendAudio(const std::vector<uint8_t>& data) {
-    if (websocket_ == nullptr) {
+    EnqueueUplink(std::vector<uint8_t>(data), true);
+}
+
+void WebsocketProtocol::EnqueueUplink(std::vector<uint8_t>&& data, bool raw_opus) {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    if (send_queue_.size() >= WEBSOCKET_SEND_QUEUE_MAX_FRAMES) {
+        // 上行拥塞时丢最旧的帧，主循环永远不等网络
+        send_queue_.pop_front();
+        dropped_frames_++;
+        // TCP 不丢下行包，拥塞体现在这里，计入链路质量
+        NetworkQuality::GetInstance().RecordUplinkDrop();
+        if (dropped_frames_ % 50 == 1) {
+            ESP_LOGW(TAG, "Uplink congested, dropped %lu frames (sent %lu)",
+                dropped_frames_, sent_frames_);
+        }
+    }
+    send_queue_.push_back({std::move(data), raw_opus});
+    send_cv_.notify_one();
+}
+
+void WebsocketProtocol::SendWakeWordAudio(std::list<std::vector<uint8_t>>&& packets) {
+    if (!wake_word_batch_supported_) {
+        Protocol::SendWakeWordAudio(std::move(packets));
         return;
     }
+    // 批帧：BinaryProtocol3 头（type=0x02，reserved=包数，payload_size=
+    // 载荷字节数），载荷是 [u16be 长度][Opus 包] 序列。~2 秒唤醒词
+    // 拼成两三个大帧，不再是几十条小 TLS 记录
+    const size_t kMaxFrameBytes = 4096;
+    std::vector<uint8_t> frame;
+    size_t count = 0;
+    auto flush = [this, &frame, &count]() {
+        if (count == 0) {
+            return;
+        }
+        uint16_t payload_size = (uint16_t)(frame.size() - sizeof(BinaryProtocol3));
+        frame[1] = (uint8_t)count;
+        frame[2] = (uint8_t)(payload_size >> 8);
+        frame[3] = (uint8_t)(payload_size & 0xFF);
+        // 已经是组好的批帧，发送任务不再拼
+        EnqueueUplink(std::move(frame), false);
+        frame.clear();
+        count = 0;
+    };
+    for (auto& packet : packets) {
+        if (packet.empty()) {
+            continue;
+        }
+        if (frame.empty()) {
+            frame.assign({0x02, 0x00, 0x00, 0x00});
+        }
+        frame.push_back((uint8_t)(packet.size() >> 8));
+        frame.push_back((uint8_t)(packet.size() & 0xFF));
+        frame.insert(frame.end(), packet.begin(), packet.end());
+        if (++count == 255 || frame.size() >= kMaxFrameBytes) {
+            flush();
+        }
+    }
+    flush();
+}
+
+void WebsocketProtocol::SenderTaskLoop() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(send_mutex_);
+        send_cv_.wait(lock, [this]() {
+            return !control_queue_.empty() || !send_queue_.empty();
+        });
+        // 控制车道优先：把 abort/stop 插到所有积压音频帧前面发出去
+        if (!control_queue_.empty()) {
+            auto control = std::move(control_queue_.front());
+            control_queue_.pop_front();
+            lock.unlock();
+
+            std::lock_guard<std::mutex> conn_lock(conn_mutex_);
+            if (websocket_ != nullptr) {
+                bool ok = control.binary
+                    ? websocket_->Send(control.data.data(), control.data.size(), true)
+                    : websocket_->Send(control.data);
+                if (!ok) {
+                    ESP_LOGE(TAG, "Failed to send control frame: %s",
+                        control.binary ? "(binary)" : control.data.c_str());
+                    SetError(Lang::Strings::SERVER_ERROR);
+                }
+            }
+            continue;
+        }
+        auto frame = std::move(send_queue_.front().data);
+        bool raw_opus = send_queue_.front().raw_opus;
+        send_queue_.pop_front();
+        // 机会式拼批：不为凑批等新帧（零额外时延），只把已经排队的
+        // 散包拼进同一条 WS 帧/TLS 记录——每包省下 ~20 字节的
+        // TLS+WS 头和一次记录级加密。FlushUplink 本来就成批入队，
+        // 稳态双工下经常有现成的第二帧
+        if (audio_batch_supported_ && raw_opus &&
+            !send_queue_.empty() && send_queue_.front().raw_opus) {
+            std::vector<uint8_t> batch;
+            batch.reserve(sizeof(BinaryProtocol3) +
+                WEBSOCKET_UPLINK_BATCH_MAX_FRAMES * (2 + frame.size()));
+            batch.assign({0x02, 0x00, 0x00, 0x00});
+            size_t count = 0;
+            auto append = [&batch, &count](const std::vector<uint8_t>& packet) {
+                batch.push_back((uint8_t)(packet.size() >> 8));
+                batch.push_back((uint8_t)(packet.size() & 0xFF));
+                batch.insert(batch.end(), packet.begin(), packet.end());
+                count++;
+            };
+            append(frame);
+            while (count < WEBSOCKET_UPLINK_BATCH_MAX_FRAMES &&
+                   !send_queue_.empty() && send_queue_.front().raw_opus) {
+                append(send_queue_.front().data);
+                send_queue_.pop_front();
+            }
+            uint16_t payload_size = (uint16_t)(batch.size() - sizeof(BinaryProtocol3));
+            batch[1] = (uint8_t)count;
+            batch[2] = (uint8_t)(payload_size >> 8);
+            batch[3] = (uint8_t)(payload_size & 0xFF);
+            frame = std::move(batch);
+        }
+        lock.unlock();
 
-    websocket_->Send(data.data(), data.size(), true);
+        std::lock_guard<std::mutex> conn_lock(conn_mutex_);
+        if (websocket_ != nullptr) {
+            if (websocket_->Send(frame.data(), frame.size(), true)) {
+                sent_frames_++;
+            }
+        }
+    }
 }
 
 void WebsocketProtocol::SendText(const std::string& text) {
@@ -38,17 +223,126 @@ void WebsocketProtocol::SendText(const std::string& text) {
         return;
     }
 
-    if (!websocket_->Send(text)) {
-        ESP_LOGE(TAG, "Failed to send text: %s", text.c_str());
-        SetError(Lang::Strings::SERVER_ERROR);
+    // 走发送任务的优先车道而不是就地写：就地写会和发送任务在同一条
+    // TCP 连接上交错，而且调用方（主循环）要陪着网络背压阻塞
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    control_queue_.push_back({text, false});
+    send_cv_.notify_one();
+}
+
+bool WebsocketProtocol::SupportsBinaryIotStates() const {
+    return iot_binary_state_supported_;
+}
+
+// 0x05 状态帧：payload 是 ThingManager 组好的二进制记录串，布局由
+// 描述符的 binary_state 段声明过。一次数值状态更新十几个字节，
+// 不再是几百字节的 JSON 文本
+void WebsocketProtocol::SendIotStatesBinary(const std::string& payload) {
+    if (websocket_ == nullptr || payload.empty() ||
+        payload.size() > 0xFFFF || !iot_binary_state_supported_) {
+        return;
     }
+    std::string frame;
+    frame.reserve(sizeof(BinaryProtocol3) + payload.size());
+    frame.push_back((char)0x05);
+    frame.push_back((char)0x00);
+    frame.push_back((char)(payload.size() >> 8));
+    frame.push_back((char)(payload.size() & 0xFF));
+    frame += payload;
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    control_queue_.push_back({std::move(frame), true});
+    send_cv_.notify_one();
 }
 
 bool WebsocketProtocol::IsAudioChannelOpened() const {
-    return websocket_ != nullptr && websocket_->IsConnected() && !error_occurred_ && !IsTimeout();
+    // 待机中的连接对上层不算打开：音频通道要走 OpenAudioChannel 复用
+    return websocket_ != nullptr && websocket_->IsConnected() && !standby_ && !error_occurred_ && !IsTimeout();
 }
 
 void WebsocketProtocol::CloseAudioChannel() {
+    // 音频帧直接扔；还在排队的控制消息（如刚发的 stop）拆连接前冲完，
+    // conn_mutex_ 保证和发送任务在同一条连接上不交错
+    std::deque<ControlFrame> pending_control;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        send_queue_.clear();
+        pending_control.swap(control_queue_);
+    }
+    std::lock_guard<std::mutex> conn_lock(conn_mutex_);
+    if (websocket_ == nullptr) {
+        return;
+    }
+    for (auto& control : pending_control) {
+        if (control.binary) {
+            websocket_->Send(control.data.data(), control.data.size(), true);
+        } else {
+            websocket_->Send(control.data);
+        }
+    }
+    // 服务器授了待机窗口就不拆连接：TLS 和 hello 状态靠心跳养着，
+    // 窗口内的下一次唤醒零重连。已在待机中又关一次（服务器 goodbye、
+    // 出错兜底）才是真正的拆除
+    if (standby_window_s_ > 0 && !standby_ && !error_occurred_ && websocket_->IsConnected()) {
+        standby_ = true;
+        standby_at_ = std::chrono::steady_clock::now();
+        if (standby_timer_ == nullptr) {
+            esp_timer_create_args_t args = {
+                .callback = [](void* arg) {
+                    static_cast<WebsocketProtocol*>(arg)->OnStandbyTick();
+                },
+                .arg = this,
+                .dispatch_method = ESP_TIMER_TASK,
+                .name = "ws_standby",
+                .skip_unhandled_events = true,
+            };
+            esp_timer_create(&args, &standby_timer_);
+        }
+        esp_timer_start_periodic(standby_timer_,
+            (uint64_t)WEBSOCKET_STANDBY_PING_SECONDS * 1000000);
+        ESP_LOGI(TAG, "Entering warm standby for %d s", standby_window_s_);
+        return;
+    }
+    standby_ = false;
+    if (standby_timer_ != nullptr) {
+        esp_timer_stop(standby_timer_);
+    }
+    delete websocket_;
+    websocket_ = nullptr;
+}
+
+void WebsocketProtocol::OnStandbyTick() {
+    if (!standby_) {
+        return;
+    }
+    auto parked_s = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - standby_at_).count();
+    bool alive;
+    {
+        std::lock_guard<std::mutex> conn_lock(conn_mutex_);
+        alive = websocket_ != nullptr && websocket_->IsConnected();
+    }
+    if (!alive || parked_s >= standby_window_s_) {
+        esp_timer_stop(standby_timer_);
+        ESP_LOGI(TAG, "Standby over after %lld s (%s), tearing down",
+            (long long)parked_s, alive ? "window expired" : "socket dead");
+        // 拆连接可能在网络上阻塞，挪到主循环做，别占 esp_timer 任务
+        Application::GetInstance().Schedule([this]() {
+            DiscardStandbyChannel();
+        });
+        return;
+    }
+    // 组件层没有开出 websocket ping，用最小的 JSON 文本帧顶替，
+    // 服务器的 pong 会刷新 last_incoming_time_
+    SendText("{\"type\":\"ping\"}");
+}
+
+void WebsocketProtocol::DiscardStandbyChannel() {
+    std::lock_guard<std::mutex> conn_lock(conn_mutex_);
+    if (!standby_) {
+        // 调度间隙里被唤醒词复用了，连接已经转回活跃
+        return;
+    }
+    standby_ = false;
     if (websocket_ != nullptr) {
         delete websocket_;
         websocket_ = nullptr;
@@ -56,12 +350,54 @@ void WebsocketProtocol::CloseAudioChannel() {
 }
 
 bool WebsocketProtocol::OpenAudioChannel() {
-    if (websocket_ != nullptr) {
-        delete websocket_;
+    TRACE_SCOPE("ws_open");
+    // 暖待机复用：套接字、TLS、hello 状态全活着，停掉心跳直接转回
+    // 活跃，不付任何重连成本
+    if (standby_) {
+        auto parked_s = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - standby_at_).count();
+        std::lock_guard<std::mutex> conn_lock(conn_mutex_);
+        if (websocket_ != nullptr && websocket_->IsConnected() &&
+            parked_s < standby_window_s_ && !error_occurred_) {
+            standby_ = false;
+            esp_timer_stop(standby_timer_);
+            // 待机期间只有心跳往返，重置静默计时免得复用即判超时
+            last_incoming_time_ = std::chrono::steady_clock::now();
+            ESP_LOGI(TAG, "Reusing warm-standby channel (parked %lld s)",
+                (long long)parked_s);
+            if (on_audio_channel_opened_ != nullptr) {
+                on_audio_channel_opened_();
+            }
+            return true;
+        }
+        standby_ = false;
+        esp_timer_stop(standby_timer_);
+        ESP_LOGI(TAG, "Standby channel stale, doing full reconnect");
+    }
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        send_queue_.clear();
+        control_queue_.clear();
+    }
+    {
+        std::lock_guard<std::mutex> conn_lock(conn_mutex_);
+        if (websocket_ != nullptr) {
+            delete websocket_;
+            websocket_ = nullptr;
+        }
     }
 
     error_occurred_ = false;
     std::string url = CONFIG_WEBSOCKET_URL;
+
+    // 先并行竞速探一遍所有解析地址：不通就立刻失败，上层直接切
+    // MQTT 兜底，不吃传输组件里单地址串行连接的整轮超时
+    if (!ConnPreflight::GetInstance().ProbeUrl(url)) {
+        ESP_LOGE(TAG, "Server unreachable in preflight, failing fast");
+        SetError(Lang::Strings::SERVER_NOT_FOUND);
+        return false;
+    }
+
     std::string token = "Bearer " + std::string(CONFIG_WEBSOCKET_ACCESS_TOKEN);
     websocket_ = Board::GetInstance().CreateWebSocket();
     websocket_->SetHeader("Authorization", token.c_str());
@@ -71,10 +407,61 @@ bool WebsocketProtocol::OpenAudioChannel() {
 
     websocket_->OnData([this](const char* data, size_t len, bool binary) {
         if (binary) {
+            // 广播音频帧（type=0x04）：头后 8 字节是服务器排定的统一
+            // 起播时刻（u64be，epoch 毫秒），余下是 Opus 包。走独立
+            // 回调分路到 UI 声道，不进会话抖动缓冲
+            if (len >= sizeof(BinaryProtocol3) + 8 && (uint8_t)data[0] == 0x04 &&
+                on_broadcast_audio_ != nullptr) {
+                auto* header = (const BinaryProtocol3*)data;
+                size_t payload_size = ((uint16_t)(uint8_t)data[2] << 8) | (uint8_t)data[3];
+                if (sizeof(BinaryProtocol3) + payload_size == len && payload_size > 8) {
+                    const uint8_t* p = header->payload;
+                    int64_t playout_ms = 0;
+                    for (int i = 0; i < 8; i++) {
+                        playout_ms = (playout_ms << 8) | p[i];
+                    }
+                    auto packet = PacketPool::GetInstance().Acquire(payload_size - 8);
+                    memcpy(packet.data(), p + 8, payload_size - 8);
+                    on_broadcast_audio_(std::move(packet), playout_ms);
+                    NetworkQuality::GetInstance().RecordReceived();
+                    return;
+                }
+            }
             if (on_incoming_audio_ != nullptr) {
-                on_incoming_audio_(std::vector<uint8_t>((uint8_t*)data, (uint8_t*)data + len));
+                // 带时间线的音频帧（type=0x03）：头后 4 字节是帧在
+                // TTS 流时间线上的位置（u32be，ms），余下才是 Opus 包。
+                // 服务器不发 0x03 时走裸包老路径，双向兼容
+                uint32_t stream_ms = 0;
+                const char* opus = data;
+                size_t opus_len = len;
+                if (len >= sizeof(BinaryProtocol3) + 4 && (uint8_t)data[0] == 0x03) {
+                    auto* header = (const BinaryProtocol3*)data;
+                    size_t payload_size = ((uint16_t)(uint8_t)data[2] << 8) | (uint8_t)data[3];
+                    if (sizeof(BinaryProtocol3) + payload_size == len && payload_size > 4) {
+                        const uint8_t* p = header->payload;
+                        stream_ms = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                                    ((uint32_t)p[2] << 8) | p[3];
+                        opus = (const char*)(p + 4);
+                        opus_len = payload_size - 4;
+                    }
+                }
+                // 传输层的缓冲只在回调期间有效，拷一次进回收池的缓冲，
+                // 堆分配在稳态被完全省掉
+                auto packet = PacketPool::GetInstance().Acquire(opus_len);
+                memcpy(packet.data(), opus, opus_len);
+                on_incoming_audio_(std::move(packet), stream_ms);
+                NetworkQuality::GetInstance().RecordReceived();
             }
         } else {
+            // 流式 TTS 的 tts/stt/llm 事件一秒来几十条，先试免建树
+            // 扫描就地分发；认不出的结构照旧走 cJSON
+            if (on_incoming_fast_json_ != nullptr) {
+                FastMessage msg;
+                if (JsonFastScan(data, msg) && on_incoming_fast_json_(msg)) {
+                    last_incoming_time_ = std::chrono::steady_clock::now();
+                    return;
+                }
+            }
             // Parse JSON data
             auto root = cJSON_Parse(data);
             auto type = cJSON_GetObjectItem(root, "type");
@@ -109,14 +496,44 @@ bool WebsocketProtocol::OpenAudioChannel() {
 
     // Send hello message to describe the client
     // keys: message type, version, audio_params (format, sample_rate, channels)
-    std::string message = "{";
-    message += "\"type\":\"hello\",";
-    message += "\"version\": 1,";
-    message += "\"transport\":\"websocket\",";
-    message += "\"audio_params\":{";
-    message += "\"format\":\"opus\", \"sample_rate\":16000, \"channels\":1, \"frame_duration\":" + std::to_string(OPUS_FRAME_DURATION_MS);
-    message += "}}";
-    websocket_->Send(message);
+    // 注意给 features 留够余量，JsonBuilder 溢出会发出截断的 hello
+    char buffer[512];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddString("type", "hello");
+    json.AddNumber("version", 1);
+    json.AddString("transport", "websocket");
+    // 告诉服务器可以下发编码档位，老服务器会忽略这个字段
+    json.BeginObject("features");
+    json.AddBool("encoder_profile", true);
+    // 报价批量唤醒词上传，服务器在 hello 响应的 features 里确认
+    json.AddBool("wake_word_batch", true);
+    // 报价会话内音频拼批：确认后发送任务把排队中的散包拼成 0x02 帧
+    json.AddBool("audio_batch", true);
+    // 报价二进制 IoT 状态：确认后数值 thing 的状态走 0x05 帧
+    json.AddBool("iot_binary_state", true);
+    // 报价回合流水线：播报尾巴还在放时接受下一句上行（AEC 板）
+    json.AddBool("turn_pipeline", true);
+    // 字幕时间线：接受 0x03 带戳音频帧和 sentence_start 的 offset_ms
+    json.AddBool("timeline", true);
+    // 接受 0x04 广播音频帧（带统一起播时刻的多设备公告）
+    json.AddBool("broadcast", true);
+    // 报价暖待机：对话结束后保持连接只发心跳，服务器在 hello 响应的
+    // features.standby_s 里授予窗口秒数
+    json.AddBool("standby", true);
+    // 客户端最多缓冲这么多帧；支持窗口推流的服务器先发满窗口，
+    // 之后跟着 audio_flow/window 的额度走，长回复不会整段压进来
+    json.AddNumber("receive_window", 1200 / OPUS_FRAME_DURATION_MS);
+    json.EndObject();
+    json.BeginObject("audio_params");
+    json.AddString("format", "opus");
+    json.AddNumber("sample_rate", 16000);
+    json.AddNumber("channels", 1);
+    json.AddNumber("frame_duration", OPUS_FRAME_DURATION_MS);
+    json.EndObject();
+    json.EndObject();
+    hello_sent_time_us_ = esp_timer_get_time();
+    websocket_->Send(json.str());
 
     // Wait for server hello
     EventBits_t bits = xEventGroupWaitBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(10000));
@@ -148,5 +565,57 @@ void WebsocketProtocol::ParseServerHello(const cJSON* root) {
         }
     }
 
+    // 服务器可以在 hello 里直接下发上行编码档位（拥塞链路降档）
+    auto encoder_profile = cJSON_GetObjectItem(root, "encoder_profile");
+    if (encoder_profile != NULL) {
+        auto item = cJSON_GetObjectItem(encoder_profile, "bitrate");
+        if (item != NULL) {
+            encoder_profile_.bitrate = item->valueint;
+        }
+        item = cJSON_GetObjectItem(encoder_profile, "complexity");
+        if (item != NULL) {
+            encoder_profile_.complexity = item->valueint;
+        }
+        item = cJSON_GetObjectItem(encoder_profile, "vbr");
+        if (item != NULL) {
+            encoder_profile_.vbr = cJSON_IsTrue(item) ? 1 : 0;
+        }
+        item = cJSON_GetObjectItem(encoder_profile, "frame_duration");
+        if (item != NULL) {
+            encoder_profile_.frame_duration = item->valueint;
+        }
+    }
+
+    // 服务器确认了才启用批帧，老服务器永远只看到逐包格式
+    wake_word_batch_supported_ = false;
+    audio_batch_supported_ = false;
+    iot_binary_state_supported_ = false;
+    turn_pipeline_supported_ = false;
+    standby_window_s_ = 0;
+    auto features = cJSON_GetObjectItem(root, "features");
+    if (features != NULL) {
+        wake_word_batch_supported_ =
+            cJSON_IsTrue(cJSON_GetObjectItem(features, "wake_word_batch"));
+        audio_batch_supported_ =
+            cJSON_IsTrue(cJSON_GetObjectItem(features, "audio_batch"));
+        iot_binary_state_supported_ =
+            cJSON_IsTrue(cJSON_GetObjectItem(features, "iot_binary_state"));
+        turn_pipeline_supported_ =
+            cJSON_IsTrue(cJSON_GetObjectItem(features, "turn_pipeline"));
+        // 服务器授予的暖待机窗口，0 或缺失 = 不支持，关通道照旧拆
+        auto standby_s = cJSON_GetObjectItem(features, "standby_s");
+        if (standby_s != NULL && cJSON_IsNumber(standby_s) && standby_s->valueint > 0) {
+            standby_window_s_ = standby_s->valueint;
+            ESP_LOGI(TAG, "Server granted warm standby window: %d s", standby_window_s_);
+        }
+    }
+
+    // hello 往返当作一次 RTT 采样（组件层没有开出 websocket ping）
+    if (hello_sent_time_us_ > 0) {
+        NetworkQuality::GetInstance().RecordRttSample(
+            (uint32_t)((esp_timer_get_time() - hello_sent_time_us_) / 1000));
+        hello_sent_time_us_ = 0;
+    }
+    NetworkQuality::GetInstance().ResetSession();
     xEventGroupSetBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT);
 }
@@ -7,9 +7,26 @@
 #include <web_socket.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
 
 #define WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
 
+// 上行音频队列深度：超出后丢最旧的帧，过期的麦克风数据没有价值
+#define WEBSOCKET_SEND_QUEUE_MAX_FRAMES 16
+
+// 机会式拼批的上限：一条 WS 帧/TLS 记录最多装这么多个 Opus 包。
+// 只拼已经排队的帧，不为凑批等新帧，所以不引入额外时延
+#define WEBSOCKET_UPLINK_BATCH_MAX_FRAMES 2
+
+// 暖待机期间的应用层心跳间隔（组件层没开 websocket ping，
+// 用一条极小的 JSON 顶替）
+#define WEBSOCKET_STANDBY_PING_SECONDS 20
+
 class WebsocketProtocol : public Protocol {
 public:
     WebsocketProtocol();
@@ -17,6 +34,9 @@ public:
 
     void Start() override;
     void SendAudio(const std::vector<uint8_t>& data) override;
+    void SendWakeWordAudio(std::list<std::vector<uint8_t>>&& packets) override;
+    bool SupportsBinaryIotStates() const override;
+    void SendIotStatesBinary(const std::string& payload) override;
     bool OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
@@ -25,6 +45,57 @@ private:
     EventGroupHandle_t event_group_handle_;
     WebSocket* websocket_ = nullptr;
 
+    // Async uplink: SendAudio only enqueues, a dedicated sender task
+    // does the blocking socket writes so network backpressure never
+    // stalls the main loop.
+    TaskHandle_t sender_task_ = nullptr;
+    std::mutex send_mutex_;
+    std::condition_variable send_cv_;
+    // raw_opus 的帧发送任务可以机会式拼成 0x02 批帧；预组好的批帧
+    //（唤醒词上传）原样发
+    struct UplinkFrame {
+        std::vector<uint8_t> data;
+        bool raw_opus;
+    };
+    std::deque<UplinkFrame> send_queue_;
+    // 控制消息的优先车道：abort/stop 这类消息要是排在积压的音频帧
+    // 后面，打断响应就要多等整个上行队列深度。发送任务先清空这条
+    // 队列再碰音频队列。0x05 二进制状态帧也走这条道：不参与音频道
+    // 的拥塞丢帧，服务器侧的增量快照不会悄悄断档
+    struct ControlFrame {
+        std::string data;
+        bool binary;
+    };
+    std::deque<ControlFrame> control_queue_;
+    // conn_mutex_ serializes sends against websocket_ teardown
+    std::mutex conn_mutex_;
+    uint32_t sent_frames_ = 0;
+    uint32_t dropped_frames_ = 0;
+    // hello 发出时刻，握手往返当一次 RTT 采样
+    int64_t hello_sent_time_us_ = 0;
+    // 服务器在 hello 里确认了批量唤醒词上传（features.wake_word_batch）
+    // 才发 0x02 批帧，否则逐包兜底
+    bool wake_word_batch_supported_ = false;
+    // 服务器确认了会话内音频拼批（features.audio_batch）才把散包
+    // 拼成 0x02 帧，否则逐包原样发
+    bool audio_batch_supported_ = false;
+    // 服务器确认了二进制 IoT 状态（features.iot_binary_state）才把
+    // 数值 thing 的状态编成 0x05 帧，否则全量走 JSON
+    bool iot_binary_state_supported_ = false;
+    // 暖待机：对话结束后不拆 TLS，只降到心跳节奏养着连接，窗口内
+    // 下一次唤醒直接复用（两分钟内追问的高频模式零重连）。窗口由
+    // 服务器 hello 的 features.standby_s 授予，0 = 不支持，照旧拆
+    bool standby_ = false;
+    std::chrono::steady_clock::time_point standby_at_;
+    int standby_window_s_ = 0;
+    esp_timer_handle_t standby_timer_ = nullptr;
+
+    void OnStandbyTick();
+    void DiscardStandbyChannel();
+    void SenderTaskLoop();
+    // 入队并执行拥塞丢帧策略（SendAudio 和唤醒词批帧共用）
+    void EnqueueUplink(std::vector<uint8_t>&& data, bool raw_opus);
+    void DnsPrefetchLoop();
     void ParseServerHello(const cJSON* root);
     void SendText(const std::string& text) override;
 };
@@ -0,0 +1,50 @@
+#include "psram_pmr.h"
+
+#include <esp_heap_caps.h>
+
+#include <new>
+
+namespace psram_pmr {
+namespace {
+
+// 上游资源：优先 PSRAM，分不到（没焊或耗尽）回退内部堆，
+// 两条路都失败才抛 bad_alloc
+class PsramResource : public std::pmr::memory_resource {
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* p = AllocWithCaps(bytes, alignment, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (p == nullptr) {
+            p = AllocWithCaps(bytes, alignment, MALLOC_CAP_8BIT);
+        }
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    void do_deallocate(void* p, size_t, size_t) override {
+        heap_caps_free(p);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    static void* AllocWithCaps(size_t bytes, size_t alignment, uint32_t caps) {
+        if (alignment > alignof(max_align_t)) {
+            return heap_caps_aligned_alloc(alignment, bytes, caps);
+        }
+        return heap_caps_malloc(bytes, caps);
+    }
+};
+
+}  // namespace
+
+std::pmr::memory_resource* cold() {
+    // 池层按大小分桶、成块向上游要内存，几十字节的字符串反复
+    // 增删不会把 PSRAM 堆打碎；多任务并发分配，用同步版本
+    static PsramResource upstream;
+    static std::pmr::synchronized_pool_resource pool(&upstream);
+    return &pool;
+}
+
+}  // namespace psram_pmr
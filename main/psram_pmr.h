@@ -0,0 +1,24 @@
+#ifndef PSRAM_PMR_H
+#define PSRAM_PMR_H
+
+#include <memory_resource>
+#include <string>
+
+// 冷路径分配的 PSRAM 池化内存资源。内部 SRAM 是全机最紧的资源，
+// 而聊天文本、IoT/协议 JSON、OTA 镜像头这类又大又冷的分配没必要
+// 占它：cold() 返回进程级的 synchronized_pool_resource（分桶成块
+// 复用，小字符串不会把堆打碎），上游优先 PSRAM、无 PSRAM 的板子
+// 自动回退内部堆。音频热路径维持 audio_buffer_pool / packet_pool
+// 的 SRAM 预分配池，不要接到这里——每 30ms 一帧付 PSRAM 带宽不值。
+namespace psram_pmr {
+
+std::pmr::memory_resource* cold();
+
+// 落在 cold() 资源上的字符串成员写法：
+//   psram_pmr::string s{psram_pmr::cold()};
+// 和 std::string 之间互转要显式 assign(data, size) / 拷贝
+using string = std::pmr::string;
+
+}  // namespace psram_pmr
+
+#endif // PSRAM_PMR_H
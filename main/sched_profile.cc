@@ -0,0 +1,170 @@
+#include "sched_profile.h"
+#include "config.h"
+
+// AFE fetch 任务布局的板级覆盖（原在 audio_frontend.cc，随档案表
+// 迁到这里）：守听叠加通话把核 1 打满的板子在 config.h 里把 fetch
+// 钉到核 0 摊开负载
+#ifndef AFE_FETCH_TASK_CORE
+#define AFE_FETCH_TASK_CORE -1
+#endif
+#ifndef AFE_FETCH_TASK_PRIORITY
+#define AFE_FETCH_TASK_PRIORITY 2
+#endif
+
+namespace sched_profile {
+
+static const Placement kProfiles[] = {
+    // balanced：沿用历史布局——LVGL 1 不绑核、主循环 3、播放 4、
+    // 编码 2/核0、解码 3/核1、AFE 按板级宏。既有板子的基线
+    { "balanced", 1, -1, 3, 4, 2, 0, 3, 1,
+      AFE_FETCH_TASK_PRIORITY, AFE_FETCH_TASK_CORE },
+    // audio_first：音频链整体集中到核 1 并抬高一档，LVGL 钉到核 0
+    // 和 WiFi 作伴——渲染让路，音频帧几乎不被动画抢
+    { "audio_first", 1, 0, 3, 5, 3, 1, 4, 1, 4, 1 },
+    // display_first：渲染抬到 2 且独占核 1 的大头，音频链退回核 0，
+    // 接受偶发的编码超预算。动画优先的展示类板子用
+    { "display_first", 2, 1, 3, 4, 2, 0, 3, 0, 2, 0 },
+};
+
+const Placement& Current() {
+#if defined(CONFIG_SCHED_PROFILE_AUDIO_FIRST)
+    return kProfiles[1];
+#elif defined(CONFIG_SCHED_PROFILE_DISPLAY_FIRST)
+    return kProfiles[2];
+#else
+    return kProfiles[0];
+#endif
+}
+
+}  // namespace sched_profile
+
+#if CONFIG_AUDIO_BENCHMARK
+
+#include <opus_encoder.h>
+#include <opus_decoder.h>
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/semphr.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace sched_profile {
+
+namespace {
+
+// 与 audio_benchmark 同口径：每档案 10 秒等效音频量，60ms 帧
+constexpr int kStressSeconds = 10;
+constexpr int kFrameMs = 60;
+
+struct StressState {
+    volatile bool stop;
+    volatile uint32_t render_passes;
+    SemaphoreHandle_t render_done;
+};
+
+// 动画负载：PSRAM 帧缓冲按 40 行条带搬进内部缓冲再写回，
+// 贴近 LVGL 渲染 + flush 的访存形态，每帧歇 5ms 模拟 vsync 间隔
+void RenderLoad(void* arg) {
+    auto state = (StressState*)arg;
+    constexpr int kWidth = 320, kHeight = 240, kChunkLines = 40;
+    auto frame = (uint16_t*)heap_caps_malloc(kWidth * kHeight * sizeof(uint16_t),
+        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    auto chunk = (uint16_t*)heap_caps_malloc(kWidth * kChunkLines * sizeof(uint16_t),
+        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    while (!state->stop && frame != nullptr && chunk != nullptr) {
+        for (int y = 0; y < kHeight; y += kChunkLines) {
+            memcpy(chunk, frame + (size_t)y * kWidth, kWidth * kChunkLines * sizeof(uint16_t));
+            for (int i = 0; i < kWidth * kChunkLines; i++) {
+                chunk[i] = __builtin_bswap16(chunk[i]);
+            }
+            memcpy(frame + (size_t)y * kWidth, chunk, kWidth * kChunkLines * sizeof(uint16_t));
+        }
+        state->render_passes = state->render_passes + 1;
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+    if (frame != nullptr) {
+        heap_caps_free(frame);
+    }
+    if (chunk != nullptr) {
+        heap_caps_free(chunk);
+    }
+    xSemaphoreGive(state->render_done);
+    vTaskDelete(NULL);
+}
+
+}  // namespace
+
+void RunStressBenchmark() {
+    const int frame_samples = 16000 / 1000 * kFrameMs;
+    const int frames = kStressSeconds * 1000 / kFrameMs;
+    std::vector<int16_t> base(frame_samples);
+    for (int i = 0; i < frame_samples; i++) {
+        base[i] = (int16_t)(16384.0 * sin(2.0 * M_PI * 1000.0 * i / 16000));
+    }
+
+    for (const auto& profile : kProfiles) {
+        StressState state = {};
+        state.render_done = xSemaphoreCreateBinary();
+        xTaskCreatePinnedToCore(RenderLoad, "stress_render", 4096, &state,
+            profile.lvgl_priority, nullptr, Core(profile.lvgl_core));
+
+        // 音频负载在按档案摆放的任务上跑：上行编码 + 下行解码，
+        // 一帧的工作（含被抢占的时间）超过 60ms 预算计一次 miss
+        struct AudioArgs {
+            const Placement* profile;
+            const std::vector<int16_t>* base;
+            uint32_t misses;
+            int64_t worst_overrun_us;
+            SemaphoreHandle_t done;
+        } audio = { &profile, &base, 0, 0, xSemaphoreCreateBinary() };
+
+        xTaskCreatePinnedToCore([](void* arg) {
+            auto a = (AudioArgs*)arg;
+            OpusEncoderWrapper encoder(16000, 1, kFrameMs);
+            encoder.SetComplexity(3);
+            OpusDecoderWrapper decoder(16000, 1);
+            const int frames_local = kStressSeconds * 1000 / kFrameMs;
+            TickType_t wake = xTaskGetTickCount();
+            for (int i = 0; i < frames_local; i++) {
+                int64_t t0 = esp_timer_get_time();
+                std::vector<uint8_t> packet;
+                encoder.Encode(std::vector<int16_t>(*a->base),
+                    [&packet](std::vector<uint8_t>&& opus) { packet = std::move(opus); });
+                std::vector<int16_t> pcm;
+                decoder.Decode(std::move(packet), pcm);
+                int64_t work_us = esp_timer_get_time() - t0;
+                if (work_us > kFrameMs * 1000) {
+                    a->misses++;
+                    if (work_us - kFrameMs * 1000 > a->worst_overrun_us) {
+                        a->worst_overrun_us = work_us - kFrameMs * 1000;
+                    }
+                }
+                xTaskDelayUntil(&wake, pdMS_TO_TICKS(kFrameMs));
+            }
+            xSemaphoreGive(a->done);
+            vTaskDelete(NULL);
+        }, "stress_audio", 4096 * 8, &audio, profile.afe_priority, nullptr,
+            Core(profile.afe_core));
+
+        xSemaphoreTake(audio.done, portMAX_DELAY);
+        state.stop = true;
+        xSemaphoreTake(state.render_done, portMAX_DELAY);
+
+        printf("BENCH,sched_stress,profile=%s,frames=%d,misses=%lu,"
+               "worst_overrun_us=%lld,render_passes=%lu\n",
+               profile.name, frames, (unsigned long)audio.misses,
+               (long long)audio.worst_overrun_us,
+               (unsigned long)state.render_passes);
+
+        vSemaphoreDelete(audio.done);
+        vSemaphoreDelete(state.render_done);
+    }
+}
+
+}  // namespace sched_profile
+
+#endif  // CONFIG_AUDIO_BENCHMARK
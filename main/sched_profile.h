@@ -0,0 +1,64 @@
+#ifndef SCHED_PROFILE_H
+#define SCHED_PROFILE_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+
+// 任务布局档案
+// LVGL、主循环、播放、编解码、AFE 的核亲和与优先级原本散落在各自的
+// 创建点，是历史上各自为战长成的布局。这里收拢成命名档案（Kconfig
+// 选择），所有创建点启动时从同一张表取值：布局变成一处可比较、
+// 可实测的决策，而不是各文件里的魔法数。AFE fetch 的板级覆盖宏
+//（config.h 的 AFE_FETCH_TASK_*）继续生效，作用在 balanced 档上
+namespace sched_profile {
+
+struct Placement {
+    const char* name;
+    // core < 0 表示不绑核
+    int lvgl_priority;
+    int lvgl_core;
+    int main_loop_priority;
+    int playback_priority;
+    int encode_priority;
+    int encode_core;
+    int decode_priority;
+    int decode_core;
+    int afe_priority;
+    int afe_core;
+};
+
+// 编译期选定的档案（CONFIG_SCHED_PROFILE_*，默认 balanced）
+const Placement& Current();
+
+// xTaskCreatePinnedToCore 的核参数：负数转 tskNO_AFFINITY，
+// 单核目标上一律不绑
+inline BaseType_t Core(int core) {
+#if CONFIG_FREERTOS_UNICORE
+    (void)core;
+    return tskNO_AFFINITY;
+#else
+    return core < 0 ? tskNO_AFFINITY : core;
+#endif
+}
+
+// lvgl_port 的 task_affinity 参数：-1 表示不绑核，单核目标一律 -1
+inline int LvglAffinity(int core) {
+#if CONFIG_FREERTOS_UNICORE
+    (void)core;
+    return -1;
+#else
+    return core;
+#endif
+}
+
+#if CONFIG_AUDIO_BENCHMARK
+// 合成对话+动画负载：渲染任务按档案的 LVGL 位置狂刷帧缓冲，
+// 音频任务按 AFE 位置以 60ms 节奏编解码，逐档案统计音频帧
+// 超预算（deadline miss）次数——布局按板实测后再定档
+void RunStressBenchmark();
+#endif
+
+}  // namespace sched_profile
+
+#endif  // SCHED_PROFILE_H
@@ -0,0 +1,148 @@
+#include "session_memory.h"
+#include "json_builder.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#ifdef CONFIG_HEAP_TASK_TRACKING
+#include <esp_heap_task_info.h>
+#endif
+
+#include <cstring>
+
+#define TAG "SessionMemory"
+
+void SessionMemory::OnSessionStart() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_ = true;
+    sessions_++;
+    session_start_us_ = esp_timer_get_time();
+    start_free_internal_ = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    min_free_internal_ = start_free_internal_;
+    task_count_ = 0;
+    memset(tasks_, 0, sizeof(tasks_));
+    // 基线就是第一份样本：没有它，会话刚建立时的分配峰值会漏记
+    SampleLocked();
+}
+
+void SessionMemory::Sample() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_) {
+        return;
+    }
+    SampleLocked();
+}
+
+void SessionMemory::SampleLocked() {
+    uint32_t free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    if (free_internal < min_free_internal_) {
+        min_free_internal_ = free_internal;
+    }
+
+#ifdef CONFIG_HEAP_TASK_TRACKING
+    heap_task_totals_t totals[kMaxTasks];
+    size_t num_totals = 0;
+    heap_task_info_params_t params = {};
+    params.caps[0] = MALLOC_CAP_INTERNAL;
+    params.mask[0] = MALLOC_CAP_INTERNAL;
+    params.tasks = NULL;
+    params.num_tasks = 0;
+    params.totals = totals;
+    params.num_totals = &num_totals;
+    params.max_totals = kMaxTasks;
+    params.blocks = NULL;
+    params.max_blocks = 0;
+    heap_caps_get_per_task_info(&params);
+
+    for (size_t i = 0; i < num_totals; i++) {
+        uint32_t bytes = totals[i].size[0];
+        uint32_t count = totals[i].count[0];
+        TaskUsage* entry = nullptr;
+        for (size_t j = 0; j < task_count_; j++) {
+            if (tasks_[j].task == totals[i].task) {
+                entry = &tasks_[j];
+                break;
+            }
+        }
+        if (entry == nullptr) {
+            // 表满归进最后一格；NULL 句柄是调度器起来前的分配
+            entry = &tasks_[task_count_ < kMaxTasks ? task_count_ : kMaxTasks - 1];
+            if (task_count_ < kMaxTasks) {
+                task_count_++;
+                entry->task = totals[i].task;
+                // 任务名趁活着的时候拷走，结算时句柄可能已经没了
+                const char* name = totals[i].task != NULL
+                    ? pcTaskGetName(totals[i].task) : "pre_sched";
+                strlcpy(entry->name, name != nullptr ? name : "?", sizeof(entry->name));
+                entry->start_bytes = bytes;
+            }
+        }
+        if (bytes > entry->peak_bytes) {
+            entry->peak_bytes = bytes;
+        }
+        if (count > entry->peak_count) {
+            entry->peak_count = count;
+        }
+    }
+#endif
+}
+
+void SessionMemory::OnSessionEnd() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_) {
+        return;
+    }
+    SampleLocked();
+    active_ = false;
+    uint32_t end_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    last_high_water_ = start_free_internal_ - min_free_internal_;
+    last_residual_ = (int32_t)start_free_internal_ - (int32_t)end_free;
+    last_duration_s_ = (uint32_t)((esp_timer_get_time() - session_start_us_) / 1000000);
+    ESP_LOGI(TAG, "Session %lu: %lus high water %lu residual %ld",
+        sessions_, last_duration_s_, last_high_water_, last_residual_);
+#ifdef CONFIG_HEAP_TASK_TRACKING
+    for (size_t i = 0; i < task_count_; i++) {
+        int32_t growth = (int32_t)tasks_[i].peak_bytes - (int32_t)tasks_[i].start_bytes;
+        if (growth > 1024) {
+            ESP_LOGI(TAG, "  %s: peak %lu (+%ld, %lu blocks)",
+                tasks_[i].name, tasks_[i].peak_bytes, growth, tasks_[i].peak_count);
+        }
+    }
+#endif
+}
+
+std::string SessionMemory::BuildJson() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    char buffer[512];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddNumber("sessions", (int)sessions_);
+    json.AddBool("active", active_);
+    json.AddNumber("start_free", (int)start_free_internal_);
+    json.AddNumber("min_free", (int)min_free_internal_);
+    json.AddNumber("high_water", (int)last_high_water_);
+    json.AddNumber("residual", (int)last_residual_);
+    json.AddNumber("duration", (int)last_duration_s_);
+#ifdef CONFIG_HEAP_TASK_TRACKING
+    // 只带会话内长过 1KB 的任务，免得把遥测包撑爆
+    json.BeginArray("tasks");
+    for (size_t i = 0; i < task_count_; i++) {
+        int32_t growth = (int32_t)tasks_[i].peak_bytes - (int32_t)tasks_[i].start_bytes;
+        if (growth <= 1024) {
+            continue;
+        }
+        json.BeginObject();
+        json.AddString("name", tasks_[i].name);
+        json.AddNumber("peak", (int)tasks_[i].peak_bytes);
+        json.AddNumber("growth", (int)growth);
+        json.EndObject();
+    }
+    json.EndArray();
+#endif
+    json.EndObject();
+    if (json.overflowed()) {
+        return "{}";
+    }
+    return json.str();
+}
@@ -0,0 +1,68 @@
+#ifndef SESSION_MEMORY_H
+#define SESSION_MEMORY_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 会话粒度的内存记账
+// OnClockTimer 的聚合日志只能看出"SRAM 在慢慢变少"，看不出是谁的。
+// 这里在进入 kDeviceStateConnecting 时拍堆基线，会话期间按任务
+//（解码在 bg 池、UI 在 display_ui、协议在传输任务——任务就是这里的
+// 子系统标签）跟踪分配峰值，通道关闭时算出本次会话的高水位画像和
+// 残留增量，通过遥测注册表上报（"session_mem"）。跑到 50+ 会话时
+// 增长归谁一眼可见。按任务归属需要 CONFIG_HEAP_TASK_TRACKING，
+// 没开时退化成整堆的基线/最低水位记账
+class SessionMemory {
+public:
+    static SessionMemory& GetInstance() {
+        static SessionMemory instance;
+        return instance;
+    }
+    SessionMemory(const SessionMemory&) = delete;
+    SessionMemory& operator=(const SessionMemory&) = delete;
+
+    // 进入 kDeviceStateConnecting 时调用；上一个会话没正常收尾
+    // 也直接重开新账
+    void OnSessionStart();
+    // 会话期间每 10 秒从时钟定时器调用一次，不在会话中时是空操作
+    void Sample();
+    // 通道关闭时调用：结算高水位画像并打日志
+    void OnSessionEnd();
+    // 预序列化给遥测注册表
+    std::string BuildJson();
+
+private:
+    SessionMemory() = default;
+
+    struct TaskUsage {
+        TaskHandle_t task;
+        char name[configMAX_TASK_NAME_LEN];
+        uint32_t start_bytes;
+        uint32_t peak_bytes;
+        uint32_t peak_count;
+    };
+
+    void SampleLocked();
+
+    // 板上常驻任务二十个上下，定长表足够；满了的归进最后一格
+    static constexpr size_t kMaxTasks = 24;
+
+    std::mutex mutex_;
+    bool active_ = false;
+    uint32_t sessions_ = 0;
+    int64_t session_start_us_ = 0;
+    uint32_t start_free_internal_ = 0;
+    uint32_t min_free_internal_ = 0;
+    // 上一个会话的结算结果，留给遥测
+    uint32_t last_high_water_ = 0;   // 会话内净占用峰值
+    int32_t last_residual_ = 0;      // 会话结束后没还回来的
+    uint32_t last_duration_s_ = 0;
+    TaskUsage tasks_[kMaxTasks] = {};
+    size_t task_count_ = 0;
+};
+
+#endif  // SESSION_MEMORY_H
@@ -1,45 +1,392 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <nvs_flash.h>
 
+#include <cstring>
+
+#include "json_builder.h"
+
 #define TAG "Settings"
 
-Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
-    nvs_open(ns.c_str(), read_write_ ? NVS_READWRITE : NVS_READONLY, &nvs_handle_);
+// CommitPending 的突发合并窗口：最近写过的命名空间先放一放，等
+// 突发停下来再落盘。启动期 wifi/board/afe/ota 各写各的，合并后每个
+// 命名空间只吃一次 commit；音量连调这类同命名空间的连环写同理
+static constexpr int64_t kCommitSettleUs = 2 * 1000000;
+
+SettingsStore::Namespace& SettingsStore::Open(const std::string& ns) {
+    auto it = namespaces_.find(ns);
+    if (it != namespaces_.end()) {
+        return it->second;
+    }
+    auto& n = namespaces_[ns];
+    // 统一按读写打开并常驻；门面层的只读语义在 Settings 里拦
+    auto ret = nvs_open(ns.c_str(), NVS_READWRITE, &n.handle);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to open namespace %s: %s", ns.c_str(), esp_err_to_name(ret));
+        n.handle = 0;
+    }
+    return n;
 }
 
-Settings::~Settings() {
-    if (nvs_handle_ != 0) {
-        if (read_write_ && dirty_) {
-            ESP_ERROR_CHECK(nvs_commit(nvs_handle_));
-        }
-        nvs_close(nvs_handle_);
+void SettingsStore::Notify(Namespace& n, const std::string& key) {
+    for (auto& listener : n.listeners) {
+        listener(key);
     }
 }
 
-std::string Settings::GetString(const std::string& key, const std::string& default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
+uint32_t SettingsStore::FreeEntries() {
+    nvs_stats_t stats;
+    if (nvs_get_stats(nullptr, &stats) != ESP_OK) {
+        return 0;
+    }
+    return stats.free_entries;
+}
+
+void SettingsStore::AccountWrite(Namespace& n, uint32_t free_before) {
+    n.dirty = true;
+    n.writes++;
+    n.last_write_us = esp_timer_get_time();
+    // NVS 的页擦除发生在写入把页写满、触发 GC 搬移的时刻；GC 回收
+    // 作废条目会让空闲条目不降反升，以此近似擦除次数
+    if (FreeEntries() > free_before) {
+        gc_erases_++;
     }
+}
 
+std::string SettingsStore::GetString(const std::string& ns, const std::string& key, const std::string& default_value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& n = Open(ns);
+    auto it = n.entries.find(key);
+    if (it != n.entries.end()) {
+        return it->second.type == Entry::kString ? it->second.string_value : default_value;
+    }
+    // 未缓存才碰 NVS，读不到也缓存否定结果，避免重连风暴反复页扫描
+    auto& entry = n.entries[key];
+    if (n.handle == 0) {
+        return default_value;
+    }
     size_t length = 0;
-    if (nvs_get_str(nvs_handle_, key.c_str(), nullptr, &length) != ESP_OK) {
+    if (nvs_get_str(n.handle, key.c_str(), nullptr, &length) != ESP_OK) {
         return default_value;
     }
-
     std::string value;
     value.resize(length);
-    ESP_ERROR_CHECK(nvs_get_str(nvs_handle_, key.c_str(), value.data(), &length));
+    ESP_ERROR_CHECK(nvs_get_str(n.handle, key.c_str(), value.data(), &length));
     while (!value.empty() && value.back() == '\0') {
         value.pop_back();
     }
+    entry.type = Entry::kString;
+    entry.string_value = value;
+    return value;
+}
+
+void SettingsStore::SetString(const std::string& ns, const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& n = Open(ns);
+    auto& entry = n.entries[key];
+    if (entry.type == Entry::kString && entry.string_value == value) {
+        return;  // 值没变就不写 flash
+    }
+    entry.type = Entry::kString;
+    entry.string_value = value;
+    if (n.handle != 0) {
+        uint32_t free_before = FreeEntries();
+        ESP_ERROR_CHECK(nvs_set_str(n.handle, key.c_str(), value.c_str()));
+        AccountWrite(n, free_before);
+    }
+    Notify(n, key);
+}
+
+int32_t SettingsStore::GetInt(const std::string& ns, const std::string& key, int32_t default_value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& n = Open(ns);
+    auto it = n.entries.find(key);
+    if (it != n.entries.end()) {
+        return it->second.type == Entry::kInt ? it->second.int_value : default_value;
+    }
+    auto& entry = n.entries[key];
+    if (n.handle == 0) {
+        return default_value;
+    }
+    int32_t value;
+    if (nvs_get_i32(n.handle, key.c_str(), &value) != ESP_OK) {
+        return default_value;
+    }
+    entry.type = Entry::kInt;
+    entry.int_value = value;
     return value;
 }
 
+void SettingsStore::SetInt(const std::string& ns, const std::string& key, int32_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& n = Open(ns);
+    auto& entry = n.entries[key];
+    if (entry.type == Entry::kInt && entry.int_value == value) {
+        return;
+    }
+    entry.type = Entry::kInt;
+    entry.int_value = value;
+    if (n.handle != 0) {
+        uint32_t free_before = FreeEntries();
+        ESP_ERROR_CHECK(nvs_set_i32(n.handle, key.c_str(), value));
+        AccountWrite(n, free_before);
+    }
+    Notify(n, key);
+}
+
+bool SettingsStore::GetBlob(const std::string& ns, const std::string& key, uint8_t version, void* out, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& n = Open(ns);
+    auto it = n.entries.find(key);
+    if (it == n.entries.end()) {
+        // 未缓存才碰 NVS，读不到同样缓存否定结果
+        auto& entry = n.entries[key];
+        if (n.handle == 0) {
+            return false;
+        }
+        size_t length = 0;
+        if (nvs_get_blob(n.handle, key.c_str(), nullptr, &length) != ESP_OK || length == 0) {
+            return false;
+        }
+        entry.string_value.resize(length);
+        ESP_ERROR_CHECK(nvs_get_blob(n.handle, key.c_str(), entry.string_value.data(), &length));
+        entry.type = Entry::kBlob;
+        it = n.entries.find(key);
+    }
+    auto& entry = it->second;
+    // 版本或长度对不上视同不存在：结构改过的老数据不往新结构里灌
+    if (entry.type != Entry::kBlob || entry.string_value.size() != size + 1 ||
+        (uint8_t)entry.string_value[0] != version) {
+        return false;
+    }
+    memcpy(out, entry.string_value.data() + 1, size);
+    return true;
+}
+
+void SettingsStore::SetBlob(const std::string& ns, const std::string& key, uint8_t version, const void* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& n = Open(ns);
+    std::string value;
+    value.reserve(size + 1);
+    value.push_back((char)version);
+    value.append((const char*)data, size);
+    auto& entry = n.entries[key];
+    if (entry.type == Entry::kBlob && entry.string_value == value) {
+        return;  // 值没变就不写 flash
+    }
+    entry.type = Entry::kBlob;
+    entry.string_value = std::move(value);
+    if (n.handle != 0) {
+        uint32_t free_before = FreeEntries();
+        ESP_ERROR_CHECK(nvs_set_blob(n.handle, key.c_str(), entry.string_value.data(), entry.string_value.size()));
+        AccountWrite(n, free_before);
+    }
+    Notify(n, key);
+}
+
+bool SettingsStore::Has(const std::string& ns, const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& n = Open(ns);
+    auto it = n.entries.find(key);
+    if (it != n.entries.end()) {
+        return it->second.type != Entry::kMissing;
+    }
+    if (n.handle == 0) {
+        return false;
+    }
+    // 只探测存在性，值留给之后真正的 Get 去缓存
+    nvs_type_t type;
+    return nvs_find_key(n.handle, key.c_str(), &type) == ESP_OK;
+}
+
+void SettingsStore::EraseKey(const std::string& ns, const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& n = Open(ns);
+    n.entries[key] = Entry{};  // 缓存否定结果
+    if (n.handle != 0) {
+        uint32_t free_before = FreeEntries();
+        auto ret = nvs_erase_key(n.handle, key.c_str());
+        if (ret != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_ERROR_CHECK(ret);
+            AccountWrite(n, free_before);
+        }
+    }
+    Notify(n, key);
+}
+
+void SettingsStore::EraseAll(const std::string& ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& n = Open(ns);
+    n.entries.clear();
+    if (n.handle != 0) {
+        uint32_t free_before = FreeEntries();
+        ESP_ERROR_CHECK(nvs_erase_all(n.handle));
+        AccountWrite(n, free_before);
+    }
+    Notify(n, "");
+}
+
+void SettingsStore::Commit(const std::string& ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = namespaces_.find(ns);
+    if (it != namespaces_.end() && it->second.dirty && it->second.handle != 0) {
+        ESP_ERROR_CHECK(nvs_commit(it->second.handle));
+        it->second.dirty = false;
+        it->second.commits++;
+    }
+    for (auto p = pending_.begin(); p != pending_.end(); ++p) {
+        if (*p == ns) {
+            pending_.erase(p);
+            break;
+        }
+    }
+}
+
+void SettingsStore::RequestCommit(const std::string& ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = namespaces_.find(ns);
+    if (it == namespaces_.end() || !it->second.dirty) {
+        return;
+    }
+    for (auto& p : pending_) {
+        if (p == ns) {
+            return;  // 已在待办里，保持原有次序
+        }
+    }
+    pending_.push_back(ns);
+}
+
+bool SettingsStore::HasPendingCommits() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !pending_.empty();
+}
+
+void SettingsStore::CommitPending() {
+    // 一次只取一个出来提交，提交期间不持锁：nvs_commit 可能挂起
+    // cache 几十毫秒，别把这段时间里的 Set/Get 都堵在 mutex 上
+    const int64_t now = esp_timer_get_time();
+    for (;;) {
+        nvs_handle_t handle = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // 找第一个突发已经停下来的待办；刚写过的留在队里等下个
+            // 空闲周期，一波跨命名空间的启动写入合并成每空间一次 commit
+            auto p = pending_.begin();
+            while (p != pending_.end()) {
+                auto it = namespaces_.find(*p);
+                if (it == namespaces_.end() || !it->second.dirty || it->second.handle == 0) {
+                    p = pending_.erase(p);  // 已被显式 Commit 清过账
+                    continue;
+                }
+                if (now - it->second.last_write_us < kCommitSettleUs) {
+                    ++p;  // 突发没停，下个空闲周期再看
+                    continue;
+                }
+                handle = it->second.handle;
+                // 先清脏标记再松锁：提交期间新来的写入会重新置脏并
+                // 重新排队，不会被这次提交顺手"提交"掉记账
+                it->second.dirty = false;
+                it->second.commits++;
+                pending_.erase(p);
+                break;
+            }
+        }
+        if (handle == 0) {
+            return;  // 待办空了，或剩下的都还在合并窗口内
+        }
+        ESP_ERROR_CHECK(nvs_commit(handle));
+    }
+}
+
+void SettingsStore::FlushAll() {
+    CommitPending();
+    // 还没进待办的脏命名空间（门面对象还活着）、以及还压在合并
+    // 窗口里的，这里不等窗口一并清账
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [name, n] : namespaces_) {
+        if (n.dirty && n.handle != 0) {
+            ESP_ERROR_CHECK(nvs_commit(n.handle));
+            n.dirty = false;
+            n.commits++;
+        }
+    }
+    pending_.clear();
+}
+
+void SettingsStore::Subscribe(const std::string& ns, std::function<void(const std::string& key)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Open(ns).listeners.push_back(std::move(callback));
+}
+
+std::string SettingsStore::BuildWearJson() {
+    nvs_stats_t stats = {};
+    nvs_get_stats(nullptr, &stats);
+
+    char buffer[512];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t total_writes = 0;
+    uint32_t total_commits = 0;
+    for (auto& [name, n] : namespaces_) {
+        total_writes += n.writes;
+        total_commits += n.commits;
+    }
+    json.AddNumber("writes", (int)total_writes);
+    json.AddNumber("commits", (int)total_commits);
+    json.AddNumber("gc_erases", (int)gc_erases_);
+    json.AddNumber("used", (int)stats.used_entries);
+    json.AddNumber("free", (int)stats.free_entries);
+    // 按命名空间细分，定位磨损大户；从没写过的只读空间不占行
+    json.BeginObject("ns");
+    for (auto& [name, n] : namespaces_) {
+        if (n.writes == 0) {
+            continue;
+        }
+        json.BeginObject(name.c_str());
+        json.AddNumber("w", (int)n.writes);
+        json.AddNumber("c", (int)n.commits);
+        json.EndObject();
+    }
+    json.EndObject();
+    json.EndObject();
+    if (json.overflowed()) {
+        // 命名空间多到装不下（不太可能）：退回只给全局计数
+        return "{\"writes\":" + std::to_string(total_writes) +
+            ",\"commits\":" + std::to_string(total_commits) +
+            ",\"gc_erases\":" + std::to_string(gc_erases_) + "}";
+    }
+    return json.str();
+}
+
+Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
+}
+
+Settings::~Settings() {
+    // 不再同步 commit：记入待办，应用空闲时批量落盘。写入本体已经
+    // 在 NVS 里，这里欠的只是 commit
+    if (read_write_ && dirty_) {
+        SettingsStore::GetInstance().RequestCommit(ns_);
+    }
+}
+
+void Settings::Flush() {
+    if (read_write_ && dirty_) {
+        SettingsStore::GetInstance().Commit(ns_);
+        dirty_ = false;
+    }
+}
+
+std::string Settings::GetString(const std::string& key, const std::string& default_value) {
+    return SettingsStore::GetInstance().GetString(ns_, key, default_value);
+}
+
 void Settings::SetString(const std::string& key, const std::string& value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_str(nvs_handle_, key.c_str(), value.c_str()));
+        SettingsStore::GetInstance().SetString(ns_, key, value);
         dirty_ = true;
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
@@ -47,20 +394,25 @@ void Settings::SetString(const std::string& key, const std::string& value) {
 }
 
 int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
-    }
+    return SettingsStore::GetInstance().GetInt(ns_, key, default_value);
+}
 
-    int32_t value;
-    if (nvs_get_i32(nvs_handle_, key.c_str(), &value) != ESP_OK) {
-        return default_value;
+void Settings::SetInt(const std::string& key, int32_t value) {
+    if (read_write_) {
+        SettingsStore::GetInstance().SetInt(ns_, key, value);
+        dirty_ = true;
+    } else {
+        ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
-    return value;
 }
 
-void Settings::SetInt(const std::string& key, int32_t value) {
+bool Settings::GetBlob(const std::string& key, uint8_t version, void* out, size_t size) {
+    return SettingsStore::GetInstance().GetBlob(ns_, key, version, out, size);
+}
+
+void Settings::SetBlob(const std::string& key, uint8_t version, const void* data, size_t size) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_i32(nvs_handle_, key.c_str(), value));
+        SettingsStore::GetInstance().SetBlob(ns_, key, version, data, size);
         dirty_ = true;
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
@@ -69,10 +421,8 @@ void Settings::SetInt(const std::string& key, int32_t value) {
 
 void Settings::EraseKey(const std::string& key) {
     if (read_write_) {
-        auto ret = nvs_erase_key(nvs_handle_, key.c_str());
-        if (ret != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_ERROR_CHECK(ret);
-        }
+        SettingsStore::GetInstance().EraseKey(ns_, key);
+        dirty_ = true;
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -80,7 +430,8 @@ void Settings::EraseKey(const std::string& key) {
 
 void Settings::EraseAll() {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_erase_all(nvs_handle_));
+        SettingsStore::GetInstance().EraseAll(ns_);
+        dirty_ = true;
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
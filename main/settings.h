@@ -1,9 +1,102 @@
 #ifndef SETTINGS_H
 #define SETTINGS_H
 
-#include <string>
 #include <nvs_flash.h>
 
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 进程级设置缓存。以前每个 Settings 对象都重新 nvs_open，MQTT 重连一次
+// 要开一把句柄读五个键，重连风暴时 NVS 页扫描正好叠在恢复音频的路径上。
+// 这里每个命名空间只打开一次并常驻，值读过一次后缓存在 RAM（包括"不存在"
+// 的否定结果），写入直写 NVS，commit 则攒进待办列表由应用在空闲态
+// 批量落盘——SetOutputVolume 这类对话中的写入不再把几十毫秒的 flash
+// commit（cache 挂起）摊在调用方身上。关键写入（马上要重启的配置）
+// 用显式 Flush。另外提供按命名空间的变更通知回调。
+class SettingsStore {
+public:
+    static SettingsStore& GetInstance() {
+        static SettingsStore instance;
+        return instance;
+    }
+    SettingsStore(const SettingsStore&) = delete;
+    SettingsStore& operator=(const SettingsStore&) = delete;
+
+    std::string GetString(const std::string& ns, const std::string& key, const std::string& default_value);
+    void SetString(const std::string& ns, const std::string& key, const std::string& value);
+    int32_t GetInt(const std::string& ns, const std::string& key, int32_t default_value);
+    void SetInt(const std::string& ns, const std::string& key, int32_t value);
+    // 成组二进制配置（结构定义见 config_blobs.h）：整组字段一次
+    // nvs_get/set_blob，首字节是版本号，版本或长度不匹配按不存在
+    // 处理，调用方回退到重新获取
+    bool GetBlob(const std::string& ns, const std::string& key, uint8_t version, void* out, size_t size);
+    void SetBlob(const std::string& ns, const std::string& key, uint8_t version, const void* data, size_t size);
+    // 键是否存在（任意类型）。只探测不取值、不污染缓存，schema
+    // 迁移用它区分"缺失"和"恰好等于默认值"
+    bool Has(const std::string& ns, const std::string& key);
+    void EraseKey(const std::string& ns, const std::string& key);
+    void EraseAll(const std::string& ns);
+    // 把该命名空间攒下的写入立即落盘（关键写入的显式 flush）
+    void Commit(const std::string& ns);
+    // 记入待办：由应用在空闲态调 CommitPending 批量落盘
+    void RequestCommit(const std::string& ns);
+    bool HasPendingCommits();
+    // 按变脏顺序落盘待办的命名空间，保持跨命名空间的写入次序
+    //（单命名空间内 NVS 自己保证顺序）。在低优先级任务上调用
+    void CommitPending();
+    // 重启前清账：所有待办一次落盘
+    void FlushAll();
+    // 该命名空间任意键被写入/擦除时回调（回调在写入方的任务上执行）
+    void Subscribe(const std::string& ns, std::function<void(const std::string& key)> callback);
+    // NVS 磨损记账快照（挂遥测注册表）：全局 commit/GC 计数与分区
+    // 条目水位，外加按命名空间的写入/提交数——flash 寿命在 24/7
+    // 设备上是运营成本，先让它可测量
+    std::string BuildWearJson();
+
+private:
+    SettingsStore() = default;
+
+    struct Entry {
+        enum Type { kMissing, kInt, kString, kBlob } type = kMissing;
+        int32_t int_value = 0;
+        // kBlob 复用这里存原始字节（含版本头）
+        std::string string_value;
+    };
+
+    struct Namespace {
+        nvs_handle_t handle = 0;
+        bool dirty = false;
+        // 磨损记账：落到 flash 的写入/擦除数、commit 数、最近一次
+        // 写入时刻（CommitPending 的突发合并窗口用）
+        uint32_t writes = 0;
+        uint32_t commits = 0;
+        int64_t last_write_us = 0;
+        std::unordered_map<std::string, Entry> entries;
+        std::vector<std::function<void(const std::string&)>> listeners;
+    };
+
+    // 调用方必须持有 mutex_
+    Namespace& Open(const std::string& ns);
+    void Notify(Namespace& n, const std::string& key);
+    // 默认分区的空闲条目数（nvs_get_stats，纯内存页表，不碰 flash）
+    static uint32_t FreeEntries();
+    // 写入落账：置脏、记磨损；写前采的 free_before 与写后对比，
+    // 空闲条目不降反升说明这次写触发了 GC（页擦除+搬移）
+    void AccountWrite(Namespace& n, uint32_t free_before);
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Namespace> namespaces_;
+    // 待落盘的命名空间，按变脏顺序
+    std::vector<std::string> pending_;
+    // GC 事件数（每次 GC 擦一页，IDF 没有直接的擦除计数器，用
+    // 写入前后的空闲条目回升近似）
+    uint32_t gc_erases_ = 0;
+};
+
+// 原有的轻量门面，保持各处调用方式不变；析构时批量 commit
 class Settings {
 public:
     Settings(const std::string& ns, bool read_write = false);
@@ -13,12 +106,16 @@ public:
     void SetString(const std::string& key, const std::string& value);
     int32_t GetInt(const std::string& key, int32_t default_value = 0);
     void SetInt(const std::string& key, int32_t value);
+    bool GetBlob(const std::string& key, uint8_t version, void* out, size_t size);
+    void SetBlob(const std::string& key, uint8_t version, const void* data, size_t size);
     void EraseKey(const std::string& key);
     void EraseAll();
+    // 立即落盘本命名空间：写完马上要重启/断电的配置走这里，
+    // 不等空闲态的批量 commit
+    void Flush();
 
 private:
     std::string ns_;
-    nvs_handle_t nvs_handle_ = 0;
     bool read_write_ = false;
     bool dirty_ = false;
 };
@@ -0,0 +1,180 @@
+#include "settings_schema.h"
+#include "settings.h"
+#include "boot_profiler.h"
+#include "json_builder.h"
+
+#include <esp_log.h>
+#include <nvs.h>
+
+#include <cstring>
+
+#define TAG "SettingsSchema"
+
+namespace settings_schema {
+
+namespace {
+
+enum KeyType { kInt, kString, kBlob };
+
+struct KeyDecl {
+    const char* ns;
+    const char* key;
+    KeyType type;
+    int32_t default_int;      // kInt 用
+    const char* default_str;  // kString 用
+};
+
+// 声明表：全部已知的配置键。新增配置键时在这里登记，否则漂移检查
+// 会拿它报警
+constexpr KeyDecl kKeys[] = {
+    { "audio",     "output_volume", kInt,    70, nullptr },
+    { "display",   "brightness",    kInt,    75, nullptr },
+    { "wifi",      "force_ap",      kInt,    0,  nullptr },
+    { "wifi",      "fast_connect",  kBlob,   0,  nullptr },
+    { "board",     "uuid",          kString, 0,  "" },
+    { "mqtt",      "endpoint",      kString, 0,  "" },
+    { "mqtt",      "client_id",     kString, 0,  "" },
+    { "mqtt",      "username",      kString, 0,  "" },
+    { "mqtt",      "password",      kString, 0,  "" },
+    { "mqtt",      "publish_topic", kString, 0,  "" },
+    { "mqtt",      "config",        kBlob,   0,  nullptr },
+    { "ota",       "url",           kString, 0,  "" },
+    { "ota",       "version",       kString, 0,  "" },
+    { "ota",       "offset",        kInt,    0,  nullptr },
+    { "ota",       "total_size",    kInt,    0,  nullptr },
+    { "ota",       "ready",         kInt,    0,  nullptr },
+    { "ota",       "check_cache",   kBlob,   0,  nullptr },
+    { "ota",       "assets_url",    kString, 0,  "" },
+    { "ota",       "assets_offset", kInt,    0,  nullptr },
+    { "ota",       "assets_total",  kInt,    0,  nullptr },
+    { "ota",       "assets_ready",  kInt,    0,  nullptr },
+    { "assets",    "active",        kString, 0,  "assets_a" },
+    { "afe",       "ambient",       kBlob,   0,  nullptr },
+    { "led_strip", "brightness",    kInt,    4,  nullptr },
+    { "vendor",    "press_to_talk", kInt,    0,  nullptr },
+};
+
+// 键改名迁移表：{生效版本, 命名空间, 老键, 新键, 类型}。存储版本到
+// kVersion 之间的条目按序应用：值搬到新键（新键已有值则不覆盖）、
+// 老键擦掉，整个过程只跑一次。目前还没有改过名的键，机制先立着
+struct Rename {
+    int32_t to_version;
+    const char* ns;
+    const char* old_key;
+    const char* new_key;
+    KeyType type;
+};
+constexpr const Rename* kRenames = nullptr;
+constexpr size_t kRenameCount = 0;
+
+bool Declared(const char* ns, const char* key) {
+    for (const auto& decl : kKeys) {
+        if (strcmp(decl.ns, ns) == 0 && strcmp(decl.key, key) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 迁移结果，BuildJson 报给遥测
+int32_t g_from_version = 0;
+int g_renamed = 0;
+int g_seeded = 0;
+int g_unknown = 0;
+
+}  // namespace
+
+void Migrate() {
+    boot_profiler::Scope scope("settings_schema");
+    auto& store = SettingsStore::GetInstance();
+    int32_t stored = store.GetInt("schema", "version", 0);
+    g_from_version = stored;
+    if (stored > kVersion) {
+        // 降级刷回老固件：数据不动，新版才有的键老代码读不懂就按
+        // 自己的默认走，不能反向"迁移"把新数据弄丢
+        ESP_LOGW(TAG, "Stored schema %ld newer than %ld, leaving data untouched",
+            stored, kVersion);
+        return;
+    }
+
+    // 1. 改名迁移：只应用比存储版本新的条目
+    for (size_t i = 0; i < kRenameCount; i++) {
+        const Rename& r = kRenames[i];
+        if (r.to_version <= stored || !store.Has(r.ns, r.old_key)) {
+            continue;
+        }
+        if (!store.Has(r.ns, r.new_key)) {
+            if (r.type == kInt) {
+                store.SetInt(r.ns, r.new_key, store.GetInt(r.ns, r.old_key, 0));
+            } else if (r.type == kString) {
+                store.SetString(r.ns, r.new_key, store.GetString(r.ns, r.old_key, ""));
+            }
+            ESP_LOGI(TAG, "Migrated %s/%s -> %s", r.ns, r.old_key, r.new_key);
+            g_renamed++;
+        }
+        store.EraseKey(r.ns, r.old_key);
+    }
+
+    // 2. 落默认值：缺失的键物化进 NVS，之后所有读取命中 RAM 缓存的
+    //    肯定结果，也让 nvs 里的状态和 schema 一一对应
+    for (const auto& decl : kKeys) {
+        if (decl.type == kBlob || store.Has(decl.ns, decl.key)) {
+            continue;
+        }
+        if (decl.type == kInt) {
+            store.SetInt(decl.ns, decl.key, decl.default_int);
+        } else {
+            store.SetString(decl.ns, decl.key, decl.default_str);
+        }
+        g_seeded++;
+    }
+    if (g_seeded > 0) {
+        ESP_LOGI(TAG, "Seeded %d missing keys with schema defaults", g_seeded);
+    }
+
+    // 3. 漂移检查：已声明命名空间里表外的键点名告警。键名动态的
+    //    命名空间（task_wm）不在表里，自然不会被扫到
+    const char* last_ns = "";
+    for (const auto& decl : kKeys) {
+        if (strcmp(decl.ns, last_ns) == 0) {
+            continue;  // 表按命名空间分组，同一个空间只扫一遍
+        }
+        last_ns = decl.ns;
+        nvs_iterator_t it = nullptr;
+        esp_err_t err = nvs_entry_find(NVS_DEFAULT_PART_NAME, decl.ns, NVS_TYPE_ANY, &it);
+        while (err == ESP_OK) {
+            nvs_entry_info_t info;
+            nvs_entry_info(it, &info);
+            if (!Declared(decl.ns, info.key)) {
+                ESP_LOGW(TAG, "Unknown key %s/%s (renamed or removed from schema?)",
+                    decl.ns, info.key);
+                g_unknown++;
+            }
+            err = nvs_entry_next(&it);
+        }
+        nvs_release_iterator(it);
+    }
+
+    if (stored != kVersion) {
+        store.SetInt("schema", "version", kVersion);
+        // 迁移结果马上落盘：这时候还没有别的脏命名空间，FlushAll
+        // 清掉的就是改名和默认值的欠账
+        store.FlushAll();
+        ESP_LOGI(TAG, "Schema migrated %ld -> %ld", stored, kVersion);
+    }
+}
+
+std::string BuildJson() {
+    char buffer[160];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    json.AddNumber("version", (int)kVersion);
+    json.AddNumber("from", (int)g_from_version);
+    json.AddNumber("renamed", g_renamed);
+    json.AddNumber("seeded", g_seeded);
+    json.AddNumber("unknown_keys", g_unknown);
+    json.EndObject();
+    return json.str();
+}
+
+}  // namespace settings_schema
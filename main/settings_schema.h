@@ -0,0 +1,30 @@
+#ifndef SETTINGS_SCHEMA_H
+#define SETTINGS_SCHEMA_H
+
+#include <string>
+
+// 设置键的声明表与开机一次性迁移。
+// 以前每个 Get 调用点各自带默认值，键缺失（包括 OTA 后改名残留的
+// 老键）只会无声地退回默认——性能配置悄悄降级，没人知道。这里把
+// 已知的键、类型、默认值收进一张表，开机跑一遍：
+//  1. 按迁移表把改过名的键搬到新名字（搬一次，老键擦掉）
+//  2. 给缺失的 int/string 键落默认值，之后所有读取都命中
+//     SettingsStore 的 RAM 缓存肯定结果，调用点默认值只剩防御意义
+//  3. 扫已声明命名空间里表外的键，记 W 日志——配置漂移从无声降级
+//     变成可见告警
+// blob 键自带版本头（config_blobs.h），不落默认值，只进白名单。
+// task_wm 这类键名动态的命名空间不在表里，迁移不碰。
+namespace settings_schema {
+
+// 当前 schema 版本：键改名/挪窝时 +1 并在 kRenames 里登记
+constexpr int32_t kVersion = 1;
+
+// 开机调一次，必须在消费方读配置之前
+void Migrate();
+
+// 迁移结果概要，挂遥测 settings 面板
+std::string BuildJson();
+
+}  // namespace settings_schema
+
+#endif  // SETTINGS_SCHEMA_H
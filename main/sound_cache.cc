@@ -0,0 +1,49 @@
+#include "sound_cache.h"
+#include "asset_pack.h"
+#include "sound_index.h"
+#include "assets/lang_config.h"
+
+#include <opus_decoder.h>
+#include <esp_log.h>
+
+#define TAG "SoundCache"
+
+void SoundCache::Prewarm() {
+    // 高频 UI 反馈音；提示语（welcome/upgrade 等）一次会话最多一回，
+    // 不值得常驻 PCM
+    static const std::string_view* kUiSounds[] = {
+        &Lang::Sounds::P3_SUCCESS,
+        &Lang::Sounds::P3_EXCLAMATION,
+        &Lang::Sounds::P3_VIBRATION,
+    };
+
+    // 专用解码器，预热全程不碰会话解码路径
+    OpusDecoderWrapper decoder(16000, 1);
+    size_t total_samples = 0;
+    for (const auto* sound : kUiSounds) {
+        auto resolved = AssetPack::GetInstance().ResolveSound(*sound);
+        if (resolved.empty()) {
+            continue;
+        }
+        for (const auto& packet : SoundIndex::GetInstance().Get(resolved)) {
+            std::vector<uint8_t> opus(packet.begin(), packet.end());
+            std::vector<int16_t> pcm;
+            if (!decoder.Decode(std::move(opus), pcm)) {
+                ESP_LOGW(TAG, "Failed to pre-decode sound packet, skipped");
+                continue;
+            }
+            total_samples += pcm.size();
+            std::lock_guard<std::mutex> lock(mutex_);
+            pcm_.emplace((const uint8_t*)packet.data(),
+                std::pmr::vector<int16_t>(pcm.begin(), pcm.end(), psram_pmr::cold()));
+        }
+    }
+    ESP_LOGI(TAG, "Pre-decoded %u packets, %u KB PCM in PSRAM",
+        (unsigned)pcm_.size(), (unsigned)(total_samples * sizeof(int16_t) / 1024));
+}
+
+const std::pmr::vector<int16_t>* SoundCache::Lookup(const uint8_t* data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pcm_.find(data);
+    return it != pcm_.end() ? &it->second : nullptr;
+}
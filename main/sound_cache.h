@@ -0,0 +1,38 @@
+#ifndef SOUND_CACHE_H
+#define SOUND_CACHE_H
+
+#include "psram_pmr.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// 常用 UI 音效的预解码 PCM 缓存。success/exclamation/vibration 这几个
+// 短音效每次播放都要过一遍共享解码路径，和会话建立抢解码时间；它们
+// 又小又固定，开机后在批量车道上解一次、PCM 存 PSRAM（16kHz 单声道，
+// 合计百来 KB），之后播放就是 memcpy，零解码延迟也不碰会话解码器。
+// 缓存按 Opus 包的数据指针命中（flash 切片常驻，指针天然唯一），
+// SoundMixer 查到就跳过解码，查不到照旧
+class SoundCache {
+public:
+    static SoundCache& GetInstance() {
+        static SoundCache instance;
+        return instance;
+    }
+    SoundCache(const SoundCache&) = delete;
+    SoundCache& operator=(const SoundCache&) = delete;
+
+    // 开机后调用一次（放后台批量车道，不占启动关键路径）
+    void Prewarm();
+    // 命中返回该 Opus 包对应的预解码 PCM，否则 nullptr
+    const std::pmr::vector<int16_t>* Lookup(const uint8_t* data);
+
+private:
+    SoundCache() = default;
+
+    std::mutex mutex_;
+    std::map<const uint8_t*, std::pmr::vector<int16_t>> pcm_;
+};
+
+#endif // SOUND_CACHE_H
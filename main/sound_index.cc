@@ -0,0 +1,27 @@
+#include "sound_index.h"
+#include "protocols/protocol.h"
+
+#include <arpa/inet.h>
+
+const std::vector<std::string_view>& SoundIndex::Get(const std::string_view& sound) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(sound.data());
+    if (it != index_.end()) {
+        return it->second;
+    }
+
+    std::vector<std::string_view> packets;
+    const char* data = sound.data();
+    size_t size = sound.size();
+    for (const char* p = data; p + sizeof(BinaryProtocol3) <= data + size; ) {
+        auto p3 = (const BinaryProtocol3*)p;
+        p += sizeof(BinaryProtocol3);
+        auto payload_size = ntohs(p3->payload_size);
+        if (p + payload_size > data + size) {
+            break;
+        }
+        packets.emplace_back(p, payload_size);
+        p += payload_size;
+    }
+    return index_.emplace(sound.data(), std::move(packets)).first->second;
+}
@@ -0,0 +1,33 @@
+#ifndef SOUND_INDEX_H
+#define SOUND_INDEX_H
+
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// P3 音效的包索引缓存：嵌入 flash 的音效是 BinaryProtocol3 帧流，
+// 以前每次 PlaySound 都重走一遍帧头解析。资产是链接期符号，内容
+// 没法 constexpr 预解析，所以首次播放时解析一次、按数据指针缓存
+// 切片表（flash 映射数据常驻，指针天然唯一且不失效），之后每次
+// 播放就是一次 O(log n) 查表加零拷贝入队。
+class SoundIndex {
+public:
+    static SoundIndex& GetInstance() {
+        static SoundIndex instance;
+        return instance;
+    }
+    SoundIndex(const SoundIndex&) = delete;
+    SoundIndex& operator=(const SoundIndex&) = delete;
+
+    // 返回音效的 Opus 包切片表，首次访问解析并缓存
+    const std::vector<std::string_view>& Get(const std::string_view& sound);
+
+private:
+    SoundIndex() = default;
+
+    std::mutex mutex_;
+    std::map<const char*, std::vector<std::string_view>> index_;
+};
+
+#endif // SOUND_INDEX_H
@@ -0,0 +1,207 @@
+#include "sound_mixer.h"
+#include "pcm_simd.h"
+#include "sound_cache.h"
+
+#include <cstring>
+#include <sys/time.h>
+
+#define TAG "SoundMixer"
+
+// 混音时会话的压低增益：约 -6dB。提示音都很短，压半秒的 TTS
+// 听感上只是"叮一声盖过来"，不值得做渐入渐出的包络
+static constexpr int16_t kDuckGainQ14 = 8192;
+
+// 广播同步参数：迟到超过两帧的包扔掉追进度（齐步比完整重要）；
+// 起播时刻偏离当前时钟超过 10 分钟按时钟没对上处理，立即播放
+static constexpr int64_t kBroadcastLateMs = 120;
+static constexpr int64_t kBroadcastSanityMs = 10 * 60 * 1000;
+
+static int64_t EpochMs() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+void SoundMixer::QueuePackets(const std::vector<std::string_view>& packets) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& packet : packets) {
+        packets_.push_back(packet);
+    }
+}
+
+void SoundMixer::QueueBroadcast(std::vector<uint8_t>&& opus, int64_t playout_epoch_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    broadcast_.push_back({std::move(opus), playout_epoch_ms});
+}
+
+void SoundMixer::Clear() {
+    std::function<void()> fire;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        packets_.clear();
+        broadcast_.clear();
+        pending_.clear();
+        pending_offset_ = 0;
+        fire = TakeDrainedLocked();
+    }
+    if (fire) {
+        fire();
+    }
+}
+
+bool SoundMixer::IsActive() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ActiveLocked();
+}
+
+void SoundMixer::NotifyWhenDrained(std::function<void()> callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (ActiveLocked()) {
+            on_drained_ = std::move(callback);
+            return;
+        }
+    }
+    // 声道本来就是空的（比如资产没刷、什么都没排进去），立刻触发，
+    // 调用方不用关心资产在不在
+    if (callback) {
+        callback();
+    }
+}
+
+std::function<void()> SoundMixer::TakeDrainedLocked() {
+    if (ActiveLocked() || !on_drained_) {
+        return nullptr;
+    }
+    auto fire = std::move(on_drained_);
+    on_drained_ = nullptr;
+    return fire;
+}
+
+bool SoundMixer::EnsurePendingLocked(int sample_rate) {
+    while (pending_offset_ >= pending_.size()) {
+        std::vector<int16_t> pcm;
+        if (!packets_.empty()) {
+            auto packet = packets_.front();
+            packets_.pop_front();
+
+            // 预解码缓存命中就是 memcpy；冷音效走专用解码器，不碰会话
+            // 解码器状态，也不计入会话路径的耗时统计
+            auto cached = SoundCache::GetInstance().Lookup((const uint8_t*)packet.data());
+            if (cached != nullptr) {
+                pcm.assign(cached->begin(), cached->end());
+            } else {
+                if (decoder_ == nullptr) {
+                    decoder_ = std::make_unique<OpusDecoderWrapper>(16000, 1);
+                }
+                std::vector<uint8_t> opus(packet.begin(), packet.end());
+                if (!decoder_->Decode(std::move(opus), pcm)) {
+                    continue;
+                }
+            }
+        } else if (!broadcast_.empty()) {
+            // 广播到点才解：没到点保持声道活跃、本帧出静音，起播
+            // 落在正确的帧边界上；迟到超限的包扔掉追进度
+            int64_t now_ms = EpochMs();
+            auto& front = broadcast_.front();
+            int64_t delta = front.playout_ms - now_ms;
+            if (front.playout_ms != 0 && delta < kBroadcastSanityMs &&
+                delta > -kBroadcastSanityMs) {
+                if (delta > 0) {
+                    return false;
+                }
+                if (-delta > kBroadcastLateMs) {
+                    broadcast_.pop_front();
+                    continue;
+                }
+            }
+            if (decoder_ == nullptr) {
+                decoder_ = std::make_unique<OpusDecoderWrapper>(16000, 1);
+            }
+            auto opus = std::move(front.opus);
+            broadcast_.pop_front();
+            if (!decoder_->Decode(std::move(opus), pcm)) {
+                continue;
+            }
+        } else {
+            return false;
+        }
+        if (sample_rate != 16000) {
+            if (resampler_rate_ != sample_rate) {
+                resampler_.Configure(16000, sample_rate);
+                resampler_rate_ = sample_rate;
+            }
+            pending_.resize(resampler_.GetOutputSamples(pcm.size()));
+            resampler_.Process(pcm.data(), pcm.size(), pending_.data());
+        } else {
+            pending_ = std::move(pcm);
+        }
+        pending_offset_ = 0;
+    }
+    return true;
+}
+
+void SoundMixer::MixInto(std::vector<int16_t>& pcm, int sample_rate) {
+    std::function<void()> fire;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ActiveLocked()) {
+            return;
+        }
+        // 没有到点的素材（广播在等起播时刻）就先不压低会话
+        if (!EnsurePendingLocked(sample_rate)) {
+            return;
+        }
+        // 会话先压低，再把提示音饱和叠加上去
+        pcm_simd::ApplyGainQ14(pcm.data(), pcm.size(), kDuckGainQ14);
+        size_t offset = 0;
+        while (offset < pcm.size() && EnsurePendingLocked(sample_rate)) {
+            size_t n = pcm.size() - offset;
+            if (n > pending_.size() - pending_offset_) {
+                n = pending_.size() - pending_offset_;
+            }
+            for (size_t i = 0; i < n; i++) {
+                int32_t mixed = (int32_t)pcm[offset + i] + pending_[pending_offset_ + i];
+                if (mixed > 32767) {
+                    mixed = 32767;
+                } else if (mixed < -32768) {
+                    mixed = -32768;
+                }
+                pcm[offset + i] = (int16_t)mixed;
+            }
+            offset += n;
+            pending_offset_ += n;
+        }
+        fire = TakeDrainedLocked();
+    }
+    if (fire) {
+        fire();
+    }
+}
+
+bool SoundMixer::RenderFrame(std::vector<int16_t>& out, size_t samples, int sample_rate) {
+    std::function<void()> fire;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ActiveLocked()) {
+            return false;
+        }
+        out.assign(samples, 0);
+        size_t offset = 0;
+        while (offset < samples && EnsurePendingLocked(sample_rate)) {
+            size_t n = samples - offset;
+            if (n > pending_.size() - pending_offset_) {
+                n = pending_.size() - pending_offset_;
+            }
+            memcpy(out.data() + offset, pending_.data() + pending_offset_,
+                n * sizeof(int16_t));
+            offset += n;
+            pending_offset_ += n;
+        }
+        fire = TakeDrainedLocked();
+    }
+    if (fire) {
+        fire();
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef SOUND_MIXER_H
+#define SOUND_MIXER_H
+
+#include "fast_resampler.h"
+
+#include <opus_decoder.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// UI 音效声道：提示音和会话音频从此分路
+// 以前提示音和会话共用抖动缓冲，开启对话要么排空要么清掉排队中的
+// 音效（ResetDecoder 直接扔），激活/告警流程里散着一串等播完的
+// 停顿。这里单开一条 UI 声道：自己的解码器和重采样器，输出前混进
+// 会话 PCM（会话先压低，提示音盖上去），会话没输出时由音频时钟
+// 驱动单独出帧——提示音和对话叠着放，不再串行
+class SoundMixer {
+public:
+    static SoundMixer& GetInstance() {
+        static SoundMixer instance;
+        return instance;
+    }
+    SoundMixer(const SoundMixer&) = delete;
+    SoundMixer& operator=(const SoundMixer&) = delete;
+
+    // 排入一段音效的 Opus 包切片（memory-mapped flash 视图，零拷贝）
+    void QueuePackets(const std::vector<std::string_view>& packets);
+    // 排入一个广播包：playout_epoch_ms 是服务器排定的起播时刻（epoch
+    // 毫秒），到点之前声道保持活跃、出静音帧，到点在帧边界起播——
+    // 各设备的系统时钟都对过服务器时间，彼此相差不超过一两帧。
+    // 0 或时钟明显没对上时立即播放
+    void QueueBroadcast(std::vector<uint8_t>&& opus, int64_t playout_epoch_ms);
+    // 丢掉未播的部分；和播完一样会触发 NotifyWhenDrained 的回调
+    void Clear();
+    bool IsActive();
+    // 声道播空（或被 Clear 冲掉）时触发一次；当前就是空的立刻触发
+    void NotifyWhenDrained(std::function<void()> callback);
+
+    // 把 UI 声道混进一帧会话 PCM（pcm 为 codec 输出采样率、单声道）。
+    // 声道活跃时会话先压到约 -6dB，提示音饱和叠加；不活跃时无操作
+    void MixInto(std::vector<int16_t>& pcm, int sample_rate);
+    // 会话无输出时的纯 UI 帧：填出 samples 个采样（不足补零），
+    // 声道不活跃返回 false
+    bool RenderFrame(std::vector<int16_t>& out, size_t samples, int sample_rate);
+
+private:
+    SoundMixer() = default;
+
+    // 持锁调用：保证 pending_ 里有未消费的采样，没货返回 false
+    bool EnsurePendingLocked(int sample_rate);
+    bool ActiveLocked() const {
+        return !packets_.empty() || !broadcast_.empty() ||
+            pending_offset_ < pending_.size();
+    }
+    // 持锁调用：播空时取走回调，由调用方在锁外触发
+    std::function<void()> TakeDrainedLocked();
+
+    struct BroadcastPacket {
+        std::vector<uint8_t> opus;
+        int64_t playout_ms;
+    };
+
+    std::mutex mutex_;
+    std::deque<std::string_view> packets_;
+    // 按起播时刻排队的广播包（服务器按发送序给帧递增的时间戳）
+    std::deque<BroadcastPacket> broadcast_;
+    // 专用解码器：UI 音效固定 16kHz 单声道，不碰会话解码器状态
+    std::unique_ptr<OpusDecoderWrapper> decoder_;
+    FastResampler resampler_;
+    int resampler_rate_ = 0;
+    // 已解码（并重采样到输出采样率）待混的 PCM
+    std::vector<int16_t> pending_;
+    size_t pending_offset_ = 0;
+    std::function<void()> on_drained_;
+};
+
+#endif // SOUND_MIXER_H
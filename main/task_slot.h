@@ -0,0 +1,133 @@
+#ifndef TASK_SLOT_H
+#define TASK_SLOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 预分配环里的内联闭包槽位。Schedule 的闭包大多只捕获 this 加一两个
+// 指针或小对象，128 字节放得下；就地构造省掉每次调度的堆分配，
+// 超大的捕获才退回堆上的 std::function 并计数。
+class TaskSlot {
+public:
+    static constexpr size_t kInlineSize = 128;
+
+    TaskSlot() = default;
+    TaskSlot(const TaskSlot&) = delete;
+    TaskSlot& operator=(const TaskSlot&) = delete;
+
+    // 多生产者用 CAS 抢占空槽
+    bool TryClaim() {
+        bool expected = false;
+        return in_use_.compare_exchange_strong(expected, true, std::memory_order_acquire);
+    }
+
+    // 闭包太大或对齐要求超限时返回 false，调用方把槽位放回去
+    template <typename F>
+    bool TrySet(F&& f) {
+        using Fn = std::decay_t<F>;
+        if (sizeof(Fn) > kInlineSize || alignof(Fn) > alignof(std::max_align_t)) {
+            return false;
+        }
+        new (storage_) Fn(std::forward<F>(f));
+        invoke_ = [](void* p) { (*static_cast<Fn*>(p))(); };
+        destroy_ = [](void* p) { static_cast<Fn*>(p)->~Fn(); };
+        return true;
+    }
+
+    void MarkFree() {
+        in_use_.store(false, std::memory_order_release);
+    }
+
+    // 执行并归还槽位
+    void Invoke() {
+        invoke_(storage_);
+        Discard();
+    }
+
+    // 不执行直接析构归还（溢出丢弃用）
+    void Discard() {
+        destroy_(storage_);
+        invoke_ = nullptr;
+        destroy_ = nullptr;
+        MarkFree();
+    }
+
+private:
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    void (*invoke_)(void*) = nullptr;
+    void (*destroy_)(void*) = nullptr;
+    std::atomic<bool> in_use_{false};
+};
+
+// 穿过 FreeRTOS 队列或车道缓冲的任务句柄：POD，按值拷贝。
+// slot 指向环里的内联槽位，heap 是超大捕获的退路，二者只有一个非空
+struct TaskRef {
+    TaskSlot* slot = nullptr;
+    std::function<void()>* heap = nullptr;
+    // 调度点给的标识（常驻字面量），长任务探测超预算时按它记账
+    const char* tag = nullptr;
+    // 入队时刻（esp_timer_get_time），队列巡检据此算排队时长
+    int64_t enqueue_us = 0;
+
+    void Run() {
+        if (slot != nullptr) {
+            slot->Invoke();
+        } else {
+            (*heap)();
+            delete heap;
+        }
+    }
+
+    void Discard() {
+        if (slot != nullptr) {
+            slot->Discard();
+        } else {
+            delete heap;
+        }
+    }
+};
+
+// 固定容量的槽位环。游标只是起搜位置的提示，空槽靠 CAS 抢；
+// 环占满或捕获超限时退回堆分配，fallback 次数有计数可查
+class TaskSlotRing {
+public:
+    explicit TaskSlotRing(size_t capacity)
+        : capacity_(capacity), slots_(new TaskSlot[capacity]) {}
+    ~TaskSlotRing() {
+        delete[] slots_;
+    }
+
+    template <typename F>
+    TaskRef Acquire(F&& f) {
+        size_t start = cursor_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < capacity_; i++) {
+            TaskSlot* slot = &slots_[(start + i) % capacity_];
+            if (!slot->TryClaim()) {
+                continue;
+            }
+            if (slot->TrySet(std::forward<F>(f))) {
+                return { slot, nullptr };
+            }
+            slot->MarkFree();
+            break;
+        }
+        heap_fallbacks_.fetch_add(1, std::memory_order_relaxed);
+        return { nullptr, new std::function<void()>(std::forward<F>(f)) };
+    }
+
+    uint32_t heap_fallbacks() const {
+        return heap_fallbacks_.load(std::memory_order_relaxed);
+    }
+
+private:
+    size_t capacity_;
+    TaskSlot* slots_;
+    std::atomic<size_t> cursor_{0};
+    std::atomic<uint32_t> heap_fallbacks_{0};
+};
+
+#endif // TASK_SLOT_H
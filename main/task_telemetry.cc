@@ -0,0 +1,99 @@
+#include "task_telemetry.h"
+#include "settings.h"
+
+#include <esp_log.h>
+
+#include <cstdio>
+
+#define TAG "TaskTelemetry"
+
+void TaskTelemetry::RegisterTask(const char* name, TaskHandle_t handle, uint32_t stack_bytes) {
+    if (handle == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back({name, handle, stack_bytes, stack_bytes});
+}
+
+void TaskTelemetry::RegisterQueue(const char* name, std::function<size_t()> depth_fn, size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queues_.push_back({name, std::move(depth_fn), capacity, 0});
+}
+
+void TaskTelemetry::Sample() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& task : tasks_) {
+        // 返回值单位是栈字（word），换算成字节
+        uint32_t free_bytes = uxTaskGetStackHighWaterMark(task.handle) * sizeof(StackType_t);
+        if (free_bytes < task.min_free_bytes) {
+            task.min_free_bytes = free_bytes;
+        }
+    }
+    for (auto& queue : queues_) {
+        size_t depth = queue.depth_fn();
+        if (depth > queue.max_depth) {
+            queue.max_depth = depth;
+        }
+    }
+    if (++sample_count_ == kReportAfterSamples && !reported_) {
+        reported_ = true;
+        LogBootReport();
+    }
+}
+
+void TaskTelemetry::LogBootReport() {
+    // 跨开机的最小余量落在 NVS：单次开机可能没跑到最深调用路径，
+    // 多次开机取最小值才有缩栈的把握。锁已经在 Sample 里持有
+    Settings settings("task_wm", true);
+    ESP_LOGI(TAG, "stack sizing report (alloc / min free this boot / min free ever):");
+    for (auto& task : tasks_) {
+        int32_t ever = settings.GetInt(task.name, (int32_t)task.min_free_bytes);
+        if ((int32_t)task.min_free_bytes < ever) {
+            ever = (int32_t)task.min_free_bytes;
+            settings.SetInt(task.name, ever);
+        } else if (settings.GetInt(task.name, -1) == -1) {
+            settings.SetInt(task.name, ever);
+        }
+        ESP_LOGI(TAG, "  %-16s %6lu / %6lu / %6ld%s", task.name,
+            task.stack_bytes, task.min_free_bytes, ever,
+            ever > (int32_t)task.stack_bytes / 2 ? "  <- oversized" : "");
+    }
+    for (auto& queue : queues_) {
+        ESP_LOGI(TAG, "  queue %-10s depth max %zu / cap %zu",
+            queue.name, queue.max_depth, queue.capacity);
+    }
+}
+
+uint32_t TaskTelemetry::MinFreeStackBytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t min_free = UINT32_MAX;
+    for (const auto& task : tasks_) {
+        if (task.min_free_bytes < min_free) {
+            min_free = task.min_free_bytes;
+        }
+    }
+    return min_free == UINT32_MAX ? 0 : min_free;
+}
+
+std::string TaskTelemetry::BuildJson() {
+    char buffer[128];
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string json = "{\"tasks\":[";
+    for (size_t i = 0; i < tasks_.size(); i++) {
+        const auto& task = tasks_[i];
+        snprintf(buffer, sizeof(buffer),
+            "%s{\"name\":\"%s\",\"stack\":%lu,\"min_free\":%lu}",
+            i > 0 ? "," : "", task.name, task.stack_bytes, task.min_free_bytes);
+        json += buffer;
+    }
+    json += "],\"queues\":[";
+    for (size_t i = 0; i < queues_.size(); i++) {
+        const auto& queue = queues_[i];
+        snprintf(buffer, sizeof(buffer),
+            "%s{\"name\":\"%s\",\"max_depth\":%zu,\"capacity\":%zu}",
+            i > 0 ? "," : "", queue.name, queue.max_depth, queue.capacity);
+        json += buffer;
+    }
+    json += "]}";
+    return json;
+}
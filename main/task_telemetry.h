@@ -0,0 +1,70 @@
+#ifndef TASK_TELEMETRY_H
+#define TASK_TELEMETRY_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 任务栈水位与队列深度遥测：各处手拍的栈大小（4096*8 的后台工人、
+// 4096*2 的主循环……）到底用掉多少，只有跑起来才知道，溢出又是无声
+// 重启。常驻任务在创建处注册进来，时钟定时器周期采
+// uxTaskGetStackHighWaterMark 和各队列深度；开机 5 分钟后输出一份
+// 本次/历史（NVS 持久化）最小余量对照报告，照着报告缩栈就有依据。
+// 短命任务（版本检查、启动期任务）栈本来就会还回去，不注册。
+class TaskTelemetry {
+public:
+    static TaskTelemetry& GetInstance() {
+        static TaskTelemetry instance;
+        return instance;
+    }
+    TaskTelemetry(const TaskTelemetry&) = delete;
+    TaskTelemetry& operator=(const TaskTelemetry&) = delete;
+
+    // name 须是常驻字符串且不超过 15 字节（直接用作 NVS key）；
+    // stack_bytes 是创建任务时给的栈大小
+    void RegisterTask(const char* name, TaskHandle_t handle, uint32_t stack_bytes);
+    // depth_fn 返回当前排队条数；采样只记录峰值
+    void RegisterQueue(const char* name, std::function<size_t()> depth_fn, size_t capacity);
+    // 每 10 秒从时钟定时器调用一次
+    void Sample();
+    // 组出完整的 JSON 对象（不含外层消息包装），随 metrics 上报
+    std::string BuildJson();
+    // 全部任务里最小的栈余量（最近一次采样），给飞行记录仪的快照用
+    uint32_t MinFreeStackBytes();
+
+private:
+    TaskTelemetry() = default;
+
+    void LogBootReport();
+
+    struct TaskEntry {
+        const char* name;
+        TaskHandle_t handle;
+        uint32_t stack_bytes;
+        uint32_t min_free_bytes;  // 本次开机观测到的最小剩余
+    };
+    struct QueueEntry {
+        const char* name;
+        std::function<size_t()> depth_fn;
+        size_t capacity;
+        size_t max_depth;
+    };
+
+    // 第 30 次采样（开机 5 分钟，稳态已到）写一次 NVS 并出报告，
+    // 之后只在内存里继续跟踪，不再碰 flash
+    static constexpr uint32_t kReportAfterSamples = 30;
+
+    std::mutex mutex_;
+    std::vector<TaskEntry> tasks_;
+    std::vector<QueueEntry> queues_;
+    uint32_t sample_count_ = 0;
+    bool reported_ = false;
+};
+
+#endif // TASK_TELEMETRY_H
@@ -0,0 +1,42 @@
+#include "telemetry_registry.h"
+#include "json_builder.h"
+
+#include <cstring>
+
+void TelemetryRegistry::Register(const char* name, std::function<std::string()> provider) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : providers_) {
+        if (strcmp(entry.first, name) == 0) {
+            entry.second = std::move(provider);
+            return;
+        }
+    }
+    providers_.emplace_back(name, std::move(provider));
+}
+
+std::string TelemetryRegistry::BuildSnapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    char buffer[2048];
+    JsonBuilder json(buffer, sizeof(buffer));
+    json.BeginObject();
+    for (auto& entry : providers_) {
+        json.AddRaw(entry.first, entry.second());
+    }
+    json.EndObject();
+    if (!json.overflowed()) {
+        return json.str();
+    }
+    // 快照超过栈缓冲（新面板挂多了），退回动态拼接
+    std::string snapshot = "{";
+    for (auto& entry : providers_) {
+        if (snapshot.size() > 1) {
+            snapshot += ',';
+        }
+        snapshot += '\"';
+        snapshot += entry.first;
+        snapshot += "\":";
+        snapshot += entry.second();
+    }
+    snapshot += '}';
+    return snapshot;
+}
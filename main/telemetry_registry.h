@@ -0,0 +1,37 @@
+#ifndef TELEMETRY_REGISTRY_H
+#define TELEMETRY_REGISTRY_H
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 性能计数器的统一出口。各遥测面（堆、CPU、链路、抖动缓冲……）
+// 把自己的 BuildJson 挂进来，服务器拉取（metrics）和周期推送
+// （telemetry）共用同一份快照组装，新计数器只登记一次就能上报，
+// 不再各处手拼 JSON、也不再靠 ESP_LOGI 刷串口
+class TelemetryRegistry {
+public:
+    static TelemetryRegistry& GetInstance() {
+        static TelemetryRegistry instance;
+        return instance;
+    }
+    TelemetryRegistry(const TelemetryRegistry&) = delete;
+    TelemetryRegistry& operator=(const TelemetryRegistry&) = delete;
+
+    // provider 返回已序列化的 JSON 值（对象或数组），快照时按名拼入。
+    // name 要求静态生存期；重名覆盖旧的
+    void Register(const char* name, std::function<std::string()> provider);
+
+    // 组一份 {"name":<json>,...} 快照：JsonBuilder 栈缓冲一次写完，
+    // 超长（罕见）退回动态拼接
+    std::string BuildSnapshot();
+
+private:
+    TelemetryRegistry() = default;
+
+    std::mutex mutex_;
+    std::vector<std::pair<const char*, std::function<std::string()>>> providers_;
+};
+
+#endif // TELEMETRY_REGISTRY_H
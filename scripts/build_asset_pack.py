@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+# 打包外置语言资产分区镜像：把 assets/<lang>/ 和 assets/common/ 的
+# p3 音效装进 asset_pack.cc 能 memory-map 的包格式（小端）：
+#   头部  { char magic[4] = "XZA1"; uint32 entry_count; char lang[8]; }
+#   条目  { char name[32]; uint32 offset; uint32 size; } * entry_count
+#   数据  紧随其后，offset 相对分区起始，4 字节对齐
+# 刷写示例（0xD00000 = partitions.csv 里的 assets_a 槽；出厂默认
+# 激活 A 槽，B 槽留给 OTA 资产预取）：
+#   python scripts/build_asset_pack.py --lang-dir main/assets/zh-CN --output build/assets.bin
+#   esptool.py write_flash 0xD00000 build/assets.bin
+import argparse
+import json
+import os
+import struct
+
+MAGIC = b"XZA1"
+HEADER_FORMAT = "<4sI8s"
+ENTRY_FORMAT = "<32sII"
+
+
+def collect_sounds(lang_dir):
+    common_dir = os.path.join(os.path.dirname(lang_dir), "common")
+    sounds = []
+    for directory in (lang_dir, common_dir):
+        for file in sorted(os.listdir(directory)):
+            if file.endswith(".p3"):
+                name = os.path.splitext(file)[0]
+                with open(os.path.join(directory, file), "rb") as f:
+                    sounds.append((name, f.read()))
+    return sounds
+
+
+def build_pack(lang_dir, output_path):
+    with open(os.path.join(lang_dir, "language.json"), "r", encoding="utf-8") as f:
+        lang_code = json.load(f)["language"]["type"]
+
+    sounds = collect_sounds(lang_dir)
+    header_size = struct.calcsize(HEADER_FORMAT)
+    table_size = struct.calcsize(ENTRY_FORMAT) * len(sounds)
+
+    entries = b""
+    payload = b""
+    offset = header_size + table_size
+    # 数据 4 字节对齐，映射后直接当结构化数据读也不会有对齐问题
+    for name, data in sounds:
+        pad = (-offset) % 4
+        payload += b"\0" * pad
+        offset += pad
+        entries += struct.pack(ENTRY_FORMAT, name.encode()[:31], offset, len(data))
+        payload += data
+        offset += len(data)
+
+    os.makedirs(os.path.dirname(output_path) or ".", exist_ok=True)
+    with open(output_path, "wb") as f:
+        f.write(struct.pack(HEADER_FORMAT, MAGIC, len(sounds), lang_code.encode()[:8]))
+        f.write(entries)
+        f.write(payload)
+    print(f"{output_path}: {lang_code}, {len(sounds)} sounds, {offset} bytes")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--lang-dir", required=True, help="语言目录，例如 main/assets/zh-CN")
+    parser.add_argument("--output", required=True, help="输出分区镜像路径")
+    args = parser.parse_args()
+
+    build_pack(args.lang_dir, args.output)
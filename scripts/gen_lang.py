@@ -24,11 +24,38 @@ namespace Lang {{
     // 音效资源
     namespace Sounds {{
 {sounds}
+
+        // 名字 ↔ 数据的资产表：asset_pack 按数据指针反查名字，
+        // 再用名字到外置资产分区找覆盖（scripts/build_asset_pack.py）
+        struct Asset {{
+            const char* name;
+            std::string_view data;
+        }};
+        static const Asset kAll[] = {{
+{sound_table}
+        }};
+        static const size_t kAllCount = sizeof(kAll) / sizeof(kAll[0]);
     }}
 }}
 """
 
-def generate_header(input_path, output_path):
+def sound_block(base_name, external):
+    if external:
+        # 外置资产模式：固件不嵌数据，string_view 指向名字常量且长度
+        # 为 0（指针唯一，asset_pack 靠它反查名字），数据在资产分区里
+        return f"""
+        static constexpr char p3_{base_name}_name[] = "{base_name}";
+        static const std::string_view P3_{base_name.upper()} {{ p3_{base_name}_name, 0 }};"""
+    return f"""
+        extern const char p3_{base_name}_start[] asm("_binary_{base_name}_p3_start");
+        extern const char p3_{base_name}_end[] asm("_binary_{base_name}_p3_end");
+        static const std::string_view P3_{base_name.upper()} {{
+        static_cast<const char*>(p3_{base_name}_start),
+        static_cast<size_t>(p3_{base_name}_end - p3_{base_name}_start)
+        }};"""
+
+
+def generate_header(input_path, output_path, external=False):
     with open(input_path, 'r', encoding='utf-8') as f:
         data = json.load(f)
 
@@ -38,7 +65,10 @@ def generate_header(input_path, output_path):
 
     lang_code = data['language']['type']
 
-    # 生成字符串常量
+    # 生成字符串常量。字符串表刻意不压缩：单固件只编一种语言，全表
+    # 实测 590B（zh-CN）到 1180B（ja-JP），而 heatshrink 解码器 +
+    # 惰性解压缓存的代码体积就超过 1KB，净亏；等表长到几 KB 再回头
+    # 考虑（届时在这里按 key 分冷热，热键保持明文）
     strings = []
     sounds = []
     for key, value in data['strings'].items():
@@ -46,35 +76,31 @@ def generate_header(input_path, output_path):
         strings.append(f'        constexpr const char* {key.upper()} = "{value}";')
 
     # 生成音效常量
+    sound_names = []
     for file in os.listdir(os.path.dirname(input_path)):
         if file.endswith('.p3'):
             base_name = os.path.splitext(file)[0]
-            sounds.append(f'''
-        extern const char p3_{base_name}_start[] asm("_binary_{base_name}_p3_start");
-        extern const char p3_{base_name}_end[] asm("_binary_{base_name}_p3_end");
-        static const std::string_view P3_{base_name.upper()} {{
-        static_cast<const char*>(p3_{base_name}_start),
-        static_cast<size_t>(p3_{base_name}_end - p3_{base_name}_start)
-        }};''')
-    
+            sound_names.append(base_name)
+            sounds.append(sound_block(base_name, external))
+
     # 生成公共音效
     for file in os.listdir(os.path.join(os.path.dirname(output_path), 'common')):
         if file.endswith('.p3'):
             base_name = os.path.splitext(file)[0]
-            sounds.append(f'''
-        extern const char p3_{base_name}_start[] asm("_binary_{base_name}_p3_start");
-        extern const char p3_{base_name}_end[] asm("_binary_{base_name}_p3_end");
-        static const std::string_view P3_{base_name.upper()} {{
-        static_cast<const char*>(p3_{base_name}_start),
-        static_cast<size_t>(p3_{base_name}_end - p3_{base_name}_start)
-        }};''')
+            sound_names.append(base_name)
+            sounds.append(sound_block(base_name, external))
+
+    sound_table = "\n".join(
+        f'            {{ "{name}", P3_{name.upper()} }},'
+        for name in sorted(sound_names))
 
     # 填充模板
     content = HEADER_TEMPLATE.format(
         lang_code=lang_code,
         lang_code_for_font=lang_code.replace('-', '_').lower(),
         strings="\n".join(sorted(strings)),
-        sounds="\n".join(sorted(sounds))
+        sounds="\n".join(sorted(sounds)),
+        sound_table=sound_table
     )
 
     # 写入文件
@@ -86,6 +112,8 @@ if __name__ == "__main__":
     parser = argparse.ArgumentParser()
     parser.add_argument("--input", required=True, help="输入JSON文件路径")
     parser.add_argument("--output", required=True, help="输出头文件路径")
+    parser.add_argument("--external", action="store_true",
+                        help="音效不嵌入固件，运行时从外置资产分区加载")
     args = parser.parse_args()
 
-    generate_header(args.input, args.output)
\ No newline at end of file
+    generate_header(args.input, args.output, args.external)
\ No newline at end of file
@@ -0,0 +1,102 @@
+import sys
+import os
+import re
+import glob
+
+# 解析链接 map，报告 IRAM（.iram0.text）里每个目标文件和符号的占用，
+# 用来核对 CONFIG_AUDIO_REALTIME_IRAM 把音频热路径放进 IRAM 的代价。
+# 用法: python scripts/iram_report.py [build/xxx.map] [--all]
+#   默认只列 main 组件的符号，--all 列出整个固件的 IRAM 明细。
+
+os.chdir(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+
+def find_map_file():
+    maps = glob.glob("build/*.map")
+    if not maps:
+        print("no .map file under build/, run idf.py build first")
+        sys.exit(1)
+    return maps[0]
+
+
+def parse_iram_entries(map_path):
+    # GNU ld map 格式：.iram0.text 段下每个输入 section 一行（或两行）：
+    #  .iram0.text.<symbol>
+    #                 0x40374c20      0x1a4 esp-idf/main/lib...(xxx.cc.obj)
+    entries = []
+    in_iram = False
+    pending_name = None
+    with open(map_path) as f:
+        for line in f:
+            if line.startswith(".iram0.text") or line.startswith(" .iram0.text") or \
+               line.startswith(".iram0.vectors"):
+                in_iram = True
+            elif re.match(r"^\.\w", line):
+                in_iram = False
+            if not in_iram:
+                continue
+
+            m = re.match(r"^ (\.\S+)$", line.rstrip())
+            if m:
+                pending_name = m.group(1)
+                continue
+            m = re.match(r"^ (\.\S+)?\s+0x[0-9a-f]+\s+(0x[0-9a-f]+)\s+(\S+)$", line.rstrip())
+            if m:
+                name = m.group(1) or pending_name or "?"
+                size = int(m.group(2), 16)
+                obj = m.group(3)
+                pending_name = None
+                if size > 0:
+                    entries.append((name, size, obj))
+    return entries
+
+
+def short_obj(obj):
+    m = re.search(r"\(([^)]+)\)$", obj)
+    leaf = m.group(1) if m else os.path.basename(obj)
+    if "esp-idf/main/" in obj:
+        return "main/" + leaf
+    m = re.search(r"esp-idf/([^/]+)/", obj)
+    return (m.group(1) + "/" if m else "") + leaf
+
+
+def main():
+    map_path = None
+    show_all = False
+    for arg in sys.argv[1:]:
+        if arg == "--all":
+            show_all = True
+        else:
+            map_path = arg
+    if map_path is None:
+        map_path = find_map_file()
+
+    entries = parse_iram_entries(map_path)
+    if not entries:
+        print("no .iram0.text entries found in %s" % map_path)
+        sys.exit(1)
+
+    total = sum(size for _, size, _ in entries)
+    shown = entries if show_all else [e for e in entries if "esp-idf/main/" in e[2]]
+
+    by_obj = {}
+    for name, size, obj in shown:
+        by_obj.setdefault(short_obj(obj), []).append((name, size))
+
+    scope = "all components" if show_all else "main component"
+    print("IRAM usage (%s), map: %s" % (scope, map_path))
+    print("total .iram0.text in firmware: %d bytes" % total)
+    print()
+    for obj in sorted(by_obj, key=lambda o: -sum(s for _, s in by_obj[o])):
+        symbols = by_obj[obj]
+        print("%-48s %6d bytes" % (obj, sum(s for _, s in symbols)))
+        for name, size in sorted(symbols, key=lambda e: -e[1]):
+            # .iram0.text._ZN10AudioCodec10OutputDataE... -> 去掉段前缀
+            sym = name.replace(".iram0.text.", "").replace(".iram0.text", "(section)")
+            print("    %-50s %6d" % (sym, size))
+    if not by_obj:
+        print("(no IRAM symbols from main — is CONFIG_AUDIO_REALTIME_IRAM enabled?)")
+
+
+if __name__ == "__main__":
+    main()